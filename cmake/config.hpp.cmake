@@ -76,6 +76,7 @@ typedef unsigned @VMIME_64BIT_TYPE@ vmime_uint64;
 #cmakedefine01 VMIME_PLATFORM_IS_WINDOWS
 #cmakedefine01 VMIME_HAVE_PTHREAD
 #cmakedefine01 VMIME_HAVE_GETADDRINFO
+#cmakedefine01 VMIME_HAVE_EPOLL
 #cmakedefine01 VMIME_HAVE_GETTID
 #cmakedefine01 VMIME_HAVE_SYSCALL
 #cmakedefine01 VMIME_HAVE_SYSCALL_GETTID
@@ -84,6 +85,7 @@ typedef unsigned @VMIME_64BIT_TYPE@ vmime_uint64;
 #cmakedefine01 VMIME_HAVE_LOCALTIME_S
 #cmakedefine01 VMIME_HAVE_LOCALTIME_R
 #cmakedefine01 VMIME_HAVE_MLANG
+#cmakedefine01 VMIME_HAVE_AVX2_DISPATCH
 #cmakedefine01 VMIME_SHARED_PTR_USE_CXX
 #cmakedefine01 VMIME_SHARED_PTR_USE_BOOST
 
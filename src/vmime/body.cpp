@@ -30,7 +30,7 @@
 #include "vmime/utility/random.hpp"
 
 #include "vmime/utility/seekableInputStreamRegionAdapter.hpp"
-#include "vmime/utility/outputStreamAdapter.hpp"
+#include "vmime/utility/outputStreamByteCounter.hpp"
 
 #include "vmime/parserHelpers.hpp"
 
@@ -60,39 +60,42 @@ size_t body::findNextBoundaryPosition
 	 const size_t position, const size_t end,
 	 size_t* boundaryStart, size_t* boundaryEnd)
 {
-	size_t pos = position;
-
-	while (pos != npos && pos < end)
+	if (position >= end)
+		return position;
+
+	// A boundary must be at the beginning of a line, start with "--" and
+	// may be preceded by transport padding bytes (SPACE or HTAB). Instead
+	// of searching the boundary string itself, only examine the lines
+	// starting with "--": they are indexed once by the parser, and shared
+	// with the bodies of the parent and child parts.
+	size_t searchStart = position;
+
+	// Include the line whose padding may extend up to the start position
+	while (searchStart != 0)
 	{
-		pos = parser->findNext(boundary, pos);
-
-		if (pos == npos)
-			break;  // not found
-
-		if (pos != 0)
-		{
-			// Skip transport padding bytes (SPACE or HTAB), if any
-			size_t advance = 0;
+		parser->seek(searchStart - 1);
 
-			while (pos != 0)
-			{
-				parser->seek(pos - advance - 1);
+		const byte_t c = parser->peekByte();
 
-				const byte_t c = parser->peekByte();
+		if (c == ' ' || c == '\t')
+			--searchStart;
+		else
+			break;
+	}
 
-				if (c == ' ' || c == '\t')
-					++advance;
-				else
-					break;
-			}
+	searchStart = (searchStart >= 3 ? searchStart - 3 : 0);
 
-			// Ensure the bytes before boundary are "[LF]--": boundary should be
-			// at the beginning of a line, and should start with "--"
-			if (pos - advance >= 3)
+	for (size_t line = parser->findNextDashLine(searchStart) ;
+	     line != npos && line + 3 < end ;
+	     line = parser->findNextDashLine(line + 1))
+	{
+		for (size_t pos = line + 3 ; pos < end ; ++pos)
+		{
+			if (pos >= position)
 			{
-				parser->seek(pos - advance - 3);
+				parser->seek(pos);
 
-				if (parser->matchBytes("\n--", 3))
+				if (parser->matchBytes(boundary.data(), boundary.length()))
 				{
 					parser->seek(pos + boundary.length());
 
@@ -102,28 +105,43 @@ size_t body::findNextBoundaryPosition
 					if (next == '\r' || next == '\n' || next == '-')
 					{
 						// Get rid of the "[CR]" just before "[LF]--", if any
-						if (pos - advance >= 4)
+						size_t start = line;
+
+						if (line != 0)
 						{
-							parser->seek(pos - advance - 4);
+							parser->seek(line - 1);
 
 							if (parser->peekByte() == '\r')
-								advance++;
+								--start;
 						}
 
-						*boundaryStart = pos - advance - 3;
+						*boundaryStart = start;
 						*boundaryEnd = pos + boundary.length();
 
 						return pos;
 					}
 				}
 			}
-		}
 
-		// Boundary is a prefix of another, continue the search
-		pos++;
+			// Skip transport padding bytes, if any
+			parser->seek(pos);
+
+			const byte_t c = parser->peekByte();
+
+			if (c != ' ' && c != '\t')
+				break;
+		}
 	}
 
-	return pos;
+	// No boundary found in the range: tell whether the boundary string
+	// appears after it (in this case, the remaining bytes are not a part
+	// but an epilog)
+	const size_t pos = parser->findNext(boundary, std::max(position, end - 1));
+
+	if (pos == npos)
+		return npos;
+
+	return std::max(pos, end);
 }
 
 
@@ -182,7 +200,7 @@ void body::parseImpl
 				}
 				else
 				{
-					pos = parser->findNext("\n--", position);
+					pos = parser->findNextDashLine(position);
 
 					if ((pos != npos) && (pos + 3 < end))
 						pos += 3;  // skip \n--
@@ -312,8 +330,11 @@ void body::parseImpl
 			partStart = boundaryEnd;
 
 			// Find the next boundary
-			pos = findNextBoundaryPosition
-				(parser, boundary, boundaryEnd, end, &boundaryStart, &boundaryEnd);
+			if (!lastPart)
+			{
+				pos = findNextBoundaryPosition
+					(parser, boundary, boundaryEnd, end, &boundaryStart, &boundaryEnd);
+			}
 		}
 
 		m_contents = make_shared <emptyContentHandler>();
@@ -419,37 +440,7 @@ void body::generateImpl
 	// MIME-Multipart
 	if (getPartCount() != 0)
 	{
-		string boundary;
-
-		if (!m_part)
-		{
-			boundary = generateRandomBoundaryString();
-		}
-		else
-		{
-			// Use current boundary string, if specified. If no "Content-Type" field is
-			// present, or the boundary is not specified, generate a random one
-			shared_ptr <contentTypeField> ctf =
-				m_part->getHeader()->findField <contentTypeField>(fields::CONTENT_TYPE);
-
-			if (ctf)
-			{
-				if (ctf->hasBoundary())
-				{
-					boundary = ctf->getBoundary();
-				}
-				else
-				{
-					// No boundary string specified
-					boundary = generateRandomBoundaryString();
-				}
-			}
-			else
-			{
-				// No Content-Type (and no boundary string specified)
-				boundary = generateRandomBoundaryString();
-			}
-		}
+		const string boundary = getActualBoundary();
 
 		const text prologText = getActualPrologText(ctx);
 		const text epilogText = getActualEpilogText(ctx);
@@ -503,12 +494,16 @@ size_t body::getGeneratedSize(const generationContext& ctx)
 	// MIME-Multipart
 	if (getPartCount() != 0)
 	{
-		size_t size = 0;
+		// Random boundaries all have the same length
+		const size_t boundaryLength = getActualBoundary().length();
+
+		// "--" + boundary, then for each part: CRLF + part + CRLF + "--" + boundary,
+		// and finally the closing "--" + CRLF
+		size_t size = 2 + boundaryLength + 2 + 2;
 
-		// Size of parts and boundaries
 		for (size_t p = 0 ; p < getPartCount() ; ++p)
 		{
-			size += 100;  // boundary, CRLF...
+			size += 2 + 2 + 2 + boundaryLength;
 			size += getPartAt(p)->getGeneratedSize(ctx);
 		}
 
@@ -517,26 +512,24 @@ size_t body::getGeneratedSize(const generationContext& ctx)
 
 		if (!prologText.isEmpty())
 		{
-			std::ostringstream oss;
-			utility::outputStreamAdapter osa(oss);
+			utility::outputStreamByteCounter counter;
 
-			prologText.encodeAndFold(ctx, osa, 0,
+			prologText.encodeAndFold(ctx, counter, 0,
 				NULL, text::FORCE_NO_ENCODING | text::NO_NEW_LINE_SEQUENCE);
 
-			size += oss.str().size();
+			size += counter.getCount() + 2 /* CRLF */;
 		}
 
 		const text epilogText = getActualEpilogText(ctx);
 
 		if (!epilogText.isEmpty())
 		{
-			std::ostringstream oss;
-			utility::outputStreamAdapter osa(oss);
+			utility::outputStreamByteCounter counter;
 
-			epilogText.encodeAndFold(ctx, osa, 0,
+			epilogText.encodeAndFold(ctx, counter, 0,
 				NULL, text::FORCE_NO_ENCODING | text::NO_NEW_LINE_SEQUENCE);
 
-			size += oss.str().size();
+			size += counter.getCount() + 2 /* CRLF */;
 		}
 
 		return size;
@@ -544,19 +537,73 @@ size_t body::getGeneratedSize(const generationContext& ctx)
 	// Simple body
 	else
 	{
-		if (getEncoding() == m_contents->getEncoding())
-		{
-			// No re-encoding has to be performed
-			return m_contents->getLength();
-		}
+		return getContentsGeneratedSize(ctx);
+	}
+}
+
+
+size_t body::getContentsGeneratedSize(const generationContext& ctx)
+{
+	const encoding enc = getEncoding();
+	const size_t length = m_contents->getLength();
+
+	// No re-encoding has to be performed
+	if (m_contents->isEncoded() && m_contents->getEncoding() == enc)
+		return length;
+
+	const size_t maxLineLength = ctx.getMaxLineLength();
+	const bool isText = (getContentType().getType() == mediaTypes::TEXT);
+
+	shared_ptr <utility::encoder::encoder> encoder = enc.getEncoder();
+	encoder->getProperties()["maxlinelength"] = maxLineLength;
+	encoder->getProperties()["text"] = isText;
+
+	// Size of Base64 and identity encodings only depends on the length of data
+	if (!m_contents->isEncoded() &&
+	    (enc == encoding(encodingTypes::BASE64) ||
+	     enc == encoding(encodingTypes::SEVEN_BIT) ||
+	     enc == encoding(encodingTypes::EIGHT_BIT) ||
+	     enc == encoding(encodingTypes::BINARY)))
+	{
+		return encoder->getEncodedSize(length);
+	}
+
+	// Otherwise, the exact size is only known after encoding. It is not
+	// cached, as content handlers may have their data replaced in place
+	// without notice. If data cannot be read twice, fall back to the
+	// encoder's worst-case estimate
+	if (!m_contents->isBuffered())
+	{
+		if (m_contents->isEncoded())
+			return encoder->getEncodedSize(m_contents->getEncoding().getEncoder()->getDecodedSize(length));
 		else
-		{
-			shared_ptr <utility::encoder::encoder> srcEncoder = m_contents->getEncoding().getEncoder();
-			shared_ptr <utility::encoder::encoder> dstEncoder = getEncoding().getEncoder();
+			return encoder->getEncodedSize(length);
+	}
 
-			return dstEncoder->getEncodedSize(srcEncoder->getDecodedSize(m_contents->getLength()));
-		}
+	shared_ptr <contentHandler> contents = m_contents->clone();
+	contents->setContentTypeHint(getContentType());
+
+	utility::outputStreamByteCounter counter;
+	contents->generate(counter, enc, maxLineLength);
+
+	return counter.getCount();
+}
+
+
+const string body::getActualBoundary() const
+{
+	// Use current boundary string, if specified. If no "Content-Type" field is
+	// present, or the boundary is not specified, generate a random one
+	if (m_part)
+	{
+		shared_ptr <contentTypeField> ctf =
+			m_part->getHeader()->findField <contentTypeField>(fields::CONTENT_TYPE);
+
+		if (ctf && ctf->hasBoundary())
+			return ctf->getBoundary();
 	}
+
+	return generateRandomBoundaryString();
 }
 
 
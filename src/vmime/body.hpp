@@ -287,6 +287,10 @@ private:
 	text getActualPrologText(const generationContext& ctx) const;
 	text getActualEpilogText(const generationContext& ctx) const;
 
+	const string getActualBoundary() const;
+
+	size_t getContentsGeneratedSize(const generationContext& ctx);
+
 	void setParentPart(bodyPart* parent);
 
 
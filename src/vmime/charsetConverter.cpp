@@ -24,6 +24,7 @@
 #include "vmime/charsetConverter.hpp"
 
 #include "vmime/charsetConverter_idna.hpp"
+#include "vmime/charsetConverter_utf8.hpp"
 
 
 namespace vmime
@@ -37,6 +38,8 @@ shared_ptr <charsetConverter> charsetConverter::create
 {
 	if (source == "idna" || dest == "idna")
 		return make_shared <charsetConverter_idna>(source, dest, opts);
+	else if (charsetConverter_utf8::isSupported(source, dest))
+		return make_shared <charsetConverter_utf8>(source, dest, opts);
 	else
 		return createGenericConverter(source, dest, opts);
 }
@@ -142,7 +142,7 @@ public:
 		(utility::outputStream& os,
 		 const charsetConverterOptions& opts = charsetConverterOptions()) = 0;
 
-private:
+protected:
 
 	static shared_ptr <charsetConverter> createGenericConverter
 		(const charset& source, const charset& dest,
@@ -30,8 +30,12 @@
 #include "vmime/charsetConverter_iconv.hpp"
 
 #include "vmime/exception.hpp"
+#include "vmime/platform.hpp"
 #include "vmime/utility/inputStreamStringAdapter.hpp"
 #include "vmime/utility/outputStreamStringAdapter.hpp"
+#include "vmime/utility/sync/autoLock.hpp"
+
+#include <map>
 
 
 extern "C"
@@ -108,6 +112,107 @@ namespace vmime
 {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+/** Keeps unused iconv descriptors for later reuse. A converter is created
+  * for each conversion (eg. for each encoded word in a header), and
+  * iconv_open() is expensive as it may have to load conversion tables.
+  * Conversion options do not change the descriptor, so descriptors are
+  * only identified by their source and destination charsets.
+  */
+class iconvDescriptorCache
+{
+public:
+
+	static iconvDescriptorCache& getInstance()
+	{
+		static iconvDescriptorCache instance;
+		return instance;
+	}
+
+	~iconvDescriptorCache()
+	{
+		for (DescMap::iterator it = m_descs.begin() ; it != m_descs.end() ; ++it)
+			iconv_close(it->second);
+	}
+
+	/** Returns a descriptor for the specified conversion, either from the
+	  * cache or newly opened.
+	  *
+	  * @param source input charset
+	  * @param dest output charset
+	  * @return iconv descriptor, or (iconv_t) -1 if the conversion is not supported
+	  */
+	iconv_t acquire(const charset& source, const charset& dest)
+	{
+		if (m_mutex)
+		{
+			utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+			DescMap::iterator it = m_descs.find(DescKey(source.getName(), dest.getName()));
+
+			if (it != m_descs.end())
+			{
+				const iconv_t cd = it->second;
+				m_descs.erase(it);
+
+				return cd;
+			}
+		}
+
+		return iconv_open(dest.getName().c_str(), source.getName().c_str());
+	}
+
+	/** Gives back a descriptor obtained with acquire(), which is then
+	  * either kept for reuse or closed.
+	  *
+	  * @param source input charset
+	  * @param dest output charset
+	  * @param cd iconv descriptor
+	  */
+	void release(const charset& source, const charset& dest, iconv_t cd)
+	{
+		if (m_mutex)
+		{
+			// Reset conversion state, which may be left in the middle
+			// of a shift sequence if the conversion failed
+			iconv(cd, NULL, NULL, NULL, NULL);
+
+			utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex);
+
+			if (m_descs.size() < MAX_CACHED_DESCRIPTORS)
+			{
+				m_descs.insert(DescMap::value_type(DescKey(source.getName(), dest.getName()), cd));
+				return;
+			}
+		}
+
+		iconv_close(cd);
+	}
+
+private:
+
+	iconvDescriptorCache()
+	{
+		// Descriptors are not cached if no platform handler is set (it is
+		// required to protect the cache against concurrent access)
+		if (platform::getHandler())
+			m_mutex = platform::getHandler()->createCriticalSection();
+	}
+
+	// Maximum number of unused descriptors to keep, for all charsets
+	static const size_t MAX_CACHED_DESCRIPTORS = 64;
+
+	typedef std::pair <string, string> DescKey;
+	typedef std::multimap <DescKey, iconv_t> DescMap;
+
+	DescMap m_descs;
+	shared_ptr <utility::sync::criticalSection> m_mutex;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
 // static
 shared_ptr <charsetConverter> charsetConverter::createGenericConverter
 	(const charset& source, const charset& dest,
@@ -122,7 +227,7 @@ charsetConverter_iconv::charsetConverter_iconv
 	: m_desc(NULL), m_source(source), m_dest(dest), m_options(opts)
 {
 	// Get an iconv descriptor
-	const iconv_t cd = iconv_open(dest.getName().c_str(), source.getName().c_str());
+	const iconv_t cd = iconvDescriptorCache::getInstance().acquire(source, dest);
 
 	if (cd != reinterpret_cast <iconv_t>(-1))
 	{
@@ -138,8 +243,8 @@ charsetConverter_iconv::~charsetConverter_iconv()
 {
 	if (m_desc != NULL)
 	{
-		// Close iconv handle
-		iconv_close(*static_cast <iconv_t*>(m_desc));
+		// Release iconv handle
+		iconvDescriptorCache::getInstance().release(m_source, m_dest, *static_cast <iconv_t*>(m_desc));
 
 		delete static_cast <iconv_t*>(m_desc);
 		m_desc = NULL;
@@ -278,7 +383,7 @@ charsetFilteredOutputStream_iconv::charsetFilteredOutputStream_iconv
 	  m_stream(*os), m_unconvCount(0), m_options(opts)
 {
 	// Get an iconv descriptor
-	const iconv_t cd = iconv_open(dest.getName().c_str(), source.getName().c_str());
+	const iconv_t cd = iconvDescriptorCache::getInstance().acquire(source, dest);
 
 	if (cd != reinterpret_cast <iconv_t>(-1))
 	{
@@ -294,8 +399,8 @@ charsetFilteredOutputStream_iconv::~charsetFilteredOutputStream_iconv()
 {
 	if (m_desc != NULL)
 	{
-		// Close iconv handle
-		iconv_close(*static_cast <iconv_t*>(m_desc));
+		// Release iconv handle
+		iconvDescriptorCache::getInstance().release(m_sourceCharset, m_destCharset, *static_cast <iconv_t*>(m_desc));
 
 		delete static_cast <iconv_t*>(m_desc);
 		m_desc = NULL;
@@ -0,0 +1,379 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "vmime/charsetConverter_utf8.hpp"
+
+#include "vmime/exception.hpp"
+
+#include "vmime/utility/stringUtils.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+
+namespace
+{
+
+
+// Unicode code points for bytes 0x80-0x9F in Windows-1252 (0 if undefined);
+// other bytes have the same value as in ISO-8859-1
+const unsigned int WINDOWS_1252_C1_CHARS[32] =
+{
+	0x20AC, 0,      0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+	0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0,      0x017D, 0,
+	0,      0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+	0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0,      0x017E, 0x0178
+};
+
+
+// Returns the number of ASCII bytes at the beginning of the buffer
+inline vmime::size_t countASCIIBytes(const vmime::byte_t* p, const vmime::size_t length)
+{
+	vmime::size_t i = 0;
+
+#if defined(__SSE2__)
+
+	// Test 16 bytes at a time: a byte is not ASCII if its high bit is set
+	for ( ; i + 16 <= length ; i += 16)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast <const __m128i*>(p + i));
+		const int mask = _mm_movemask_epi8(v);
+
+		if (mask != 0)
+			return i + static_cast <vmime::size_t>(__builtin_ctz(static_cast <unsigned int>(mask)));
+	}
+
+#endif // defined(__SSE2__)
+
+	// Test a machine word at a time
+	typedef vmime::size_t word_t;
+	const word_t highBits = (static_cast <word_t>(-1) / 0xFF) * 0x80;
+
+	for ( ; i + sizeof(word_t) <= length ; i += sizeof(word_t))
+	{
+		word_t w;
+		std::copy(p + i, p + i + sizeof(word_t), reinterpret_cast <vmime::byte_t*>(&w));
+
+		if (w & highBits)
+			break;
+	}
+
+	while (i < length && p[i] < 0x80)
+		++i;
+
+	return i;
+}
+
+
+inline void appendUTF8(vmime::string& out, const unsigned int c)
+{
+	if (c < 0x800)
+	{
+		out += static_cast <char>(0xC0 | (c >> 6));
+		out += static_cast <char>(0x80 | (c & 0x3F));
+	}
+	else
+	{
+		out += static_cast <char>(0xE0 | (c >> 12));
+		out += static_cast <char>(0x80 | ((c >> 6) & 0x3F));
+		out += static_cast <char>(0x80 | (c & 0x3F));
+	}
+}
+
+
+// Returns the length of the well-formed UTF-8 sequence at the beginning
+// of the buffer (see RFC 3629), 0 if it is invalid, or npos if it is
+// valid but truncated by the end of the buffer
+vmime::size_t checkUTF8Sequence(const vmime::byte_t* p, const vmime::size_t length)
+{
+	const vmime::byte_t c = p[0];
+
+	vmime::size_t seqLength = 0;
+	vmime::byte_t min = 0x80, max = 0xBF;  // range for second byte
+
+	if (c >= 0xC2 && c <= 0xDF)
+	{
+		seqLength = 2;
+	}
+	else if (c >= 0xE0 && c <= 0xEF)
+	{
+		seqLength = 3;
+
+		if (c == 0xE0)
+			min = 0xA0;  // overlong
+		else if (c == 0xED)
+			max = 0x9F;  // surrogates
+	}
+	else if (c >= 0xF0 && c <= 0xF4)
+	{
+		seqLength = 4;
+
+		if (c == 0xF0)
+			min = 0x90;  // overlong
+		else if (c == 0xF4)
+			max = 0x8F;  // > U+10FFFF
+	}
+	else
+	{
+		return 0;
+	}
+
+	for (vmime::size_t i = 1 ; i < seqLength ; ++i)
+	{
+		if (i >= length)
+			return vmime::npos;
+
+		if (p[i] < min || p[i] > max)
+			return 0;
+
+		min = 0x80;
+		max = 0xBF;
+	}
+
+	return seqLength;
+}
+
+
+bool isCharset(const vmime::charset& ch, const char* const name)
+{
+	const vmime::string& chName = ch.getName();
+	const vmime::size_t nameLength = std::strlen(name);
+
+	return chName.length() == nameLength &&
+	       vmime::utility::stringUtils::isStringEqualNoCase(chName, name, nameLength);
+}
+
+
+} // namespace
+
+
+namespace vmime
+{
+
+
+charsetConverter_utf8::charsetConverter_utf8
+	(const charset& source, const charset& dest, const charsetConverterOptions& opts)
+	: m_source(source), m_dest(dest), m_sourceType(SOURCE_UTF_8), m_options(opts)
+{
+	if (isCharset(source, charsets::US_ASCII) || isCharset(source, "ascii"))
+		m_sourceType = SOURCE_US_ASCII;
+	else if (isCharset(source, charsets::ISO8859_1) || isCharset(source, "latin1"))
+		m_sourceType = SOURCE_ISO_8859_1;
+	else if (isCharset(source, charsets::WINDOWS_1252) || isCharset(source, charsets::CP_1252))
+		m_sourceType = SOURCE_WINDOWS_1252;
+}
+
+
+charsetConverter_utf8::~charsetConverter_utf8()
+{
+}
+
+
+// static
+bool charsetConverter_utf8::isSupported(const charset& source, const charset& dest)
+{
+	if (!isCharset(dest, charsets::UTF_8) && !isCharset(dest, "utf8"))
+		return false;
+
+	return isCharset(source, charsets::UTF_8) || isCharset(source, "utf8") ||
+	       isCharset(source, charsets::US_ASCII) || isCharset(source, "ascii") ||
+	       isCharset(source, charsets::ISO8859_1) || isCharset(source, "latin1") ||
+	       isCharset(source, charsets::WINDOWS_1252) || isCharset(source, charsets::CP_1252);
+}
+
+
+size_t charsetConverter_utf8::convertBlock
+	(const byte_t* in, const size_t length, string& out, const bool final, status* st)
+{
+	const size_t outStart = out.length();
+	size_t pos = 0;
+
+	while (pos < length)
+	{
+		// ASCII is the same in all supported charsets: copy runs as-is
+		const size_t asciiLength = countASCIIBytes(in + pos, length - pos);
+
+		if (asciiLength != 0)
+		{
+			out.append(reinterpret_cast <const char*>(in + pos), asciiLength);
+
+			if ((pos += asciiLength) == length)
+				break;
+		}
+
+		const byte_t c = in[pos];
+		size_t seqLength = 0;  // 0 if sequence is invalid
+
+		switch (m_sourceType)
+		{
+		case SOURCE_US_ASCII:
+
+			break;
+
+		case SOURCE_ISO_8859_1:
+
+			appendUTF8(out, c);
+			seqLength = 1;
+
+			break;
+
+		case SOURCE_WINDOWS_1252:
+		{
+			const unsigned int uc = (c < 0xA0 ? WINDOWS_1252_C1_CHARS[c - 0x80] : c);
+
+			if (uc != 0)
+			{
+				appendUTF8(out, uc);
+				seqLength = 1;
+			}
+
+			break;
+		}
+		case SOURCE_UTF_8:
+
+			seqLength = checkUTF8Sequence(in + pos, length - pos);
+
+			if (seqLength == npos)
+			{
+				// Truncated sequence: wait for more bytes, if any
+				if (!final)
+				{
+					if (st)
+					{
+						st->inputBytesRead += pos;
+						st->outputBytesWritten += out.length() - outStart;
+					}
+
+					return pos;
+				}
+
+				seqLength = 0;
+			}
+			else if (seqLength != 0)
+			{
+				out.append(reinterpret_cast <const char*>(in + pos), seqLength);
+			}
+
+			break;
+		}
+
+		if (seqLength == 0)
+		{
+			if (!m_options.silentlyReplaceInvalidSequences)
+			{
+				if (st)
+				{
+					st->inputBytesRead += pos;
+					st->outputBytesWritten += out.length() - outStart;
+				}
+
+				throw exceptions::illegal_byte_sequence_for_charset();
+			}
+
+			// Output a special character to indicate we don't known how to
+			// convert the sequence at this position, and skip a byte
+			out += m_options.invalidSequence;
+			seqLength = 1;
+		}
+
+		pos += seqLength;
+	}
+
+	if (st)
+	{
+		st->inputBytesRead += pos;
+		st->outputBytesWritten += out.length() - outStart;
+	}
+
+	return pos;
+}
+
+
+void charsetConverter_utf8::convert(const string& in, string& out, status* st)
+{
+	if (st)
+		new (st) status();
+
+	out.clear();
+	out.reserve(in.length() + in.length() / 8);
+
+	convertBlock(reinterpret_cast <const byte_t*>(in.data()), in.length(), out, true, st);
+}
+
+
+void charsetConverter_utf8::convert(utility::inputStream& in, utility::outputStream& out, status* st)
+{
+	if (st)
+		new (st) status();
+
+	byte_t buffer[32768];
+	size_t bufferLength = 0;
+
+	string outBuffer;
+
+	while (true)
+	{
+		bufferLength += in.read(buffer + bufferLength, sizeof(buffer) - bufferLength);
+
+		const bool final = in.eof();
+
+		outBuffer.clear();
+
+		size_t converted = 0;
+
+		try
+		{
+			converted = convertBlock(buffer, bufferLength, outBuffer, final, st);
+		}
+		catch (exceptions::illegal_byte_sequence_for_charset&)
+		{
+			// Write successfully converted bytes
+			out.write(outBuffer.data(), outBuffer.length());
+			throw;
+		}
+
+		out.write(outBuffer.data(), outBuffer.length());
+
+		if (final)
+			break;
+
+		// Leave unconverted bytes (truncated sequence) in the input buffer
+		std::copy(buffer + converted, buffer + bufferLength, buffer);
+		bufferLength -= converted;
+	}
+}
+
+
+shared_ptr <utility::charsetFilteredOutputStream> charsetConverter_utf8::getFilteredOutputStream
+	(utility::outputStream& os, const charsetConverterOptions& opts)
+{
+	// Not needed on hot paths: use the generic converter
+	return createGenericConverter(m_source, m_dest, m_options)->getFilteredOutputStream(os, opts);
+}
+
+
+} // vmime
@@ -0,0 +1,107 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_CHARSETCONVERTER_UTF8_HPP_INCLUDED
+#define VMIME_CHARSETCONVERTER_UTF8_HPP_INCLUDED
+
+
+#include "vmime/charsetConverter.hpp"
+
+
+namespace vmime
+{
+
+
+/** A built-in charset converter for the most common conversions
+  * to UTF-8 (from US-ASCII, ISO-8859-1, Windows-1252 and UTF-8),
+  * which does not need to go through iconv or ICU.
+  */
+
+class charsetConverter_utf8 : public charsetConverter
+{
+public:
+
+	/** Construct and initialize a built-in UTF-8 charset converter.
+	  *
+	  * @param source input charset
+	  * @param dest output charset
+	  * @param opts conversion options
+	  */
+	charsetConverter_utf8(const charset& source, const charset& dest,
+		const charsetConverterOptions& opts = charsetConverterOptions());
+
+	~charsetConverter_utf8();
+
+	void convert(const string& in, string& out, status* st = NULL);
+	void convert(utility::inputStream& in, utility::outputStream& out, status* st = NULL);
+
+	shared_ptr <utility::charsetFilteredOutputStream> getFilteredOutputStream
+		(utility::outputStream& os,
+		 const charsetConverterOptions& opts = charsetConverterOptions());
+
+	/** Tests whether a conversion is handled by this converter.
+	  *
+	  * @param source input charset
+	  * @param dest output charset
+	  * @return true if this converter can be used for the conversion,
+	  * false otherwise
+	  */
+	static bool isSupported(const charset& source, const charset& dest);
+
+private:
+
+	/** Converts a block of bytes and appends the result to a string.
+	  *
+	  * @param in input bytes
+	  * @param length number of input bytes
+	  * @param out string to which converted bytes are appended
+	  * @param final if false, an incomplete UTF-8 sequence at the end
+	  * of the block is left unconverted (more bytes may follow)
+	  * @param st status to update (can be NULL)
+	  * @return number of input bytes converted
+	  */
+	size_t convertBlock(const byte_t* in, const size_t length, string& out,
+		const bool final, status* st);
+
+
+	enum SourceType
+	{
+		SOURCE_US_ASCII,
+		SOURCE_ISO_8859_1,
+		SOURCE_WINDOWS_1252,
+		SOURCE_UTF_8
+	};
+
+	charset m_source;
+	charset m_dest;
+
+	SourceType m_sourceType;
+
+	charsetConverterOptions m_options;
+};
+
+
+} // vmime
+
+
+#endif // VMIME_CHARSETCONVERTER_UTF8_HPP_INCLUDED
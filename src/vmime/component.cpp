@@ -71,7 +71,17 @@ void component::parse
 	shared_ptr <utility::seekableInputStream> seekableStream =
 		dynamicCast <utility::seekableInputStream>(inputStream);
 
-	if (seekableStream == NULL || end == 0)
+	// When parsing a sub-component (eg. a body part), reuse the parser
+	// of the parent component instead of stacking another adapter on it:
+	// this keeps its read-ahead window and the positions it has indexed
+	shared_ptr <utility::parserInputStreamAdapter> parentParser =
+		dynamicCast <utility::parserInputStreamAdapter>(inputStream);
+
+	if (parentParser && end != 0)
+	{
+		parseImpl(ctx, parentParser, position, end, newPosition);
+	}
+	else if (seekableStream == NULL || end == 0)
 	{
 		// Read the whole stream into a buffer
 		std::ostringstream oss;
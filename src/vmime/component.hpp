@@ -221,6 +221,12 @@ protected:
 
 	void setParsedBounds(const size_t start, const size_t end);
 
+	/** Shifts the parsed bounds of this component and its children.
+	  *
+	  * @param offset offset to add to the parsed bounds
+	  */
+	virtual void offsetParsedBounds(const size_t offset);
+
 	// AT LEAST ONE of these parseImpl() functions MUST be implemented in derived class
 	virtual void parseImpl
 		(const parsingContext& ctx,
@@ -244,8 +250,6 @@ protected:
 
 private:
 
-	void offsetParsedBounds(const size_t offset);
-
 	size_t m_parsedOffset;
 	size_t m_parsedLength;
 };
@@ -62,6 +62,65 @@ field-body-contents =
 		 specials tokens, or else consisting of texts>
 */
 
+void header::parseImpl
+	(const parsingContext& ctx, shared_ptr <utility::parserInputStreamAdapter> parser,
+	 const size_t position, const size_t end, size_t* newPosition)
+{
+	// Header parsing always stops at the first empty line, so only extract
+	// the header block instead of the whole part contents
+	component::parseImpl(ctx, parser, position, findHeaderEnd(parser, position, end), newPosition);
+}
+
+
+// static
+size_t header::findHeaderEnd
+	(shared_ptr <utility::parserInputStreamAdapter> parser,
+	 const size_t position, const size_t end)
+{
+	const size_t initialPos = parser->getPosition();
+
+	size_t headerEnd = end;
+	size_t pos = position;
+
+	// Empty header
+	parser->seek(position);
+
+	if (position < end && parser->peekByte() == '\n')
+	{
+		headerEnd = position + 1;
+	}
+	else if (position + 1 < end && parser->matchBytes("\r\n", 2))
+	{
+		headerEnd = position + 2;
+	}
+	else
+	{
+		// Find the first LF followed by LF or CRLF
+		while ((pos = parser->findNext("\n", pos)) != npos && pos + 1 < end)
+		{
+			parser->seek(pos + 1);
+
+			if (parser->peekByte() == '\n')
+			{
+				headerEnd = pos + 2;
+				break;
+			}
+			else if (pos + 2 < end && parser->matchBytes("\r\n", 2))
+			{
+				headerEnd = pos + 3;
+				break;
+			}
+
+			++pos;
+		}
+	}
+
+	parser->seek(initialPos);
+
+	return headerEnd;
+}
+
+
 void header::parseImpl
 	(const parsingContext& ctx, const string& buffer, const size_t position,
 	 const size_t end, size_t* newPosition)
@@ -70,14 +129,25 @@ void header::parseImpl
 
 	removeAllFields();
 
+	// With lazy parsing, the fields only record where their value is:
+	// they share the context and a copy of the header block
+	shared_ptr <headerField::deferredInput> input;
+
+	if (ctx.getLazyHeaderFieldParsing())
+		input = make_shared <headerField::deferredInput>(ctx, position);
+
 	while (pos < end)
 	{
-		shared_ptr <headerField> field = headerField::parseNext(ctx, buffer, pos, end, &pos);
+		shared_ptr <headerField> field = headerField::parseNext(ctx, buffer, pos, end, &pos, input);
 		if (field == NULL) break;
 
 		m_fields.push_back(field);
 	}
 
+	// The end of the header block is only known now
+	if (input)
+		input->buffer.assign(buffer.begin() + position, buffer.begin() + pos);
+
 	setParsedBounds(position, pos);
 
 	if (newPosition)
@@ -155,8 +225,7 @@ header& header::operator=(const header& other)
 bool header::hasField(const string& fieldName) const
 {
 	std::vector <shared_ptr <headerField> >::const_iterator pos =
-		std::find_if(m_fields.begin(), m_fields.end(),
-		             fieldHasName(utility::stringUtils::toLower(fieldName)));
+		std::find_if(m_fields.begin(), m_fields.end(), fieldHasName(fieldName));
 
 	return (pos != m_fields.end());
 }
@@ -166,8 +235,7 @@ shared_ptr <headerField> header::findField(const string& fieldName) const
 {
 	// Find the first field that matches the specified name
 	std::vector <shared_ptr <headerField> >::const_iterator pos =
-		std::find_if(m_fields.begin(), m_fields.end(),
-		             fieldHasName(utility::stringUtils::toLower(fieldName)));
+		std::find_if(m_fields.begin(), m_fields.end(), fieldHasName(fieldName));
 
 	// No field with this name can be found
 	if (pos == m_fields.end())
@@ -183,8 +251,7 @@ std::vector <shared_ptr <headerField> > header::findAllFields(const string& fiel
 	std::vector <shared_ptr <headerField> > result;
 	std::back_insert_iterator <std::vector <shared_ptr <headerField> > > back(result);
 
-	std::remove_copy_if(m_fields.begin(), m_fields.end(), back,
-	                    fieldHasNotName(utility::stringUtils::toLower(fieldName)));
+	std::remove_copy_if(m_fields.begin(), m_fields.end(), back, fieldHasNotName(fieldName));
 
 	return result;
 }
@@ -192,17 +259,12 @@ std::vector <shared_ptr <headerField> > header::findAllFields(const string& fiel
 
 shared_ptr <headerField> header::getField(const string& fieldName)
 {
-	const string name = utility::stringUtils::toLower(fieldName);
-
 	// Find the first field that matches the specified name
-	std::vector <shared_ptr <headerField> >::const_iterator pos = m_fields.begin();
-	const std::vector <shared_ptr <headerField> >::const_iterator end = m_fields.end();
-
-	while (pos != end && utility::stringUtils::toLower((*pos)->getName()) != name)
-		++pos;
+	std::vector <shared_ptr <headerField> >::const_iterator pos =
+		std::find_if(m_fields.begin(), m_fields.end(), fieldHasName(fieldName));
 
 	// If no field with this name can be found, create a new one
-	if (pos == end)
+	if (pos == m_fields.end())
 	{
 		shared_ptr <headerField> field = headerFieldFactory::getInstance()->create(fieldName);
 
@@ -363,25 +425,28 @@ const std::vector <shared_ptr <component> > header::getChildComponents()
 // Field search
 
 
+// Fields cache the hash of their name, so most fields are rejected by
+// comparing hashes only, without building lower-case copies of the names
+
 header::fieldHasName::fieldHasName(const string& name)
-	: m_name(name)
+	: m_name(name), m_nameHash(headerField::hashName(name))
 {
 }
 
-bool header::fieldHasName::operator() (const shared_ptr <const headerField>& field)
+bool header::fieldHasName::operator() (const shared_ptr <headerField>& field) const
 {
-	return utility::stringUtils::toLower(field->getName()) == m_name;
+	return field->hasName(m_name, m_nameHash);
 }
 
 
 header::fieldHasNotName::fieldHasNotName(const string& name)
-	: m_name(name)
+	: m_name(name), m_nameHash(headerField::hashName(name))
 {
 }
 
-bool header::fieldHasNotName::operator() (const shared_ptr <const headerField>& field)
+bool header::fieldHasNotName::operator() (const shared_ptr <headerField>& field) const
 {
-	return utility::stringUtils::toLower(field->getName()) != m_name;
+	return !field->hasName(m_name, m_nameHash);
 }
 
 
@@ -303,11 +303,12 @@ private:
 	public:
 
 		fieldHasName(const string& name);
-		bool operator() (const shared_ptr <const headerField>& field);
+		bool operator() (const shared_ptr <headerField>& field) const;
 
 	private:
 
-		string m_name;
+		const string& m_name;
+		const unsigned int m_nameHash;
 	};
 
 	class fieldHasNotName
@@ -315,16 +316,37 @@ private:
 	public:
 
 		fieldHasNotName(const string& name);
-		bool operator() (const shared_ptr <const headerField>& field);
+		bool operator() (const shared_ptr <headerField>& field) const;
 
 	private:
 
-		string m_name;
+		const string& m_name;
+		const unsigned int m_nameHash;
 	};
 
+	/** Finds the end of the header block, ie. the position just after
+	  * the first empty line.
+	  *
+	  * @param parser parser object
+	  * @param position start position
+	  * @param end end position
+	  * @return position of the first byte following the empty line, or
+	  * 'end' if no empty line was found
+	  */
+	static size_t findHeaderEnd
+		(shared_ptr <utility::parserInputStreamAdapter> parser,
+		 const size_t position, const size_t end);
+
 protected:
 
 	// Component parsing & assembling
+	void parseImpl
+		(const parsingContext& ctx,
+		 shared_ptr <utility::parserInputStreamAdapter> parser,
+		 const size_t position,
+		 const size_t end,
+		 size_t* newPosition = NULL);
+
 	void parseImpl
 		(const parsingContext& ctx,
 		 const string& buffer,
@@ -28,19 +28,23 @@
 
 #include "vmime/exception.hpp"
 
+#include "vmime/utility/outputStreamByteCounter.hpp"
+
 
 namespace vmime
 {
 
 
 headerField::headerField()
-	: m_name("X-Undefined")
+	: m_name("X-Undefined"), m_nameHash(hashName(m_name)),
+	  m_deferredValueStart(0), m_deferredValueEnd(0), m_deferredValueOffset(0)
 {
 }
 
 
 headerField::headerField(const string& fieldName)
-	: m_name(fieldName)
+	: m_name(fieldName), m_nameHash(hashName(m_name)),
+	  m_deferredValueStart(0), m_deferredValueEnd(0), m_deferredValueOffset(0)
 {
 }
 
@@ -64,6 +68,11 @@ void headerField::copyFrom(const component& other)
 {
 	const headerField& hf = dynamic_cast <const headerField&>(other);
 
+	hf.parseDeferredValue();
+
+	// Our own raw value (if any) is replaced
+	m_deferredInput = null;
+
 	m_value->copyFrom(*hf.m_value);
 }
 
@@ -78,6 +87,15 @@ headerField& headerField::operator=(const headerField& other)
 shared_ptr <headerField> headerField::parseNext
 	(const parsingContext& ctx, const string& buffer, const size_t position,
 	 const size_t end, size_t* newPosition)
+{
+	return parseNext(ctx, buffer, position, end, newPosition, null);
+}
+
+
+// static
+shared_ptr <headerField> headerField::parseNext
+	(const parsingContext& ctx, const string& buffer, const size_t position,
+	 const size_t end, size_t* newPosition, shared_ptr <const deferredInput> input)
 {
 	size_t pos = position;
 
@@ -175,7 +193,11 @@ shared_ptr <headerField> headerField::parseNext
 				// Return a new field
 				shared_ptr <headerField> field = headerFieldFactory::getInstance()->create(name);
 
-				field->parse(ctx, buffer, contentsStart, contentsEnd, NULL);
+				if (input)
+					field->deferValueParsing(input, contentsStart, contentsEnd);
+				else
+					field->parse(ctx, buffer, contentsStart, contentsEnd, NULL);
+
 				field->setParsedBounds(nameStart, pos);
 
 				if (newPosition)
@@ -226,7 +248,68 @@ void headerField::parseImpl
 	(const parsingContext& ctx, const string& buffer, const size_t position,
 	 const size_t end, size_t* newPosition)
 {
-	m_value->parse(ctx, buffer, position, end, newPosition);
+	m_deferredInput = null;
+
+	parseValue(ctx, buffer, position, end, 0);
+
+	if (newPosition)
+		*newPosition = end;
+}
+
+
+void headerField::parseValue
+	(const parsingContext& ctx, const string& buffer,
+	 const size_t position, const size_t end, const size_t offset) const
+{
+	m_value->parse(ctx, buffer, position, end, NULL);
+
+	if (offset != 0)
+		m_value->offsetParsedBounds(offset);
+}
+
+
+void headerField::deferValueParsing
+	(shared_ptr <const deferredInput> input, const size_t position, const size_t end)
+{
+	m_deferredInput = input;
+	m_deferredValueStart = position - input->position;
+	m_deferredValueEnd = end - input->position;
+	m_deferredValueOffset = input->position;
+}
+
+
+void headerField::parseDeferredValue() const
+{
+	if (!m_deferredInput)
+		return;
+
+	// Parsing does not change the logical state of the field: it only
+	// materializes the value, so it is allowed on a const object
+	shared_ptr <const deferredInput> input = m_deferredInput;
+	m_deferredInput = null;
+
+	// Value is parsed from the copy of the header block: its bounds are
+	// shifted so that they are relative to the original buffer
+	parseValue(input->ctx, input->buffer, m_deferredValueStart,
+		m_deferredValueEnd, m_deferredValueOffset);
+}
+
+
+void headerField::offsetParsedBounds(const size_t offset)
+{
+	if (m_deferredInput)
+	{
+		// Value not parsed yet: shift the field bounds, and remember the
+		// offset to apply to the value once it is parsed
+		if (getParsedLength() != 0)
+			setParsedBounds(getParsedOffset() + offset, getParsedOffset() + getParsedLength() + offset);
+
+		m_deferredValueOffset += offset;
+	}
+	else
+	{
+		component::offsetParsedBounds(offset);
+	}
 }
 
 
@@ -234,6 +317,8 @@ void headerField::generateImpl
 	(const generationContext& ctx, utility::outputStream& os,
 	 const size_t curLinePos, size_t* newLinePos) const
 {
+	parseDeferredValue();
+
 	os << m_name + ": ";
 
 	m_value->generate(ctx, os, curLinePos + m_name.length() + 2, newLinePos);
@@ -242,7 +327,13 @@ void headerField::generateImpl
 
 size_t headerField::getGeneratedSize(const generationContext& ctx)
 {
-	return m_name.length() + 2 /* ": " */ + m_value->getGeneratedSize(ctx);
+	// Value folding depends on the position after the field name, so
+	// the size is only exact if the field is generated as a whole
+	utility::outputStreamByteCounter counter;
+
+	generate(ctx, counter);
+
+	return counter.getCount();
 }
 
 
@@ -255,6 +346,7 @@ const string headerField::getName() const
 void headerField::setName(const string& name)
 {
 	m_name = name;
+	m_nameHash = hashName(name);
 }
 
 
@@ -264,8 +356,47 @@ bool headerField::isCustom() const
 }
 
 
+bool headerField::hasName(const string& name) const
+{
+	return hasName(name, hashName(name));
+}
+
+
+bool headerField::hasName(const string& name, const unsigned int nameHash) const
+{
+	if (nameHash != m_nameHash || name.length() != m_name.length())
+		return false;
+
+	for (size_t i = 0, n = name.length() ; i < n ; ++i)
+	{
+		if (parserHelpers::toLower(name[i]) != parserHelpers::toLower(m_name[i]))
+			return false;
+	}
+
+	return true;
+}
+
+
+// static
+unsigned int headerField::hashName(const string& name)
+{
+	// FNV-1a hash of the lower-case name
+	unsigned int hash = 2166136261u;
+
+	for (size_t i = 0, n = name.length() ; i < n ; ++i)
+	{
+		hash ^= static_cast <unsigned char>(parserHelpers::toLower(name[i]));
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+
 const std::vector <shared_ptr <component> > headerField::getChildComponents()
 {
+	parseDeferredValue();
+
 	std::vector <shared_ptr <component> > list;
 
 	if (m_value)
@@ -277,12 +408,16 @@ const std::vector <shared_ptr <component> > headerField::getChildComponents()
 
 shared_ptr <const headerFieldValue> headerField::getValue() const
 {
+	parseDeferredValue();
+
 	return m_value;
 }
 
 
 shared_ptr <headerFieldValue> headerField::getValue()
 {
+	parseDeferredValue();
+
 	return m_value;
 }
 
@@ -292,6 +427,8 @@ void headerField::setValue(shared_ptr <headerFieldValue> value)
 	if (!headerFieldFactory::getInstance()->isValueTypeValid(*this, *value))
 		throw exceptions::bad_field_value_type(getName());
 
+	parseDeferredValue();
+
 	if (value != NULL)
 		m_value = value;
 }
@@ -302,6 +439,8 @@ void headerField::setValueConst(shared_ptr <const headerFieldValue> value)
 	if (!headerFieldFactory::getInstance()->isValueTypeValid(*this, *value))
 		throw exceptions::bad_field_value_type(getName());
 
+	parseDeferredValue();
+
 	m_value = vmime::clone(value);
 }
 
@@ -311,6 +450,8 @@ void headerField::setValue(const headerFieldValue& value)
 	if (!headerFieldFactory::getInstance()->isValueTypeValid(*this, value))
 		throw exceptions::bad_field_value_type(getName());
 
+	parseDeferredValue();
+
 	m_value = vmime::clone(value);
 }
 
@@ -78,6 +78,14 @@ public:
 	  */
 	bool isCustom() const;
 
+	/** Check whether this field has the specified name.
+	  * Field name is case-insensitive.
+	  *
+	  * @param name field name (eg: "From" or "X-MyField")
+	  * @return true if the field has the specified name, false otherwise
+	  */
+	bool hasName(const string& name) const;
+
 	/** Return the read-only value object attached to this field.
 	  *
 	  * @return read-only value object
@@ -92,6 +100,7 @@ public:
 	template <typename T>
 	shared_ptr <const T> getValue() const
 	{
+		parseDeferredValue();
 		return dynamicCast <const T>(m_value);
 	}
 
@@ -109,6 +118,7 @@ public:
 	template <typename T>
 	shared_ptr <T> getValue()
 	{
+		parseDeferredValue();
 		return dynamicCast <T>(m_value);
 	}
 
@@ -144,7 +154,9 @@ public:
 	void setValue(const string& value);
 
 
-	/** Parse a header field from a buffer.
+	/** Parse a header field from a buffer. The value of the field is
+	  * parsed immediately: lazy parsing (see parsingContext) only applies
+	  * when parsing a whole header.
 	  *
 	  * @param ctx parsing context
 	  * @param buffer input buffer
@@ -178,9 +190,107 @@ protected:
 		 const size_t curLinePos = 0,
 		 size_t* newLinePos = NULL) const;
 
+	void offsetParsedBounds(const size_t offset);
+
+	/** Input shared by the fields of a header whose values are parsed
+	  * lazily: the parsing context, and a copy of the header block.
+	  */
+	struct deferredInput
+	{
+		deferredInput(const parsingContext& ctx, const size_t position)
+			: ctx(ctx), position(position)
+		{
+		}
+
+		parsingContext ctx;
+		string buffer;
+		size_t position;   // position of the copied block in the input buffer
+	};
+
+	/** Parse a header field from a buffer, deferring the parsing of its
+	  * value if 'input' is not NULL.
+	  *
+	  * @param ctx parsing context
+	  * @param buffer input buffer
+	  * @param position current position in the input buffer
+	  * @param end end position in the input buffer
+	  * @param newPosition will receive the new position in the input buffer
+	  * @param input input the value will be parsed from later, or NULL
+	  * to parse the value immediately
+	  * @return parsed header field, or NULL if no more header field can be parsed
+	  * in the input buffer
+	  */
+	static shared_ptr <headerField> parseNext
+		(const parsingContext& ctx,
+		 const string& buffer,
+		 const size_t position,
+		 const size_t end,
+		 size_t* newPosition,
+		 shared_ptr <const deferredInput> input);
+
+	/** Records the location of the raw value of this field, to be
+	  * parsed later by parseDeferredValue().
+	  *
+	  * @param input input the value will be parsed from
+	  * @param position start position of the value in the input buffer
+	  * @param end end position of the value in the input buffer
+	  */
+	void deferValueParsing
+		(shared_ptr <const deferredInput> input,
+		 const size_t position,
+		 const size_t end);
+
+	/** Parses the value of this field (and any data parsed along with
+	  * it). This may be called on first access to a deferred value, so
+	  * parsed data must be held by the value object or mutable members.
+	  *
+	  * @param ctx parsing context
+	  * @param buffer input buffer
+	  * @param position start position of the value in the input buffer
+	  * @param end end position of the value in the input buffer
+	  * @param offset offset to add to the parsed bounds, if the input
+	  * buffer is a part of the buffer the field was parsed from
+	  */
+	virtual void parseValue
+		(const parsingContext& ctx,
+		 const string& buffer,
+		 const size_t position,
+		 const size_t end,
+		 const size_t offset) const;
+
+	/** Parses the raw value stored by deferValueParsing(), if any.
+	  * This must be called before accessing the value (or any other
+	  * parsed data) of the field.
+	  */
+	void parseDeferredValue() const;
+
+	/** Computes a case-insensitive hash of a field name.
+	  *
+	  * @param name field name
+	  * @return hash value
+	  */
+	static unsigned int hashName(const string& name);
+
+	/** Check whether this field has the specified name, given its
+	  * hash as returned by hashName(). Field name is case-insensitive.
+	  *
+	  * @param name field name
+	  * @param nameHash hash of the field name
+	  * @return true if the field has the specified name, false otherwise
+	  */
+	bool hasName(const string& name, const unsigned int nameHash) const;
+
 
 	string m_name;
+	unsigned int m_nameHash;
 	shared_ptr <headerFieldValue> m_value;
+
+	// Input and location of the raw value, if the value has not been parsed
+	// yet (it is parsed on first access, which may be through a const object)
+	mutable shared_ptr <const deferredInput> m_deferredInput;
+	size_t m_deferredValueStart;
+	size_t m_deferredValueEnd;
+	size_t m_deferredValueOffset;
 };
 
 
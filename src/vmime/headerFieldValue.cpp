@@ -23,7 +23,7 @@
 
 #include "vmime/headerFieldValue.hpp"
 
-#include "vmime/utility/outputStreamAdapter.hpp"
+#include "vmime/utility/outputStreamByteCounter.hpp"
 
 
 namespace vmime
@@ -32,12 +32,11 @@ namespace vmime
 
 size_t headerFieldValue::getGeneratedSize(const generationContext& ctx)
 {
-	std::ostringstream oss;
-	utility::outputStreamAdapter osa(oss);
+	utility::outputStreamByteCounter counter;
 
-	generate(ctx, osa);
+	generate(ctx, counter);
 
-	return oss.str().length();
+	return counter.getCount();
 }
 
 
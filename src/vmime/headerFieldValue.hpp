@@ -39,6 +39,8 @@ namespace vmime
 
 class VMIME_EXPORT headerFieldValue : public component
 {
+	friend class headerField;
+
 public:
 
 	size_t getGeneratedSize(const generationContext& ctx);
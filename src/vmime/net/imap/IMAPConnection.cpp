@@ -523,6 +523,7 @@ void IMAPConnection::startTLS()
 		shared_ptr <tls::TLSSocket> tlsSocket =
 			tlsSession->getSocket(m_socket);
 
+		tlsSocket->setServer(m_cntInfos->getHost(), m_cntInfos->getPort());
 		tlsSocket->handshake();
 
 		m_socket = tlsSocket;
@@ -695,6 +696,9 @@ void IMAPConnection::disconnect()
 
 void IMAPConnection::internalDisconnect()
 {
+	// Responses to pending commands will never be read
+	clearQueuedCommands();
+
 	if (isConnected())
 	{
 		IMAPCommand::LOGOUT()->send(dynamicCast <IMAPConnection>(shared_from_this()));
@@ -755,14 +759,23 @@ void IMAPConnection::initHierarchySeparator()
 
 
 void IMAPConnection::sendCommand(shared_ptr <IMAPCommand> cmd)
+{
+	// The response to this command can only be read once the
+	// responses to the commands sent before have been read
+	if (!m_queuedCommands.empty())
+		processQueuedCommands();
+
+	writeCommand(cmd);
+}
+
+
+void IMAPConnection::writeCommand(shared_ptr <IMAPCommand> cmd)
 {
 	if (!m_firstTag)
 		++(*m_tag);
 
-	m_socket->send(*m_tag);
-	m_socket->send(" ");
-	m_socket->send(cmd->getText());
-	m_socket->send("\r\n");
+	// Send the whole command line at once
+	m_socket->send(string(*m_tag) + " " + cmd->getText() + "\r\n");
 
 	m_firstTag = false;
 
@@ -782,9 +795,157 @@ void IMAPConnection::sendRaw(const byte_t* buffer, const size_t count)
 }
 
 
-IMAPParser::response* IMAPConnection::readResponse(IMAPParser::literalHandler* lh)
+IMAPParser::response* IMAPConnection::readResponse
+	(IMAPParser::literalHandler* lh, IMAPParser::responseHandler* rh)
 {
-	return (m_parser->readResponse(lh));
+	return (m_parser->readResponse(lh, rh));
+}
+
+
+void IMAPConnection::queueCommand(shared_ptr <IMAPCommand> cmd,
+	commandResponseHandler* handler, IMAPParser::responseHandler* rh)
+{
+	// Limit the number of commands in flight: if we do not read the
+	// responses, the server may stop reading our commands while we
+	// are still sending them
+	static const size_t MAX_QUEUED_COMMANDS = 64;
+
+	try
+	{
+		while (m_queuedCommands.size() >= MAX_QUEUED_COMMANDS)
+			processNextQueuedResponse();
+
+		writeCommand(cmd);
+	}
+	catch (...)
+	{
+		// The caller will not process the queue: do not keep the handlers
+		// of the commands already sent, as they may no longer exist when
+		// the queue is processed
+		clearQueuedCommands();
+		throw;
+	}
+
+	queuedCommand qcmd;
+	qcmd.tag = string(*m_tag);
+	qcmd.command = cmd;
+	qcmd.handler = handler;
+	qcmd.dataHandler = rh;
+
+	m_queuedCommands.push_back(qcmd);
+
+	updatePendingTags();
+}
+
+
+void IMAPConnection::processQueuedCommands()
+{
+	while (!m_queuedCommands.empty())
+		processNextQueuedResponse();
+
+	if (m_queuedCommandError.get())
+	{
+		const exceptions::command_error error(*m_queuedCommandError);
+		m_queuedCommandError.reset();
+
+		throw error;
+	}
+}
+
+
+size_t IMAPConnection::getQueuedCommandCount() const
+{
+	return m_queuedCommands.size();
+}
+
+
+void IMAPConnection::processNextQueuedResponse()
+{
+	// Untagged data is passed to the handler of the oldest command, as
+	// servers generally complete pipelined commands in order
+	std::auto_ptr <IMAPParser::response> resp;
+
+	try
+	{
+		resp.reset(m_parser->readResponse
+			(/* literalHandler */ NULL, m_queuedCommands.front().dataHandler));
+	}
+	catch (...)
+	{
+		// We do not know which responses have been received
+		clearQueuedCommands();
+		throw;
+	}
+
+	const IMAPParser::response_tagged* respTagged =
+		resp->response_done() ? resp->response_done()->response_tagged() : NULL;
+
+	if (respTagged == NULL)  // BYE, or continuation request
+	{
+		clearQueuedCommands();
+		throw exceptions::invalid_response("", resp->getErrorLog());
+	}
+
+	// The parser only accepts the tags of the pending commands
+	std::vector <queuedCommand>::iterator it = m_queuedCommands.begin();
+
+	while (it != m_queuedCommands.end() && (*it).tag != respTagged->tag()->value())
+		++it;
+
+	const queuedCommand qcmd = *it;
+
+	m_queuedCommands.erase(it);
+	updatePendingTags();
+
+	// The rest of the responses must be read even if processing failed:
+	// only the first error is kept, and thrown by processQueuedCommands()
+	std::auto_ptr <exception> error;
+
+	try
+	{
+		if (qcmd.handler)
+			qcmd.handler->handleCommandResponse(qcmd.command, resp.get());
+	}
+	catch (exception& e)
+	{
+		error.reset(e.clone());
+	}
+	catch (std::exception& e)
+	{
+		error.reset(new exception(e.what()));
+	}
+
+	if (error.get() && !m_queuedCommandError.get())
+	{
+		const string text = qcmd.command->getTraceText();
+
+		m_queuedCommandError.reset(new exceptions::command_error
+			(text.substr(0, text.find(' ')), resp->getErrorLog(), "cannot process response", *error));
+	}
+}
+
+
+void IMAPConnection::clearQueuedCommands()
+{
+	m_queuedCommands.clear();
+	m_queuedCommandError.reset();
+
+	updatePendingTags();
+}
+
+
+void IMAPConnection::updatePendingTags()
+{
+	std::vector <string> tags;
+	tags.reserve(m_queuedCommands.size());
+
+	for (std::vector <queuedCommand>::const_iterator it = m_queuedCommands.begin() ;
+	     it != m_queuedCommands.end() ; ++it)
+	{
+		tags.push_back((*it).tag);
+	}
+
+	m_parser->setPendingTags(tags);
 }
 
 
@@ -830,6 +991,12 @@ shared_ptr <const socket> IMAPConnection::getSocket() const
 }
 
 
+shared_ptr <socket> IMAPConnection::getSocket()
+{
+	return m_socket;
+}
+
+
 void IMAPConnection::setSocket(shared_ptr <socket> sok)
 {
 	m_socket = sok;
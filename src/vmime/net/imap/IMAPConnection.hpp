@@ -84,7 +84,67 @@ public:
 	void sendCommand(shared_ptr <IMAPCommand> cmd);
 	void sendRaw(const byte_t* buffer, const size_t count);
 
-	IMAPParser::response* readResponse(IMAPParser::literalHandler* lh = NULL);
+	IMAPParser::response* readResponse
+		(IMAPParser::literalHandler* lh = NULL, IMAPParser::responseHandler* rh = NULL);
+
+
+	/** Receives the response to a command sent with queueCommand().
+	  */
+	class commandResponseHandler
+	{
+	public:
+
+		virtual ~commandResponseHandler() { }
+
+		/** Called when the tagged response to a queued command has been
+		  * received. As the server may send the untagged data of pipelined
+		  * commands in any order, the response may also contain data which
+		  * relates to another command of the queue.
+		  *
+		  * @param cmd command which has completed
+		  * @param resp response to the command (freed when this function
+		  * returns)
+		  */
+		virtual void handleCommandResponse
+			(shared_ptr <IMAPCommand> cmd, const IMAPParser::response* resp) = 0;
+	};
+
+	/** Send a command without waiting for its response, so that several
+	  * commands can be sent in a row (pipelining). The responses are read
+	  * and dispatched to their handlers by processQueuedCommands().
+	  *
+	  * Only commands which do not need a continuation from the server
+	  * (ie. which do not contain synchronizing literals) can be queued.
+	  *
+	  * @param cmd command to send
+	  * @param handler receives the response to the command
+	  * @param rh if not NULL, receives untagged data as soon as it is
+	  * parsed, while waiting for the completion of this command
+	  * @throw exception if the command cannot be sent (in this case,
+	  * the queue is cleared)
+	  */
+	void queueCommand(shared_ptr <IMAPCommand> cmd, commandResponseHandler* handler,
+		IMAPParser::responseHandler* rh = NULL);
+
+	/** Read the responses to all the commands sent with queueCommand(),
+	  * and dispatch each of them to the handler of its command. This is
+	  * also done implicitly before sending a command with sendCommand().
+	  *
+	  * If a handler throws an exception, the remaining responses are
+	  * still read, and the first error is thrown afterwards.
+	  *
+	  * @throw exceptions::command_error if a handler failed
+	  * @throw exceptions::invalid_response if the server did not complete
+	  * the commands (in this case, the queue is cleared)
+	  */
+	void processQueuedCommands();
+
+	/** Return the number of commands sent with queueCommand() which
+	  * have not been completed yet.
+	  *
+	  * @return number of pending commands
+	  */
+	size_t getQueuedCommandCount() const;
 
 
 	shared_ptr <const IMAPStore> getStore() const;
@@ -104,6 +164,7 @@ public:
 	shared_ptr <connectionInfos> getConnectionInfos() const;
 
 	shared_ptr <const socket> getSocket() const;
+	shared_ptr <socket> getSocket();
 	void setSocket(shared_ptr <socket> sok);
 
 	shared_ptr <tracer> getTracer();
@@ -127,6 +188,12 @@ private:
 	bool processCapabilityResponseData(const IMAPParser::response* resp);
 	void processCapabilityResponseData(const IMAPParser::capability_data* capaData);
 
+	void writeCommand(shared_ptr <IMAPCommand> cmd);
+
+	void processNextQueuedResponse();
+	void clearQueuedCommands();
+	void updatePendingTags();
+
 
 	weak_ptr <IMAPStore> m_store;
 
@@ -156,6 +223,17 @@ private:
 
 	shared_ptr <tracer> m_tracer;
 
+	struct queuedCommand
+	{
+		string tag;
+		shared_ptr <IMAPCommand> command;
+		commandResponseHandler* handler;
+		IMAPParser::responseHandler* dataHandler;
+	};
+
+	std::vector <queuedCommand> m_queuedCommands;
+	std::auto_ptr <exceptions::command_error> m_queuedCommandError;
+
 
 	void internalDisconnect();
 
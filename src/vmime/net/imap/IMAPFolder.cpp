@@ -32,6 +32,7 @@
 #include "vmime/net/imap/IMAPStore.hpp"
 #include "vmime/net/imap/IMAPParser.hpp"
 #include "vmime/net/imap/IMAPMessage.hpp"
+#include "vmime/net/imap/IMAPMessagePart.hpp"
 #include "vmime/net/imap/IMAPUtils.hpp"
 #include "vmime/net/imap/IMAPConnection.hpp"
 #include "vmime/net/imap/IMAPFolderStatus.hpp"
@@ -42,6 +43,7 @@
 #include "vmime/exception.hpp"
 
 #include "vmime/utility/outputStreamAdapter.hpp"
+#include "vmime/utility/outputStreamBufferedSocketAdapter.hpp"
 
 #include <algorithm>
 #include <sstream>
@@ -52,6 +54,242 @@ namespace net {
 namespace imap {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+//
+// IMAPFolder_fetchResponseHandler
+//
+
+// Processes FETCH responses as soon as they are received, so that the
+// whole response to a FETCH command does not have to be kept in memory
+class IMAPFolder_fetchResponseHandler : public IMAPParser::responseHandler
+{
+public:
+
+	IMAPFolder_fetchResponseHandler(IMAPFolder& folder)
+		: m_folder(folder)
+	{
+	}
+
+	bool handleResponseData(const IMAPParser::response_data* respData)
+	{
+		const IMAPParser::message_data* messageData = respData->message_data();
+
+		// We are only interested in responses of type "FETCH"; other
+		// responses are kept for processStatusUpdate()
+		if (messageData == NULL || messageData->type() != IMAPParser::message_data::FETCH)
+			return false;
+
+		// The rest of the response must be read even if processing
+		// failed: the error is thrown once the response has been read
+		if (m_error.get())
+			return true;
+
+		try
+		{
+			processMessage(messageData);
+
+			m_folder.updateMessages(messageData);
+			m_changedMessages.push_back(static_cast <int>(messageData->number()));
+		}
+		catch (exception& e)
+		{
+			m_error.reset(e.clone());
+		}
+		catch (std::exception& e)
+		{
+			m_error.reset(new exception(e.what()));
+		}
+
+		return true;
+	}
+
+	/** Throws the error which occurred while processing the
+	  * FETCH responses, if any.
+	  *
+	  * @param resp response to the FETCH command
+	  */
+	void checkError(const IMAPParser::response* resp) const
+	{
+		if (m_error.get())
+		{
+			throw exceptions::command_error("FETCH",
+				resp->getErrorLog(), "cannot process response", *m_error);
+		}
+	}
+
+	const std::vector <int>& getChangedMessages() const
+	{
+		return m_changedMessages;
+	}
+
+protected:
+
+	virtual void processMessage(const IMAPParser::message_data* messageData) = 0;
+
+	static void processFetchResponse(shared_ptr <IMAPMessage> msg,
+		const fetchAttributes& options, const IMAPParser::message_data* messageData)
+	{
+		msg->processFetchResponse(options, messageData);
+	}
+
+	IMAPFolder& m_folder;
+
+private:
+
+	std::vector <int> m_changedMessages;
+	std::auto_ptr <exception> m_error;
+};
+
+
+//
+// IMAPFolder_fetchMessagesHandler
+//
+
+class IMAPFolder_fetchMessagesHandler : public IMAPFolder_fetchResponseHandler
+{
+public:
+
+	IMAPFolder_fetchMessagesHandler
+		(IMAPFolder& folder, const fetchAttributes& options,
+		 std::vector <shared_ptr <message> >& msg, utility::progressListener* progress)
+		: IMAPFolder_fetchResponseHandler(folder),
+		  m_options(options), m_progress(progress), m_current(0), m_total(msg.size())
+	{
+		for (std::vector <shared_ptr <message> >::iterator it = msg.begin() ; it != msg.end() ; ++it)
+			m_numberToMsg[(*it)->getNumber()] = dynamicCast <IMAPMessage>(*it);
+	}
+
+protected:
+
+	void processMessage(const IMAPParser::message_data* messageData)
+	{
+		// Process fetch response for this message
+		const int num = static_cast <int>(messageData->number());
+
+		std::map <int, shared_ptr <IMAPMessage> >::iterator msg = m_numberToMsg.find(num);
+
+		if (msg != m_numberToMsg.end())
+		{
+			processFetchResponse((*msg).second, m_options, messageData);
+
+			if (m_progress)
+				m_progress->progress(++m_current, m_total);
+		}
+	}
+
+private:
+
+	const fetchAttributes& m_options;
+	utility::progressListener* m_progress;
+
+	size_t m_current;
+	const size_t m_total;
+
+	std::map <int, shared_ptr <IMAPMessage> > m_numberToMsg;
+};
+
+
+//
+// IMAPFolder_fetchPartHeadersHandler
+//
+
+// Checks the completion of the pipelined FETCH commands which request
+// the headers of the parts
+class IMAPFolder_fetchPartHeadersHandler : public IMAPConnection::commandResponseHandler
+{
+public:
+
+	IMAPFolder_fetchPartHeadersHandler
+		(IMAPFolder& folder, IMAPFolder_fetchResponseHandler& dataHandler)
+		: m_folder(folder), m_dataHandler(dataHandler)
+	{
+	}
+
+	void handleCommandResponse(shared_ptr <IMAPCommand> /* cmd */, const IMAPParser::response* resp)
+	{
+		if (resp->isBad() || resp->response_done()->response_tagged()->
+			resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+		{
+			throw exceptions::command_error("FETCH",
+				resp->getErrorLog(), "bad response");
+		}
+
+		m_dataHandler.checkError(resp);
+
+		// Flags have not changed: only process other status updates
+		m_folder.processStatusUpdate(resp);
+	}
+
+private:
+
+	IMAPFolder& m_folder;
+	IMAPFolder_fetchResponseHandler& m_dataHandler;
+};
+
+
+//
+// IMAPFolder_getAndFetchMessagesHandler
+//
+
+class IMAPFolder_getAndFetchMessagesHandler : public IMAPFolder_fetchResponseHandler
+{
+public:
+
+	IMAPFolder_getAndFetchMessagesHandler
+		(IMAPFolder& folder, const fetchAttributes& options,
+		 std::vector <shared_ptr <message> >& messages)
+		: IMAPFolder_fetchResponseHandler(folder),
+		  m_options(options), m_messages(messages)
+	{
+	}
+
+protected:
+
+	void processMessage(const IMAPParser::message_data* messageData)
+	{
+		// Get message number
+		const int msgNum = static_cast <int>(messageData->number());
+
+		// Get message UID
+		const std::vector <IMAPParser::msg_att_item*> atts = messageData->msg_att()->items();
+		message::uid msgUID;
+
+		for (std::vector <IMAPParser::msg_att_item*>::const_iterator
+			 it = atts.begin() ; it != atts.end() ; ++it)
+		{
+			if ((*it)->type() == IMAPParser::msg_att_item::UID)
+			{
+				msgUID = (*it)->unique_id()->value();
+				break;
+			}
+		}
+
+		// Create a new message reference
+		shared_ptr <IMAPFolder> thisFolder = dynamicCast <IMAPFolder>(m_folder.shared_from_this());
+		shared_ptr <IMAPMessage> msg = make_shared <IMAPMessage>(thisFolder, msgNum, msgUID);
+
+		m_messages.push_back(msg);
+
+		// Process fetch response for this message
+		processFetchResponse(msg, m_options, messageData);
+	}
+
+private:
+
+	const fetchAttributes& m_options;
+	std::vector <shared_ptr <message> >& m_messages;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
+
+//
+// IMAPFolder
+//
+
+
 IMAPFolder::IMAPFolder(const folder::path& path, shared_ptr <IMAPStore> store, shared_ptr <folderAttributes> attribs)
 	: m_store(store), m_connection(store->connection()), m_path(path),
 	  m_name(path.isEmpty() ? folder::path::component("") : path.getLastComponent()), m_mode(-1),
@@ -313,9 +551,14 @@ void IMAPFolder::close(const bool expunge)
 
 void IMAPFolder::onClose()
 {
-	for (std::vector <IMAPMessage*>::iterator it = m_messages.begin() ;
-	     it != m_messages.end() ; ++it)
+	std::vector <IMAPMessage*> messages;
+	m_messages.getAllMessages(messages);
+
+	for (std::vector <IMAPMessage*>::iterator it = messages.begin() ;
+	     it != messages.end() ; ++it)
 	{
+		// Messages keep their last known number
+		(*it)->renumber(m_messages.getMessageNumber(*it));
 		(*it)->onFolderClosed();
 	}
 
@@ -763,68 +1006,34 @@ void IMAPFolder::fetchMessages(std::vector <shared_ptr <message> >& msg, const f
 	std::vector <int> list;
 	list.reserve(msg.size());
 
-	std::map <int, shared_ptr <IMAPMessage> > numberToMsg;
-
 	for (std::vector <shared_ptr <message> >::iterator it = msg.begin() ; it != msg.end() ; ++it)
-	{
 		list.push_back((*it)->getNumber());
-		numberToMsg[(*it)->getNumber()] = dynamicCast <IMAPMessage>(*it);
-	}
 
 	// Send the request
 	IMAPUtils::buildFetchCommand
 		(m_connection, messageSet::byNumber(list), options)->send(m_connection);
 
-	// Get the response
-	std::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
-
-	if (resp->isBad() || resp->response_done()->response_tagged()->
-		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
-	{
-		throw exceptions::command_error("FETCH",
-			resp->getErrorLog(), "bad response");
-	}
-
-	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
-		resp->continue_req_or_response_data();
-
+	// Get the response (messages are processed while it is received)
 	const size_t total = msg.size();
-	size_t current = 0;
 
 	if (progress)
 		progress->start(total);
 
+	IMAPFolder_fetchMessagesHandler handler(*this, options, msg, progress);
+	std::auto_ptr <IMAPParser::response> resp;
+
 	try
 	{
-		for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
-		     it = respDataList.begin() ; it != respDataList.end() ; ++it)
-		{
-			if ((*it)->response_data() == NULL)
-			{
-				throw exceptions::command_error("FETCH",
-					resp->getErrorLog(), "invalid response");
-			}
-
-			const IMAPParser::message_data* messageData =
-				(*it)->response_data()->message_data();
+		resp.reset(m_connection->readResponse(/* literalHandler */ NULL, &handler));
 
-			// We are only interested in responses of type "FETCH"
-			if (messageData == NULL || messageData->type() != IMAPParser::message_data::FETCH)
-				continue;
-
-			// Process fetch response for this message
-			const int num = static_cast <int>(messageData->number());
-
-			std::map <int, shared_ptr <IMAPMessage> >::iterator msg = numberToMsg.find(num);
-
-			if (msg != numberToMsg.end())
-			{
-				(*msg).second->processFetchResponse(options, messageData);
-
-				if (progress)
-					progress->progress(++current, total);
-			}
+		if (resp->isBad() || resp->response_done()->response_tagged()->
+			resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+		{
+			throw exceptions::command_error("FETCH",
+				resp->getErrorLog(), "bad response");
 		}
+
+		handler.checkError(resp.get());
 	}
 	catch (...)
 	{
@@ -837,7 +1046,67 @@ void IMAPFolder::fetchMessages(std::vector <shared_ptr <message> >& msg, const f
 	if (progress)
 		progress->stop(total);
 
-	processStatusUpdate(resp.get());
+	processStatusUpdate(resp.get(), handler.getChangedMessages());
+
+	// Also fetch the header of the parts, as the full header of the message
+	// is requested along with its structure
+	if (options.has(fetchAttributes::FULL_HEADER) && options.has(fetchAttributes::STRUCTURE))
+		fetchPartHeaders(msg);
+}
+
+
+void IMAPFolder::fetchPartHeaders(std::vector <shared_ptr <message> >& msg)
+{
+	// FETCH requests the same items for all the messages in the set, so
+	// group together messages whose parts have the same numbering
+	typedef std::map <std::vector <string>, std::vector <shared_ptr <message> > > GroupMap;
+	GroupMap groups;
+
+	for (std::vector <shared_ptr <message> >::iterator it = msg.begin() ; it != msg.end() ; ++it)
+	{
+		shared_ptr <IMAPMessage> imapMsg = dynamicCast <IMAPMessage>(*it);
+
+		if (imapMsg->m_structure == NULL || imapMsg->m_structure->getPartCount() == 0)
+			continue;
+
+		shared_ptr <IMAPMessagePart> rootPart =
+			dynamicCast <IMAPMessagePart>(imapMsg->m_structure->getPartAt(0));
+
+		// The header of the root part is the header of the message
+		if (imapMsg->m_header != NULL && !rootPart->hasHeader())
+			rootPart->getOrCreateHeader().copyFrom(*imapMsg->m_header);
+
+		std::vector <string> items;
+		IMAPMessage::getPartHeaderFetchItems(imapMsg->m_structure, items);
+
+		if (!items.empty())
+			groups[items].push_back(*it);
+	}
+
+	// Headers are dispatched to the parts by IMAPMessage::processFetchResponse();
+	// as messages are found by number, a single handler serves all the groups
+	const fetchAttributes options;
+
+	IMAPFolder_fetchMessagesHandler dataHandler(*this, options, msg, /* progress */ NULL);
+	IMAPFolder_fetchPartHeadersHandler handler(*this, dataHandler);
+
+	// Send one FETCH command per group, without waiting for the responses
+	for (GroupMap::iterator it = groups.begin() ; it != groups.end() ; ++it)
+	{
+		std::vector <int> list;
+		list.reserve((*it).second.size());
+
+		for (std::vector <shared_ptr <message> >::const_iterator jt = (*it).second.begin() ;
+		     jt != (*it).second.end() ; ++jt)
+		{
+			list.push_back((*jt)->getNumber());
+		}
+
+		m_connection->queueCommand
+			(IMAPCommand::FETCH(messageSet::byNumber(list), (*it).first), &handler, &dataHandler);
+	}
+
+	m_connection->processQueuedCommands();
 }
 
 
@@ -871,8 +1140,11 @@ std::vector <shared_ptr <message> > IMAPFolder::getAndFetchMessages
 	IMAPUtils::buildFetchCommand
 		(m_connection, msgs, attribsWithUID)->send(m_connection);
 
-	// Get the response
-	std::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
+	// Get the response (messages are created while it is received)
+	std::vector <shared_ptr <message> > messages;
+
+	IMAPFolder_getAndFetchMessagesHandler handler(*this, attribsWithUID, messages);
+	std::auto_ptr <IMAPParser::response> resp(m_connection->readResponse(/* literalHandler */ NULL, &handler));
 
 	if (resp->isBad() || resp->response_done()->response_tagged()->
 		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
@@ -881,55 +1153,9 @@ std::vector <shared_ptr <message> > IMAPFolder::getAndFetchMessages
 			resp->getErrorLog(), "bad response");
 	}
 
-	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
-		resp->continue_req_or_response_data();
+	handler.checkError(resp.get());
 
-	std::vector <shared_ptr <message> > messages;
-
-	for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
-	     it = respDataList.begin() ; it != respDataList.end() ; ++it)
-	{
-		if ((*it)->response_data() == NULL)
-		{
-			throw exceptions::command_error("FETCH",
-				resp->getErrorLog(), "invalid response");
-		}
-
-		const IMAPParser::message_data* messageData =
-			(*it)->response_data()->message_data();
-
-		// We are only interested in responses of type "FETCH"
-		if (messageData == NULL || messageData->type() != IMAPParser::message_data::FETCH)
-			continue;
-
-		// Get message number
-		const int msgNum = static_cast <int>(messageData->number());
-
-		// Get message UID
-		const std::vector <IMAPParser::msg_att_item*> atts = messageData->msg_att()->items();
-		message::uid msgUID;
-
-		for (std::vector <IMAPParser::msg_att_item*>::const_iterator
-			 it = atts.begin() ; it != atts.end() ; ++it)
-		{
-			if ((*it)->type() == IMAPParser::msg_att_item::UID)
-			{
-				msgUID = (*it)->unique_id()->value();
-				break;
-			}
-		}
-
-		// Create a new message reference
-		shared_ptr <IMAPFolder> thisFolder = dynamicCast <IMAPFolder>(shared_from_this());
-		shared_ptr <IMAPMessage> msg = make_shared <IMAPMessage>(thisFolder, msgNum, msgUID);
-
-		messages.push_back(msg);
-
-		// Process fetch response for this message
-		msg->processFetchResponse(attribsWithUID, messageData);
-	}
-
-	processStatusUpdate(resp.get());
+	processStatusUpdate(resp.get(), handler.getChangedMessages());
 
 	return messages;
 }
@@ -967,17 +1193,13 @@ shared_ptr <store> IMAPFolder::getStore()
 
 void IMAPFolder::registerMessage(IMAPMessage* msg)
 {
-	m_messages.push_back(msg);
+	m_messages.registerMessage(msg, msg->m_num);
 }
 
 
 void IMAPFolder::unregisterMessage(IMAPMessage* msg)
 {
-	std::vector <IMAPMessage*>::iterator it =
-		std::find(m_messages.begin(), m_messages.end(), msg);
-
-	if (it != m_messages.end())
-		m_messages.erase(it);
+	m_messages.unregisterMessage(msg);
 }
 
 
@@ -1115,21 +1337,26 @@ messageSet IMAPFolder::addMessage
 	std::vector <byte_t> vbuffer(blockSize);
 	byte_t* buffer = &vbuffer.front();
 
+	// Coalesce small reads before sending them to the socket
+	utility::outputStreamBufferedSocketAdapter sos(*m_connection->getSocket());
+
 	while (!is.eof())
 	{
 		// Read some data from the input stream
-		const size_t read = is.read(buffer, sizeof(buffer));
+		const size_t read = is.read(buffer, blockSize);
 		current += read;
 
 		// Put read data into socket output stream
-		m_connection->sendRaw(buffer, read);
+		sos.write(buffer, read);
 
 		// Notify progress
 		if (progress)
 			progress->progress(current, total);
 	}
 
-	m_connection->sendRaw(utility::stringUtils::bytesFromString("\r\n"), 2);
+	// Terminate the command along with the last data block
+	sos.write("\r\n", 2);
+	sos.flush();
 
 	if (m_connection->getTracer())
 		m_connection->getTracer()->traceSendBytes(current);
@@ -1308,22 +1535,8 @@ shared_ptr <folderStatus> IMAPFolder::getStatus()
 	if (!store)
 		throw exceptions::illegal_state("Store disconnected");
 
-	// Build the attributes list
-	std::vector <string> attribs;
-
-	attribs.push_back("MESSAGES");
-	attribs.push_back("UNSEEN");
-	attribs.push_back("UIDNEXT");
-	attribs.push_back("UIDVALIDITY");
-
-	if (m_connection->hasCapability("CONDSTORE"))
-		attribs.push_back("HIGHESTMODSEQ");
-
 	// Send the request
-	IMAPCommand::STATUS(
-		IMAPUtils::pathToString(m_connection->hierarchySeparator(), getFullPath()),
-		attribs
-	)->send(m_connection);
+	createStatusCommand(m_connection)->send(m_connection);
 
 	// Get the response
 	std::auto_ptr <IMAPParser::response> resp(m_connection->readResponse());
@@ -1348,12 +1561,7 @@ shared_ptr <folderStatus> IMAPFolder::getStatus()
 			if (responseData->mailbox_data() &&
 				responseData->mailbox_data()->type() == IMAPParser::mailbox_data::STATUS)
 			{
-				shared_ptr <IMAPFolderStatus> status = make_shared <IMAPFolderStatus>();
-				status->updateFromResponse(responseData->mailbox_data());
-
-				m_status->updateFromResponse(responseData->mailbox_data());
-
-				return status;
+				return processStatusData(responseData->mailbox_data());
 			}
 		}
 	}
@@ -1363,6 +1571,35 @@ shared_ptr <folderStatus> IMAPFolder::getStatus()
 }
 
 
+shared_ptr <IMAPCommand> IMAPFolder::createStatusCommand(shared_ptr <IMAPConnection> cnt) const
+{
+	// Build the attributes list
+	std::vector <string> attribs;
+
+	attribs.push_back("MESSAGES");
+	attribs.push_back("UNSEEN");
+	attribs.push_back("UIDNEXT");
+	attribs.push_back("UIDVALIDITY");
+
+	if (cnt->hasCapability("CONDSTORE"))
+		attribs.push_back("HIGHESTMODSEQ");
+
+	return IMAPCommand::STATUS
+		(IMAPUtils::pathToString(cnt->hierarchySeparator(), getFullPath()), attribs);
+}
+
+
+shared_ptr <IMAPFolderStatus> IMAPFolder::processStatusData(const IMAPParser::mailbox_data* mailboxData)
+{
+	shared_ptr <IMAPFolderStatus> status = make_shared <IMAPFolderStatus>();
+	status->updateFromResponse(mailboxData);
+
+	m_status->updateFromResponse(mailboxData);
+
+	return status;
+}
+
+
 void IMAPFolder::noop()
 {
 	shared_ptr <IMAPStore> store = m_store.lock();
@@ -1443,10 +1680,21 @@ std::vector <int> IMAPFolder::getMessageNumbersStartingOnUID(const message::uid&
 }
 
 
-void IMAPFolder::processStatusUpdate(const IMAPParser::response* resp)
+void IMAPFolder::processStatusUpdate
+	(const IMAPParser::response* resp, const std::vector <int>& changedMessages)
 {
 	std::vector <shared_ptr <events::event> > events;
 
+	// FETCH responses which have already been processed
+	for (std::vector <int>::const_iterator it = changedMessages.begin() ;
+	     it != changedMessages.end() ; ++it)
+	{
+		events.push_back(make_shared <events::messageChangedEvent>
+			(dynamicCast <folder>(shared_from_this()),
+			 events::messageChangedEvent::TYPE_FLAGS,
+			 std::vector <int>(1, *it)));
+	}
+
 	shared_ptr <IMAPFolderStatus> oldStatus = vmime::clone(m_status);
 	int expungedMessageCount = 0;
 
@@ -1497,12 +1745,7 @@ void IMAPFolder::processStatusUpdate(const IMAPParser::response* resp)
 			if ((*it)->response_data()->message_data()->type() == IMAPParser::message_data::FETCH)
 			{
 				// Message changed
-				for (std::vector <IMAPMessage*>::iterator mit =
-				     m_messages.begin() ; mit != m_messages.end() ; ++mit)
-				{
-					if ((*mit)->getNumber() == msgNumber)
-						(*mit)->processFetchResponse(/* options */ 0, msgData);
-				}
+				updateMessages(msgData);
 
 				events.push_back(make_shared <events::messageChangedEvent>
 					(dynamicCast <folder>(shared_from_this()),
@@ -1511,14 +1754,16 @@ void IMAPFolder::processStatusUpdate(const IMAPParser::response* resp)
 			}
 			else if ((*it)->response_data()->message_data()->type() == IMAPParser::message_data::EXPUNGE)
 			{
-				// A message has been expunged, renumber messages
+				// A message has been expunged: following messages are
+				// renumbered by the registry
+				std::vector <IMAPMessage*> expunged;
+				m_messages.expunge(msgNumber, expunged);
+
 				for (std::vector <IMAPMessage*>::iterator jt =
-				     m_messages.begin() ; jt != m_messages.end() ; ++jt)
+				     expunged.begin() ; jt != expunged.end() ; ++jt)
 				{
-					if ((*jt)->getNumber() == msgNumber)
-						(*jt)->setExpunged();
-					else if ((*jt)->getNumber() > msgNumber)
-						(*jt)->renumber((*jt)->getNumber() - 1);
+					(*jt)->renumber(msgNumber);
+					(*jt)->setExpunged();
 				}
 
 				events.push_back(make_shared <events::messageCountEvent>
@@ -1557,6 +1802,21 @@ void IMAPFolder::processStatusUpdate(const IMAPParser::response* resp)
 }
 
 
+void IMAPFolder::updateMessages(const IMAPParser::message_data* msgData)
+{
+	const int msgNumber = static_cast <int>(msgData->number());
+
+	std::vector <IMAPMessage*> messages;
+	m_messages.getMessages(msgNumber, messages);
+
+	for (std::vector <IMAPMessage*>::iterator it =
+	     messages.begin() ; it != messages.end() ; ++it)
+	{
+		(*it)->processFetchResponse(/* options */ 0, msgData);
+	}
+}
+
+
 } // imap
 } // net
 } // vmime
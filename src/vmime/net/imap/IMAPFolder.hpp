@@ -39,6 +39,7 @@
 #include "vmime/net/folder.hpp"
 
 #include "vmime/net/imap/IMAPParser.hpp"
+#include "vmime/net/imap/IMAPMessageRegistry.hpp"
 
 
 namespace vmime {
@@ -49,6 +50,7 @@ namespace imap {
 class IMAPStore;
 class IMAPMessage;
 class IMAPConnection;
+class IMAPCommand;
 class IMAPFolderStatus;
 
 
@@ -61,6 +63,9 @@ private:
 
 	friend class IMAPStore;
 	friend class IMAPMessage;
+	friend class IMAPFolder_fetchResponseHandler;
+	friend class IMAPFolder_fetchPartHeadersHandler;
+	friend class IMAPStore_getFoldersStatusHandler;
 
 	IMAPFolder(const IMAPFolder&);
 
@@ -174,6 +179,22 @@ private:
 
 	void copyMessagesImpl(const string& set, const folder::path& dest);
 
+	/** Build the STATUS command which requests the status of this folder.
+	  *
+	  * @param cnt connection on which the command will be sent
+	  * @return STATUS command
+	  */
+	shared_ptr <IMAPCommand> createStatusCommand(shared_ptr <IMAPConnection> cnt) const;
+
+	/** Build the status of this folder from the data returned by the
+	  * server in response to a STATUS command, and update the cached
+	  * status of this folder.
+	  *
+	  * @param mailboxData STATUS data for this folder
+	  * @return folder status
+	  */
+	shared_ptr <IMAPFolderStatus> processStatusData(const IMAPParser::mailbox_data* mailboxData);
+
 
 	/** Process status updates ("unsolicited responses") contained in the
 	  * specified response. Example:
@@ -183,8 +204,25 @@ private:
 	  *    S: a006 OK Success
 	  *
 	  * @param resp parsed IMAP response
+	  * @param changedMessages numbers of the messages whose FETCH responses
+	  * have already been processed while reading the response
+	  */
+	void processStatusUpdate(const IMAPParser::response* resp,
+		const std::vector <int>& changedMessages = std::vector <int>());
+
+	/** Update the messages for which a FETCH response has been received.
+	  *
+	  * @param msgData FETCH response
+	  */
+	void updateMessages(const IMAPParser::message_data* msgData);
+
+	/** Fetch the header of all the parts of the specified messages, whose
+	  * structure has already been fetched. Messages which have the same
+	  * parts are fetched together, using a single FETCH command.
+	  *
+	  * @param msg messages for which to fetch parts headers
 	  */
-	void processStatusUpdate(const IMAPParser::response* resp);
+	void fetchPartHeaders(std::vector <shared_ptr <message> >& msg);
 
 
 	weak_ptr <IMAPStore> m_store;
@@ -200,7 +238,7 @@ private:
 
 	shared_ptr <IMAPFolderStatus> m_status;
 
-	std::vector <IMAPMessage*> m_messages;
+	IMAPMessageRegistry m_messages;
 };
 
 
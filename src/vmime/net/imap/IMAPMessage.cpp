@@ -137,6 +137,21 @@ void IMAPMessage::onFolderClosed()
 
 int IMAPMessage::getNumber() const
 {
+	// Sequence numbers change when messages are expunged, so the
+	// current number is maintained by the folder
+	if (!m_expunged)
+	{
+		shared_ptr <IMAPFolder> folder = m_folder.lock();
+
+		if (folder)
+		{
+			const int num = folder->m_messages.getMessageNumber(this);
+
+			if (num != 0)
+				return num;
+		}
+	}
+
 	return (m_num);
 }
 
@@ -254,58 +269,165 @@ void IMAPMessage::fetchPartHeader(shared_ptr <messagePart> p)
 
 
 void IMAPMessage::fetchPartHeaderForStructure(shared_ptr <messageStructure> str)
+{
+	shared_ptr <IMAPFolder> folder = m_folder.lock();
+
+	if (!folder)
+		throw exceptions::folder_not_found();
+
+	std::vector <string> fetchParams;
+	getPartHeaderFetchItems(str, fetchParams);
+
+	if (fetchParams.empty())
+		return;
+
+	// Fetch the headers of all parts at once, instead of issuing
+	// one FETCH command per part
+	IMAPCommand::FETCH(
+		m_uid.empty() ? messageSet::byNumber(getNumber()) : messageSet::byUID(m_uid),
+		fetchParams
+	)->send(folder->m_connection);
+
+	std::auto_ptr <IMAPParser::response> resp(folder->m_connection->readResponse());
+
+	if (resp->isBad() || resp->response_done()->response_tagged()->
+		resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+	{
+		throw exceptions::command_error("FETCH",
+			resp->getErrorLog(), "bad response");
+	}
+
+	// Each header is dispatched to its part by processFetchResponse()
+	const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+		resp->continue_req_or_response_data();
+
+	for (size_t i = 0 ; i < respDataList.size() ; ++i)
+	{
+		if (respDataList[i]->response_data() == NULL)
+			continue;
+
+		const IMAPParser::message_data* messageData =
+			respDataList[i]->response_data()->message_data();
+
+		if (messageData == NULL || messageData->type() != IMAPParser::message_data::FETCH ||
+		    static_cast <int>(messageData->number()) != getNumber())
+		{
+			continue;
+		}
+
+		processFetchResponse(/* options */ 0, messageData);
+	}
+}
+
+
+// static
+void IMAPMessage::getPartHeaderFetchItems
+	(shared_ptr <const messageStructure> str, std::vector <string>& items)
 {
 	for (size_t i = 0, n = str->getPartCount() ; i < n ; ++i)
 	{
-		shared_ptr <messagePart> part = str->getPartAt(i);
+		shared_ptr <const IMAPMessagePart> part =
+			dynamicCast <const IMAPMessagePart>(str->getPartAt(i));
 
-		// Fetch header of current part
-		fetchPartHeader(part);
+		if (!part->hasHeader())
+		{
+			const string section = getPartSection(part);
+
+			// "MIME" not "HEADER" for parts
+			if (section.empty())
+				items.push_back("BODY.PEEK[HEADER]");
+			else
+				items.push_back("BODY.PEEK[" + section + ".MIME]");
+		}
 
-		// Fetch header of sub-parts
-		fetchPartHeaderForStructure(part->getStructure());
+		getPartHeaderFetchItems(part->getStructure(), items);
 	}
 }
 
 
-void IMAPMessage::extractImpl
-	(shared_ptr <const messagePart> p,
-	 utility::outputStream& os,
-	 utility::progressListener* progress,
-	 const size_t start, const size_t length,
-	 const int extractFlags) const
+// static
+const string IMAPMessage::getPartSection(shared_ptr <const IMAPMessagePart> p)
 {
-	shared_ptr <const IMAPFolder> folder = m_folder.lock();
+	std::vector <int> numbers;
 
-	IMAPMessage_literalHandler literalHandler(os, progress);
+	for (shared_ptr <const IMAPMessagePart> currentPart = p ;
+	     currentPart != NULL ; currentPart = currentPart->getParent())
+	{
+		numbers.push_back(currentPart->getNumber());
+	}
+
+	// The root part is the message itself
+	numbers.erase(numbers.end() - 1);
 
-	// Construct section identifier
 	std::ostringstream section;
 	section.imbue(std::locale::classic());
 
-	if (p != NULL)
+	for (std::vector <int>::reverse_iterator it = numbers.rbegin() ; it != numbers.rend() ; ++it)
 	{
-		shared_ptr <const IMAPMessagePart> currentPart = dynamicCast <const IMAPMessagePart>(p);
-		std::vector <int> numbers;
+		if (it != numbers.rbegin()) section << ".";
+		section << (*it + 1);
+	}
 
-		numbers.push_back(currentPart->getNumber());
-		currentPart = currentPart->getParent();
+	return section.str();
+}
 
-		while (currentPart != NULL)
-		{
-			numbers.push_back(currentPart->getNumber());
-			currentPart = currentPart->getParent();
-		}
 
-		numbers.erase(numbers.end() - 1);
+shared_ptr <IMAPMessagePart> IMAPMessage::findPartForHeaderSection(const IMAPParser::section* section)
+{
+	if (m_structure == NULL || m_structure->getPartCount() == 0)
+		return null;
+
+	const std::vector <unsigned int>& numbers = section->nz_numbers();
 
-		for (std::vector <int>::reverse_iterator it = numbers.rbegin() ; it != numbers.rend() ; ++it)
+	// "HEADER" is the header of the root part, "x.y.MIME" the header of a sub-part
+	if (numbers.empty())
+	{
+		if (!section->section_text1() ||
+		    section->section_text1()->type() != IMAPParser::section_text::HEADER)
+		{
+			return null;
+		}
+	}
+	else
+	{
+		if (!section->section_text2() ||
+		    section->section_text2()->type() != IMAPParser::section_text::MIME)
 		{
-			if (it != numbers.rbegin()) section << ".";
-			section << (*it + 1);
+			return null;
 		}
 	}
 
+	shared_ptr <messagePart> part = m_structure->getPartAt(0);
+
+	for (std::vector <unsigned int>::const_iterator it = numbers.begin() ; it != numbers.end() ; ++it)
+	{
+		shared_ptr <messageStructure> str = part->getStructure();
+
+		if (*it > str->getPartCount())
+			return null;
+
+		part = str->getPartAt(*it - 1);
+	}
+
+	return dynamicCast <IMAPMessagePart>(part);
+}
+
+
+void IMAPMessage::extractImpl
+	(shared_ptr <const messagePart> p,
+	 utility::outputStream& os,
+	 utility::progressListener* progress,
+	 const size_t start, const size_t length,
+	 const int extractFlags) const
+{
+	shared_ptr <const IMAPFolder> folder = m_folder.lock();
+
+	IMAPMessage_literalHandler literalHandler(os, progress);
+
+	// Construct section identifier
+	const string section = (p != NULL)
+		? getPartSection(dynamicCast <const IMAPMessagePart>(p)) : "";
+
 	// Build the body descriptor for FETCH
 	/*
 	   BODY[]               header + body
@@ -325,7 +447,7 @@ void IMAPMessage::extractImpl
 
 	bodyDesc << "[";
 
-	if (section.str().empty())
+	if (section.empty())
 	{
 		// header + body
 		if ((extractFlags & EXTRACT_HEADER) && (extractFlags & EXTRACT_BODY))
@@ -339,7 +461,7 @@ void IMAPMessage::extractImpl
 	}
 	else
 	{
-		bodyDesc << section.str();
+		bodyDesc << section;
 
 		// header + body
 		if ((extractFlags & EXTRACT_HEADER) && (extractFlags & EXTRACT_BODY))
@@ -359,7 +481,7 @@ void IMAPMessage::extractImpl
 
 	// Send the request
 	IMAPCommand::FETCH(
-		m_uid.empty() ? messageSet::byNumber(m_num) : messageSet::byUID(m_uid),
+		m_uid.empty() ? messageSet::byNumber(getNumber()) : messageSet::byUID(m_uid),
 		fetchParams
 	)->send(constCast <IMAPFolder>(folder)->m_connection);
 
@@ -495,7 +617,14 @@ int IMAPMessage::processFetchResponse
 		}
 		case IMAPParser::msg_att_item::BODY_SECTION:
 		{
-			if (!options.has(fetchAttributes::FULL_HEADER))
+			// Header of a part (see fetchPartHeaderForStructure())
+			shared_ptr <IMAPMessagePart> part = findPartForHeaderSection((*it)->section());
+
+			if (part != NULL)
+			{
+				part->getOrCreateHeader().parse((*it)->nstring()->value());
+			}
+			else if (!options.has(fetchAttributes::FULL_HEADER))
 			{
 				if ((*it)->section()->section_text1() &&
 				    (*it)->section()->section_text1()->type()
@@ -551,7 +680,7 @@ void IMAPMessage::setFlags(const int flags, const int mode)
 	if (!m_uid.empty())
 		folder->setMessageFlags(messageSet::byUID(m_uid), flags, mode);
 	else
-		folder->setMessageFlags(messageSet::byNumber(m_num), flags, mode);
+		folder->setMessageFlags(messageSet::byNumber(getNumber()), flags, mode);
 }
 
 
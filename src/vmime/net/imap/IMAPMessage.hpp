@@ -43,6 +43,7 @@ namespace imap {
 
 
 class IMAPFolder;
+class IMAPMessagePart;
 
 
 /** IMAP message implementation.
@@ -53,6 +54,7 @@ class VMIME_EXPORT IMAPMessage : public message
 private:
 
 	friend class IMAPFolder;
+	friend class IMAPFolder_fetchResponseHandler;
 	friend class IMAPMessagePartContentHandler;
 
 	IMAPMessage(const IMAPMessage&) : message() { }
@@ -131,12 +133,39 @@ private:
 	  */
 	int processFetchResponse(const fetchAttributes& options, const IMAPParser::message_data* msgData);
 
-	/** Recursively fetch part header for all parts in the structure.
+	/** Fetch the header of all the parts in the structure (recursively)
+	  * which have not been fetched yet, using a single FETCH command.
 	  *
 	  * @param str structure for which to fetch parts headers
 	  */
 	void fetchPartHeaderForStructure(shared_ptr <messageStructure> str);
 
+	/** Build the FETCH items to retrieve the header of all the parts in
+	  * the structure (recursively) which have not been fetched yet.
+	  *
+	  * @param str structure for which to fetch parts headers
+	  * @param items vector to which the FETCH items will be appended
+	  */
+	static void getPartHeaderFetchItems
+		(shared_ptr <const messageStructure> str, std::vector <string>& items);
+
+	/** Return the section specifier of a part, as used in FETCH
+	  * commands (eg. "2.1"). The section of the root part is empty.
+	  *
+	  * @param p message part
+	  * @return section specifier of the part
+	  */
+	static const string getPartSection(shared_ptr <const IMAPMessagePart> p);
+
+	/** Return the part of this message whose header is returned by
+	  * a BODY[section] item, if this section is the header of a part.
+	  *
+	  * @param section section returned by the server
+	  * @return part of the message, or NULL if the section does not
+	  * identify the header of a part of the current structure
+	  */
+	shared_ptr <IMAPMessagePart> findPartForHeaderSection(const IMAPParser::section* section);
+
 	/** Recursively contruct parsed message from structure.
 	  * Called by getParsedMessage().
 	  *
@@ -125,6 +125,12 @@ shared_ptr <const header> IMAPMessagePart::getHeader() const
 }
 
 
+bool IMAPMessagePart::hasHeader() const
+{
+	return m_header != NULL;
+}
+
+
 // static
 shared_ptr <IMAPMessagePart> IMAPMessagePart::create
 	(shared_ptr <IMAPMessagePart> parent, const int number, const IMAPParser::body* body)
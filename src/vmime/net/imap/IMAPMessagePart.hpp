@@ -62,6 +62,12 @@ public:
 
 	shared_ptr <const header> getHeader() const;
 
+	/** Tests whether the header of this part has already been fetched.
+	  *
+	  * @return true if the header is available, false otherwise
+	  */
+	bool hasHeader() const;
+
 
 	static shared_ptr <IMAPMessagePart> create
 		(shared_ptr <IMAPMessagePart> parent, const int number, const IMAPParser::body* body);
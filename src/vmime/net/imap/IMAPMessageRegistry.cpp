@@ -0,0 +1,219 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
+
+#include "vmime/net/imap/IMAPMessageRegistry.hpp"
+
+
+namespace vmime {
+namespace net {
+namespace imap {
+
+
+IMAPMessageRegistry::IMAPMessageRegistry()
+	: m_tree(1, 0), m_count(0)
+{
+}
+
+
+void IMAPMessageRegistry::registerMessage(IMAPMessage* msg, const int number)
+{
+	if (number <= 0 || m_messageSlots.find(msg) != m_messageSlots.end())
+		return;
+
+	extendTo(number);
+
+	const size_t slot = findSlot(number);
+
+	m_slotMessages.insert(std::multimap <size_t, IMAPMessage*>::value_type(slot, msg));
+	m_messageSlots[msg] = slot;
+}
+
+
+void IMAPMessageRegistry::unregisterMessage(IMAPMessage* msg)
+{
+	std::map <const IMAPMessage*, size_t>::iterator it = m_messageSlots.find(msg);
+
+	if (it == m_messageSlots.end())
+		return;
+
+	std::pair <std::multimap <size_t, IMAPMessage*>::iterator,
+	           std::multimap <size_t, IMAPMessage*>::iterator> range =
+		m_slotMessages.equal_range((*it).second);
+
+	for ( ; range.first != range.second ; ++range.first)
+	{
+		if ((*range.first).second == msg)
+		{
+			m_slotMessages.erase(range.first);
+			break;
+		}
+	}
+
+	m_messageSlots.erase(it);
+
+	// Slots are only needed to number registered messages
+	if (m_messageSlots.empty())
+		clear();
+}
+
+
+int IMAPMessageRegistry::getMessageNumber(const IMAPMessage* msg) const
+{
+	std::map <const IMAPMessage*, size_t>::const_iterator it = m_messageSlots.find(msg);
+
+	if (it == m_messageSlots.end())
+		return 0;
+
+	return getPrefixCount((*it).second);
+}
+
+
+void IMAPMessageRegistry::getMessages(const int number, std::vector <IMAPMessage*>& msgs) const
+{
+	if (number <= 0 || number > m_count)
+		return;
+
+	std::pair <std::multimap <size_t, IMAPMessage*>::const_iterator,
+	           std::multimap <size_t, IMAPMessage*>::const_iterator> range =
+		m_slotMessages.equal_range(findSlot(number));
+
+	for ( ; range.first != range.second ; ++range.first)
+		msgs.push_back((*range.first).second);
+}
+
+
+void IMAPMessageRegistry::getAllMessages(std::vector <IMAPMessage*>& msgs) const
+{
+	for (std::multimap <size_t, IMAPMessage*>::const_iterator it = m_slotMessages.begin() ;
+	     it != m_slotMessages.end() ; ++it)
+	{
+		msgs.push_back((*it).second);
+	}
+}
+
+
+void IMAPMessageRegistry::expunge(const int number, std::vector <IMAPMessage*>& msgs)
+{
+	// No message has been registered with a number greater than
+	// the number of slots, so there is nothing to renumber
+	if (number <= 0 || number > m_count)
+		return;
+
+	const size_t slot = findSlot(number);
+
+	std::pair <std::multimap <size_t, IMAPMessage*>::iterator,
+	           std::multimap <size_t, IMAPMessage*>::iterator> range =
+		m_slotMessages.equal_range(slot);
+
+	for (std::multimap <size_t, IMAPMessage*>::iterator it = range.first ; it != range.second ; ++it)
+	{
+		msgs.push_back((*it).second);
+		m_messageSlots.erase((*it).second);
+	}
+
+	m_slotMessages.erase(range.first, range.second);
+
+	// Remove the slot: the number of all the following slots is decremented
+	for (size_t i = slot ; i < m_tree.size() ; i += (i & (~i + 1)))
+		--m_tree[i];
+
+	--m_count;
+
+	if (m_messageSlots.empty())
+		clear();
+}
+
+
+void IMAPMessageRegistry::clear()
+{
+	m_slotMessages.clear();
+	m_messageSlots.clear();
+
+	m_tree.resize(1);
+	m_count = 0;
+}
+
+
+int IMAPMessageRegistry::getPrefixCount(const size_t slot) const
+{
+	int count = 0;
+
+	for (size_t i = slot ; i > 0 ; i -= (i & (~i + 1)))
+		count += m_tree[i];
+
+	return count;
+}
+
+
+size_t IMAPMessageRegistry::findSlot(const int number) const
+{
+	// Find the first slot whose prefix count is equal to 'number'
+	size_t pos = 0;
+	int remaining = number;
+
+	size_t step = 1;
+
+	while (step * 2 < m_tree.size())
+		step *= 2;
+
+	for ( ; step > 0 ; step /= 2)
+	{
+		if (pos + step < m_tree.size() && m_tree[pos + step] < remaining)
+		{
+			pos += step;
+			remaining -= m_tree[pos];
+		}
+	}
+
+	return pos + 1;
+}
+
+
+void IMAPMessageRegistry::extendTo(const int number)
+{
+	while (m_count < number)
+	{
+		// New slot is live: its node covers the slots in (slot - lowbit, slot]
+		const size_t slot = m_tree.size();
+		const size_t lowBit = slot & (~slot + 1);
+
+		m_tree.push_back(1 + getPrefixCount(slot - 1) - getPrefixCount(slot - lowBit));
+
+		++m_count;
+	}
+}
+
+
+} // imap
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
@@ -0,0 +1,151 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_NET_IMAP_IMAPMESSAGEREGISTRY_HPP_INCLUDED
+#define VMIME_NET_IMAP_IMAPMESSAGEREGISTRY_HPP_INCLUDED
+
+
+#include "vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
+
+#include "vmime/types.hpp"
+
+#include <map>
+#include <vector>
+
+
+namespace vmime {
+namespace net {
+namespace imap {
+
+
+class IMAPMessage;
+
+
+/** Keeps track of the messages objects of a folder, and of their
+  * current sequence number.
+  *
+  * When a message is expunged, the sequence number of all the messages
+  * which follow it is decremented. Instead of renumbering each message,
+  * the registry maps each message to a fixed slot, and maintains the
+  * sequence number of the slots in a Fenwick tree (binary indexed tree).
+  * Looking up messages by number, expunging a message and getting the
+  * number of a message are all O(log n) operations.
+  */
+
+class VMIME_EXPORT IMAPMessageRegistry : public object
+{
+public:
+
+	IMAPMessageRegistry();
+
+	/** Registers a message object.
+	  *
+	  * @param msg message object
+	  * @param number current sequence number of the message
+	  */
+	void registerMessage(IMAPMessage* msg, const int number);
+
+	/** Unregisters a message object. Nothing is done if the
+	  * message is not registered.
+	  *
+	  * @param msg message object
+	  */
+	void unregisterMessage(IMAPMessage* msg);
+
+	/** Returns the current sequence number of a message.
+	  *
+	  * @param msg message object
+	  * @return sequence number of the message, or 0 if the
+	  * message is not registered
+	  */
+	int getMessageNumber(const IMAPMessage* msg) const;
+
+	/** Returns the message objects which have the specified
+	  * sequence number.
+	  *
+	  * @param number sequence number
+	  * @param msgs vector to which the messages will be appended
+	  */
+	void getMessages(const int number, std::vector <IMAPMessage*>& msgs) const;
+
+	/** Returns all the registered message objects.
+	  *
+	  * @param msgs vector to which the messages will be appended
+	  */
+	void getAllMessages(std::vector <IMAPMessage*>& msgs) const;
+
+	/** Removes a sequence number, as a result of an EXPUNGE response.
+	  * Messages which had this number are unregistered, and the number
+	  * of the following messages is decremented.
+	  *
+	  * @param number sequence number of the expunged message
+	  * @param msgs vector to which the messages which had this number
+	  * will be appended
+	  */
+	void expunge(const int number, std::vector <IMAPMessage*>& msgs);
+
+	/** Unregisters all the message objects.
+	  */
+	void clear();
+
+private:
+
+	/** Returns the number of live sequence numbers before the
+	  * specified slot, including this slot.
+	  */
+	int getPrefixCount(const size_t slot) const;
+
+	/** Returns the slot of the specified sequence number, which must
+	  * not be greater than the number of sequence numbers known.
+	  */
+	size_t findSlot(const int number) const;
+
+	/** Appends slots so that the specified sequence number is known.
+	  */
+	void extendTo(const int number);
+
+
+	// Fenwick tree of live slots (index 0 is not used)
+	std::vector <int> m_tree;
+
+	// Number of live slots, ie. the greatest sequence number known
+	int m_count;
+
+	std::multimap <size_t, IMAPMessage*> m_slotMessages;
+	std::map <const IMAPMessage*, size_t> m_messageSlots;
+};
+
+
+} // imap
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_MESSAGING_PROTO_IMAP
+
+#endif // VMIME_NET_IMAP_IMAPMESSAGEREGISTRY_HPP_INCLUDED
+
@@ -54,6 +54,7 @@
 #include "vmime/net/imap/IMAPTag.hpp"
 
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 #include <memory>
 
@@ -70,7 +71,7 @@
   */
 #define VIMAP_PARSER_FAIL() \
 	{  \
-		parser.m_errorResponseLine = makeResponseLine(getComponentName(), line, pos);  \
+		parser.setErrorPosition(getComponentName(), line, pos);  \
 		return false;  \
 	}
 
@@ -240,7 +241,8 @@ public:
 
 	IMAPParser()
 		: m_tag(), m_socket(), m_progress(NULL), m_strict(false),
-		  m_literalHandler(NULL), m_timeoutHandler()
+		  m_literalHandler(NULL), m_responseHandler(NULL), m_timeoutHandler(),
+		  m_bufferPos(0), m_lineCount(0), m_errorLineCount(0), m_errorPos(0)
 	{
 	}
 
@@ -263,6 +265,34 @@ public:
 		return m_tag.lock();
 	}
 
+	/** Set the tags of the commands which have been sent to the server
+	  * but have not been completed yet, when several commands are
+	  * pipelined. A tagged response is then accepted if it matches any
+	  * of these tags. If the list is empty, only the current tag is
+	  * accepted (see setTag()).
+	  *
+	  * @param tags tags of the commands in progress
+	  */
+	void setPendingTags(const std::vector <string>& tags)
+	{
+		m_pendingTags = tags;
+	}
+
+	/** Test whether the specified tag is the one of a command which
+	  * is waiting for completion.
+	  *
+	  * @param tag tag string
+	  * @return true if a tagged response with this tag is expected,
+	  * or false otherwise
+	  */
+	bool isExpectedTag(const string& tag) const
+	{
+		if (m_pendingTags.empty())
+			return tag == string(*getTag());
+
+		return std::find(m_pendingTags.begin(), m_pendingTags.end(), tag) != m_pendingTags.end();
+	}
+
 	/** Set the socket currently used by this parser to receive data
 	  * from server.
 	  *
@@ -408,6 +438,184 @@ public:
 	};
 
 
+
+	//
+	// responseHandler : untagged response handler
+	//
+
+	class response_data;
+
+	class responseHandler
+	{
+	public:
+
+		virtual ~responseHandler() { }
+
+		// Called as soon as an untagged response has been parsed, before
+		// the rest of the response is read from the server. This must
+		// not throw, as the response would not be read entirely.
+		//
+		// Returns :
+		//    . true if the untagged response has been processed: it is
+		//      freed and will not appear in the response
+		//    . false to keep it in the response
+
+		virtual bool handleResponseData(const response_data* data) = 0;
+	};
+
+
+	//
+	// componentArena : allocator for the components of responses
+	//
+
+	/** Allocates components by carving them out of large chunks, instead
+	  * of allocating each of them separately on the heap. A response tree
+	  * typically contains hundreds of small components per message, which
+	  * are all created and freed together.
+	  *
+	  * A block is never reused on its own, except if it is the last one
+	  * which has been allocated (this is the case of tokens which fail to
+	  * parse). A chunk is released in one shot when all the components it
+	  * contains have been deleted and the arena has moved to another chunk.
+	  *
+	  * Chunks are not thread-safe: components allocated by a parser must
+	  * be deleted in the thread which uses the parser.
+	  */
+	class componentArena
+	{
+	public:
+
+		componentArena()
+			: m_chunk(NULL)
+		{
+		}
+
+		~componentArena()
+		{
+			if (m_chunk)
+				releaseChunk(m_chunk);
+		}
+
+		/** Allocate a block from the current chunk.
+		  *
+		  * @param size size of the block, in bytes
+		  * @return pointer to the block
+		  */
+		void* allocate(const size_t size)
+		{
+			const size_t blockSize = BLOCK_HEADER_SIZE + align(size);
+
+			if (m_chunk == NULL || m_chunk->used + blockSize > m_chunk->size)
+				newChunk(blockSize);
+
+			blockHeader* header = reinterpret_cast <blockHeader*>(m_chunk->data() + m_chunk->used);
+			header->owner = m_chunk;
+			header->size = blockSize;
+
+			m_chunk->used += blockSize;
+			++m_chunk->refCount;
+
+			return reinterpret_cast <byte_t*>(header) + BLOCK_HEADER_SIZE;
+		}
+
+		/** Allocate a block on the heap, outside of any arena.
+		  *
+		  * @param size size of the block, in bytes
+		  * @return pointer to the block
+		  */
+		static void* allocateOnHeap(const size_t size)
+		{
+			blockHeader* header = static_cast <blockHeader*>(::operator new(BLOCK_HEADER_SIZE + size));
+			header->owner = NULL;
+			header->size = BLOCK_HEADER_SIZE + size;
+
+			return reinterpret_cast <byte_t*>(header) + BLOCK_HEADER_SIZE;
+		}
+
+		/** Free a block allocated by allocate() or allocateOnHeap().
+		  *
+		  * @param ptr pointer to the block
+		  */
+		static void deallocate(void* ptr)
+		{
+			if (ptr == NULL)
+				return;
+
+			blockHeader* header = reinterpret_cast <blockHeader*>(static_cast <byte_t*>(ptr) - BLOCK_HEADER_SIZE);
+			chunk* owner = header->owner;
+
+			if (owner == NULL)
+			{
+				::operator delete(header);
+				return;
+			}
+
+			// Last block allocated in the chunk: give the space back
+			if (reinterpret_cast <byte_t*>(header) + header->size == owner->data() + owner->used)
+				owner->used -= header->size;
+
+			releaseChunk(owner);
+		}
+
+	private:
+
+		componentArena(const componentArena&);
+		componentArena& operator=(const componentArena&);
+
+
+		static const size_t ALIGNMENT = 16;
+		static const size_t CHUNK_SIZE = 16384;
+
+		struct chunk
+		{
+			size_t size;       // usable size, in bytes
+			size_t used;       // number of bytes allocated
+			size_t refCount;   // number of blocks allocated, plus one if the chunk is in use by the arena
+
+			byte_t* data() { return reinterpret_cast <byte_t*>(this) + CHUNK_HEADER_SIZE; }
+		};
+
+		struct blockHeader
+		{
+			chunk* owner;      // NULL if the block has been allocated on the heap
+			size_t size;
+		};
+
+		static const size_t CHUNK_HEADER_SIZE = (sizeof(chunk) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		static const size_t BLOCK_HEADER_SIZE = (sizeof(blockHeader) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+
+		static size_t align(const size_t size)
+		{
+			return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		}
+
+		void newChunk(const size_t minSize)
+		{
+			const size_t size = std::max(static_cast <size_t>(CHUNK_SIZE), minSize);
+
+			chunk* c = static_cast <chunk*>(::operator new(CHUNK_HEADER_SIZE + size));
+			c->size = size;
+			c->used = 0;
+			c->refCount = 1;
+
+			if (m_chunk)
+				releaseChunk(m_chunk);
+
+			m_chunk = c;
+		}
+
+		static void releaseChunk(chunk* c)
+		{
+			if (--c->refCount == 0)
+				::operator delete(c);
+		}
+
+
+		chunk* m_chunk;
+	};
+
+
 	//
 	// Base class for a terminal or a non-terminal
 	//
@@ -419,6 +627,28 @@ public:
 		component() { }
 		virtual ~component() { }
 
+		// Components created by the parser are allocated in its arena,
+		// the other ones are allocated on the heap
+		static void* operator new(size_t size, componentArena& arena)
+		{
+			return arena.allocate(size);
+		}
+
+		static void* operator new(size_t size)
+		{
+			return componentArena::allocateOnHeap(size);
+		}
+
+		static void operator delete(void* ptr, componentArena& /* arena */)
+		{
+			componentArena::deallocate(ptr);
+		}
+
+		static void operator delete(void* ptr)
+		{
+			componentArena::deallocate(ptr);
+		}
+
 		virtual const string getComponentName() const = 0;
 
 		bool parse(IMAPParser& parser, string& line, size_t* currentPos)
@@ -432,8 +662,8 @@ public:
 		virtual bool parseImpl(IMAPParser& parser, string& line, size_t* currentPos) = 0;
 
 
-		const string makeResponseLine(const string& comp, const string& line,
-		                              const size_t pos)
+		static const string makeResponseLine(const string& comp, const string& line,
+		                                     const size_t pos)
 		{
 #if DEBUG_RESPONSE
 			if (pos > line.length())
@@ -609,8 +839,10 @@ public:
 				}
 			}
 
-			if (tagString == string(*parser.getTag()))
+			if (parser.isExpectedTag(tagString))
 			{
+				m_value = tagString;
+
 				*currentPos = pos;
 				return true;
 			}
@@ -620,6 +852,14 @@ public:
 				return false;
 			}
 		}
+
+	private:
+
+		string m_value;
+
+	public:
+
+		const string& value() const { return (m_value); }
 	};
 
 
@@ -5324,12 +5564,13 @@ public:
 	DECLARE_COMPONENT(response_tagged)
 
 		response_tagged()
-			: m_resp_cond_state(NULL)
+			: m_xtag(NULL), m_resp_cond_state(NULL)
 		{
 		}
 
 		~response_tagged()
 		{
+			delete (m_xtag);
 			delete (m_resp_cond_state);
 		}
 
@@ -5337,7 +5578,7 @@ public:
 		{
 			size_t pos = *currentPos;
 
-			VIMAP_PARSER_CHECK(IMAPParser::xtag);
+			VIMAP_PARSER_GET(IMAPParser::xtag, m_xtag);
 			VIMAP_PARSER_CHECK(SPACE);
 			VIMAP_PARSER_GET(IMAPParser::resp_cond_state, m_resp_cond_state);
 
@@ -5357,10 +5598,12 @@ public:
 
 	private:
 
+		IMAPParser::xtag* m_xtag;
 		IMAPParser::resp_cond_state* m_resp_cond_state;
 
 	public:
 
+		const IMAPParser::xtag* tag() const { return (m_xtag); }
 		const IMAPParser::resp_cond_state* resp_cond_state() const { return (m_resp_cond_state); }
 	};
 
@@ -5439,17 +5682,29 @@ public:
 
 			while ((resp = parser.get <IMAPParser::continue_req_or_response_data>(curLine, &pos)))
 			{
-				m_continue_req_or_response_data.push_back(resp);
-
 				// Partial response (continue_req)
 				if (resp->continue_req())
 				{
+					m_continue_req_or_response_data.push_back(resp);
+
 					partial = true;
 					break;
 				}
 
+				// Give the handler a chance to process the untagged
+				// response now, so that it is not kept in memory
+				if (parser.m_responseHandler != NULL &&
+				    parser.m_responseHandler->handleResponseData(resp->response_data()))
+				{
+					delete (resp);
+				}
+				else
+				{
+					m_continue_req_or_response_data.push_back(resp);
+				}
+
 				// We have read a CRLF, read another line
-				curLine = parser.readLine();
+				parser.readLine(curLine);
 				pos = 0;
 			}
 
@@ -5569,17 +5824,19 @@ public:
 	// The main functions used to parse a response
 	//
 
-	response* readResponse(literalHandler* lh = NULL)
+	response* readResponse(literalHandler* lh = NULL, responseHandler* rh = NULL)
 	{
 		size_t pos = 0;
 		string line = readLine();
 
 		m_literalHandler = lh;
+		m_responseHandler = rh;
 		response* resp = get <response>(line, &pos);
 		m_literalHandler = NULL;
+		m_responseHandler = NULL;
 
 		if (!resp)
-			throw exceptions::invalid_response("", m_errorResponseLine);
+			throw exceptions::invalid_response("", getErrorResponseLine());
 
 		resp->setErrorLog(lastLine());
 
@@ -5595,7 +5852,7 @@ public:
 		greeting* greet = get <greeting>(line, &pos);
 
 		if (!greet)
-			throw exceptions::invalid_response("", m_errorResponseLine);
+			throw exceptions::invalid_response("", getErrorResponseLine());
 
 		greet->setErrorLog(lastLine());
 
@@ -5616,7 +5873,7 @@ public:
 	template <class TYPE>
 	TYPE* get(string& line, size_t* currentPos)
 	{
-		component* resp = new TYPE;
+		component* resp = new (m_arena) TYPE;
 		return internalGet <TYPE>(resp, line, currentPos);
 	}
 
@@ -5638,7 +5895,7 @@ public:
 	TYPE* getWithArgs(string& line, size_t* currentPos,
 	                  ARG1_TYPE arg1, ARG2_TYPE arg2)
 	{
-		component* resp = new TYPE(arg1, arg2);
+		component* resp = new (m_arena) TYPE(arg1, arg2);
 		return internalGet <TYPE>(resp, line, currentPos);
 	}
 
@@ -5661,6 +5918,36 @@ private:
 		return static_cast <TYPE*>(resp);
 	}
 
+	/** Remember the position at which parsing failed. As most failures
+	  * only make the parser try another alternative, the line is only
+	  * copied once, and the error message is built on demand.
+	  *
+	  * @param comp name of the component which failed
+	  * @param line line which is currently being parsed
+	  * @param pos position in the line at which parsing failed
+	  */
+	void setErrorPosition(const string& comp, const string& line, const size_t pos)
+	{
+		// Lines are only modified by appending newly read lines
+		if (m_errorLineCount != m_lineCount || m_errorLine.length() != line.length())
+		{
+			m_errorLine = line;
+			m_errorLineCount = m_lineCount;
+		}
+
+		m_errorComponent = comp;
+		m_errorPos = pos;
+	}
+
+	/** Return a description of the position at which parsing failed.
+	  *
+	  * @return line with the position of the error
+	  */
+	const string getErrorResponseLine() const
+	{
+		return component::makeResponseLine(m_errorComponent, m_errorLine, m_errorPos);
+	}
+
 	const string lastLine() const
 	{
 		// Remove blanks and new lines at the end of the line.
@@ -5745,6 +6032,7 @@ public:
 private:
 
 	weak_ptr <IMAPTag> m_tag;
+	std::vector <string> m_pendingTags;
 	weak_ptr <socket> m_socket;
 	shared_ptr <tracer> m_tracer;
 
@@ -5753,14 +6041,24 @@ private:
 	bool m_strict;
 
 	literalHandler* m_literalHandler;
+	responseHandler* m_responseHandler;
 
 	weak_ptr <timeoutHandler> m_timeoutHandler;
 
+	componentArena m_arena;
+
 
 	string m_buffer;
+	size_t m_bufferPos;   // position of the first byte not read yet in m_buffer
 
 	string m_lastLine;
-	string m_errorResponseLine;
+
+	unsigned long m_lineCount;   // number of lines read
+
+	string m_errorLine;
+	unsigned long m_errorLineCount;
+	size_t m_errorPos;
+	string m_errorComponent;
 
 public:
 
@@ -5771,19 +6069,37 @@ public:
 	  * @return next line
 	  */
 	const string readLine()
+	{
+		string line;
+		readLine(line);
+
+		return (line);
+	}
+
+	/** Read a line from the input buffer. The function blocks until a
+	  * complete line is read from the buffer. Position in input buffer
+	  * will be updated.
+	  *
+	  * @param line will receive the next line (the storage already
+	  * allocated for the string is reused)
+	  */
+	void readLine(string& line)
 	{
 		size_t pos;
+		size_t searched = 0;  // bytes already searched for a LF
 
-		while ((pos = m_buffer.find('\n')) == string::npos)
+		while ((pos = m_buffer.find('\n', m_bufferPos + searched)) == string::npos)
 		{
+			searched = m_buffer.length() - m_bufferPos;
 			read();
 		}
 
-		string line;
-		line.resize(pos + 1);
-		std::copy(m_buffer.begin(), m_buffer.begin() + pos + 1, line.begin());
+		// Lines are not removed from the buffer one at a time: data
+		// before m_bufferPos is discarded when the buffer is refilled
+		line.assign(m_buffer, m_bufferPos, pos + 1 - m_bufferPos);
+		m_bufferPos = pos + 1;
 
-		m_buffer.erase(m_buffer.begin(), m_buffer.begin() + pos + 1);
+		++m_lineCount;
 
 		m_lastLine = line;
 
@@ -5797,8 +6113,6 @@ public:
 			while (len != 0 && (line[len - 1] == '\r' || line[len - 1] == '\n')) --len;
 			m_tracer->traceReceive(line.substr(0, len));
 		}
-
-		return (line);
 	}
 
 	/** Fill in the input buffer with data available from the socket stream.
@@ -5814,6 +6128,13 @@ public:
 		if (toh)
 			toh->resetTimeOut();
 
+		// Discard data which has already been read
+		if (m_bufferPos != 0)
+		{
+			m_buffer.erase(0, m_bufferPos);
+			m_bufferPos = 0;
+		}
+
 		while (receiveBuffer.empty())
 		{
 			// Check whether the time-out delay is elapsed
@@ -5841,7 +6162,10 @@ public:
 				toh->resetTimeOut();
 		}
 
-		m_buffer += receiveBuffer;
+		if (m_buffer.empty())
+			m_buffer.swap(receiveBuffer);
+		else
+			m_buffer += receiveBuffer;
 	}
 
 
@@ -5859,21 +6183,34 @@ public:
 		if (toh)
 			toh->resetTimeOut();
 
-		if (!m_buffer.empty())
+		if (m_bufferPos < m_buffer.length())
 		{
-			if (m_buffer.length() > count)
+			const size_t available = m_buffer.length() - m_bufferPos;
+
+			if (available > count)
 			{
-				buffer.putData(string(m_buffer.begin(), m_buffer.begin() + count));
-				m_buffer.erase(m_buffer.begin(), m_buffer.begin() + count);
+				buffer.putData(string(m_buffer, m_bufferPos, count));
+				m_bufferPos += count;
 				len = count;
 			}
 			else
 			{
-				len += m_buffer.length();
-				buffer.putData(m_buffer);
+				len += available;
+
+				if (m_bufferPos == 0)
+					buffer.putData(m_buffer);
+				else
+					buffer.putData(string(m_buffer, m_bufferPos));
+
 				m_buffer.clear();
+				m_bufferPos = 0;
 			}
 		}
+		else
+		{
+			m_buffer.clear();
+			m_bufferPos = 0;
+		}
 
 		while (len < count)
 		{
@@ -5911,8 +6248,7 @@ public:
 				buffer.putData(string(receiveBuffer.begin(), receiveBuffer.begin() + remaining));
 
 				// Put the remaining data into the internal response buffer
-				receiveBuffer.erase(receiveBuffer.begin(), receiveBuffer.begin() + remaining);
-				m_buffer += receiveBuffer;
+				m_buffer.append(receiveBuffer, remaining, string::npos);
 
 				len = count;
 			}
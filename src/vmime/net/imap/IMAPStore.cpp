@@ -32,10 +32,13 @@
 #include "vmime/net/imap/IMAPConnection.hpp"
 #include "vmime/net/imap/IMAPFolderStatus.hpp"
 #include "vmime/net/imap/IMAPCommand.hpp"
+#include "vmime/net/imap/IMAPUtils.hpp"
 
 #include "vmime/exception.hpp"
 #include "vmime/platform.hpp"
 
+#include "vmime/utility/stringUtils.hpp"
+
 #include <map>
 
 
@@ -44,6 +47,89 @@ namespace net {
 namespace imap {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+//
+// IMAPStore_getFoldersStatusHandler
+//
+
+// Dispatches the data returned by pipelined STATUS commands to the folders.
+// Data is matched by mailbox name, as it may be received along with the
+// completion of another command.
+class IMAPStore_getFoldersStatusHandler : public IMAPConnection::commandResponseHandler
+{
+public:
+
+	IMAPStore_getFoldersStatusHandler
+		(const std::vector <shared_ptr <IMAPFolder> >& folders, const char hierarchySeparator)
+		: m_folders(folders), m_status(folders.size())
+	{
+		for (size_t i = 0 ; i < folders.size() ; ++i)
+		{
+			m_nameToIndex.insert(std::multimap <string, size_t>::value_type
+				(normalizeName(IMAPUtils::pathToString(hierarchySeparator, folders[i]->getFullPath())), i));
+		}
+	}
+
+	void handleCommandResponse(shared_ptr <IMAPCommand> /* cmd */, const IMAPParser::response* resp)
+	{
+		if (resp->isBad() || resp->response_done()->response_tagged()->
+			resp_cond_state()->status() != IMAPParser::resp_cond_state::OK)
+		{
+			throw exceptions::command_error("STATUS",
+				resp->getErrorLog(), "bad response");
+		}
+
+		const std::vector <IMAPParser::continue_req_or_response_data*>& respDataList =
+			resp->continue_req_or_response_data();
+
+		for (std::vector <IMAPParser::continue_req_or_response_data*>::const_iterator
+		     it = respDataList.begin() ; it != respDataList.end() ; ++it)
+		{
+			const IMAPParser::response_data* responseData = (*it)->response_data();
+
+			if (responseData == NULL || responseData->mailbox_data() == NULL ||
+			    responseData->mailbox_data()->type() != IMAPParser::mailbox_data::STATUS)
+			{
+				continue;
+			}
+
+			const IMAPParser::mailbox_data* mailboxData = responseData->mailbox_data();
+
+			typedef std::multimap <string, size_t>::const_iterator NameIterator;
+			const std::pair <NameIterator, NameIterator> range =
+				m_nameToIndex.equal_range(normalizeName(mailboxData->mailbox()->name()));
+
+			for (NameIterator jt = range.first ; jt != range.second ; ++jt)
+				m_status[(*jt).second] = m_folders[(*jt).second]->processStatusData(mailboxData);
+		}
+	}
+
+	const std::vector <shared_ptr <folderStatus> >& getStatus() const
+	{
+		return m_status;
+	}
+
+private:
+
+	static const string normalizeName(const string& name)
+	{
+		// INBOX is case-insensitive
+		if (utility::stringUtils::isStringEqualNoCase(name, "INBOX"))
+			return "INBOX";
+
+		return name;
+	}
+
+	const std::vector <shared_ptr <IMAPFolder> >& m_folders;
+	std::vector <shared_ptr <folderStatus> > m_status;
+
+	std::multimap <string, size_t> m_nameToIndex;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
 IMAPStore::IMAPStore(shared_ptr <session> sess, shared_ptr <security::authenticator> auth, const bool secured)
 	: store(sess, getInfosInstance(), auth), m_connection(null), m_isIMAPS(secured)
 {
@@ -205,6 +291,51 @@ void IMAPStore::noop()
 }
 
 
+std::vector <shared_ptr <folderStatus> > IMAPStore::getFoldersStatus
+	(const std::vector <shared_ptr <folder> >& folders)
+{
+	if (!isConnected())
+		throw exceptions::not_connected();
+
+	std::vector <shared_ptr <IMAPFolder> > imapFolders;
+	imapFolders.reserve(folders.size());
+
+	for (std::vector <shared_ptr <folder> >::const_iterator it = folders.begin() ;
+	     it != folders.end() ; ++it)
+	{
+		shared_ptr <IMAPFolder> imapFolder = dynamicCast <IMAPFolder>(*it);
+
+		if (!imapFolder || imapFolder->m_store.lock().get() != this)
+			throw exceptions::invalid_argument();
+
+		imapFolders.push_back(imapFolder);
+	}
+
+	IMAPStore_getFoldersStatusHandler handler(imapFolders, m_connection->hierarchySeparator());
+
+	for (std::vector <shared_ptr <IMAPFolder> >::const_iterator it = imapFolders.begin() ;
+	     it != imapFolders.end() ; ++it)
+	{
+		m_connection->queueCommand((*it)->createStatusCommand(m_connection), &handler);
+	}
+
+	m_connection->processQueuedCommands();
+
+	const std::vector <shared_ptr <folderStatus> >& status = handler.getStatus();
+
+	for (size_t i = 0 ; i < status.size() ; ++i)
+	{
+		if (!status[i])
+		{
+			throw exceptions::command_error("STATUS", "",
+				"no status returned for folder '" + imapFolders[i]->getName().getBuffer() + "'");
+		}
+	}
+
+	return status;
+}
+
+
 shared_ptr <IMAPConnection> IMAPStore::connection()
 {
 	return (m_connection);
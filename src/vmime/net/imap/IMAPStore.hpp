@@ -80,6 +80,18 @@ public:
 
 	void noop();
 
+	/** Request the status of several folders at once. STATUS commands
+	  * are pipelined, so that this costs a single round-trip to the
+	  * server instead of one per folder with folder::getStatus().
+	  *
+	  * @param folders folders of this store
+	  * @return status of each folder, in the same order
+	  * @throw exceptions::command_error if the status of a folder
+	  * could not be retrieved
+	  */
+	std::vector <shared_ptr <folderStatus> > getFoldersStatus
+		(const std::vector <shared_ptr <folder> >& folders);
+
 	int getCapabilities() const;
 
 	bool isIMAPS() const;
@@ -52,7 +52,8 @@ namespace maildir {
 maildirFolder::maildirFolder(const folder::path& path, shared_ptr <maildirStore> store)
 	: m_store(store), m_path(path),
 	  m_name(path.isEmpty() ? folder::path::component("") : path.getLastComponent()),
-	  m_mode(-1), m_open(false), m_unreadMessageCount(0), m_messageCount(0)
+	  m_mode(-1), m_open(false), m_unreadMessageCount(0), m_messageCount(0),
+	  m_newDirModTime(-1), m_curDirModTime(-1)
 {
 	store->registerFolder(this);
 }
@@ -137,6 +138,9 @@ void maildirFolder::open(const int mode, bool /* failIfModeIsNotAvailable */)
 	else if (!exists())
 		throw exceptions::illegal_state("Folder does not exist");
 
+	// Always do a full scan when opening the folder
+	m_newDirModTime = m_curDirModTime = -1;
+
 	scanFolder();
 
 	m_open = true;
@@ -274,9 +278,6 @@ void maildirFolder::scanFolder()
 
 	try
 	{
-		m_messageCount = 0;
-		m_unreadMessageCount = 0;
-
 		shared_ptr <utility::fileSystemFactory> fsf = platform::getHandler()->getFileSystemFactory();
 
 		utility::file::path newDirPath = store->getFormat()->folderPathToFileSystemPath
@@ -287,6 +288,22 @@ void maildirFolder::scanFolder()
 			(m_path, maildirFormat::CUR_DIRECTORY);
 		shared_ptr <utility::file> curDir = fsf->create(curDirPath);
 
+		// Messages are delivered, flagged or expunged by creating, renaming
+		// or removing files, which updates the modification time of the
+		// directories: if they have not changed, neither has the folder
+		const time_t scanTime = ::time(NULL);
+
+		const time_t newDirModTime = newDir->getLastModificationTime();
+		const time_t curDirModTime = curDir->getLastModificationTime();
+
+		if (newDirModTime == m_newDirModTime && curDirModTime == m_curDirModTime)
+			return;
+
+		m_newDirModTime = m_curDirModTime = -1;
+
+		m_messageCount = 0;
+		m_unreadMessageCount = 0;
+
 		// New received messages (new/)
 		shared_ptr <utility::fileIterator> nit = newDir->getFiles();
 		std::vector <utility::file::path::component> newMessageFilenames;
@@ -311,33 +328,41 @@ void maildirFolder::scanFolder()
 				curMessageFilenames.push_back(file->getFullPath().getLastComponent());
 		}
 
+		// Index the files in 'cur' by message id.
+		// NOTE: the flags may have changed (eg. moving from 'new' to 'cur'
+		// may imply the 'S' flag) and so the filename. That's why we only
+		// use the 'unique' portion of the filename to identify messages...
+		std::map <string, size_t> curMessageIds;
+
+		for (size_t i = 0 ; i < curMessageFilenames.size() ; ++i)
+		{
+			curMessageIds.insert(std::map <string, size_t>::value_type
+				(maildirUtils::extractId(curMessageFilenames[i]).getBuffer(), i));
+		}
+
+		std::vector <bool> curMessageFound(curMessageFilenames.size(), false);
+
 		// Update/delete existing messages (found in previous scan)
 		for (unsigned int i = 0 ; i < m_messageInfos.size() ; ++i)
 		{
 			messageInfos& msgInfos = m_messageInfos[i];
 
-			// NOTE: the flags may have changed (eg. moving from 'new' to 'cur'
-			// may imply the 'S' flag) and so the filename. That's why we use
-			// "maildirUtils::messageIdComparator" to compare only the 'unique'
-			// portion of the filename...
-
 			if (msgInfos.type == messageInfos::TYPE_CUR)
 			{
-				const std::vector <utility::file::path::component>::iterator pos =
-					std::find_if(curMessageFilenames.begin(), curMessageFilenames.end(),
-						maildirUtils::messageIdComparator(msgInfos.path));
+				const std::map <string, size_t>::const_iterator pos =
+					curMessageIds.find(maildirUtils::extractId(msgInfos.path).getBuffer());
 
 				// If we cannot find this message in the 'cur' directory,
 				// it means it has been deleted (and expunged).
-				if (pos == curMessageFilenames.end())
+				if (pos == curMessageIds.end() || curMessageFound[pos->second])
 				{
 					msgInfos.type = messageInfos::TYPE_DELETED;
 				}
 				// Otherwise, update its information.
 				else
 				{
-					msgInfos.path = *pos;
-					curMessageFilenames.erase(pos);
+					msgInfos.path = curMessageFilenames[pos->second];
+					curMessageFound[pos->second] = true;
 				}
 			}
 		}
@@ -372,12 +397,14 @@ void maildirFolder::scanFolder()
 
 		// Add new messages from 'cur': the files have already been moved
 		// from 'new' to 'cur'. Just append them to our message list.
-		for (std::vector <utility::file::path::component>::const_iterator
-		     it = curMessageFilenames.begin() ; it != curMessageFilenames.end() ; ++it)
+		for (size_t i = 0 ; i < curMessageFilenames.size() ; ++i)
 		{
+			if (curMessageFound[i])
+				continue;
+
 			// Append to message list
 			messageInfos msgInfos;
-			msgInfos.path = *it;
+			msgInfos.path = curMessageFilenames[i];
 
 			if (maildirUtils::extractFlags(msgInfos.path) & message::FLAG_DELETED)
 				msgInfos.type = messageInfos::TYPE_DELETED;
@@ -399,6 +426,19 @@ void maildirFolder::scanFolder()
 
 		m_unreadMessageCount = unreadMessageCount;
 		m_messageCount = m_messageInfos.size();
+
+		// Directories modified in the same second as the scan may be
+		// modified again without their time changing (and moving messages
+		// from 'new' modified them just now): only skip the next scan if
+		// they were last modified before this one. If the file system does
+		// not provide modification times, always do a full scan.
+		if (newMessageFilenames.empty() &&
+		    newDirModTime != 0 && newDirModTime < scanTime &&
+		    curDirModTime != 0 && curDirModTime < scanTime)
+		{
+			m_newDirModTime = newDirModTime;
+			m_curDirModTime = curDirModTime;
+		}
 	}
 	catch (exceptions::filesystem_exception&)
 	{
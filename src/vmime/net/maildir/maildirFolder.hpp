@@ -176,6 +176,11 @@ private:
 
 	std::vector <messageInfos> m_messageInfos;
 
+	// Modification times of the 'new' and 'cur' directories when the
+	// folder was last scanned, or -1 if it needs to be scanned again
+	time_t m_newDirModTime;
+	time_t m_curDirModTime;
+
 	// Instanciated message objects
 	std::vector <maildirMessage*> m_messages;
 };
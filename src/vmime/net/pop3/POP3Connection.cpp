@@ -35,6 +35,8 @@
 
 #include "vmime/security/digest/messageDigestFactory.hpp"
 
+#include "vmime/utility/stringUtils.hpp"
+
 #include "vmime/net/defaultConnectionInfos.hpp"
 
 #if VMIME_HAVE_SASL_SUPPORT
@@ -220,6 +222,8 @@ void POP3Connection::internalDisconnect()
 	m_secured = false;
 
 	m_cntInfos = null;
+
+	m_receivedData.clear();
 }
 
 
@@ -586,6 +590,7 @@ void POP3Connection::startTLS()
 		shared_ptr <tls::TLSSocket> tlsSocket =
 			tlsSession->getSocket(m_socket);
 
+		tlsSocket->setServer(m_cntInfos->getHost(), m_cntInfos->getPort());
 		tlsSocket->handshake();
 
 		m_socket = tlsSocket;
@@ -653,6 +658,83 @@ void POP3Connection::fetchCapabilities()
 }
 
 
+bool POP3Connection::hasCapability(const string& capa)
+{
+	const std::vector <string> capabilities = getCapabilities();
+	const string name = utility::stringUtils::toLower(capa);
+
+	for (size_t i = 0, n = capabilities.size() ; i < n ; ++i)
+	{
+		// Capability name is the first word of the line (eg. "SASL PLAIN LOGIN")
+		const string& line = capabilities[i];
+		const size_t end = std::min(line.find_first_of(" \t"), line.length());
+
+		if (end == name.length() && utility::stringUtils::isStringEqualNoCase
+				(line.begin(), line.begin() + end, name.data(), name.length()))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+size_t POP3Connection::getPipeliningWindowSize()
+{
+	if (HAS_PROPERTY(PROPERTY_OPTIONS_PIPELINING) &&
+	    !GET_PROPERTY(bool, PROPERTY_OPTIONS_PIPELINING))
+	{
+		return 1;
+	}
+
+	if (!hasCapability("PIPELINING"))
+		return 1;
+
+	const int window = GET_PROPERTY(int, PROPERTY_OPTIONS_PIPELINING_WINDOW);
+
+	return window > 1 ? static_cast <size_t>(window) : 1;
+}
+
+
+void POP3Connection::receive(string& buffer)
+{
+	if (!m_receivedData.empty())
+	{
+		buffer.clear();
+		buffer.swap(m_receivedData);
+	}
+	else
+	{
+		getSocket()->receive(buffer);
+	}
+}
+
+
+size_t POP3Connection::receiveRaw(byte_t* buffer, const size_t count)
+{
+	if (!m_receivedData.empty())
+	{
+		const size_t n = std::min(count, m_receivedData.length());
+
+		std::copy(m_receivedData.begin(), m_receivedData.begin() + n, buffer);
+		m_receivedData.erase(0, n);
+
+		return n;
+	}
+	else
+	{
+		return getSocket()->receiveRaw(buffer, count);
+	}
+}
+
+
+void POP3Connection::unreceive(const byte_t* data, const size_t count)
+{
+	m_receivedData.insert(0, reinterpret_cast <const char*>(data), count);
+}
+
+
 bool POP3Connection::isConnected() const
 {
 	return m_socket && m_socket->isConnected() && m_authenticated;
@@ -83,6 +83,50 @@ public:
 	virtual shared_ptr <session> getSession();
 	virtual shared_ptr <tracer> getTracer();
 
+	/** Receive data from the server. Data previously given back with
+	  * unreceive() is returned first.
+	  *
+	  * @param buffer buffer in which to store received data (empty
+	  * if no data is available for now)
+	  */
+	void receive(string& buffer);
+
+	/** Receive raw data from the server. Data previously given back
+	  * with unreceive() is returned first.
+	  *
+	  * @param buffer buffer in which to store received data
+	  * @param count maximum number of bytes to receive
+	  * @return number of bytes received (0 if no data is available
+	  * for now)
+	  */
+	size_t receiveRaw(byte_t* buffer, const size_t count);
+
+	/** Give back data that has been received but not consumed, so
+	  * that it is returned by the next call to receive() or receiveRaw().
+	  * This is used when the server sent more than one response at once.
+	  *
+	  * @param data data to give back
+	  * @param count number of bytes to give back
+	  */
+	void unreceive(const byte_t* data, const size_t count);
+
+	/** Check whether the server advertised the specified capability
+	  * in its response to the CAPA command.
+	  *
+	  * @param capa capability name (case-insensitive)
+	  * @return true if the server supports this capability, or
+	  * false otherwise
+	  */
+	bool hasCapability(const string& capa);
+
+	/** Return the maximum number of commands that can be sent to the
+	  * server before reading their responses.
+	  *
+	  * @return pipelining window size, or 1 if pipelining is not
+	  * supported or has been disabled
+	  */
+	size_t getPipeliningWindowSize();
+
 private:
 
 	void authenticate(const messageId& randomMID);
@@ -115,6 +159,8 @@ private:
 
 	std::vector <string> m_capabilities;
 	bool m_capabilitiesFetched;
+
+	string m_receivedData;
 };
 
 
@@ -39,12 +39,148 @@
 
 #include "vmime/exception.hpp"
 
+#include <memory>
+
 
 namespace vmime {
 namespace net {
 namespace pop3 {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+/** Sends a sequence of commands and reads their responses in order.
+  * If the server supports pipelining, several commands are sent
+  * before reading the responses.
+  */
+class POP3CommandPipeline
+{
+public:
+
+	POP3CommandPipeline(shared_ptr <POP3Connection> conn)
+		: m_conn(conn)
+	{
+	}
+
+	virtual ~POP3CommandPipeline()
+	{
+	}
+
+	/** Send the commands and read the responses. If a command fails,
+	  * no more commands are sent but the responses to the commands
+	  * already sent are read, so that the connection stays in sync.
+	  *
+	  * @param count number of commands
+	  * @throw exceptions::command_error the first error that occurred
+	  */
+	void run(const size_t count)
+	{
+		const size_t window = m_conn->getPipeliningWindowSize();
+
+		std::auto_ptr <exceptions::command_error> error;
+		size_t sent = 0, received = 0;
+
+		while (received < sent || (!error.get() && sent < count))
+		{
+			while (!error.get() && sent < count && sent - received < window)
+				sendCommand(sent++);
+
+			try
+			{
+				readResponse(received++);
+			}
+			catch (exceptions::command_error& e)
+			{
+				if (!error.get())
+					error.reset(new exceptions::command_error(e));
+			}
+		}
+
+		if (error.get())
+			throw *error;
+	}
+
+protected:
+
+	virtual void sendCommand(const size_t index) = 0;
+	virtual void readResponse(const size_t index) = 0;
+
+	shared_ptr <POP3Connection> m_conn;
+};
+
+
+/** Retrieves the header of messages with the "TOP" command.
+  */
+class POP3Folder_fetchHeadersPipeline : public POP3CommandPipeline
+{
+public:
+
+	POP3Folder_fetchHeadersPipeline
+		(shared_ptr <POP3Connection> conn, const std::vector <shared_ptr <POP3Message> >& msgs,
+		 utility::progressListener* progress, const size_t total)
+		: POP3CommandPipeline(conn), m_msgs(msgs), m_progress(progress), m_total(total)
+	{
+	}
+
+protected:
+
+	void sendCommand(const size_t index)
+	{
+		POP3Command::TOP(m_msgs[index]->m_num, 0)->send(m_conn);
+	}
+
+	void readResponse(const size_t index)
+	{
+		m_msgs[index]->readHeader(m_conn);
+
+		if (m_progress)
+			m_progress->progress(index + 1, m_total);
+	}
+
+private:
+
+	const std::vector <shared_ptr <POP3Message> >& m_msgs;
+
+	utility::progressListener* m_progress;
+	const size_t m_total;
+};
+
+
+/** Marks messages as deleted with the "DELE" command.
+  */
+class POP3Folder_deleteMessagesPipeline : public POP3CommandPipeline
+{
+public:
+
+	POP3Folder_deleteMessagesPipeline
+		(shared_ptr <POP3Connection> conn, const std::vector <int>& nums)
+		: POP3CommandPipeline(conn), m_nums(nums)
+	{
+	}
+
+protected:
+
+	void sendCommand(const size_t index)
+	{
+		POP3Command::DELE(m_nums[index])->send(m_conn);
+	}
+
+	void readResponse(const size_t /* index */)
+	{
+		shared_ptr <POP3Response> response = POP3Response::readResponse(m_conn);
+
+		if (!response->isSuccess())
+			throw exceptions::command_error("DELE", response->getFirstLine());
+	}
+
+private:
+
+	const std::vector <int>& m_nums;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
 POP3Folder::POP3Folder(const folder::path& path, shared_ptr <POP3Store> store)
 	: m_store(store), m_path(path),
 	  m_name(path.isEmpty() ? folder::path::component("") : path.getLastComponent()),
@@ -326,21 +462,30 @@ void POP3Folder::fetchMessages(std::vector <shared_ptr <message> >& msg, const f
 		return;
 
 	const size_t total = msg.size();
-	size_t current = 0;
 
 	if (progress)
 		progress->start(total);
 
+	// Find the messages for which the header has to be retrieved
+	shared_ptr <POP3Folder> thisFolder = dynamicCast <POP3Folder>(shared_from_this());
+	std::vector <shared_ptr <POP3Message> > headerMsgs;
+
 	for (std::vector <shared_ptr <message> >::iterator it = msg.begin() ;
 	     it != msg.end() ; ++it)
 	{
-		dynamicCast <POP3Message>(*it)->fetch
-			(dynamicCast <POP3Folder>(shared_from_this()), options);
+		shared_ptr <POP3Message> m = dynamicCast <POP3Message>(*it);
 
-		if (progress)
-			progress->progress(++current, total);
+		if (m->checkFetchAttributes(thisFolder, options))
+			headerMsgs.push_back(m);
 	}
 
+	// Send the "TOP" commands (pipelined, if possible)
+	POP3Folder_fetchHeadersPipeline(store->getConnection(), headerMsgs, progress, total)
+		.run(headerMsgs.size());
+
+	if (progress && headerMsgs.size() < total)
+		progress->progress(total, total);
+
 	if (options.has(fetchAttributes::SIZE))
 	{
 		// Send the "LIST" command
@@ -568,17 +713,8 @@ void POP3Folder::deleteMessages(const messageSet& msgs)
 	else if (!isOpen())
 		throw exceptions::illegal_state("Folder not open");
 
-	for (std::vector <int>::const_iterator
-	     it = nums.begin() ; it != nums.end() ; ++it)
-	{
-		POP3Command::DELE(*it)->send(store->getConnection());
-
-		shared_ptr <POP3Response> response =
-			POP3Response::readResponse(store->getConnection());
-
-		if (!response->isSuccess())
-			throw exceptions::command_error("DELE", response->getFirstLine());
-	}
+	// Send the "DELE" commands (pipelined, if possible)
+	POP3Folder_deleteMessagesPipeline(store->getConnection(), nums).run(nums.size());
 
 	// Sort message list
 	std::vector <int> list;
@@ -32,6 +32,7 @@
 #include "vmime/net/pop3/POP3Response.hpp"
 #include "vmime/net/pop3/POP3Folder.hpp"
 #include "vmime/net/pop3/POP3Store.hpp"
+#include "vmime/net/pop3/POP3Connection.hpp"
 
 #include "vmime/utility/outputStreamAdapter.hpp"
 #include "vmime/utility/outputStreamStringAdapter.hpp"
@@ -183,6 +184,25 @@ void POP3Message::fetchPartHeader(shared_ptr <messagePart> /* p */)
 
 
 void POP3Message::fetch(shared_ptr <POP3Folder> msgFolder, const fetchAttributes& options)
+{
+	if (!checkFetchAttributes(msgFolder, options))
+		return;
+
+	// No need to differenciate between ENVELOPE, CONTENT_INFO, ...
+	// since POP3 only permits to retrieve the whole header and not
+	// fields in particular.
+
+	// Emit the "TOP" command
+	shared_ptr <POP3Store> store = msgFolder->m_store.lock();
+
+	POP3Command::TOP(m_num, 0)->send(store->getConnection());
+
+	readHeader(store->getConnection());
+}
+
+
+bool POP3Message::checkFetchAttributes
+	(shared_ptr <POP3Folder> msgFolder, const fetchAttributes& options) const
 {
 	shared_ptr <POP3Folder> folder = m_folder.lock();
 
@@ -198,24 +218,18 @@ void POP3Message::fetch(shared_ptr <POP3Folder> msgFolder, const fetchAttributes
 		fetchAttributes::ENVELOPE | fetchAttributes::CONTENT_INFO |
 		fetchAttributes::FULL_HEADER | fetchAttributes::IMPORTANCE;
 
-	if (!options.has(optionsRequiringHeader))
-		return;
-
-	// No need to differenciate between ENVELOPE, CONTENT_INFO, ...
-	// since POP3 only permits to retrieve the whole header and not
-	// fields in particular.
-
-	// Emit the "TOP" command
-	shared_ptr <POP3Store> store = folder->m_store.lock();
+	return options.has(optionsRequiringHeader);
+}
 
-	POP3Command::TOP(m_num, 0)->send(store->getConnection());
 
+void POP3Message::readHeader(shared_ptr <POP3Connection> conn)
+{
 	try
 	{
 		string buffer;
 		utility::outputStreamStringAdapter bufferStream(buffer);
 
-		POP3Response::readLargeResponse(store->getConnection(),
+		POP3Response::readLargeResponse(conn,
 			bufferStream, /* progress */ NULL, /* predictedSize */ 0);
 
 		m_header = make_shared <header>();
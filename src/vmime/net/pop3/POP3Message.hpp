@@ -41,6 +41,7 @@ namespace pop3 {
 
 
 class POP3Folder;
+class POP3Connection;
 
 
 /** POP3 message implementation.
@@ -51,6 +52,7 @@ class VMIME_EXPORT POP3Message : public message
 private:
 
 	friend class POP3Folder;
+	friend class POP3Folder_fetchHeadersPipeline;
 
 	POP3Message(const POP3Message&);
 
@@ -98,6 +100,21 @@ private:
 
 	void fetch(shared_ptr <POP3Folder> folder, const fetchAttributes& options);
 
+	/** Check whether the specified attributes can be fetched for this
+	  * message, and whether the header has to be retrieved for this.
+	  *
+	  * @param folder folder from which the message is fetched
+	  * @param options attributes to fetch
+	  * @return true if the "TOP" command has to be sent, false otherwise
+	  */
+	bool checkFetchAttributes(shared_ptr <POP3Folder> folder, const fetchAttributes& options) const;
+
+	/** Read the response to the "TOP" command and parse the header.
+	  *
+	  * @param conn connection from which to read
+	  */
+	void readHeader(shared_ptr <POP3Connection> conn);
+
 	void onFolderClosed();
 
 	weak_ptr <POP3Folder> m_folder;
@@ -34,8 +34,8 @@
 
 #include "vmime/utility/stringUtils.hpp"
 #include "vmime/utility/filteredStream.hpp"
-#include "vmime/utility/stringUtils.hpp"
-#include "vmime/utility/inputStreamSocketAdapter.hpp"
+
+#include <cstring>
 
 #include "vmime/net/socket.hpp"
 #include "vmime/net/timeoutHandler.hpp"
@@ -46,8 +46,121 @@ namespace net {
 namespace pop3 {
 
 
-POP3Response::POP3Response(shared_ptr <socket> sok, shared_ptr <timeoutHandler> toh, shared_ptr <tracer> tracer)
-	: m_socket(sok), m_timeoutHandler(toh), m_tracer(tracer)
+#ifndef VMIME_BUILDING_DOC
+
+/** Finds the end of a POP3 response in received data, so that data
+  * belonging to the next responses (if commands have been pipelined)
+  * is not consumed.
+  */
+class POP3ResponseScanner
+{
+public:
+
+	POP3ResponseScanner()
+		: m_state(STATE_FIRST_LINE), m_singleLine(false),
+		  m_lineStart(true), m_dotLine(0)
+	{
+	}
+
+	/** Scan received data.
+	  *
+	  * @param data received data
+	  * @param count number of bytes received
+	  * @return number of bytes which belong to the response
+	  */
+	size_t scan(const byte_t* data, const size_t count)
+	{
+		size_t pos = 0;
+
+		while (pos < count && m_state != STATE_DONE)
+		{
+			// Inside a line: skip directly to the end of line
+			if (m_state == STATE_BODY && !m_lineStart && m_dotLine == 0)
+			{
+				const byte_t* eol = static_cast <const byte_t*>
+					(std::memchr(data + pos, '\n', count - pos));
+
+				if (eol == NULL)
+					return count;
+
+				pos = eol - data;
+			}
+
+			processChar(data[pos++]);
+		}
+
+		return pos;
+	}
+
+	bool isComplete() const
+	{
+		return m_state == STATE_DONE;
+	}
+
+private:
+
+	void processChar(const char c)
+	{
+		if (m_state == STATE_FIRST_LINE)
+		{
+			// Error responses consist of a single line
+			if (m_lineStart && c != '+')
+				m_singleLine = true;
+
+			m_lineStart = false;
+
+			if (c == '\n')
+			{
+				m_state = (m_singleLine ? STATE_DONE : STATE_BODY);
+				m_lineStart = true;
+			}
+		}
+		else if (m_dotLine == 0)
+		{
+			if (m_lineStart && c == '.')
+				m_dotLine = 1;
+
+			m_lineStart = (c == '\n');
+		}
+		else
+		{
+			// Response ends with a line containing a single dot
+			if (c == '\n')
+			{
+				m_state = STATE_DONE;
+			}
+			else if (c == '\r' && m_dotLine == 1)
+			{
+				m_dotLine = 2;
+			}
+			else
+			{
+				m_dotLine = 0;
+				m_lineStart = false;
+			}
+		}
+	}
+
+
+	enum State
+	{
+		STATE_FIRST_LINE,
+		STATE_BODY,
+		STATE_DONE
+	};
+
+	State m_state;
+	bool m_singleLine;
+	bool m_lineStart;
+	int m_dotLine;   // 1 after '.' at line start, 2 after '.' + CR
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
+
+POP3Response::POP3Response(shared_ptr <POP3Connection> conn)
+	: m_conn(conn), m_timeoutHandler(conn->getTimeoutHandler()), m_tracer(conn->getTracer())
 {
 }
 
@@ -55,8 +168,7 @@ POP3Response::POP3Response(shared_ptr <socket> sok, shared_ptr <timeoutHandler>
 // static
 shared_ptr <POP3Response> POP3Response::readResponse(shared_ptr <POP3Connection> conn)
 {
-	shared_ptr <POP3Response> resp = shared_ptr <POP3Response>
-		(new POP3Response(conn->getSocket(), conn->getTimeoutHandler(), conn->getTracer()));
+	shared_ptr <POP3Response> resp = shared_ptr <POP3Response>(new POP3Response(conn));
 
 	string buffer;
 	resp->readResponseImpl(buffer, /* multiLine */ false);
@@ -75,8 +187,7 @@ shared_ptr <POP3Response> POP3Response::readResponse(shared_ptr <POP3Connection>
 // static
 shared_ptr <POP3Response> POP3Response::readMultilineResponse(shared_ptr <POP3Connection> conn)
 {
-	shared_ptr <POP3Response> resp = shared_ptr <POP3Response>
-		(new POP3Response(conn->getSocket(), conn->getTimeoutHandler(), conn->getTracer()));
+	shared_ptr <POP3Response> resp = shared_ptr <POP3Response>(new POP3Response(conn));
 
 	string buffer;
 	resp->readResponseImpl(buffer, /* multiLine */ true);
@@ -115,8 +226,7 @@ shared_ptr <POP3Response> POP3Response::readLargeResponse
 	(shared_ptr <POP3Connection> conn, utility::outputStream& os,
 	 utility::progressListener* progress, const size_t predictedSize)
 {
-	shared_ptr <POP3Response> resp = shared_ptr <POP3Response>
-		(new POP3Response(conn->getSocket(), conn->getTimeoutHandler(), conn->getTracer()));
+	shared_ptr <POP3Response> resp = shared_ptr <POP3Response>(new POP3Response(conn));
 
 	string firstLine;
 	const size_t length = resp->readResponseImpl(firstLine, os, progress, predictedSize);
@@ -128,7 +238,7 @@ shared_ptr <POP3Response> POP3Response::readLargeResponse
 	if (resp->m_tracer)
 	{
 		resp->m_tracer->traceReceive(firstLine);
-		resp->m_tracer->traceReceiveBytes(length - firstLine.length());
+		resp->m_tracer->traceReceiveBytes(length);
 		resp->m_tracer->traceReceive(".");
 	}
 
@@ -174,16 +284,16 @@ size_t POP3Response::getLineCount() const
 
 void POP3Response::readResponseImpl(string& buffer, const bool multiLine)
 {
-	bool foundTerminator = false;
-
 	if (m_timeoutHandler)
 		m_timeoutHandler->resetTimeOut();
 
 	buffer.clear();
 
-	char last1 = '\0', last2 = '\0';
+	shared_ptr <socket> sok = m_conn->getSocket();
 
-	for ( ; !foundTerminator ; )
+	size_t searchPos = 0, contentEnd = 0, responseEnd = 0;
+
+	while (!findTerminator(buffer, multiLine, searchPos, &contentEnd, &responseEnd))
 	{
 		// Check whether the time-out delay is elapsed
 		if (m_timeoutHandler && m_timeoutHandler->isTimeOut())
@@ -196,14 +306,14 @@ void POP3Response::readResponseImpl(string& buffer, const bool multiLine)
 
 		// Receive data from the socket
 		string receiveBuffer;
-		m_socket->receive(receiveBuffer);
+		m_conn->receive(receiveBuffer);
 
 		if (receiveBuffer.empty())   // buffer is empty
 		{
-			if (m_socket->getStatus() & socket::STATUS_WANT_WRITE)
-				m_socket->waitForWrite();
+			if (sok->getStatus() & socket::STATUS_WANT_WRITE)
+				sok->waitForWrite();
 			else
-				m_socket->waitForRead();
+				sok->waitForRead();
 
 			continue;
 		}
@@ -212,43 +322,24 @@ void POP3Response::readResponseImpl(string& buffer, const bool multiLine)
 		if (m_timeoutHandler)
 			m_timeoutHandler->resetTimeOut();
 
-		// Check for transparent characters: '\n..' becomes '\n.'
-		const char first = receiveBuffer[0];
-
-		if (first == '.' && last2 == '\n' && last1 == '.')
-		{
-			receiveBuffer.erase(receiveBuffer.begin());
-		}
-		else if (receiveBuffer.length() >= 2 && first == '.' &&
-		         receiveBuffer[1] == '.' && last1 == '\n')
-		{
-			receiveBuffer.erase(receiveBuffer.begin());
-		}
-
-		for (size_t trans ;
-		     string::npos != (trans = receiveBuffer.find("\n..")) ; )
-		{
-			receiveBuffer.replace(trans, 3, "\n.");
-		}
-
-		last1 = receiveBuffer[receiveBuffer.length() - 1];
-		last2 = static_cast <char>((receiveBuffer.length() >= 2) ? receiveBuffer[receiveBuffer.length() - 2] : 0);
-
 		// Append the data to the response buffer
-		buffer += receiveBuffer;
+		if (buffer.empty())
+			buffer.swap(receiveBuffer);
+		else
+			buffer += receiveBuffer;
+	}
 
-		// Check for terminator string (and strip it if present)
-		foundTerminator = checkTerminator(buffer, multiLine);
+	// Data following the terminator belongs to the next response(s), if
+	// commands have been pipelined: keep it for the next read
+	if (responseEnd < buffer.length())
+		m_conn->unreceive(utility::stringUtils::bytesFromString(buffer) + responseEnd,
+		                  buffer.length() - responseEnd);
 
-		// If there is an error (-ERR) when executing a command that
-		// requires a multi-line response, the error response will
-		// include only one line, so we stop waiting for a multi-line
-		// terminator and check for a "normal" one.
-		if (multiLine && !foundTerminator && buffer.length() >= 4 && buffer[0] == '-')
-		{
-			foundTerminator = checkTerminator(buffer, false);
-		}
-	}
+	// Strip terminator
+	buffer.erase(contentEnd);
+
+	// Check for transparent characters: '\n..' becomes '\n.'
+	unstuffDots(buffer);
 }
 
 
@@ -258,23 +349,22 @@ size_t POP3Response::readResponseImpl
 {
 	size_t current = 0, total = predictedSize;
 
-	string temp;
-	bool codeDone = false;
-
 	if (progress)
 		progress->start(total);
 
 	if (m_timeoutHandler)
 		m_timeoutHandler->resetTimeOut();
 
-	utility::inputStreamSocketAdapter sis(*m_socket);
-	utility::stopSequenceFilteredInputStream <5> sfis1(sis, "\r\n.\r\n");
-	utility::stopSequenceFilteredInputStream <3> sfis2(sfis1, "\n.\n");
-	utility::dotFilteredInputStream dfis(sfis2);   // "\n.." --> "\n."
+	shared_ptr <socket> sok = m_conn->getSocket();
+
+	POP3ResponseScanner scanner;
+	utility::dotUnstuffingFilteredOutputStream dos(os);   // "\n.." --> "\n."
+
+	firstLine.clear();
 
-	utility::inputStream& is = dfis;
+	bool codeDone = false;
 
-	while (!is.eof())
+	while (!scanner.isComplete())
 	{
 		// Check whether the time-out delay is elapsed
 		if (m_timeoutHandler && m_timeoutHandler->isTimeOut())
@@ -285,24 +375,14 @@ size_t POP3Response::readResponseImpl
 
 		// Receive data from the socket
 		byte_t buffer[65536];
-		const size_t read = is.read(buffer, sizeof(buffer));
+		const size_t read = m_conn->receiveRaw(buffer, sizeof(buffer));
 
 		if (read == 0)   // buffer is empty
 		{
-			if (m_socket->getStatus() & socket::STATUS_WANT_WRITE)
-			{
-				m_socket->waitForWrite();
-			}
-			else if (m_socket->getStatus() & socket::STATUS_WANT_READ)
-			{
-				m_socket->waitForRead();
-			}
+			if (sok->getStatus() & socket::STATUS_WANT_WRITE)
+				sok->waitForWrite();
 			else
-			{
-				// Input stream needs more bytes to continue, but there
-				// is enough data into socket buffer. Do not waitForRead(),
-				// just retry read()ing on the stream.
-			}
+				sok->waitForRead();
 
 			continue;
 		}
@@ -311,39 +391,42 @@ size_t POP3Response::readResponseImpl
 		if (m_timeoutHandler)
 			m_timeoutHandler->resetTimeOut();
 
-		// Notify progress
-		current += read;
+		// Give back the data which belongs to the next response(s)
+		const size_t length = scanner.scan(buffer, read);
 
-		if (progress)
-		{
-			total = std::max(total, current);
-			progress->progress(current, total);
-		}
+		if (length < read)
+			m_conn->unreceive(buffer + length, read - length);
+
+		size_t pos = 0;
 
 		// If we don't have extracted the response code yet
 		if (!codeDone)
 		{
-			vmime::utility::stringUtils::appendBytesToString(temp, buffer, read);
+			const byte_t* eol = static_cast <const byte_t*>(std::memchr(buffer, '\n', length));
+			pos = (eol == NULL ? length : eol - buffer + 1);
 
-			string responseData;
-
-			if (stripFirstLine(temp, responseData, &firstLine) == true)
-			{
-				if (getResponseCode(firstLine) != CODE_OK)
-					throw exceptions::command_error("?", firstLine);
+			vmime::utility::stringUtils::appendBytesToString(firstLine, buffer, pos);
 
-				codeDone = true;
+			if (eol == NULL)
+				continue;
 
-				os.write(responseData.data(), responseData.length());
-				temp.clear();
+			firstLine = utility::stringUtils::trim(firstLine);
+			codeDone = true;
 
-				continue;
-			}
+			if (getResponseCode(firstLine) != CODE_OK)
+				throw exceptions::command_error("?", firstLine);
 		}
-		else
+
+		// Inject the data into the output stream
+		dos.write(buffer + pos, length - pos);
+
+		// Notify progress
+		current += length - pos;
+
+		if (progress)
 		{
-			// Inject the data into the output stream
-			os.write(buffer, read);
+			total = std::max(total, current);
+			progress->progress(current, total);
 		}
 	}
 
@@ -417,42 +500,86 @@ void POP3Response::stripResponseCode(const string& buffer, string& result)
 
 
 // static
-bool POP3Response::checkTerminator(string& buffer, const bool multiLine)
+bool POP3Response::findTerminator
+	(const string& buffer, const bool multiLine, size_t& searchPos,
+	 size_t* contentEnd, size_t* responseEnd)
 {
-	// Multi-line response
-	if (multiLine)
+	const size_t length = buffer.length();
+
+	// If there is an error (-ERR) when executing a command that
+	// requires a multi-line response, the error response will
+	// include only one line, so we do not wait for a multi-line
+	// terminator and check for a "normal" one.
+	if (!multiLine || (length != 0 && buffer[0] == '-'))
 	{
-		static const string term1("\r\n.\r\n");
-		static const string term2("\n.\n");
+		const size_t eol = buffer.find('\n', searchPos);
 
-		return (checkOneTerminator(buffer, term1) ||
-		        checkOneTerminator(buffer, term2));
+		if (eol == string::npos)
+		{
+			searchPos = length;
+			return false;
+		}
+
+		*responseEnd = eol + 1;
+		*contentEnd = (eol > 0 && buffer[eol - 1] == '\r') ? eol - 1 : eol;
+
+		return true;
 	}
-	// Normal response
-	else
+
+	// Multi-line response: search for a line containing a single dot
+	for (size_t pos ; (pos = buffer.find("\n.", searchPos)) != string::npos ; searchPos = pos + 1)
 	{
-		static const string term1("\r\n");
-		static const string term2("\n");
+		size_t end = pos + 2;
+
+		if (end < length && buffer[end] == '\r')
+			++end;
 
-		return (checkOneTerminator(buffer, term1) ||
-		        checkOneTerminator(buffer, term2));
+		// Incomplete line, wait for more data
+		if (end >= length)
+		{
+			searchPos = pos;
+			return false;
+		}
+
+		if (buffer[end] == '\n')
+		{
+			*responseEnd = end + 1;
+			*contentEnd = (pos > 0 && buffer[pos - 1] == '\r') ? pos - 1 : pos;
+
+			return true;
+		}
 	}
 
+	// Last byte may be the beginning of the terminator
+	searchPos = (length != 0 ? length - 1 : 0);
+
 	return false;
 }
 
 
 // static
-bool POP3Response::checkOneTerminator(string& buffer, const string& term)
+void POP3Response::unstuffDots(string& buffer)
 {
-	if (buffer.length() >= term.length() &&
-		std::equal(buffer.end() - term.length(), buffer.end(), term.begin()))
+	const size_t first = buffer.find("\n..");
+
+	if (first == string::npos)
+		return;
+
+	size_t out = first;
+
+	for (size_t in = first, length = buffer.length() ; in < length ; ++in)
 	{
-		buffer.erase(buffer.end() - term.length(), buffer.end());
-		return true;
+		buffer[out++] = buffer[in];
+
+		// Skip the first dot of "\n.."
+		if (buffer[in] == '\n' && in + 2 < length &&
+		    buffer[in + 1] == '.' && buffer[in + 2] == '.')
+		{
+			++in;
+		}
 	}
 
-	return false;
+	buffer.erase(out);
 }
 
 
@@ -144,7 +144,7 @@ public:
 
 private:
 
-	POP3Response(shared_ptr <socket> sok, shared_ptr <timeoutHandler> toh, shared_ptr <tracer> tracer);
+	POP3Response(shared_ptr <POP3Connection> conn);
 
 	void readResponseImpl(string& buffer, const bool multiLine);
 	size_t readResponseImpl
@@ -158,11 +158,14 @@ private:
 
 	static void stripResponseCode(const string& buffer, string& result);
 
-	static bool checkTerminator(string& buffer, const bool multiLine);
-	static bool checkOneTerminator(string& buffer, const string& term);
+	static bool findTerminator
+		(const string& buffer, const bool multiLine, size_t& searchPos,
+		 size_t* contentEnd, size_t* responseEnd);
 
+	static void unstuffDots(string& buffer);
 
-	shared_ptr <socket> m_socket;
+
+	shared_ptr <POP3Connection> m_conn;
 	shared_ptr <timeoutHandler> m_timeoutHandler;
 	shared_ptr <tracer> m_tracer;
 
@@ -57,6 +57,8 @@ const POP3ServiceInfos::props& POP3ServiceInfos::getProperties() const
 		// POP3-specific options
 		property("options.apop", serviceInfos::property::TYPE_BOOLEAN, "true"),
 		property("options.apop.fallback", serviceInfos::property::TYPE_BOOLEAN, "true"),
+		property("options.pipelining", serviceInfos::property::TYPE_BOOLEAN, "true"),
+		property("options.pipelining.window", serviceInfos::property::TYPE_INTEGER, "32"),
 #if VMIME_HAVE_SASL_SUPPORT
 		property("options.sasl", serviceInfos::property::TYPE_BOOLEAN, "true"),
 		property("options.sasl.fallback", serviceInfos::property::TYPE_BOOLEAN, "true"),
@@ -80,6 +82,8 @@ const POP3ServiceInfos::props& POP3ServiceInfos::getProperties() const
 		// POP3-specific options
 		property("options.apop", serviceInfos::property::TYPE_BOOLEAN, "true"),
 		property("options.apop.fallback", serviceInfos::property::TYPE_BOOLEAN, "true"),
+		property("options.pipelining", serviceInfos::property::TYPE_BOOLEAN, "true"),
+		property("options.pipelining.window", serviceInfos::property::TYPE_INTEGER, "32"),
 #if VMIME_HAVE_SASL_SUPPORT
 		property("options.sasl", serviceInfos::property::TYPE_BOOLEAN, "true"),
 		property("options.sasl.fallback", serviceInfos::property::TYPE_BOOLEAN, "true"),
@@ -110,6 +114,8 @@ const std::vector <serviceInfos::property> POP3ServiceInfos::getAvailablePropert
 	// POP3-specific options
 	list.push_back(p.PROPERTY_OPTIONS_APOP);
 	list.push_back(p.PROPERTY_OPTIONS_APOP_FALLBACK);
+	list.push_back(p.PROPERTY_OPTIONS_PIPELINING);
+	list.push_back(p.PROPERTY_OPTIONS_PIPELINING_WINDOW);
 #if VMIME_HAVE_SASL_SUPPORT
 	list.push_back(p.PROPERTY_OPTIONS_SASL);
 	list.push_back(p.PROPERTY_OPTIONS_SASL_FALLBACK);
@@ -53,6 +53,8 @@ public:
 		// POP3-specific options
 		serviceInfos::property PROPERTY_OPTIONS_APOP;
 		serviceInfos::property PROPERTY_OPTIONS_APOP_FALLBACK;
+		serviceInfos::property PROPERTY_OPTIONS_PIPELINING;
+		serviceInfos::property PROPERTY_OPTIONS_PIPELINING_WINDOW;
 #if VMIME_HAVE_SASL_SUPPORT
 		serviceInfos::property PROPERTY_OPTIONS_SASL;
 		serviceInfos::property PROPERTY_OPTIONS_SASL_FALLBACK;
@@ -50,8 +50,7 @@ SMTPChunkingOutputStreamAdapter::SMTPChunkingOutputStreamAdapter
 }
 
 
-void SMTPChunkingOutputStreamAdapter::sendChunk
-	(const byte_t* const data, const size_t count, const bool last)
+void SMTPChunkingOutputStreamAdapter::sendChunk(const size_t count, const bool last)
 {
 	if (count == 0 && !last)
 	{
@@ -59,9 +58,18 @@ void SMTPChunkingOutputStreamAdapter::sendChunk
 		return;
 	}
 
-	// Send this chunk
-	m_connection->sendRequest(SMTPCommand::BDAT(count, last));
-	m_connection->getSocket()->sendRaw(data, count);
+	// Send the BDAT command and this chunk at once: the command is
+	// written into the space reserved just before the chunk data
+	shared_ptr <SMTPCommand> cmd = SMTPCommand::BDAT(count, last);
+	const string cmdText = cmd->getText() + "\r\n";
+
+	byte_t* const chunk = m_buffer + COMMAND_SPACE - cmdText.length();
+	std::copy(cmdText.begin(), cmdText.end(), chunk);
+
+	m_connection->getSocket()->sendRaw(chunk, cmdText.length() + count);
+
+	if (m_connection->getTracer())
+		m_connection->getTracer()->traceSend(cmd->getTraceText());
 
 	++m_chunkCount;
 
@@ -120,19 +128,19 @@ void SMTPChunkingOutputStreamAdapter::writeImpl
 	while (curCount != 0)
 	{
 		// Fill the buffer
-		const size_t remaining = sizeof(m_buffer) - m_bufferSize;
+		const size_t remaining = CHUNK_SIZE - m_bufferSize;
 		const size_t bytesToCopy = std::min(remaining, curCount);
 
-		std::copy(curData, curData + bytesToCopy, m_buffer + m_bufferSize);
+		std::copy(curData, curData + bytesToCopy, m_buffer + COMMAND_SPACE + m_bufferSize);
 
 		m_bufferSize += bytesToCopy;
 		curData += bytesToCopy;
 		curCount -= bytesToCopy;
 
 		// If the buffer is full, send this chunk
-		if (m_bufferSize >= sizeof(m_buffer))
+		if (m_bufferSize >= CHUNK_SIZE)
 		{
-			sendChunk(m_buffer, m_bufferSize, /* last */ false);
+			sendChunk(m_bufferSize, /* last */ false);
 			m_bufferSize = 0;
 		}
 	}
@@ -141,7 +149,7 @@ void SMTPChunkingOutputStreamAdapter::writeImpl
 
 void SMTPChunkingOutputStreamAdapter::flush()
 {
-	sendChunk(m_buffer, m_bufferSize, /* last */ true);
+	sendChunk(m_bufferSize, /* last */ true);
 	m_bufferSize = 0;
 
 	if (m_progress)
@@ -154,7 +162,7 @@ void SMTPChunkingOutputStreamAdapter::flush()
 
 size_t SMTPChunkingOutputStreamAdapter::getBlockSize()
 {
-	return sizeof(m_buffer);
+	return CHUNK_SIZE;
 }
 
 
@@ -65,12 +65,21 @@ private:
 	SMTPChunkingOutputStreamAdapter(const SMTPChunkingOutputStreamAdapter&);
 
 
-	void sendChunk(const byte_t* const data, const size_t count, const bool last);
+	void sendChunk(const size_t count, const bool last);
+
+
+	/** Space reserved at the beginning of the buffer for the BDAT
+	  * command, so that the command and the chunk data are sent at once
+	  * (enough for "BDAT <64-bit size> LAST" followed by CRLF).
+	  */
+	static const size_t COMMAND_SPACE = 32;
+
+	static const size_t CHUNK_SIZE = 262144;  // 256 KB
 
 
 	shared_ptr <SMTPConnection> m_connection;
 
-	byte_t m_buffer[262144];  // 256 KB
+	byte_t m_buffer[COMMAND_SPACE + CHUNK_SIZE];
 	size_t m_bufferSize;
 
 	unsigned int m_chunkCount;
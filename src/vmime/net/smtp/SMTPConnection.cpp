@@ -504,6 +504,7 @@ void SMTPConnection::startTLS()
 		shared_ptr <tls::TLSSocket> tlsSocket =
 			tlsSession->getSocket(m_socket);
 
+		tlsSocket->setServer(m_cntInfos->getHost(), m_cntInfos->getPort());
 		tlsSocket->handshake();
 
 		m_socket = tlsSocket;
@@ -40,10 +40,10 @@
 
 #include "vmime/utility/filteredStream.hpp"
 #include "vmime/utility/stringUtils.hpp"
-#include "vmime/utility/outputStreamSocketAdapter.hpp"
+#include "vmime/utility/outputStreamBufferedSocketAdapter.hpp"
 #include "vmime/utility/streamUtils.hpp"
-#include "vmime/utility/outputStreamAdapter.hpp"
-#include "vmime/utility/inputStreamStringAdapter.hpp"
+
+#include <algorithm>
 
 
 namespace vmime {
@@ -51,6 +51,76 @@ namespace net {
 namespace smtp {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+/** Output stream which notifies a progress listener of the amount of
+  * data written through it. Notifications are sent at most once per
+  * block of data, as generated messages are written in small pieces.
+  */
+class SMTPTransport_progressOutputStream : public utility::filteredOutputStream
+{
+public:
+
+	SMTPTransport_progressOutputStream(utility::outputStream& os, const size_t total,
+	                                   utility::progressListener* progress)
+		: m_stream(os), m_blockSize(os.getBlockSize()), m_total(total),
+		  m_current(0), m_lastNotified(0), m_progress(progress)
+	{
+		if (m_progress)
+			m_progress->start(m_total);
+	}
+
+	utility::outputStream& getNextOutputStream()
+	{
+		return m_stream;
+	}
+
+	void flush()
+	{
+		m_stream.flush();
+	}
+
+	/** Notify the listener that all the data has been written.
+	  *
+	  * @return number of bytes written
+	  */
+	size_t stop()
+	{
+		if (m_progress)
+			m_progress->stop(m_current);
+
+		return m_current;
+	}
+
+protected:
+
+	void writeImpl(const byte_t* const data, const size_t count)
+	{
+		m_stream.write(data, count);
+		m_current += count;
+
+		if (m_progress && m_current - m_lastNotified >= m_blockSize)
+		{
+			m_progress->progress(m_current, std::max(m_current, m_total));
+			m_lastNotified = m_current;
+		}
+	}
+
+private:
+
+	utility::outputStream& m_stream;
+	const size_t m_blockSize;
+
+	const size_t m_total;
+	size_t m_current;
+	size_t m_lastNotified;
+
+	utility::progressListener* m_progress;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
 SMTPTransport::SMTPTransport(shared_ptr <session> sess, shared_ptr <security::authenticator> auth, const bool secured)
 	: transport(sess, getInfosInstance(), auth), m_isSMTPS(secured), m_needReset(false)
 {
@@ -307,16 +377,22 @@ void SMTPTransport::send
 	sendEnvelope(expeditor, recipients, sender, /* sendDATACommand */ true, size);
 
 	// Send the message data
-	// Stream copy with "\n." to "\n.." transformation
-	utility::outputStreamSocketAdapter sos(*m_connection->getSocket());
+	// Stream copy with "\n." to "\n.." transformation; small writes from
+	// the filter are coalesced before being sent to the socket
+	utility::outputStreamBufferedSocketAdapter sos(*m_connection->getSocket());
 	utility::dotFilteredOutputStream fos(sos);
 
 	utility::bufferedStreamCopy(is, fos, size, progress);
 
-	fos.flush();
+	sendEndOfData(sos, size);
+}
 
-	// Send end-of-data delimiter
-	m_connection->getSocket()->send("\r\n.\r\n");
+
+void SMTPTransport::sendEndOfData(utility::outputStream& os, const size_t size)
+{
+	// Send end-of-data delimiter along with the last data block
+	os.write("\r\n.\r\n", 5);
+	os.flush();
 
 	if (m_connection->getTracer())
 	{
@@ -346,29 +422,50 @@ void SMTPTransport::send
 	generationContext ctx(generationContext::getDefaultContext());
 	ctx.setInternationalizedEmailSupport(m_connection->hasExtension("SMTPUTF8"));
 
-	// If CHUNKING is not supported, generate the message to a temporary
-	// buffer then use the send() method which takes an inputStream
+	const size_t msgSize = msg->getGeneratedSize(ctx);
+
+	// If CHUNKING is not supported, generate the message directly to the
+	// socket after the DATA command, so that it is never held in memory
 	if (!m_connection->hasExtension("CHUNKING") ||
 	    !getInfos().getPropertyValue <bool>(getSession(),
 			dynamic_cast <const SMTPServiceInfos&>(getInfos()).getProperties().PROPERTY_OPTIONS_CHUNKING))
 
 	{
-		std::ostringstream oss;
-		utility::outputStreamAdapter ossAdapter(oss);
+		sendEnvelope(expeditor, recipients, sender,
+			/* sendDATACommand */ true, msgSize);
 
-		msg->generate(ctx, ossAdapter);
+		// Generate with "\n." to "\n.." transformation
+		utility::outputStreamBufferedSocketAdapter sos(*m_connection->getSocket());
+		utility::dotFilteredOutputStream fos(sos);
+		SMTPTransport_progressOutputStream pos(fos, msgSize, progress);
 
-		const string& str(oss.str());
+		try
+		{
+			msg->generate(ctx, pos);
+		}
+		catch (...)
+		{
+			// The server is waiting for the rest of the message, and a DATA
+			// transaction cannot be aborted: close the connection so that
+			// the partial message is discarded
+			try
+			{
+				if (isConnected())
+					disconnect();
+			}
+			catch (...)
+			{
+				// Report the error which interrupted the message
+			}
 
-		utility::inputStreamStringAdapter isAdapter(str);
+			throw;
+		}
 
-		send(expeditor, recipients, isAdapter, str.length(), progress, sender);
+		sendEndOfData(sos, pos.stop());
 		return;
 	}
 
 	// Send message envelope
-	const size_t msgSize = msg->getGeneratedSize(ctx);
-
 	sendEnvelope(expeditor, recipients, sender,
 		/* sendDATACommand */ false, msgSize);
 
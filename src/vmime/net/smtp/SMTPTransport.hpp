@@ -108,6 +108,14 @@ private:
 		 bool sendDATACommand,
 		 const size_t size);
 
+	/** Send the end-of-data delimiter after the message data, and
+	  * check the response to the DATA command.
+	  *
+	  * @param os socket output stream used to send the message data
+	  * @param size number of bytes of message data sent
+	  */
+	void sendEndOfData(utility::outputStream& os, const size_t size);
+
 
 	shared_ptr <SMTPConnection> m_connection;
 
@@ -0,0 +1,178 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_TLS_SUPPORT
+
+
+#include "vmime/net/tls/TLSSessionCache.hpp"
+
+#include "vmime/platform.hpp"
+
+#include "vmime/utility/stringUtils.hpp"
+#include "vmime/utility/sync/autoLock.hpp"
+
+#include <sstream>
+
+
+namespace vmime {
+namespace net {
+namespace tls {
+
+
+#define LOCK_CACHE() \
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_mutex)
+
+
+TLSSessionCache::TLSSessionCache()
+	: m_maxSize(1000), m_serial(0)
+{
+	m_mutex = platform::getHandler()->createCriticalSection();
+}
+
+
+// static
+shared_ptr <TLSSessionCache> TLSSessionCache::getInstance()
+{
+	static TLSSessionCache instance;
+	return shared_ptr <TLSSessionCache>(&instance, noop_shared_ptr_deleter <TLSSessionCache>());
+}
+
+
+// static
+const string TLSSessionCache::makeKey(const string& host, const port_t port,
+	const string& cipherSuite, const string& clientIdentity)
+{
+	std::ostringstream key;
+	key.imbue(std::locale::classic());
+
+	key << utility::stringUtils::toLower(host) << ':' << port << '/' << cipherSuite;
+
+	if (!clientIdentity.empty())
+		key << '#' << clientIdentity;
+
+	return key.str();
+}
+
+
+void TLSSessionCache::store(const string& key, shared_ptr <object> data)
+{
+	LOCK_CACHE();
+
+	if (m_maxSize == 0)
+		return;
+
+	EntryMap::iterator it = m_entries.find(key);
+
+	if (it == m_entries.end())
+	{
+		if (m_entries.size() >= m_maxSize)
+			removeOldest();
+
+		it = m_entries.insert(EntryMap::value_type(key, Entry())).first;
+	}
+
+	it->second.data = data;
+	it->second.serial = ++m_serial;
+}
+
+
+shared_ptr <object> TLSSessionCache::find(const string& key) const
+{
+	LOCK_CACHE();
+
+	EntryMap::const_iterator it = m_entries.find(key);
+
+	if (it == m_entries.end())
+		return null;
+
+	return it->second.data;
+}
+
+
+void TLSSessionCache::remove(const string& key)
+{
+	LOCK_CACHE();
+
+	m_entries.erase(key);
+}
+
+
+void TLSSessionCache::removeAll()
+{
+	LOCK_CACHE();
+
+	m_entries.clear();
+}
+
+
+void TLSSessionCache::setMaxSize(const size_t maxSize)
+{
+	LOCK_CACHE();
+
+	m_maxSize = maxSize;
+
+	while (m_entries.size() > m_maxSize)
+		removeOldest();
+}
+
+
+size_t TLSSessionCache::getMaxSize() const
+{
+	LOCK_CACHE();
+
+	return m_maxSize;
+}
+
+
+size_t TLSSessionCache::getSize() const
+{
+	LOCK_CACHE();
+
+	return m_entries.size();
+}
+
+
+void TLSSessionCache::removeOldest()
+{
+	EntryMap::iterator oldest = m_entries.begin();
+
+	for (EntryMap::iterator it = m_entries.begin() ; it != m_entries.end() ; ++it)
+	{
+		if (it->second.serial < oldest->second.serial)
+			oldest = it;
+	}
+
+	if (oldest != m_entries.end())
+		m_entries.erase(oldest);
+}
+
+
+} // tls
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_TLS_SUPPORT
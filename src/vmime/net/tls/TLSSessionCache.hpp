@@ -0,0 +1,153 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_NET_TLS_TLSSESSIONCACHE_HPP_INCLUDED
+#define VMIME_NET_TLS_TLSSESSIONCACHE_HPP_INCLUDED
+
+
+#include "vmime/config.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_TLS_SUPPORT
+
+
+#include "vmime/types.hpp"
+
+#include "vmime/utility/sync/criticalSection.hpp"
+
+#include <map>
+
+
+namespace vmime {
+namespace net {
+namespace tls {
+
+
+/** Process-wide cache of the parameters of TLS sessions established
+  * with servers, so that connecting again to a server can resume the
+  * previous session instead of doing a full handshake.
+  *
+  * Sessions are identified by the server host name and port, by the
+  * cipher suite, and by the credentials of the client. The cached data depend on the TLS library, and are
+  * opaque for users of this class.
+  */
+class VMIME_EXPORT TLSSessionCache : public object
+{
+public:
+
+	/** Returns the default instance of the cache, which is used
+	  * by all TLS sockets.
+	  *
+	  * @return cache instance
+	  */
+	static shared_ptr <TLSSessionCache> getInstance();
+
+	/** Builds the key which identifies sessions with a server.
+	  *
+	  * @param host server host name
+	  * @param port server port
+	  * @param cipherSuite cipher suite used for the session
+	  * @param clientIdentity identifies the credentials the client
+	  * authenticates with (empty if the client does not authenticate),
+	  * so that a session is never resumed with other credentials
+	  * @return cache key
+	  */
+	static const string makeKey(const string& host, const port_t port,
+		const string& cipherSuite, const string& clientIdentity = "");
+
+	/** Stores the parameters of a session, replacing the parameters
+	  * previously stored for the same key, if any.
+	  *
+	  * @param key session key (see makeKey())
+	  * @param data session parameters
+	  */
+	void store(const string& key, shared_ptr <object> data);
+
+	/** Returns the parameters stored for a session.
+	  *
+	  * @param key session key (see makeKey())
+	  * @return session parameters, or NULL if none are stored
+	  */
+	shared_ptr <object> find(const string& key) const;
+
+	/** Removes the parameters stored for a session, if any.
+	  *
+	  * @param key session key (see makeKey())
+	  */
+	void remove(const string& key);
+
+	/** Removes all the sessions from the cache.
+	  */
+	void removeAll();
+
+	/** Sets the maximum number of sessions kept in the cache. When the
+	  * cache is full, the least recently stored session is removed.
+	  * Setting this to zero disables session resumption. Default is 1000.
+	  *
+	  * @param maxSize maximum number of sessions
+	  */
+	void setMaxSize(const size_t maxSize);
+
+	/** Returns the maximum number of sessions kept in the cache.
+	  *
+	  * @return maximum number of sessions
+	  */
+	size_t getMaxSize() const;
+
+	/** Returns the number of sessions currently in the cache.
+	  *
+	  * @return number of sessions
+	  */
+	size_t getSize() const;
+
+private:
+
+	TLSSessionCache();
+
+	void removeOldest();
+
+
+	struct Entry
+	{
+		shared_ptr <object> data;
+		unsigned long serial;
+	};
+
+	typedef std::map <string, Entry> EntryMap;
+
+	EntryMap m_entries;
+	size_t m_maxSize;
+	unsigned long m_serial;
+
+	shared_ptr <utility::sync::criticalSection> m_mutex;
+};
+
+
+} // tls
+} // net
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES && VMIME_HAVE_TLS_SUPPORT
+
+#endif // VMIME_NET_TLS_TLSSESSIONCACHE_HPP_INCLUDED
@@ -69,6 +69,18 @@ public:
 	  */
 	virtual void handshake() = 0;
 
+	/** Sets the server this socket is connected to. Parameters of the
+	  * TLS sessions established with a server are kept in the
+	  * TLSSessionCache, so that the next handshake with the same server
+	  * can resume the session instead of doing a full handshake.
+	  * This must be called before handshake(); connect() calls it
+	  * automatically. If it is not called, sessions are not resumed.
+	  *
+	  * @param host server host name
+	  * @param port server port
+	  */
+	virtual void setServer(const string& host, const port_t port) = 0;
+
 	/** Return the peer's certificate (chain) as sent by the peer.
 	  *
 	  * @return server certificate chain, or NULL if the handshake
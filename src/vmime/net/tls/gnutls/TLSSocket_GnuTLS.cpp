@@ -34,6 +34,7 @@
 
 #include "vmime/net/tls/gnutls/TLSSocket_GnuTLS.hpp"
 #include "vmime/net/tls/gnutls/TLSSession_GnuTLS.hpp"
+#include "vmime/net/tls/TLSSessionCache.hpp"
 
 #include "vmime/platform.hpp"
 
@@ -42,6 +43,7 @@
 #include "vmime/utility/stringUtils.hpp"
 
 #include <cstring>
+#include <vector>
 
 
 namespace vmime {
@@ -49,6 +51,32 @@ namespace net {
 namespace tls {
 
 
+#ifndef VMIME_BUILDING_DOC
+
+/** Parameters of a session, as stored in the TLS session cache.
+  */
+class TLSSessionData_GnuTLS : public object
+{
+public:
+
+	TLSSessionData_GnuTLS(const byte_t* data, const size_t size)
+		: m_data(data, data + size)
+	{
+	}
+
+	const std::vector <byte_t>& getData() const
+	{
+		return m_data;
+	}
+
+private:
+
+	std::vector <byte_t> m_data;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
 // static
 shared_ptr <TLSSocket> TLSSocket::wrap(shared_ptr <TLSSession> session, shared_ptr <socket> sok)
 {
@@ -92,6 +120,9 @@ void TLSSocket_GnuTLS::connect(const string& address, const port_t port)
 {
 	try
 	{
+		if (m_sessionCacheKey.empty())
+			setServer(address, port);
+
 		m_wrapped->connect(address, port);
 
 		handshake();
@@ -108,6 +139,10 @@ void TLSSocket_GnuTLS::disconnect()
 {
 	if (m_connected)
 	{
+		// With TLS 1.3, session tickets are sent after the handshake:
+		// update the parameters stored when the handshake completed
+		storeSession();
+
 		gnutls_bye(*m_session->m_gnutlsSession, GNUTLS_SHUT_RDWR);
 
 		m_wrapped->disconnect();
@@ -302,6 +337,20 @@ void TLSSocket_GnuTLS::handshake()
 	if (getTracer())
 		getTracer()->traceSend("Beginning SSL/TLS handshake");
 
+	// Try to resume the last session established with this server
+	if (!m_sessionCacheKey.empty())
+	{
+		shared_ptr <TLSSessionData_GnuTLS> data = dynamicCast <TLSSessionData_GnuTLS>
+			(TLSSessionCache::getInstance()->find(m_sessionCacheKey));
+
+		if (data && !data->getData().empty())
+		{
+			// If the session cannot be resumed, a full handshake is done
+			gnutls_session_set_data(*m_session->m_gnutlsSession,
+				&data->getData()[0], data->getData().size());
+		}
+	}
+
 	// Start handshaking process
 	try
 	{
@@ -350,7 +399,35 @@ void TLSSocket_GnuTLS::handshake()
 
 	m_session->getCertificateVerifier()->verify(certs, getPeerName());
 
+	if (getTracer() && gnutls_session_is_resumed(*m_session->m_gnutlsSession))
+		getTracer()->traceReceive("SSL/TLS session resumed");
+
 	m_connected = true;
+
+	storeSession();
+}
+
+
+void TLSSocket_GnuTLS::setServer(const string& host, const port_t port)
+{
+	m_sessionCacheKey = TLSSessionCache::makeKey(host, port, m_session->m_props->getCipherSuite());
+}
+
+
+void TLSSocket_GnuTLS::storeSession()
+{
+	if (m_sessionCacheKey.empty())
+		return;
+
+	gnutls_datum_t data;
+
+	if (gnutls_session_get_data2(*m_session->m_gnutlsSession, &data) != GNUTLS_E_SUCCESS)
+		return;
+
+	TLSSessionCache::getInstance()->store
+		(m_sessionCacheKey, make_shared <TLSSessionData_GnuTLS>(data.data, data.size));
+
+	gnutls_free(data.data);
 }
 
 
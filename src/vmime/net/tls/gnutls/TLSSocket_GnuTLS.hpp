@@ -55,6 +55,7 @@ public:
 
 
 	void handshake();
+	void setServer(const string& host, const port_t port);
 
 	shared_ptr <security::cert::certificateChain> getPeerCertificates();
 
@@ -90,6 +91,8 @@ private:
 
 	void internalThrow();
 
+	void storeSession();
+
 #ifdef LIBGNUTLS_VERSION
 	static ssize_t gnutlsPushFunc(gnutls_transport_ptr trspt, const void* data, size_t len);
 	static ssize_t gnutlsPullFunc(gnutls_transport_ptr trspt, void* data, size_t len);
@@ -112,6 +115,8 @@ private:
 
 	unsigned int m_status;
 	int m_errno;
+
+	string m_sessionCacheKey;
 };
 
 
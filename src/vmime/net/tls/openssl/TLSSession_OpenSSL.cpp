@@ -30,12 +30,20 @@
 #include "vmime/net/tls/openssl/TLSSession_OpenSSL.hpp"
 #include "vmime/net/tls/openssl/TLSProperties_OpenSSL.hpp"
 #include "vmime/net/tls/openssl/OpenSSLInitializer.hpp"
+#include "vmime/net/tls/openssl/TLSSocket_OpenSSL.hpp"
+
+#include "vmime/exception.hpp"
+#include "vmime/platform.hpp"
+#include "vmime/utility/sync/autoLock.hpp"
 
 #include "vmime/security/cert/certificateException.hpp"
 
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 
+#include <map>
+#include <sstream>
+
 
 namespace vmime {
 namespace net {
@@ -53,13 +61,9 @@ shared_ptr <TLSSession> TLSSession::create(shared_ptr <security::cert::certifica
 
 
 TLSSession_OpenSSL::TLSSession_OpenSSL(shared_ptr <vmime::security::cert::certificateVerifier> cv, shared_ptr <TLSProperties> props)
-	: m_sslctx(0), m_certVerifier(cv), m_props(props)
+	: m_sslctx(0), m_ownContext(false), m_certVerifier(cv), m_props(props)
 {
-	m_sslctx = SSL_CTX_new(SSLv23_client_method());
-	SSL_CTX_set_options(m_sslctx, SSL_OP_ALL | SSL_OP_NO_SSLv2);
-	SSL_CTX_set_mode(m_sslctx, SSL_MODE_AUTO_RETRY);
-	SSL_CTX_set_cipher_list(m_sslctx, m_props->getCipherSuite().c_str());
-	SSL_CTX_set_session_cache_mode(m_sslctx, SSL_SESS_CACHE_OFF);
+	m_sslctx = getSharedContext(m_props->getCipherSuite());
 }
 
 
@@ -72,7 +76,103 @@ TLSSession_OpenSSL::TLSSession_OpenSSL(const TLSSession_OpenSSL&)
 
 TLSSession_OpenSSL::~TLSSession_OpenSSL()
 {
-	SSL_CTX_free(m_sslctx);
+	if (m_ownContext)
+		SSL_CTX_free(m_sslctx);
+}
+
+
+// static
+SSL_CTX* TLSSession_OpenSSL::createContext(const string& cipherSuite)
+{
+	SSL_CTX* ctx = SSL_CTX_new(SSLv23_client_method());
+
+	if (ctx == NULL)
+		throw exceptions::tls_exception("Cannot create SSL context");
+
+	SSL_CTX_set_options(ctx, SSL_OP_ALL | SSL_OP_NO_SSLv2);
+	SSL_CTX_set_mode(ctx, SSL_MODE_AUTO_RETRY);
+	SSL_CTX_set_cipher_list(ctx, cipherSuite.c_str());
+
+	// Sessions are kept in TLSSessionCache instead of the context's
+	// internal cache, so that they can be resumed with any context
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(ctx, TLSSocket_OpenSSL::newSessionCallback);
+
+	return ctx;
+}
+
+
+#ifndef VMIME_BUILDING_DOC
+
+struct sharedSSLContexts
+{
+	sharedSSLContexts()
+		: mutex(platform::getHandler()->createCriticalSection())
+	{
+	}
+
+	~sharedSSLContexts()
+	{
+		for (std::map <string, SSL_CTX*>::iterator it = contexts.begin() ; it != contexts.end() ; ++it)
+			SSL_CTX_free(it->second);
+	}
+
+	std::map <string, SSL_CTX*> contexts;
+	shared_ptr <utility::sync::criticalSection> mutex;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
+// static
+SSL_CTX* TLSSession_OpenSSL::getSharedContext(const string& cipherSuite)
+{
+	// Creating a context is costly, and the context settings are the
+	// same for all the sessions which use the same cipher suite
+	static sharedSSLContexts shared;
+
+	utility::sync::autoLock <utility::sync::criticalSection> lock(shared.mutex);
+
+	std::map <string, SSL_CTX*>::iterator it = shared.contexts.find(cipherSuite);
+
+	if (it != shared.contexts.end())
+		return it->second;
+
+	SSL_CTX* ctx = createContext(cipherSuite);
+	shared.contexts[cipherSuite] = ctx;
+
+	return ctx;
+}
+
+
+void TLSSession_OpenSSL::useOwnContext()
+{
+	if (!m_ownContext)
+	{
+		m_sslctx = createContext(m_props->getCipherSuite());
+		m_ownContext = true;
+
+		// The credentials loaded in the context cannot be compared with
+		// those of other sessions: give the context a unique identity, so
+		// that the sessions established with it can only be resumed by
+		// sockets created from this session
+		static unsigned long lastContextId = 0;
+		static shared_ptr <utility::sync::criticalSection> mutex =
+			platform::getHandler()->createCriticalSection();
+
+		unsigned long contextId;
+
+		{
+			utility::sync::autoLock <utility::sync::criticalSection> lock(mutex);
+			contextId = ++lastContextId;
+		}
+
+		std::ostringstream oss;
+		oss.imbue(std::locale::classic());
+		oss << "ctx" << contextId;
+
+		m_clientIdentity = oss.str();
+	}
 }
 
 
@@ -90,6 +190,8 @@ shared_ptr <security::cert::certificateVerifier> TLSSession_OpenSSL::getCertific
 
 void TLSSession_OpenSSL::usePrivateKeyFile(const vmime::string& keyfile)
 {
+	useOwnContext();
+
 	if (SSL_CTX_use_PrivateKey_file(m_sslctx, keyfile.c_str(), SSL_FILETYPE_PEM) != 1)
 	{
 		unsigned long errCode = ERR_get_error();
@@ -106,6 +208,8 @@ void TLSSession_OpenSSL::usePrivateKeyFile(const vmime::string& keyfile)
 
 void TLSSession_OpenSSL::useCertificateChainFile(const vmime::string& chainFile)
 {
+	useOwnContext();
+
 	if (SSL_CTX_use_certificate_chain_file(m_sslctx, chainFile.c_str()) != 1)
 	{
 		unsigned long errCode = ERR_get_error();
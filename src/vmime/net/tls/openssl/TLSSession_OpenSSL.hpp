@@ -88,7 +88,33 @@ private:
 
 	TLSSession_OpenSSL(const TLSSession_OpenSSL&);
 
+	/** Creates a new SSL context, configured for use by a client.
+	  *
+	  * @param cipherSuite cipher suite
+	  * @return new SSL context
+	  */
+	static SSL_CTX* createContext(const string& cipherSuite);
+
+	/** Returns the SSL context shared by all the sessions which use the
+	  * specified cipher suite, and no client certificate.
+	  *
+	  * @param cipherSuite cipher suite
+	  * @return shared SSL context (must not be freed)
+	  */
+	static SSL_CTX* getSharedContext(const string& cipherSuite);
+
+	/** Replaces the shared SSL context with a context owned by this
+	  * session, which can then be modified.
+	  */
+	void useOwnContext();
+
+
 	SSL_CTX* m_sslctx;
+	bool m_ownContext;
+
+	// Identifies the client credentials in session cache keys;
+	// empty when the shared context is used
+	string m_clientIdentity;
 
 	shared_ptr <security::cert::certificateVerifier> m_certVerifier;
 	shared_ptr <TLSProperties> m_props;
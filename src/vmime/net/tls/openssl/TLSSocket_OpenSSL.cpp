@@ -33,6 +33,7 @@
 #include "vmime/net/tls/openssl/TLSSocket_OpenSSL.hpp"
 #include "vmime/net/tls/openssl/TLSSession_OpenSSL.hpp"
 #include "vmime/net/tls/openssl/OpenSSLInitializer.hpp"
+#include "vmime/net/tls/TLSSessionCache.hpp"
 
 #include "vmime/platform.hpp"
 
@@ -52,6 +53,38 @@ namespace tls {
 static OpenSSLInitializer::autoInitializer openSSLInitializer;
 
 
+#ifndef VMIME_BUILDING_DOC
+
+/** Parameters of a session, as stored in the TLS session cache.
+  */
+class TLSSessionData_OpenSSL : public object
+{
+public:
+
+	// Takes ownership of the session
+	TLSSessionData_OpenSSL(SSL_SESSION* session)
+		: m_session(session)
+	{
+	}
+
+	~TLSSessionData_OpenSSL()
+	{
+		SSL_SESSION_free(m_session);
+	}
+
+	SSL_SESSION* getSession()
+	{
+		return m_session;
+	}
+
+private:
+
+	SSL_SESSION* m_session;
+};
+
+#endif // VMIME_BUILDING_DOC
+
+
 // static
 BIO_METHOD TLSSocket_OpenSSL::sm_customBIOMethod =
 {
@@ -77,7 +110,8 @@ shared_ptr <TLSSocket> TLSSocket::wrap(shared_ptr <TLSSession> session, shared_p
 
 
 TLSSocket_OpenSSL::TLSSocket_OpenSSL(shared_ptr <TLSSession_OpenSSL> session, shared_ptr <socket> sok)
-	: m_session(session), m_wrapped(sok), m_connected(false), m_ssl(0), m_status(0), m_ex(NULL)
+	: m_session(session), m_wrapped(sok), m_connected(false), m_ssl(0), m_status(0), m_ex(NULL),
+	  m_serverPort(0)
 {
 }
 
@@ -112,8 +146,25 @@ void TLSSocket_OpenSSL::createSSLHandle()
 		}
 
 		SSL_set_bio(m_ssl, sockBio, sockBio);
+		SSL_set_app_data(m_ssl, this);
 		SSL_set_connect_state(m_ssl);
 		SSL_set_mode(m_ssl, SSL_MODE_AUTO_RETRY | SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+		// Try to resume the last session established with this server
+		// (if the session cannot be resumed, a full handshake is done)
+		if (!m_serverHost.empty())
+		{
+			// Built here rather than in setServer(), as the client
+			// credentials may have been set in the meantime
+			m_sessionCacheKey = TLSSessionCache::makeKey(m_serverHost, m_serverPort,
+				m_session->m_props->getCipherSuite(), m_session->m_clientIdentity);
+
+			shared_ptr <TLSSessionData_OpenSSL> data = dynamicCast <TLSSessionData_OpenSSL>
+				(TLSSessionCache::getInstance()->find(m_sessionCacheKey));
+
+			if (data)
+				SSL_set_session(m_ssl, data->getSession());
+		}
 	}
 	else
 	{
@@ -126,6 +177,9 @@ void TLSSocket_OpenSSL::connect(const string& address, const port_t port)
 {
 	try
 	{
+		if (m_serverHost.empty())
+			setServer(address, port);
+
 		m_wrapped->connect(address, port);
 
 		createSSLHandle();
@@ -395,12 +449,50 @@ void TLSSocket_OpenSSL::handshake()
 	if (certs == NULL)
 		throw exceptions::tls_exception("No peer certificate.");
 
-	m_session->getCertificateVerifier()->verify(certs, getPeerName());
+	try
+	{
+		m_session->getCertificateVerifier()->verify(certs, getPeerName());
+	}
+	catch (...)
+	{
+		// Do not resume a session with an untrusted server
+		if (!m_sessionCacheKey.empty())
+			TLSSessionCache::getInstance()->remove(m_sessionCacheKey);
+
+		throw;
+	}
+
+	if (getTracer() && SSL_session_reused(m_ssl))
+		getTracer()->traceReceive("SSL/TLS session resumed");
 
 	m_connected = true;
 }
 
 
+void TLSSocket_OpenSSL::setServer(const string& host, const port_t port)
+{
+	m_serverHost = host;
+	m_serverPort = port;
+}
+
+
+// static
+int TLSSocket_OpenSSL::newSessionCallback(SSL* ssl, SSL_SESSION* session)
+{
+	// Called when the server sends new session parameters: during the
+	// handshake, or after it with TLS 1.3 session tickets
+	TLSSocket_OpenSSL* sok = reinterpret_cast <TLSSocket_OpenSSL*>(SSL_get_app_data(ssl));
+
+	if (sok == NULL || sok->m_sessionCacheKey.empty())
+		return 0;  // session not used
+
+	TLSSessionCache::getInstance()->store
+		(sok->m_sessionCacheKey, make_shared <TLSSessionData_OpenSSL>(session));
+
+	return 1;  // we keep a reference to the session
+}
+
+
 shared_ptr <security::cert::certificateChain> TLSSocket_OpenSSL::getPeerCertificates()
 {
 	if (getTracer())
@@ -52,6 +52,8 @@ class TLSSession_OpenSSL;
 
 class TLSSocket_OpenSSL : public TLSSocket
 {
+	friend class TLSSession_OpenSSL;
+
 public:
 
 	TLSSocket_OpenSSL(shared_ptr <TLSSession_OpenSSL> session, shared_ptr <socket> sok);
@@ -59,6 +61,7 @@ public:
 
 
 	void handshake();
+	void setServer(const string& host, const port_t port);
 
 	shared_ptr <security::cert::certificateChain> getPeerCertificates();
 
@@ -102,6 +105,8 @@ private:
 	static int bio_create(BIO* bio);
 	static int bio_destroy(BIO* bio);
 
+	static int newSessionCallback(SSL* ssl, SSL_SESSION* session);
+
 	void createSSLHandle();
 
 	void internalThrow();
@@ -122,6 +127,10 @@ private:
 
 	// Last exception thrown from C BIO functions
 	std::auto_ptr <exception> m_ex;
+
+	string m_serverHost;
+	port_t m_serverPort;
+	string m_sessionCacheKey;
 };
 
 
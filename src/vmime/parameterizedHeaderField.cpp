@@ -78,9 +78,9 @@ struct paramInfo
 #endif // VMIME_BUILDING_DOC
 
 
-void parameterizedHeaderField::parseImpl
+void parameterizedHeaderField::parseValue
 	(const parsingContext& ctx, const string& buffer, const size_t position,
-	 const size_t end, size_t* newPosition)
+	 const size_t end, const size_t offset) const
 {
 	const char* const pend = buffer.data() + end;
 	const char* const pstart = buffer.data() + position;
@@ -109,10 +109,10 @@ void parameterizedHeaderField::parseImpl
 		--valueLength;
 
 	// Parse value
-	getValue()->parse(ctx, buffer, valueStart, valueStart + valueLength);
+	headerField::parseValue(ctx, buffer, valueStart, valueStart + valueLength, offset);
 
 	// Reset parameters
-	removeAllParameters();
+	m_params.clear();
 
 	// If there is one or more parameters following...
 	if (p < pend)
@@ -324,14 +324,11 @@ void parameterizedHeaderField::parseImpl
 			shared_ptr <parameter> param = make_shared <parameter>((*it).first);
 
 			param->parse(ctx, info.value);
-			param->setParsedBounds(info.start, info.end);
+			param->setParsedBounds(info.start + offset, info.end + offset);
 
-			appendParameter(param);
+			m_params.push_back(param);
 		}
 	}
-
-	if (newPosition)
-		*newPosition = end;
 }
 
 
@@ -359,21 +356,6 @@ void parameterizedHeaderField::generateImpl
 }
 
 
-size_t parameterizedHeaderField::getGeneratedSize(const generationContext& ctx)
-{
-	size_t size = headerField::getGeneratedSize(ctx);
-
-	for (std::vector <shared_ptr <parameter> >::const_iterator
-	     it = m_params.begin() ; it != m_params.end() ; ++it)
-	{
-		size += 2;  // "; "
-		size += (*it)->getGeneratedSize(ctx);
-	}
-
-	return size;
-}
-
-
 void parameterizedHeaderField::copyFrom(const component& other)
 {
 	headerField::copyFrom(other);
@@ -399,6 +381,8 @@ parameterizedHeaderField& parameterizedHeaderField::operator=(const parameterize
 
 bool parameterizedHeaderField::hasParameter(const string& paramName) const
 {
+	parseDeferredValue();
+
 	const string name = utility::stringUtils::toLower(paramName);
 
 	std::vector <shared_ptr <parameter> >::const_iterator pos = m_params.begin();
@@ -412,6 +396,8 @@ bool parameterizedHeaderField::hasParameter(const string& paramName) const
 
 shared_ptr <parameter> parameterizedHeaderField::findParameter(const string& paramName) const
 {
+	parseDeferredValue();
+
 	const string name = utility::stringUtils::toLower(paramName);
 
 	// Find the first parameter that matches the specified name
@@ -431,6 +417,8 @@ shared_ptr <parameter> parameterizedHeaderField::findParameter(const string& par
 
 shared_ptr <parameter> parameterizedHeaderField::getParameter(const string& paramName)
 {
+	parseDeferredValue();
+
 	const string name = utility::stringUtils::toLower(paramName);
 
 	// Find the first parameter that matches the specified name
@@ -459,12 +447,16 @@ shared_ptr <parameter> parameterizedHeaderField::getParameter(const string& para
 
 void parameterizedHeaderField::appendParameter(shared_ptr <parameter> param)
 {
+	parseDeferredValue();
+
 	m_params.push_back(param);
 }
 
 
 void parameterizedHeaderField::insertParameterBefore(shared_ptr <parameter> beforeParam, shared_ptr <parameter> param)
 {
+	parseDeferredValue();
+
 	const std::vector <shared_ptr <parameter> >::iterator it = std::find
 		(m_params.begin(), m_params.end(), beforeParam);
 
@@ -477,6 +469,8 @@ void parameterizedHeaderField::insertParameterBefore(shared_ptr <parameter> befo
 
 void parameterizedHeaderField::insertParameterBefore(const size_t pos, shared_ptr <parameter> param)
 {
+	parseDeferredValue();
+
 	if (pos >= m_params.size())
 		throw std::out_of_range("Invalid position");
 
@@ -486,6 +480,8 @@ void parameterizedHeaderField::insertParameterBefore(const size_t pos, shared_pt
 
 void parameterizedHeaderField::insertParameterAfter(shared_ptr <parameter> afterParam, shared_ptr <parameter> param)
 {
+	parseDeferredValue();
+
 	const std::vector <shared_ptr <parameter> >::iterator it = std::find
 		(m_params.begin(), m_params.end(), afterParam);
 
@@ -498,6 +494,8 @@ void parameterizedHeaderField::insertParameterAfter(shared_ptr <parameter> after
 
 void parameterizedHeaderField::insertParameterAfter(const size_t pos, shared_ptr <parameter> param)
 {
+	parseDeferredValue();
+
 	if (pos >= m_params.size())
 		throw std::out_of_range("Invalid position");
 
@@ -507,6 +505,8 @@ void parameterizedHeaderField::insertParameterAfter(const size_t pos, shared_ptr
 
 void parameterizedHeaderField::removeParameter(shared_ptr <parameter> param)
 {
+	parseDeferredValue();
+
 	const std::vector <shared_ptr <parameter> >::iterator it = std::find
 		(m_params.begin(), m_params.end(), param);
 
@@ -519,6 +519,8 @@ void parameterizedHeaderField::removeParameter(shared_ptr <parameter> param)
 
 void parameterizedHeaderField::removeParameter(const size_t pos)
 {
+	parseDeferredValue();
+
 	const std::vector <shared_ptr <parameter> >::iterator it = m_params.begin() + pos;
 
 	m_params.erase(it);
@@ -527,36 +529,48 @@ void parameterizedHeaderField::removeParameter(const size_t pos)
 
 void parameterizedHeaderField::removeAllParameters()
 {
+	parseDeferredValue();
+
 	m_params.clear();
 }
 
 
 size_t parameterizedHeaderField::getParameterCount() const
 {
+	parseDeferredValue();
+
 	return (m_params.size());
 }
 
 
 bool parameterizedHeaderField::isEmpty() const
 {
+	parseDeferredValue();
+
 	return (m_params.empty());
 }
 
 
 const shared_ptr <parameter> parameterizedHeaderField::getParameterAt(const size_t pos)
 {
+	parseDeferredValue();
+
 	return (m_params[pos]);
 }
 
 
 const shared_ptr <const parameter> parameterizedHeaderField::getParameterAt(const size_t pos) const
 {
+	parseDeferredValue();
+
 	return (m_params[pos]);
 }
 
 
 const std::vector <shared_ptr <const parameter> > parameterizedHeaderField::getParameterList() const
 {
+	parseDeferredValue();
+
 	std::vector <shared_ptr <const parameter> > list;
 
 	list.reserve(m_params.size());
@@ -573,6 +587,8 @@ const std::vector <shared_ptr <const parameter> > parameterizedHeaderField::getP
 
 const std::vector <shared_ptr <parameter> > parameterizedHeaderField::getParameterList()
 {
+	parseDeferredValue();
+
 	return (m_params);
 }
 
@@ -179,22 +179,21 @@ public:
 	  */
 	const std::vector <shared_ptr <parameter> > getParameterList();
 
-	size_t getGeneratedSize(const generationContext& ctx);
-
 	const std::vector <shared_ptr <component> > getChildComponents();
 
 private:
 
-	std::vector <shared_ptr <parameter> > m_params;
+	// Parameters are parsed along with the value, which may be deferred
+	mutable std::vector <shared_ptr <parameter> > m_params;
 
 protected:
 
-	void parseImpl
+	void parseValue
 		(const parsingContext& ctx,
 		 const string& buffer,
 		 const size_t position,
 		 const size_t end,
-		 size_t* newPosition = NULL);
+		 const size_t offset) const;
 
 	void generateImpl
 		(const generationContext& ctx,
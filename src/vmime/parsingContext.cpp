@@ -29,12 +29,14 @@ namespace vmime
 
 
 parsingContext::parsingContext()
+	: m_lazyHeaderFieldParsing(false)
 {
 }
 
 
 parsingContext::parsingContext(const parsingContext& ctx)
-	: context(ctx)
+	: context(ctx),
+	  m_lazyHeaderFieldParsing(ctx.m_lazyHeaderFieldParsing)
 {
 }
 
@@ -46,4 +48,31 @@ parsingContext& parsingContext::getDefaultContext()
 }
 
 
+bool parsingContext::getLazyHeaderFieldParsing() const
+{
+	return m_lazyHeaderFieldParsing;
+}
+
+
+void parsingContext::setLazyHeaderFieldParsing(const bool lazy)
+{
+	m_lazyHeaderFieldParsing = lazy;
+}
+
+
+parsingContext& parsingContext::operator=(const parsingContext& ctx)
+{
+	copyFrom(ctx);
+	return *this;
+}
+
+
+void parsingContext::copyFrom(const parsingContext& ctx)
+{
+	context::copyFrom(ctx);
+
+	m_lazyHeaderFieldParsing = ctx.m_lazyHeaderFieldParsing;
+}
+
+
 } // vmime
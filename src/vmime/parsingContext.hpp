@@ -48,8 +48,38 @@ public:
 	  */
 	static parsingContext& getDefaultContext();
 
+	/** Returns whether parsing of header field values is deferred
+	  * until the value is accessed for the first time.
+	  *
+	  * @return true if header field values are parsed lazily,
+	  * false if they are parsed along with the header
+	  */
+	bool getLazyHeaderFieldParsing() const;
+
+	/** Enables or disables lazy parsing of header field values.
+	  * When enabled, the parser only locates the fields of a header, and
+	  * keeps a copy of the header block which is shared by the fields;
+	  * each value is parsed the first time it is accessed (or when the
+	  * field is generated, copied, etc.). This is disabled by default,
+	  * and is useful when only a few fields of each message are needed.
+	  *
+	  * Note that since a value may be parsed when it is first read,
+	  * accessing the fields of a parsed header through const methods
+	  * is no longer thread-safe: a header shared between threads must
+	  * be protected by the caller (or all its values accessed once
+	  * before it is shared).
+	  *
+	  * @param lazy true to parse header field values lazily, false
+	  * to parse them along with the header
+	  */
+	void setLazyHeaderFieldParsing(const bool lazy);
+
+	parsingContext& operator=(const parsingContext& ctx);
+	void copyFrom(const parsingContext& ctx);
+
 protected:
 
+	bool m_lazyHeaderFieldParsing;
 };
 
 
@@ -35,12 +35,16 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #include <dirent.h>
 
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <limits>
+
 #include "vmime/exception.hpp"
 
 
@@ -249,6 +253,71 @@ void posixFileReaderInputStream::seek(const size_t pos)
 
 
 
+//
+// posixFileReaderMappedInputStream
+//
+
+posixFileReaderMappedInputStream::posixFileReaderMappedInputStream
+	(const vmime::utility::file::path& path, void* data, const size_t length)
+	: m_path(path), m_data(data), m_length(length), m_pos(0)
+{
+}
+
+
+posixFileReaderMappedInputStream::~posixFileReaderMappedInputStream()
+{
+	if (::munmap(m_data, m_length) == -1)
+		posixFileSystemFactory::reportError(m_path, errno);
+}
+
+
+bool posixFileReaderMappedInputStream::eof() const
+{
+	return m_pos >= m_length;
+}
+
+
+void posixFileReaderMappedInputStream::reset()
+{
+	m_pos = 0;
+}
+
+
+size_t posixFileReaderMappedInputStream::read
+	(byte_t* const data, const size_t count)
+{
+	const size_t n = std::min(count, m_length - m_pos);
+
+	::memcpy(data, static_cast <const byte_t*>(m_data) + m_pos, n);
+	m_pos += n;
+
+	return n;
+}
+
+
+size_t posixFileReaderMappedInputStream::skip(const size_t count)
+{
+	const size_t n = std::min(count, m_length - m_pos);
+
+	m_pos += n;
+
+	return n;
+}
+
+
+size_t posixFileReaderMappedInputStream::getPosition() const
+{
+	return m_pos;
+}
+
+
+void posixFileReaderMappedInputStream::seek(const size_t pos)
+{
+	m_pos = std::min(pos, m_length);
+}
+
+
+
 //
 // posixFileWriter
 //
@@ -288,10 +357,52 @@ shared_ptr <vmime::utility::inputStream> posixFileReader::getInputStream()
 	if ((fd = ::open(m_nativePath.c_str(), O_RDONLY, 0640)) == -1)
 		posixFileSystemFactory::reportError(m_path, errno);
 
+	shared_ptr <vmime::utility::seekableInputStream> mapped = getMappedInputStream(fd);
+
+	if (mapped)
+	{
+		::close(fd);
+		return mapped;
+	}
+
 	return make_shared <posixFileReaderInputStream>(m_path, fd);
 }
 
 
+shared_ptr <vmime::utility::seekableInputStream> posixFileReader::getMappedInputStream(const int fd)
+{
+	struct stat buf;
+
+	if (::fstat(fd, &buf) == -1 || !S_ISREG(buf.st_mode) || buf.st_size <= 0)
+		return null;
+
+	if (static_cast <unsigned long long>(buf.st_size) >
+	    static_cast <unsigned long long>(std::numeric_limits <size_t>::max()))
+	{
+		return null;
+	}
+
+	const size_t length = static_cast <size_t>(buf.st_size);
+	void* data = ::mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (data == MAP_FAILED)
+		return null;
+
+	// Parsing scans the file from the beginning to the end
+	::madvise(data, length, MADV_SEQUENTIAL);
+
+	try
+	{
+		return make_shared <posixFileReaderMappedInputStream>(m_path, data, length);
+	}
+	catch (...)
+	{
+		::munmap(data, length);
+		throw;
+	}
+}
+
+
 
 //
 // posixFile
@@ -405,6 +516,17 @@ posixFile::length_type posixFile::getLength()
 }
 
 
+time_t posixFile::getLastModificationTime()
+{
+	struct stat buf;
+
+	if (::stat(m_nativePath.c_str(), &buf) == -1)
+		posixFileSystemFactory::reportError(m_path, errno);
+
+	return buf.st_mtime;
+}
+
+
 const posixFile::path& posixFile::getFullPath() const
 {
 	return (m_path);
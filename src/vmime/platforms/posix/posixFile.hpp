@@ -92,6 +92,39 @@ private:
 
 
 
+/** A seekable input stream which reads from a memory-mapped file.
+  * All operations are performed in memory, without any system call.
+  */
+class posixFileReaderMappedInputStream : public vmime::utility::seekableInputStream
+{
+public:
+
+	posixFileReaderMappedInputStream(const vmime::utility::file::path& path, void* data, const size_t length);
+	~posixFileReaderMappedInputStream();
+
+	bool eof() const;
+
+	void reset();
+
+	size_t read(byte_t* const data, const size_t count);
+
+	size_t skip(const size_t count);
+
+	size_t getPosition() const;
+	void seek(const size_t pos);
+
+private:
+
+	const vmime::utility::file::path m_path;
+
+	void* m_data;
+	const size_t m_length;
+
+	size_t m_pos;
+};
+
+
+
 class posixFileWriter : public vmime::utility::fileWriter
 {
 public:
@@ -114,10 +147,22 @@ public:
 
 	posixFileReader(const vmime::utility::file::path& path, const vmime::string& nativePath);
 
+	/** Returns an input stream for reading the file. Regular files are
+	  * memory-mapped if possible; if the file cannot be mapped (eg. empty
+	  * file, special file or mmap() failure), a stream based on read()
+	  * and lseek() is returned instead.
+	  *
+	  * Note that a mapped file must not be truncated while it is being
+	  * read, as accessing the mapped pages would then fail.
+	  *
+	  * @return input stream (always seekable)
+	  */
 	shared_ptr <vmime::utility::inputStream> getInputStream();
 
 private:
 
+	shared_ptr <vmime::utility::seekableInputStream> getMappedInputStream(const int fd);
+
 	vmime::utility::file::path m_path;
 	vmime::string m_nativePath;
 };
@@ -163,6 +208,7 @@ public:
 	bool canWrite() const;
 
 	length_type getLength();
+	time_t getLastModificationTime();
 
 	const path& getFullPath() const;
 
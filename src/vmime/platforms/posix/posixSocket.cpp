@@ -35,12 +35,19 @@
 #include <arpa/inet.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <poll.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
 
+#include <algorithm>
+
+#if VMIME_HAVE_EPOLL
+#	include <sys/epoll.h>
+#endif
+
 #include "vmime/utility/stringUtils.hpp"
 
 #include "vmime/exception.hpp"
@@ -170,7 +177,7 @@ void posixSocket::connect(const vmime::string& address, const vmime::port_t port
 				// Wait for socket to be connected.
 				bool connected = false;
 
-				const int selectTimeout = 1000;   // select() timeout (ms)
+				const int pollTimeout = 1000;     // poll() timeout (ms)
 				const int tryNextTimeout = 5000;  // maximum time before trying next (ms)
 
 				timeval startTime = { 0, 0 };
@@ -178,15 +185,12 @@ void posixSocket::connect(const vmime::string& address, const vmime::port_t port
 
 				do
 				{
-					struct timeval tm;
-					tm.tv_sec = selectTimeout / 1000;
-					tm.tv_usec = selectTimeout % 1000;
+					struct ::pollfd fds;
+					fds.fd = sock;
+					fds.events = POLLOUT;
+					fds.revents = 0;
 
-					fd_set fds;
-					FD_ZERO(&fds);
-					FD_SET(sock, &fds);
-
-					const int ret = select(sock + 1, NULL, &fds, NULL, &tm);
+					const int ret = ::poll(&fds, 1, pollTimeout);
 
 					// Success
 					if (ret > 0)
@@ -209,7 +213,7 @@ void posixSocket::connect(const vmime::string& address, const vmime::port_t port
 						break;
 					}
 					// Error
-					else if (ret < -1)
+					else if (ret < 0)
 					{
 						if (errno != EINTR)
 						{
@@ -244,8 +248,10 @@ void posixSocket::connect(const vmime::string& address, const vmime::port_t port
 					timeval curTime = { 0, 0 };
 					gettimeofday(&curTime, /* timezone */ NULL);
 
-					if (res->ai_next != NULL &&
-						curTime.tv_usec - startTime.tv_usec >= tryNextTimeout * 1000)
+					const long elapsed = (curTime.tv_sec - startTime.tv_sec) * 1000
+						+ (curTime.tv_usec - startTime.tv_usec) / 1000;
+
+					if (res->ai_next != NULL && elapsed >= tryNextTimeout)
 					{
 						connectErrno = ETIMEDOUT;
 						break;
@@ -488,18 +494,17 @@ size_t posixSocket::getBlockSize() const
 
 bool posixSocket::waitForData(const bool read, const bool write, const int msecs)
 {
-	for (int i = 0 ; i <= msecs / 10 ; ++i)
-	{
-		// Check whether data is available
-		fd_set fds;
-		FD_ZERO(&fds);
-		FD_SET(m_desc, &fds);
+	// Wait in short steps, so that the timeout handler is called regularly
+	const int pollTimeout = 100;  // ms
 
-		struct timeval tv;
-		tv.tv_sec = 0;
-		tv.tv_usec = 10000;  // 10 ms
+	for (int remaining = msecs ; ; remaining -= pollTimeout)
+	{
+		struct ::pollfd fds;
+		fds.fd = m_desc;
+		fds.events = static_cast <short>((read ? POLLIN : 0) | (write ? POLLOUT : 0));
+		fds.revents = 0;
 
-		ssize_t ret = ::select(m_desc + 1, read ? &fds : NULL, write ? &fds : NULL, NULL, &tv);
+		const int ret = ::poll(&fds, 1, std::max(0, std::min(remaining, pollTimeout)));
 
 		if (ret <= 0)
 		{
@@ -522,8 +527,11 @@ bool posixSocket::waitForData(const bool read, const bool write, const int msecs
 					m_timeoutHandler->resetTimeOut();
 				}
 			}
+
+			if (remaining <= pollTimeout)
+				break;
 		}
-		else if (ret > 0)
+		else
 		{
 			return true;
 		}
@@ -556,17 +564,29 @@ size_t posixSocket::receiveRaw(byte_t* buffer, const size_t count)
 {
 	m_status &= ~STATUS_WOULDBLOCK;
 
-	// Check whether data is available
-	if (!waitForRead(50 /* msecs */))
+#if defined(MSG_DONTWAIT)
+	// Read data which is already available, without waiting
+	ssize_t ret = ::recv(m_desc, buffer, count, MSG_DONTWAIT);
+	const bool mustWait = (ret < 0 && IS_EAGAIN(errno));
+#else
+	ssize_t ret = -1;
+	const bool mustWait = true;
+#endif // MSG_DONTWAIT
+
+	if (mustWait)
 	{
-		m_status |= STATUS_WOULDBLOCK;
+		// Check whether data is available
+		if (!waitForRead(50 /* msecs */))
+		{
+			m_status |= STATUS_WOULDBLOCK;
 
-		// Continue waiting for data
-		return 0;
-	}
+			// Continue waiting for data
+			return 0;
+		}
 
-	// Read available data
-	ssize_t ret = ::recv(m_desc, buffer, count, 0);
+		// Read available data
+		ret = ::recv(m_desc, buffer, count, 0);
+	}
 
 	if (ret < 0)
 	{
@@ -771,6 +791,107 @@ shared_ptr <vmime::net::socket> posixSocketFactory::create(shared_ptr <vmime::ne
 }
 
 
+
+#if VMIME_HAVE_EPOLL
+
+
+//
+// posixSocketReactor
+//
+
+posixSocketReactor::posixSocketReactor()
+	: m_epollDesc(::epoll_create1(EPOLL_CLOEXEC))
+{
+	if (m_epollDesc < 0)
+		posixSocket::throwSocketError(errno);
+}
+
+
+posixSocketReactor::~posixSocketReactor()
+{
+	::close(m_epollDesc);
+}
+
+
+void posixSocketReactor::addSocket(shared_ptr <net::socket> sock)
+{
+	shared_ptr <posixSocket> psock = dynamicCast <posixSocket>(sock);
+
+	if (!psock || psock->m_desc == -1)
+		throw exceptions::invalid_argument();
+
+	struct ::epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+
+	ev.events = EPOLLIN;
+	ev.data.fd = psock->m_desc;
+
+	if (::epoll_ctl(m_epollDesc, EPOLL_CTL_ADD, psock->m_desc, &ev) < 0 && errno != EEXIST)
+		posixSocket::throwSocketError(errno);
+
+	m_sockets[psock->m_desc] = psock;
+}
+
+
+void posixSocketReactor::removeSocket(shared_ptr <net::socket> sock)
+{
+	for (std::map <int, shared_ptr <posixSocket> >::iterator it = m_sockets.begin() ;
+	     it != m_sockets.end() ; ++it)
+	{
+		if (it->second == sock)
+		{
+			// Descriptor is removed automatically from the set when it is closed
+			if (it->second->m_desc == it->first)
+				::epoll_ctl(m_epollDesc, EPOLL_CTL_DEL, it->first, NULL);
+
+			m_sockets.erase(it);
+			break;
+		}
+	}
+}
+
+
+const std::vector <shared_ptr <net::socket> > posixSocketReactor::waitForRead(const int msecs)
+{
+	std::vector <shared_ptr <net::socket> > ready;
+
+	struct ::epoll_event events[64];
+	const int count = ::epoll_wait(m_epollDesc, events, sizeof(events) / sizeof(events[0]), msecs);
+
+	if (count < 0)
+	{
+		if (errno != EINTR)
+			posixSocket::throwSocketError(errno);
+
+		return ready;
+	}
+
+	ready.reserve(count);
+
+	for (int i = 0 ; i < count ; ++i)
+	{
+		std::map <int, shared_ptr <posixSocket> >::iterator it = m_sockets.find(events[i].data.fd);
+
+		if (it == m_sockets.end())
+			continue;
+
+		// Socket has been disconnected (and maybe reconnected) since it was added
+		if (it->second->m_desc != it->first)
+		{
+			m_sockets.erase(it);
+			continue;
+		}
+
+		ready.push_back(it->second);
+	}
+
+	return ready;
+}
+
+
+#endif // VMIME_HAVE_EPOLL
+
+
 } // posix
 } // platforms
 } // vmime
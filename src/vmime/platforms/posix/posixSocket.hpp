@@ -33,6 +33,9 @@
 
 #include "vmime/net/socket.hpp"
 
+#include <map>
+#include <vector>
+
 
 namespace vmime {
 namespace platforms {
@@ -41,6 +44,8 @@ namespace posix {
 
 class posixSocket : public vmime::net::socket
 {
+	friend class posixSocketReactor;
+
 public:
 
 	posixSocket(shared_ptr <vmime::net::timeoutHandler> th);
@@ -103,6 +108,59 @@ public:
 };
 
 
+#if VMIME_HAVE_EPOLL
+
+
+/** Waits for incoming data on many sockets at once, using epoll.
+  *
+  * This allows a single thread to service a large number of connections:
+  * only the sockets returned by waitForRead() need to be read from.
+  */
+
+class VMIME_EXPORT posixSocketReactor : public object, private noncopyable
+{
+public:
+
+	posixSocketReactor();
+	~posixSocketReactor();
+
+	/** Starts monitoring a socket. The socket must be connected and
+	  * must have been created by the POSIX socket factory (sockets
+	  * wrapped into TLS are not supported, as decrypted data may be
+	  * buffered without the descriptor being readable).
+	  *
+	  * @param sock socket to monitor
+	  * @throw exceptions::invalid_argument if the socket is not a
+	  * connected POSIX socket
+	  */
+	void addSocket(shared_ptr <net::socket> sock);
+
+	/** Stops monitoring a socket.
+	  *
+	  * @param sock socket to stop monitoring
+	  */
+	void removeSocket(shared_ptr <net::socket> sock);
+
+	/** Waits until data is available for reading on at least one
+	  * of the monitored sockets.
+	  *
+	  * @param msecs maximum time to wait, in milliseconds (-1 to wait
+	  * with no time limit)
+	  * @return sockets on which data can be read without blocking,
+	  * or an empty list if the delay expired
+	  */
+	const std::vector <shared_ptr <net::socket> > waitForRead(const int msecs);
+
+private:
+
+	int m_epollDesc;
+	std::map <int, shared_ptr <posixSocket> > m_sockets;
+};
+
+
+#endif // VMIME_HAVE_EPOLL
+
+
 } // posix
 } // platforms
 } // vmime
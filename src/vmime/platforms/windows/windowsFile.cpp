@@ -298,6 +298,21 @@ windowsFile::length_type windowsFile::getLength()
 	return dwSize;
 }
 
+time_t windowsFile::getLastModificationTime()
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+
+	if (!GetFileAttributesEx(m_nativePath.c_str(), GetFileExInfoStandard, &data))
+		windowsFileSystemFactory::reportError(m_path, GetLastError());
+
+	// Convert from 100-nanosecond intervals since January 1, 1601
+	ULARGE_INTEGER t;
+	t.LowPart = data.ftLastWriteTime.dwLowDateTime;
+	t.HighPart = data.ftLastWriteTime.dwHighDateTime;
+
+	return static_cast <time_t>((t.QuadPart - 116444736000000000ULL) / 10000000ULL);
+}
+
 const vmime::utility::path& windowsFile::getFullPath() const
 {
 	return m_path;
@@ -79,6 +79,7 @@ public:
 	bool canWrite() const;
 
 	length_type getLength();
+	time_t getLastModificationTime();
 
 	const path& getFullPath() const;
 
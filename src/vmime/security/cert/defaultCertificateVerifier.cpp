@@ -32,6 +32,12 @@
 #include "vmime/security/cert/X509Certificate.hpp"
 
 #include "vmime/exception.hpp"
+#include "vmime/platform.hpp"
+
+#include "vmime/utility/stringUtils.hpp"
+#include "vmime/utility/sync/autoLock.hpp"
+
+#include <sstream>
 
 
 namespace vmime {
@@ -39,8 +45,14 @@ namespace security {
 namespace cert {
 
 
+#define LOCK_CACHE() \
+	utility::sync::autoLock <utility::sync::criticalSection> lock(m_cacheMutex)
+
+
 defaultCertificateVerifier::defaultCertificateVerifier()
+	: m_cacheTimeout(300), m_cacheMaxSize(100)
 {
+	m_cacheMutex = platform::getHandler()->createCriticalSection();
 }
 
 
@@ -50,7 +62,7 @@ defaultCertificateVerifier::~defaultCertificateVerifier()
 
 
 defaultCertificateVerifier::defaultCertificateVerifier(const defaultCertificateVerifier&)
-	: certificateVerifier()
+	: certificateVerifier(), m_cacheTimeout(0), m_cacheMaxSize(0)
 {
 	// Not used
 }
@@ -74,6 +86,17 @@ void defaultCertificateVerifier::verify
 void defaultCertificateVerifier::verifyX509
 	(shared_ptr <certificateChain> chain, const string& hostname)
 {
+	// Do not verify again a chain which has been verified recently
+	string cacheKey;
+
+	if (m_cacheTimeout != 0)
+	{
+		cacheKey = makeCacheKey(chain, hostname);
+
+		if (isVerificationCached(cacheKey))
+			return;
+	}
+
 	// For every certificate in the chain, verify that the certificate
 	// has been issued by the next certificate in the chain
 	if (chain->getCount() >= 2)
@@ -153,6 +176,97 @@ void defaultCertificateVerifier::verifyX509
 
 		throw ex;
 	}
+
+	if (!cacheKey.empty())
+		cacheVerification(cacheKey, chain);
+}
+
+
+// static
+const string defaultCertificateVerifier::makeCacheKey
+	(shared_ptr <certificateChain> chain, const string& hostname)
+{
+	// The encoded certificates are compared, rather than a digest of
+	// them, so that a chain cannot be mistaken for another one
+	std::ostringstream key;
+	key.imbue(std::locale::classic());
+
+	key << utility::stringUtils::toLower(hostname) << '\n';
+
+	for (size_t i = 0 ; i < chain->getCount() ; ++i)
+	{
+		const byteArray encoded = chain->getAt(i)->getEncoded();
+
+		key << encoded.size() << ':';
+
+		if (!encoded.empty())
+			key.write(reinterpret_cast <const char*>(&encoded[0]), encoded.size());
+	}
+
+	return key.str();
+}
+
+
+bool defaultCertificateVerifier::isVerificationCached(const string& key)
+{
+	LOCK_CACHE();
+
+	CacheMap::iterator it = m_cache.find(key);
+
+	if (it == m_cache.end())
+		return false;
+
+	if (platform::getHandler()->getUnixTime() < it->second.expireTime &&
+	    !(datetime::now() > it->second.notAfter))
+	{
+		return true;
+	}
+
+	m_cache.erase(it);
+
+	return false;
+}
+
+
+void defaultCertificateVerifier::cacheVerification
+	(const string& key, shared_ptr <certificateChain> chain)
+{
+	CacheEntry entry;
+	entry.expireTime = platform::getHandler()->getUnixTime() + m_cacheTimeout;
+
+	for (size_t i = 0 ; i < chain->getCount() ; ++i)
+	{
+		const datetime expirationDate =
+			dynamicCast <X509Certificate>(chain->getAt(i))->getExpirationDate();
+
+		if (i == 0 || expirationDate < entry.notAfter)
+			entry.notAfter = expirationDate;
+	}
+
+	LOCK_CACHE();
+
+	if (m_cacheMaxSize == 0)
+		return;
+
+	if (m_cache.find(key) == m_cache.end())
+	{
+		// All entries have the same lifetime: the one which expires
+		// first is the oldest one
+		while (m_cache.size() >= m_cacheMaxSize)
+		{
+			CacheMap::iterator oldest = m_cache.begin();
+
+			for (CacheMap::iterator it = m_cache.begin() ; it != m_cache.end() ; ++it)
+			{
+				if (it->second.expireTime < oldest->second.expireTime)
+					oldest = it;
+			}
+
+			m_cache.erase(oldest);
+		}
+	}
+
+	m_cache[key] = entry;
 }
 
 
@@ -160,6 +274,8 @@ void defaultCertificateVerifier::setX509RootCAs
 	(const std::vector <shared_ptr <X509Certificate> >& caCerts)
 {
 	m_x509RootCAs = caCerts;
+
+	clearVerificationCache();
 }
 
 
@@ -167,6 +283,46 @@ void defaultCertificateVerifier::setX509TrustedCerts
 	(const std::vector <shared_ptr <X509Certificate> >& trustedCerts)
 {
 	m_x509TrustedCerts = trustedCerts;
+
+	clearVerificationCache();
+}
+
+
+void defaultCertificateVerifier::setVerificationCacheTimeout(const unsigned int seconds)
+{
+	LOCK_CACHE();
+
+	m_cacheTimeout = seconds;
+	m_cache.clear();
+}
+
+
+unsigned int defaultCertificateVerifier::getVerificationCacheTimeout() const
+{
+	return m_cacheTimeout;
+}
+
+
+void defaultCertificateVerifier::setVerificationCacheMaxSize(const size_t maxSize)
+{
+	LOCK_CACHE();
+
+	m_cacheMaxSize = maxSize;
+	m_cache.clear();
+}
+
+
+size_t defaultCertificateVerifier::getVerificationCacheMaxSize() const
+{
+	return m_cacheMaxSize;
+}
+
+
+void defaultCertificateVerifier::clearVerificationCache()
+{
+	LOCK_CACHE();
+
+	m_cache.clear();
 }
 
 
@@ -33,6 +33,12 @@
 
 #include "vmime/security/cert/certificateVerifier.hpp"
 
+#include "vmime/dateTime.hpp"
+
+#include "vmime/utility/sync/criticalSection.hpp"
+
+#include <map>
+
 
 namespace vmime {
 namespace security {
@@ -67,6 +73,43 @@ public:
 	  */
 	void setX509RootCAs(const std::vector <shared_ptr <X509Certificate> >& caCerts);
 
+	/** Sets for how long the result of a successful verification is
+	  * remembered. During this time, a server presenting the same chain
+	  * of certificates for the same host name is accepted without the
+	  * chain being verified again. Results are forgotten when the trusted
+	  * certificates or root CAs are changed, and never outlive the
+	  * expiration date of the certificates. Default is 300 seconds.
+	  *
+	  * @param seconds lifetime of cached results, or zero to disable
+	  * the cache
+	  */
+	void setVerificationCacheTimeout(const unsigned int seconds);
+
+	/** Returns for how long the result of a successful verification
+	  * is remembered.
+	  *
+	  * @return lifetime of cached results, in seconds
+	  */
+	unsigned int getVerificationCacheTimeout() const;
+
+	/** Sets the maximum number of verification results remembered.
+	  * When the cache is full, the oldest result is forgotten.
+	  * Default is 100.
+	  *
+	  * @param maxSize maximum number of cached results
+	  */
+	void setVerificationCacheMaxSize(const size_t maxSize);
+
+	/** Returns the maximum number of verification results remembered.
+	  *
+	  * @return maximum number of cached results
+	  */
+	size_t getVerificationCacheMaxSize() const;
+
+	/** Forgets the results of all previous verifications.
+	  */
+	void clearVerificationCache();
+
 
 	// Implementation of 'certificateVerifier'
 	void verify(shared_ptr <certificateChain> chain, const string& hostname);
@@ -80,9 +123,47 @@ private:
 	  */
 	void verifyX509(shared_ptr <certificateChain> chain, const string& hostname);
 
+	/** Builds the key which identifies a chain of X.509 certificates
+	  * presented for the specified host in the verification cache.
+	  *
+	  * @param chain list of X.509 certificates
+	  * @param hostname server hostname
+	  * @return cache key
+	  */
+	static const string makeCacheKey(shared_ptr <certificateChain> chain, const string& hostname);
+
+	/** Checks whether a successful verification of a chain is cached.
+	  *
+	  * @param key cache key (see makeCacheKey())
+	  * @return true if the chain has already been verified successfully
+	  */
+	bool isVerificationCached(const string& key);
+
+	/** Remembers that a chain has been verified successfully.
+	  *
+	  * @param key cache key (see makeCacheKey())
+	  * @param chain list of X.509 certificates
+	  */
+	void cacheVerification(const string& key, shared_ptr <certificateChain> chain);
+
 
 	std::vector <shared_ptr <X509Certificate> > m_x509RootCAs;
 	std::vector <shared_ptr <X509Certificate> > m_x509TrustedCerts;
+
+
+	struct CacheEntry
+	{
+		unsigned long expireTime;   // end of cache lifetime (Unix time)
+		datetime notAfter;          // earliest expiration date in the chain
+	};
+
+	typedef std::map <string, CacheEntry> CacheMap;
+
+	CacheMap m_cache;
+	unsigned int m_cacheTimeout;
+	size_t m_cacheMaxSize;
+
+	shared_ptr <utility::sync::criticalSection> m_cacheMutex;
 };
 
 
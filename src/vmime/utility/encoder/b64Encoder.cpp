@@ -24,6 +24,15 @@
 #include "vmime/utility/encoder/b64Encoder.hpp"
 #include "vmime/parserHelpers.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+#if VMIME_HAVE_AVX2_DISPATCH
+	#include <immintrin.h>
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
 
 namespace vmime {
 namespace utility {
@@ -70,7 +79,264 @@ const unsigned char b64Encoder::sm_decodeMap[256] =
 };
 
 #ifndef VMIME_BUILDING_DOC
-	#define B64_WRITE(s, x, l) s.write(reinterpret_cast <byte_t*>(x), l)
+
+namespace
+{
+
+
+// Block kernels
+//
+// Kernels process as much data as they can using SIMD instructions, and
+// return the number of 3-byte groups (encoding) or characters (decoding)
+// they have processed; the rest is processed by the generic code. Decoding
+// kernels stop on the first block containing a character which is not in
+// the Base64 alphabet (whitespace, padding or invalid characters).
+//
+// Vector algorithms are the ones described by Wojciech Mula and Daniel
+// Lemire in "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+
+typedef vmime::size_t (*encodeKernel)
+	(const vmime::byte_t* in, const vmime::size_t groupCount, vmime::byte_t* out);
+
+typedef vmime::size_t (*decodeKernel)
+	(const vmime::byte_t* in, const vmime::size_t length, vmime::byte_t* out);
+
+
+// Number of bytes which may be written by a decoding kernel after
+// the end of the decoded data
+const vmime::size_t DECODE_KERNEL_OVERRUN = 8;
+
+
+#if defined(__SSE2__)
+
+// Translates characters of the Base64 alphabet into 6-bit values; 'valid'
+// is set to 0xff for each character which is in the alphabet
+inline __m128i charsToValuesSSE2(const __m128i v, __m128i& valid)
+{
+	const __m128i upper = _mm_and_si128
+		(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), v));
+	const __m128i lower = _mm_and_si128
+		(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), v));
+	const __m128i digit = _mm_and_si128
+		(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), v));
+	const __m128i plus = _mm_cmpeq_epi8(v, _mm_set1_epi8('+'));
+	const __m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+
+	valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash);
+
+	const __m128i shift = _mm_or_si128(
+		_mm_or_si128(
+			_mm_or_si128(
+				_mm_and_si128(upper, _mm_set1_epi8(0 - 'A')),
+				_mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+			_mm_or_si128(
+				_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+				_mm_and_si128(plus, _mm_set1_epi8(62 - '+')))),
+		_mm_and_si128(slash, _mm_set1_epi8(63 - '/')));
+
+	return _mm_add_epi8(v, shift);
+}
+
+
+vmime::size_t decodeSSE2(const vmime::byte_t* in, const vmime::size_t length, vmime::byte_t* out)
+{
+	// 16 characters are decoded at a time
+	vmime::size_t i = 0;
+
+	for ( ; i + 16 <= length ; i += 16, out += 12)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast <const __m128i*>(in + i));
+
+		__m128i valid;
+		const __m128i values = charsToValuesSSE2(v, valid);
+
+		if (_mm_movemask_epi8(valid) != 0xffff)
+			break;
+
+		// Merge values [a b c d] into 24-bit integers (a << 18 | b << 12 | c << 6 | d)
+		const __m128i ab = _mm_or_si128
+			(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00ff)), 6),
+			 _mm_srli_epi16(values, 8));
+		const __m128i abcd = _mm_madd_epi16(ab, _mm_set1_epi32(0x00011000));
+
+		// Swap bytes, so that the most significant byte comes first
+		const __m128i bytes = _mm_or_si128(
+			_mm_or_si128(
+				_mm_and_si128(_mm_srli_epi32(abcd, 16), _mm_set1_epi32(0x0000ff)),
+				_mm_and_si128(abcd, _mm_set1_epi32(0x00ff00))),
+			_mm_and_si128(_mm_slli_epi32(abcd, 16), _mm_set1_epi32(0xff0000)));
+
+		// Write 3 bytes from each 32-bit lane
+		vmime::byte_t lanes[16];
+		_mm_storeu_si128(reinterpret_cast <__m128i*>(lanes), bytes);
+
+		std::memcpy(out, lanes, 4);
+		std::memcpy(out + 3, lanes + 4, 4);
+		std::memcpy(out + 6, lanes + 8, 4);
+		std::memcpy(out + 9, lanes + 12, 4);
+	}
+
+	return i;
+}
+
+#endif // defined(__SSE2__)
+
+
+#if VMIME_HAVE_AVX2_DISPATCH
+
+__attribute__((target("avx2")))
+vmime::size_t encodeAVX2(const vmime::byte_t* in, const vmime::size_t groupCount, vmime::byte_t* out)
+{
+	// Each 128-bit lane is loaded with 16 bytes and encodes 12 of them,
+	// so 28 bytes must be readable for 8 groups (24 bytes) to be encoded
+	const __m256i groupShuffle = _mm256_setr_epi8
+		(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+		 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+	const __m256i shiftLUT = _mm256_setr_epi8
+		('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		 '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+		 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		 '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+	vmime::size_t i = 0;
+
+	for ( ; (i + 8) * 3 + 4 <= groupCount * 3 ; i += 8, in += 24, out += 32)
+	{
+		const __m256i v = _mm256_inserti128_si256
+			(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast <const __m128i*>(in))),
+			 _mm_loadu_si128(reinterpret_cast <const __m128i*>(in + 12)), 1);
+
+		const __m256i groups = _mm256_shuffle_epi8(v, groupShuffle);
+
+		const __m256i indices = _mm256_or_si256
+			(_mm256_mulhi_epu16(_mm256_and_si256(groups, _mm256_set1_epi32(0x0fc0fc00)),
+			                    _mm256_set1_epi32(0x04000040)),
+			 _mm256_mullo_epi16(_mm256_and_si256(groups, _mm256_set1_epi32(0x003f03f0)),
+			                    _mm256_set1_epi32(0x01000010)));
+
+		// Translate indices: compute an index into 'shiftLUT' for each range
+		// of the alphabet, and add the shift to the index
+		__m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+		range = _mm256_or_si256(range, _mm256_and_si256
+			(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+
+		const __m256i chars = _mm256_add_epi8(_mm256_shuffle_epi8(shiftLUT, range), indices);
+
+		_mm256_storeu_si256(reinterpret_cast <__m256i*>(out), chars);
+	}
+
+	return i;
+}
+
+
+__attribute__((target("avx2")))
+vmime::size_t decodeAVX2(const vmime::byte_t* in, const vmime::size_t length, vmime::byte_t* out)
+{
+	const __m256i packShuffle = _mm256_setr_epi8
+		(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+	// 32 characters are decoded at a time
+	vmime::size_t i = 0;
+
+	for ( ; i + 32 <= length ; i += 32, out += 24)
+	{
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast <const __m256i*>(in + i));
+
+		const __m256i upper = _mm256_and_si256
+			(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+		const __m256i lower = _mm256_and_si256
+			(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), v));
+		const __m256i digit = _mm256_and_si256
+			(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+		const __m256i plus = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('+'));
+		const __m256i slash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'));
+
+		const __m256i valid = _mm256_or_si256
+			(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, plus)), slash);
+
+		if (_mm256_movemask_epi8(valid) != -1)
+			break;
+
+		const __m256i shift = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_or_si256(
+					_mm256_and_si256(upper, _mm256_set1_epi8(0 - 'A')),
+					_mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+				_mm256_or_si256(
+					_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+					_mm256_and_si256(plus, _mm256_set1_epi8(62 - '+')))),
+			_mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')));
+
+		const __m256i values = _mm256_add_epi8(v, shift);
+
+		// Merge values [a b c d] into 24-bit integers, then pack them
+		const __m256i ab = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+		const __m256i abcd = _mm256_madd_epi16(ab, _mm256_set1_epi32(0x00011000));
+
+		const __m256i packed = _mm256_permutevar8x32_epi32
+			(_mm256_shuffle_epi8(abcd, packShuffle), _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+		_mm256_storeu_si256(reinterpret_cast <__m256i*>(out), packed);
+	}
+
+	return i;
+}
+
+#endif // VMIME_HAVE_AVX2_DISPATCH
+
+
+struct b64Kernels
+{
+	encodeKernel encode;
+	decodeKernel decode;
+};
+
+
+// Select the best kernels for the processor we are running on
+b64Kernels selectKernels()
+{
+	b64Kernels kernels;
+	kernels.encode = NULL;
+	kernels.decode = NULL;
+
+#if defined(__SSE2__)
+	// SSE2 has no byte shuffle instruction, and the encoding kernel that
+	// can be built without it is not faster than the generic code
+	kernels.decode = decodeSSE2;
+#endif
+
+#if VMIME_HAVE_AVX2_DISPATCH
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2"))
+	{
+		kernels.encode = encodeAVX2;
+		kernels.decode = decodeAVX2;
+	}
+#endif
+
+	return kernels;
+}
+
+
+const b64Kernels KERNELS = selectKernels();
+
+
+// Number of 4-byte groups on a line: a CRLF is written after a group if
+// there is no room left on the line for another group and the CRLF
+inline vmime::size_t getGroupsPerLine(const vmime::size_t maxLineLength)
+{
+	if (maxLineLength > 2 + 4 + 4)
+		return (maxLineLength - 2 - 4 + 3) / 4;
+
+	return 1;
+}
+
+
+} // namespace
+
 #endif // VMIME_BUILDING_DOC
 
 
@@ -86,98 +352,101 @@ size_t b64Encoder::encode(utility::inputStream& in,
 	const bool cutLines = (propMaxLineLength != static_cast <size_t>(-1));
 	const size_t maxLineLength = std::min(propMaxLineLength, static_cast <size_t>(76));
 
-	// Process data
-	byte_t buffer[65536];
-	size_t bufferLength = 0;
-	size_t bufferPos = 0;
+	const size_t groupsPerLine = cutLines ? getGroupsPerLine(maxLineLength) : 0;
 
-	byte_t bytes[3];
-	byte_t output[4];
+	// Data is processed by blocks of whole 3-byte groups; the bytes of an
+	// incomplete group are kept for the next block
+	byte_t buffer[3 * 4096];
+	byte_t output[(4 + 2) * 4096];  // 4 bytes + CRLF per group, at most
+
+	size_t bufferLength = 0;
+	size_t lineGroupCount = 0;  // number of groups on the current line
 
 	size_t total = 0;
 	size_t inTotal = 0;
 
-	size_t curCol = 0;
-
 	if (progress)
 		progress->start(0);
 
-	while (bufferPos < bufferLength || !in.eof())
-	{
-		if (bufferPos >= bufferLength)
-		{
-			bufferLength = in.read(buffer, sizeof(buffer));
-			bufferPos = 0;
+	bool last = false;
 
-			if (bufferLength == 0)
-				break;
-		}
+	while (!last)
+	{
+		const size_t read = in.eof() ? 0 : in.read(buffer + bufferLength, sizeof(buffer) - bufferLength);
 
-		// Get 3 bytes of data
-		int count = 0;
+		bufferLength += read;
+		last = (read == 0);
 
-		while (count < 3 && bufferPos < bufferLength)
-			bytes[count++] = buffer[bufferPos++];
+		size_t groupCount = bufferLength / 3;
+		const size_t rest = bufferLength % 3;
 
-		while (count < 3)
+		// At the end of data, the last group is padded
+		if (last && rest != 0)
 		{
-			// There may be more data in the next chunk...
-			if (bufferPos >= bufferLength)
-			{
-				bufferLength = in.read(buffer, sizeof(buffer));
-				bufferPos = 0;
-
-				if (bufferLength == 0)
-					break;
-			}
-
-			while (count < 3 && bufferPos < bufferLength)
-				bytes[count++] = buffer[bufferPos++];
+			std::fill(buffer + bufferLength, buffer + groupCount * 3 + 3, 0);
+			++groupCount;
 		}
 
-		// Encode data
-		switch (count)
+		// Encode groups, line by line
+		const byte_t* inPos = buffer;
+		byte_t* outPos = output;
+
+		for (size_t remaining = groupCount ; remaining != 0 ; )
 		{
-		case 1:
+			size_t count = remaining;
 
-			output[0] = sm_alphabet[(bytes[0] & 0xFC) >> 2];
-			output[1] = sm_alphabet[(bytes[0] & 0x03) << 4];
-			output[2] = sm_alphabet[64]; // padding
-			output[3] = sm_alphabet[64]; // padding
+			if (cutLines)
+				count = std::min(count, groupsPerLine - lineGroupCount);
 
-			break;
+			size_t done = 0;
 
-		case 2:
+			if (KERNELS.encode)
+				done = KERNELS.encode(inPos, count, outPos);
 
-			output[0] = sm_alphabet[(bytes[0] & 0xFC) >> 2];
-			output[1] = sm_alphabet[((bytes[0] & 0x03) << 4) | ((bytes[1] & 0xF0) >> 4)];
-			output[2] = sm_alphabet[(bytes[1] & 0x0F) << 2];
-			output[3] = sm_alphabet[64]; // padding
+			for (size_t i = done ; i < count ; ++i)
+			{
+				const byte_t* bytes = inPos + i * 3;
+				byte_t* chars = outPos + i * 4;
 
-			break;
+				chars[0] = sm_alphabet[(bytes[0] & 0xFC) >> 2];
+				chars[1] = sm_alphabet[((bytes[0] & 0x03) << 4) | ((bytes[1] & 0xF0) >> 4)];
+				chars[2] = sm_alphabet[((bytes[1] & 0x0F) << 2) | ((bytes[2] & 0xC0) >> 6)];
+				chars[3] = sm_alphabet[(bytes[2] & 0x3F)];
+			}
 
-		default:
-		case 3:
+			inPos += count * 3;
+			outPos += count * 4;
+			remaining -= count;
 
-			output[0] = sm_alphabet[(bytes[0] & 0xFC) >> 2];
-			output[1] = sm_alphabet[((bytes[0] & 0x03) << 4) | ((bytes[1] & 0xF0) >> 4)];
-			output[2] = sm_alphabet[((bytes[1] & 0x0F) << 2) | ((bytes[2] & 0xC0) >> 6)];
-			output[3] = sm_alphabet[(bytes[2] & 0x3F)];
+			if (last && rest != 0 && remaining == 0)
+			{
+				// Padding
+				outPos[-1] = sm_alphabet[64];
 
-			break;
+				if (rest == 1)
+					outPos[-2] = sm_alphabet[64];
+			}
+
+			if (cutLines && (lineGroupCount += count) == groupsPerLine)
+			{
+				*outPos++ = '\r';
+				*outPos++ = '\n';
+
+				lineGroupCount = 0;
+			}
 		}
 
 		// Write encoded data to output stream
-		B64_WRITE(out, output, 4);
+		out.write(output, outPos - output);
 
-		inTotal += count;
-		total += 4;
-		curCol += 4;
+		total += groupCount * 4;
+		inTotal += (last ? bufferLength : groupCount * 3);
 
-		if (cutLines && curCol + 2 /* \r\n */ + 4 /* next bytes */ >= maxLineLength)
+		// Keep the bytes of the incomplete group
+		if (!last)
 		{
-			out.write("\r\n", 2);
-			curCol = 0;
+			std::copy(buffer + groupCount * 3, buffer + bufferLength, buffer);
+			bufferLength = rest;
 		}
 
 		if (progress)
@@ -198,103 +467,125 @@ size_t b64Encoder::decode(utility::inputStream& in,
 
 	// Process the data
 	byte_t buffer[16384];
-	size_t bufferLength = 0;
-	size_t bufferPos = 0;
+	byte_t output[(sizeof(buffer) / 4 + 1) * 3 + DECODE_KERNEL_OVERRUN];
 
 	size_t total = 0;
 	size_t inTotal = 0;
 
+	// 4 bytes of input provide 3 bytes of output; characters of a group
+	// may be separated by whitespace, or be split between two blocks
 	byte_t bytes[4];
-	byte_t output[3];
+	int count = 0;
+
+	bool end = false;
 
 	if (progress)
 		progress->start(0);
 
-	while (bufferPos < bufferLength || !in.eof())
+	while (!end && !in.eof())
 	{
-		bytes[0] = '=';
-		bytes[1] = '=';
-		bytes[2] = '=';
-		bytes[3] = '=';
+		const size_t bufferLength = in.read(buffer, sizeof(buffer));
 
-		// Need to get more data?
-		if (bufferPos >= bufferLength)
-		{
-			bufferLength = in.read(buffer, sizeof(buffer));
-			bufferPos = 0;
-
-			// No more data
-			if (bufferLength == 0)
-				break;
-		}
-
-		// 4 bytes of input provide 3 bytes of output, so
-		// get the next 4 bytes from the input stream.
-		int count = 0;
+		// No more data
+		if (bufferLength == 0)
+			break;
 
-		while (count < 4 && bufferPos < bufferLength)
-		{
-			const byte_t c = buffer[bufferPos++];
+		const byte_t* pos = buffer;
+		const byte_t* const bufferEnd = buffer + bufferLength;
 
-			if (!parserHelpers::isSpace(c))
-				bytes[count++] = c;
-		}
+		byte_t* outPos = output;
 
-		if (count != 4)
+		while (pos < bufferEnd && !end)
 		{
-			while (count < 4 && !in.eof())
+			if (count == 0)
 			{
-				// Data continues on the next chunk
-				bufferLength = in.read(buffer, sizeof(buffer));
-				bufferPos = 0;
+				// Decode contiguous groups that do not contain whitespace,
+				// padding or invalid characters
+				if (KERNELS.decode)
+				{
+					const size_t n = KERNELS.decode(pos, bufferEnd - pos, outPos);
+
+					pos += n;
+					outPos += (n / 4) * 3;
+				}
 
-				while (count < 4 && bufferPos < bufferLength)
+				for ( ; bufferEnd - pos >= 4 ; pos += 4, outPos += 3)
 				{
-					const byte_t c = buffer[bufferPos++];
+					// Padding is mapped to a valid value in the decoding table
+					if (pos[0] == '=' || pos[1] == '=' || pos[2] == '=' || pos[3] == '=')
+						break;
+
+					const unsigned char v0 = sm_decodeMap[pos[0]];
+					const unsigned char v1 = sm_decodeMap[pos[1]];
+					const unsigned char v2 = sm_decodeMap[pos[2]];
+					const unsigned char v3 = sm_decodeMap[pos[3]];
+
+					if ((v0 | v1 | v2 | v3) & 0xc0)
+						break;
 
-					if (!parserHelpers::isSpace(c))
-						bytes[count++] = c;
+					outPos[0] = static_cast <byte_t>((v0 << 2) | (v1 >> 4));
+					outPos[1] = static_cast <byte_t>(((v1 & 0xf) << 4) | (v2 >> 2));
+					outPos[2] = static_cast <byte_t>(((v2 & 0x03) << 6) | v3);
 				}
+
+				if (pos == bufferEnd)
+					break;
 			}
-		}
 
-		if (count != 4)  // input length is not a multiple of 4 bytes
-			break;
+			// Whitespace, padding, invalid characters, or end of block
+			const byte_t c = *pos++;
 
-		// Decode the bytes
-		byte_t c1 = bytes[0];
-		byte_t c2 = bytes[1];
+			if (parserHelpers::isSpace(c))
+				continue;
 
-		if (c1 == '=' || c2 == '=')  // end
-			break;
+			bytes[count++] = c;
 
-		output[0] = static_cast <byte_t>((sm_decodeMap[c1] << 2) | ((sm_decodeMap[c2] & 0x30) >> 4));
+			if (count != 4)
+				continue;
 
-		c1 = bytes[2];
+			count = 0;
 
-		if (c1 == '=')  // end
-		{
-			B64_WRITE(out, output, 1);
-			total += 1;
-			break;
-		}
+			// Decode the bytes
+			byte_t c1 = bytes[0];
+			byte_t c2 = bytes[1];
 
-		output[1] = static_cast <byte_t>(((sm_decodeMap[c2] & 0xf) << 4) | ((sm_decodeMap[c1] & 0x3c) >> 2));
+			if (c1 == '=' || c2 == '=')  // end
+			{
+				end = true;
+				break;
+			}
 
-		c2 = bytes[3];
+			outPos[0] = static_cast <byte_t>((sm_decodeMap[c1] << 2) | ((sm_decodeMap[c2] & 0x30) >> 4));
 
-		if (c2 == '=')  // end
-		{
-			B64_WRITE(out, output, 2);
-			total += 2;
-			break;
+			c1 = bytes[2];
+
+			if (c1 == '=')  // end
+			{
+				outPos += 1;
+				end = true;
+				break;
+			}
+
+			outPos[1] = static_cast <byte_t>(((sm_decodeMap[c2] & 0xf) << 4) | ((sm_decodeMap[c1] & 0x3c) >> 2));
+
+			c2 = bytes[3];
+
+			if (c2 == '=')  // end
+			{
+				outPos += 2;
+				end = true;
+				break;
+			}
+
+			outPos[2] = static_cast <byte_t>(((sm_decodeMap[c1] & 0x03) << 6) | sm_decodeMap[c2]);
+			outPos += 3;
 		}
 
-		output[2] = static_cast <byte_t>(((sm_decodeMap[c1] & 0x03) << 6) | sm_decodeMap[c2]);
+		// Write decoded data to output stream
+		out.write(output, outPos - output);
 
-		B64_WRITE(out, output, 3);
-		total += 3;
-		inTotal += count;
+		total += outPos - output;
+		inTotal += pos - buffer;
 
 		if (progress)
 			progress->progress(inTotal, inTotal);
@@ -315,9 +606,13 @@ size_t b64Encoder::getEncodedSize(const size_t n) const
 	const bool cutLines = (propMaxLineLength != static_cast <size_t>(-1));
 	const size_t maxLineLength = std::min(propMaxLineLength, static_cast <size_t>(76));
 
-	return (n * 4) / 3                               // 3 bytes of input provide 4 bytes of output
-		 + (cutLines ? (n / maxLineLength) * 2 : 0)  // CRLF (2 bytes) for each line.
-		 + 4;                                        // padding
+	// 3 bytes of input provide 4 bytes of output (the last group is padded)
+	const size_t groupCount = (n + 2) / 3;
+
+	if (!cutLines)
+		return groupCount * 4;
+
+	return groupCount * 4 + (groupCount / getGroupsPerLine(maxLineLength)) * 2;
 }
 
 
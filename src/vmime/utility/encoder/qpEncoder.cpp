@@ -24,6 +24,13 @@
 #include "vmime/utility/encoder/qpEncoder.hpp"
 #include "vmime/parserHelpers.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
 
 namespace vmime {
 namespace utility {
@@ -159,6 +166,115 @@ int qpEncoder::RFC2047_getEncodedLength(const byte_t c)
 
 #define QP_WRITE(s, x, l) s.write(reinterpret_cast <byte_t*>(x), l)
 
+
+namespace
+{
+
+
+// Number of bytes which may be written by copyLiteralRun() after
+// the end of the copied data
+const vmime::size_t RUN_COPY_OVERRUN = 16;
+
+
+// Returns whether the specified character can be represented literally
+// in quoted-printable encoded data: the printable characters except '='
+// and '?' (see encode()), and space, if not followed by a line break
+inline bool isLiteralChar(const vmime::byte_t c)
+{
+	return static_cast <unsigned int>(c - 32) < 95 && c != '=' && c != '?';
+}
+
+
+// Copies the characters at the beginning of the specified data which can
+// be represented literally (spaces are not checked for line breaks), up to
+// 'maxCount' characters, and returns the number of characters copied
+vmime::size_t copyLiteralRun(const vmime::byte_t* const in, const vmime::size_t length,
+	vmime::byte_t* const out, const vmime::size_t maxCount)
+{
+	vmime::size_t i = 0;
+
+#if defined(__SSE2__)
+
+	// Classify 16 characters at a time; they are copied before we know
+	// where the run ends, as characters after the run will be overwritten
+	for ( ; i < maxCount && i + 16 <= length ; i += 16)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast <const __m128i*>(in + i));
+		_mm_storeu_si128(reinterpret_cast <__m128i*>(out + i), v);
+
+		const __m128i printable = _mm_and_si128
+			(_mm_cmpgt_epi8(v, _mm_set1_epi8(31)), _mm_cmpgt_epi8(_mm_set1_epi8(127), v));
+		const __m128i special = _mm_or_si128
+			(_mm_cmpeq_epi8(v, _mm_set1_epi8('=')), _mm_cmpeq_epi8(v, _mm_set1_epi8('?')));
+
+		const int mask = _mm_movemask_epi8(_mm_andnot_si128(special, printable));
+
+		if (mask != 0xffff)
+		{
+			i += static_cast <vmime::size_t>(__builtin_ctz(static_cast <unsigned int>(~mask)));
+			return std::min(i, maxCount);
+		}
+	}
+
+#endif // defined(__SSE2__)
+
+	for ( ; i < maxCount && i < length && isLiteralChar(in[i]) ; ++i)
+		out[i] = in[i];
+
+	return std::min(i, maxCount);
+}
+
+
+// Copies the characters at the beginning of the specified data up to the
+// first occurrence of '=' or 'other', up to 'maxCount' characters, and
+// returns the number of characters copied
+vmime::size_t copyUnencodedRun(const vmime::byte_t* const in, const vmime::size_t length,
+	vmime::byte_t* const out, const vmime::size_t maxCount, const vmime::byte_t other)
+{
+	const vmime::size_t count = std::min(length, maxCount);
+
+#if defined(__SSE2__)
+
+	vmime::size_t i = 0;
+
+	for ( ; i + 16 <= count ; i += 16)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast <const __m128i*>(in + i));
+		_mm_storeu_si128(reinterpret_cast <__m128i*>(out + i), v);
+
+		const int mask = _mm_movemask_epi8(_mm_or_si128
+			(_mm_cmpeq_epi8(v, _mm_set1_epi8('=')),
+			 _mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast <char>(other)))));
+
+		if (mask != 0)
+			return i + static_cast <vmime::size_t>(__builtin_ctz(static_cast <unsigned int>(mask)));
+	}
+
+	for ( ; i < count && in[i] != '=' && in[i] != other ; ++i)
+		out[i] = in[i];
+
+	return i;
+
+#else
+
+	const vmime::byte_t* end = static_cast <const vmime::byte_t*>(std::memchr(in, '=', count));
+
+	if (end == NULL)
+		end = in + count;
+
+	end = std::find(in, end, other);
+
+	std::copy(in, end, out);
+
+	return end - in;
+
+#endif // defined(__SSE2__)
+}
+
+
+} // namespace
+
+
 #endif // VMIME_BUILDING_DOC
 
 
@@ -183,7 +299,8 @@ size_t qpEncoder::encode(utility::inputStream& in,
 
 	size_t curCol = 0;
 
-	byte_t outBuffer[16384];
+	const size_t outBufferSize = 16384;
+	byte_t outBuffer[outBufferSize + RUN_COPY_OVERRUN];
 	size_t outBufferPos = 0;
 
 	size_t total = 0;
@@ -195,7 +312,7 @@ size_t qpEncoder::encode(utility::inputStream& in,
 	while (bufferPos < bufferLength || !in.eof())
 	{
 		// Flush current output buffer
-		if (outBufferPos + 6 >= static_cast <int>(sizeof(outBuffer)))
+		if (outBufferPos + 6 >= outBufferSize)
 		{
 			QP_WRITE(out, outBuffer, outBufferPos);
 
@@ -214,6 +331,72 @@ size_t qpEncoder::encode(utility::inputStream& in,
 				break;
 		}
 
+		// Copy characters which do not need to be encoded at once, up to
+		// the end of the line; other characters are handled one by one
+		const byte_t first = buffer[bufferPos];
+
+		if (rfc2047 ? (first < 128 && sm_RFC2047EncodeTable[first] == 0)
+		            : (isLiteralChar(first) && (first != '.' || curCol != 0)))
+		{
+			const byte_t* const start = buffer + bufferPos;
+			const size_t length = bufferLength - bufferPos;
+
+			size_t maxCount = outBufferSize - 6 - outBufferPos;
+			size_t count = 0;
+
+			if (rfc2047)
+			{
+				for ( ; count < length && count < maxCount &&
+				        start[count] < 128 && sm_RFC2047EncodeTable[start[count]] == 0 ; ++count)
+				{
+					outBuffer[outBufferPos + count] = start[count];
+				}
+			}
+			else
+			{
+				if (cutLines)
+				{
+					const size_t lineLength = maxLineLength - 1;
+					maxCount = std::min(maxCount, curCol < lineLength ? lineLength - curCol : 1);
+				}
+
+				count = copyLiteralRun(start, length, outBuffer + outBufferPos, maxCount);
+
+				// A space followed by a line break (or at the end of the
+				// buffer) may have to be encoded, so it is checked later
+				if (count != 0 && start[count - 1] == ' ' &&
+				    (count == length || start[count] == '\r' || start[count] == '\n'))
+				{
+					--count;
+				}
+			}
+
+			if (count != 0)
+			{
+				outBufferPos += count;
+				bufferPos += count;
+				curCol += count;
+
+				// Soft line break : "=\r\n"
+				if (!rfc2047 && cutLines && curCol >= maxLineLength - 1)
+				{
+					outBuffer[outBufferPos] = '=';
+					outBuffer[outBufferPos + 1] = '\r';
+					outBuffer[outBufferPos + 2] = '\n';
+
+					outBufferPos += 3;
+					curCol = 0;
+				}
+
+				inTotal += count;
+
+				if (progress)
+					progress->progress(inTotal, inTotal);
+
+				continue;
+			}
+		}
+
 		// Get the next char and encode it
 		const byte_t c = buffer[bufferPos++];
 
@@ -414,6 +597,25 @@ size_t qpEncoder::decode(utility::inputStream& in,
 				break;
 		}
 
+		// Copy characters up to the next encoded sequence at once
+		const byte_t first = buffer[bufferPos];
+
+		if (first != '=' && (first != '_' || !rfc2047))
+		{
+			const size_t count = copyUnencodedRun
+				(buffer + bufferPos, bufferLength - bufferPos, outBuffer + outBufferPos,
+				 sizeof(outBuffer) - outBufferPos, rfc2047 ? '_' : '=');
+
+			outBufferPos += count;
+			bufferPos += count;
+			inTotal += count;
+
+			if (progress)
+				progress->progress(inTotal, inTotal);
+
+			continue;
+		}
+
 		// Decode the next sequence (hex-encoded byte or printable character)
 		byte_t c = buffer[bufferPos++];
 
@@ -544,8 +746,14 @@ size_t qpEncoder::getEncodedSize(const size_t n) const
 	const size_t maxLineLength = std::min(propMaxLineLength, static_cast <size_t>(74));
 
 	// Worst cast: 1 byte of input provide 3 bytes of output
-	// Count CRLF (2 bytes) for each line.
-	return n * 3 + (cutLines ? (n / maxLineLength) * 2 : 0);
+	if (!cutLines)
+		return n * 3;
+
+	// A soft line break ("=" + CRLF) is inserted when the line is full,
+	// which takes at least (maxLineLength - 1) / 3 bytes of input
+	const size_t minBytesPerLine = std::max(static_cast <size_t>(1), (maxLineLength - 1) / 3);
+
+	return n * 3 + (n / minBytesPerLine) * 3;
 }
 
 
@@ -30,6 +30,8 @@
 #include "vmime/utility/path.hpp"
 #include "vmime/utility/stream.hpp"
 
+#include <ctime>
+
 
 #if VMIME_HAVE_FILESYSTEM_FEATURES
 
@@ -149,6 +151,20 @@ public:
 	  */
 	virtual length_type getLength() = 0;
 
+	/** Return the time of the last modification of this file/directory.
+	  * For a directory, this is updated when a file is created, removed
+	  * or renamed in it.
+	  *
+	  * The default implementation returns 0, for file systems which
+	  * do not provide this information.
+	  *
+	  * @return last modification time, or 0 if it is unknown
+	  */
+	virtual time_t getLastModificationTime()
+	{
+		return 0;
+	}
+
 	/** Return the full path of this file/directory.
 	  *
 	  * @return full path of the file
@@ -24,6 +24,7 @@
 #include "vmime/utility/filteredStream.hpp"
 
 #include <algorithm>
+#include <cstring>
 
 
 namespace vmime {
@@ -86,42 +87,36 @@ size_t dotFilteredInputStream::read(byte_t* const data, const size_t count)
 
 	size_t written = 0;
 
+	// Previous characters must be tracked separately, as data is
+	// modified in place
+	byte_t prevChar2 = m_previousChar2;
+	byte_t prevChar1 = m_previousChar1;
+
 	// Replace "\n.." with "\n."
 	while (readPtr < end)
 	{
-		if (*readPtr == '.')
-		{
-			const byte_t prevChar2 =
-				(readPtr == data + 1 ? m_previousChar1 :
-				 readPtr == data ? m_previousChar2 : *(readPtr - 2));
-			const byte_t prevChar1 =
-				(readPtr == data ? m_previousChar1 : *(readPtr - 1));
-
-			if (prevChar2 == '\n' && prevChar1 == '.')
-			{
-				// Ignore last dot
-			}
-			else
-			{
-				*writePtr = *readPtr;
+		const byte_t c = *readPtr;
 
-				++writePtr;
-				++written;
-			}
+		if (c == '.' && prevChar2 == '\n' && prevChar1 == '.')
+		{
+			// Ignore last dot
 		}
 		else
 		{
-			*writePtr = *readPtr;
+			*writePtr = c;
 
 			++writePtr;
 			++written;
 		}
 
+		prevChar2 = prevChar1;
+		prevChar1 = c;
+
 		++readPtr;
 	}
 
-	m_previousChar2 = (read >= 2 ? data[read - 2] : m_previousChar1);
-	m_previousChar1 = (read >= 1 ? data[read - 1] : '\0');
+	m_previousChar2 = prevChar2;
+	m_previousChar1 = prevChar1;
 
 	return (written);
 }
@@ -216,6 +211,170 @@ size_t dotFilteredOutputStream::getBlockSize()
 }
 
 
+// dotUnstuffingFilteredOutputStream
+
+dotUnstuffingFilteredOutputStream::dotUnstuffingFilteredOutputStream(outputStream& os)
+	: m_stream(os), m_state(STATE_LINE_START), m_lineBreakLength(0)
+{
+}
+
+
+outputStream& dotUnstuffingFilteredOutputStream::getNextOutputStream()
+{
+	return (m_stream);
+}
+
+
+void dotUnstuffingFilteredOutputStream::writeImpl
+	(const byte_t* const data, const size_t count)
+{
+	const byte_t* pos = data;
+	const byte_t* const end = data + count;
+
+	// Line breaks and dots at the beginning of a line are not written
+	// until we know whether they are part of the terminating line
+	while (pos < end && m_state != STATE_TERMINATED)
+	{
+		switch (m_state)
+		{
+		case STATE_TEXT:
+		{
+			// Write the rest of the line at once
+			const byte_t* lf = static_cast <const byte_t*>(std::memchr(pos, '\n', end - pos));
+
+			if (lf == NULL)
+			{
+				if (end[-1] == '\r')
+				{
+					m_stream.write(pos, end - 1 - pos);
+					m_state = STATE_CR;
+				}
+				else
+				{
+					m_stream.write(pos, end - pos);
+				}
+
+				pos = end;
+			}
+			else
+			{
+				m_lineBreakLength = (lf > pos && lf[-1] == '\r') ? 2 : 1;
+				m_stream.write(pos, lf + 1 - m_lineBreakLength - pos);
+
+				m_state = STATE_LINE_START;
+				pos = lf + 1;
+			}
+
+			break;
+		}
+		case STATE_CR:
+
+			if (*pos == '\n')
+			{
+				m_lineBreakLength = 2;
+				m_state = STATE_LINE_START;
+
+				++pos;
+			}
+			else
+			{
+				m_stream.write("\r", 1);
+				m_state = STATE_TEXT;
+			}
+
+			break;
+
+		case STATE_LINE_START:
+
+			if (*pos == '.')
+			{
+				m_state = STATE_DOT;
+				++pos;
+			}
+			else
+			{
+				writeLineBreak();
+				m_state = STATE_TEXT;
+			}
+
+			break;
+
+		case STATE_DOT:
+
+			if (*pos == '\n')
+			{
+				m_state = STATE_TERMINATED;
+			}
+			else if (*pos == '\r')
+			{
+				m_state = STATE_DOT_CR;
+				++pos;
+			}
+			else
+			{
+				// "\n.." becomes "\n.": the second dot (if any) is
+				// written as part of the line
+				writeLineBreak();
+				m_state = STATE_TEXT;
+
+				if (*pos != '.')
+					m_stream.write(".", 1);
+			}
+
+			break;
+
+		case STATE_DOT_CR:
+
+			if (*pos == '\n')
+			{
+				m_state = STATE_TERMINATED;
+			}
+			else
+			{
+				writeLineBreak();
+				m_stream.write(".\r", 2);
+
+				m_state = STATE_TEXT;
+			}
+
+			break;
+
+		case STATE_TERMINATED:
+
+			break;
+		}
+	}
+}
+
+
+void dotUnstuffingFilteredOutputStream::writeLineBreak()
+{
+	// There is no line break before the first line
+	if (m_lineBreakLength == 2)
+		m_stream.write("\r\n", 2);
+	else if (m_lineBreakLength == 1)
+		m_stream.write("\n", 1);
+}
+
+
+bool dotUnstuffingFilteredOutputStream::isTerminated() const
+{
+	return m_state == STATE_TERMINATED;
+}
+
+
+void dotUnstuffingFilteredOutputStream::flush()
+{
+	m_stream.flush();
+}
+
+
+size_t dotUnstuffingFilteredOutputStream::getBlockSize()
+{
+	return m_stream.getBlockSize();
+}
+
+
 // CRLFToLFFilteredOutputStream
 
 CRLFToLFFilteredOutputStream::CRLFToLFFilteredOutputStream(outputStream& os)
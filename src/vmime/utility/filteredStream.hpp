@@ -134,6 +134,59 @@ private:
 };
 
 
+/** A filtered output stream which decodes dot-stuffed data, as
+  * received from a server in a multi-line response: "\n.." sequences
+  * are replaced with "\n.", and the terminating line (a single dot)
+  * is removed, along with the line break before it. Data written
+  * after the terminating line is ignored.
+  */
+
+class VMIME_EXPORT dotUnstuffingFilteredOutputStream : public filteredOutputStream
+{
+public:
+
+	/** Construct a new filter for the specified output stream.
+	  *
+	  * @param os stream into which write filtered data
+	  */
+	dotUnstuffingFilteredOutputStream(outputStream& os);
+
+	outputStream& getNextOutputStream();
+
+	void flush();
+
+	size_t getBlockSize();
+
+	/** Returns whether the terminating line has been written.
+	  *
+	  * @return true if the end of data has been reached, false otherwise
+	  */
+	bool isTerminated() const;
+
+protected:
+
+	void writeImpl(const byte_t* const data, const size_t count);
+
+private:
+
+	enum State
+	{
+		STATE_TEXT,        // inside a line
+		STATE_CR,          // after a CR inside a line
+		STATE_LINE_START,  // after a line break
+		STATE_DOT,         // after a dot at the beginning of a line
+		STATE_DOT_CR,      // after a dot and a CR at the beginning of a line
+		STATE_TERMINATED   // after the terminating line
+	};
+
+	void writeLineBreak();
+
+	outputStream& m_stream;
+	State m_state;
+	size_t m_lineBreakLength;   // pending line break: 0 (none), 1 (LF) or 2 (CRLF)
+};
+
+
 /** A filtered output stream which replaces CRLF sequences
   * with single LF characters.
   */
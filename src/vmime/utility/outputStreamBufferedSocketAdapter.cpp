@@ -0,0 +1,112 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "vmime/utility/outputStreamBufferedSocketAdapter.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+
+#include "vmime/net/socket.hpp"
+
+#include <algorithm>
+
+
+namespace vmime {
+namespace utility {
+
+
+outputStreamBufferedSocketAdapter::outputStreamBufferedSocketAdapter
+	(net::socket& sok, const size_t bufferSize)
+	: m_socket(sok), m_bufferLength(0)
+{
+	m_buffer.resize(bufferSize != 0 ? bufferSize : sok.getBlockSize());
+}
+
+
+void outputStreamBufferedSocketAdapter::writeImpl
+	(const byte_t* const data, const size_t count)
+{
+	const size_t bufferSize = m_buffer.size();
+
+	// Data fits in the buffer
+	if (m_bufferLength + count < bufferSize)
+	{
+		std::copy(data, data + count, m_buffer.begin() + m_bufferLength);
+		m_bufferLength += count;
+
+		return;
+	}
+
+	const byte_t* pos = data;
+	size_t remaining = count;
+
+	// Complete the buffer and send it
+	if (m_bufferLength != 0)
+	{
+		const size_t n = bufferSize - m_bufferLength;
+
+		std::copy(pos, pos + n, m_buffer.begin() + m_bufferLength);
+
+		m_socket.sendRaw(&m_buffer[0], bufferSize);
+		m_bufferLength = 0;
+
+		pos += n;
+		remaining -= n;
+	}
+
+	// Send large blocks directly, and keep the rest for later
+	if (remaining >= bufferSize)
+	{
+		m_socket.sendRaw(pos, remaining);
+	}
+	else
+	{
+		std::copy(pos, pos + remaining, m_buffer.begin());
+		m_bufferLength = remaining;
+	}
+}
+
+
+void outputStreamBufferedSocketAdapter::flush()
+{
+	if (m_bufferLength != 0)
+	{
+		m_socket.sendRaw(&m_buffer[0], m_bufferLength);
+		m_bufferLength = 0;
+	}
+}
+
+
+size_t outputStreamBufferedSocketAdapter::getBlockSize()
+{
+	return m_buffer.size();
+}
+
+
+} // utility
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+
@@ -0,0 +1,97 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#ifndef VMIME_UTILITY_OUTPUTSTREAMBUFFEREDSOCKETADAPTER_HPP_INCLUDED
+#define VMIME_UTILITY_OUTPUTSTREAMBUFFEREDSOCKETADAPTER_HPP_INCLUDED
+
+
+#include "vmime/utility/outputStream.hpp"
+
+
+#if VMIME_HAVE_MESSAGING_FEATURES
+
+
+#include <vector>
+
+
+namespace vmime {
+namespace net {
+	class socket;  // forward reference
+} // net
+} // vmime
+
+
+namespace vmime {
+namespace utility {
+
+
+/** An output stream that is connected to a socket, and which
+  * coalesces small writes before sending them.
+  *
+  * Data is sent when the buffer is full, or when flush() is called.
+  * Large writes are not copied: the buffered data is completed with
+  * the beginning of the write, and the rest is sent directly.
+  * Buffered data is discarded if the stream is destroyed without
+  * being flushed.
+  */
+
+class VMIME_EXPORT outputStreamBufferedSocketAdapter : public outputStream
+{
+public:
+
+	/** Construct a new buffered socket output stream.
+	  *
+	  * @param sok socket to which data will be sent
+	  * @param bufferSize size of the buffer, or 0 to use the block
+	  * size of the socket
+	  */
+	outputStreamBufferedSocketAdapter(net::socket& sok, const size_t bufferSize = 0);
+
+	void flush();
+
+	size_t getBlockSize();
+
+protected:
+
+	void writeImpl(const byte_t* const data, const size_t count);
+
+private:
+
+	outputStreamBufferedSocketAdapter(const outputStreamBufferedSocketAdapter&);
+
+	net::socket& m_socket;
+
+	std::vector <byte_t> m_buffer;
+	size_t m_bufferLength;
+};
+
+
+} // utility
+} // vmime
+
+
+#endif // VMIME_HAVE_MESSAGING_FEATURES
+
+
+#endif // VMIME_UTILITY_OUTPUTSTREAMBUFFEREDSOCKETADAPTER_HPP_INCLUDED
+
@@ -0,0 +1,58 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "vmime/utility/outputStreamByteCounter.hpp"
+
+
+namespace vmime {
+namespace utility {
+
+
+outputStreamByteCounter::outputStreamByteCounter()
+	: m_count(0)
+{
+}
+
+
+void outputStreamByteCounter::writeImpl
+	(const byte_t* const /* data */, const size_t count)
+{
+	m_count += count;
+}
+
+
+size_t outputStreamByteCounter::getCount() const
+{
+	return m_count;
+}
+
+
+void outputStreamByteCounter::flush()
+{
+	// Do nothing
+}
+
+
+} // utility
+} // vmime
+
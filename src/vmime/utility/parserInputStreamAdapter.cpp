@@ -28,28 +28,105 @@ namespace vmime {
 namespace utility {
 
 
+// Bounds for the size of the read-ahead window
+static const size_t MIN_BUFFER_SIZE = 512;
+static const size_t MAX_BUFFER_SIZE = 65536;
+
+
 parserInputStreamAdapter::parserInputStreamAdapter(shared_ptr <seekableInputStream> stream)
-	: m_stream(stream)
+	: m_stream(stream), m_bufferOffset(0), m_bufferLength(0), m_pos(stream->getPosition()),
+	  m_dashLinesBegin(0), m_dashLinesEnd(0)
 {
 }
 
 
 bool parserInputStreamAdapter::eof() const
 {
-	return m_stream->eof();
+	return !isBuffered(m_pos, 1) && fillBuffer(m_pos, 1) == 0;
 }
 
 
 void parserInputStreamAdapter::reset()
 {
 	m_stream->reset();
+	m_pos = 0;
 }
 
 
 size_t parserInputStreamAdapter::read
 	(byte_t* const data, const size_t count)
 {
-	return m_stream->read(data, count);
+	size_t total = 0;
+
+	// Copy bytes available in the read-ahead window
+	if (isBuffered(m_pos, 1))
+	{
+		total = std::min(count, m_bufferOffset + m_bufferLength - m_pos);
+
+		std::copy(m_buffer.begin() + (m_pos - m_bufferOffset),
+		          m_buffer.begin() + (m_pos - m_bufferOffset + total), data);
+
+		m_pos += total;
+	}
+
+	if (total < count)
+	{
+		const size_t remaining = count - total;
+
+		if (remaining < MIN_BUFFER_SIZE)
+		{
+			// Small read: go through the window
+			const size_t n = std::min(remaining, fillBuffer(m_pos, 1));
+
+			std::copy(m_buffer.begin(), m_buffer.begin() + n, data + total);
+
+			total += n;
+			m_pos += n;
+		}
+		else
+		{
+			// Large read: bypass the window
+			m_stream->seek(m_pos);
+
+			const size_t n = m_stream->read(data + total, remaining);
+
+			total += n;
+			m_pos += n;
+		}
+	}
+
+	return total;
+}
+
+
+void parserInputStreamAdapter::seek(const size_t pos)
+{
+	if (pos >= m_bufferOffset && pos <= m_bufferOffset + m_bufferLength)
+	{
+		m_pos = pos;
+	}
+	else
+	{
+		m_stream->seek(pos);
+		m_pos = m_stream->getPosition();
+	}
+}
+
+
+size_t parserInputStreamAdapter::skip(const size_t count)
+{
+	if (isBuffered(m_pos, count))
+	{
+		m_pos += count;
+		return count;
+	}
+
+	m_stream->seek(m_pos);
+
+	const size_t n = m_stream->skip(count);
+	m_pos += n;
+
+	return n;
 }
 
 
@@ -59,108 +136,137 @@ shared_ptr <seekableInputStream> parserInputStreamAdapter::getUnderlyingStream()
 }
 
 
-const string parserInputStreamAdapter::extract(const size_t begin, const size_t end) const
+size_t parserInputStreamAdapter::fillBuffer(const size_t pos, const size_t minLength) const
 {
-	const size_t initialPos = m_stream->getPosition();
+	// The window grows each time it is refilled: this avoids allocating
+	// a large buffer when parsing small strings
+	size_t size = std::max(m_buffer.size() * 2, MIN_BUFFER_SIZE);
 
-	byte_t *buffer = NULL;
+	if (size > MAX_BUFFER_SIZE)
+		size = std::max(m_buffer.size(), MAX_BUFFER_SIZE);
 
-	try
-	{
-		buffer = new byte_t[end - begin + 1];
+	if (size < minLength)
+		size = minLength;
 
-		m_stream->seek(begin);
+	if (size != m_buffer.size())
+		m_buffer.resize(size);
 
-		const size_t readBytes = m_stream->read(buffer, end - begin);
-		buffer[readBytes] = '\0';
+	// Invalidate current window, in case read() throws
+	m_bufferOffset = 0;
+	m_bufferLength = 0;
 
-		m_stream->seek(initialPos);
+	m_stream->seek(pos);
 
-		string str(buffer, buffer + readBytes);
-		delete [] buffer;
+	const size_t readBytes = m_stream->read(&m_buffer[0], size);
 
-		return str;
-	}
-	catch (...)
-	{
-		delete [] buffer;
+	m_bufferOffset = pos;
+	m_bufferLength = readBytes;
+
+	return readBytes;
+}
 
-		m_stream->seek(initialPos);
-		throw;
+
+const string parserInputStreamAdapter::extract(const size_t begin, const size_t end) const
+{
+	if (end <= begin)
+		return string();
+
+	if (isBuffered(begin, end - begin))
+	{
+		return string(m_buffer.begin() + (begin - m_bufferOffset),
+		              m_buffer.begin() + (end - m_bufferOffset));
 	}
+
+	string str(end - begin, '\0');
+
+	m_stream->seek(begin);
+
+	const size_t readBytes = m_stream->read(reinterpret_cast <byte_t*>(&str[0]), end - begin);
+	str.resize(readBytes);
+
+	return str;
 }
 
 
 size_t parserInputStreamAdapter::findNext
 	(const string& token, const size_t startPosition)
 {
-	static const unsigned int BUFFER_SIZE = 4096;
-
-	// Token must not be longer than BUFFER_SIZE/2
-	if (token.empty() || token.length() > BUFFER_SIZE / 2)
+	if (token.empty())
 		return npos;
 
-	const size_t initialPos = getPosition();
+	const size_t tokenLength = token.length();
+	const byte_t* const tokenBytes = reinterpret_cast <const byte_t*>(token.data());
 
-	seek(startPosition);
+	size_t pos = startPosition;
 
-	try
+	while (true)
 	{
-		byte_t findBuffer[BUFFER_SIZE];
-		byte_t* findBuffer1 = findBuffer;
-		byte_t* findBuffer2 = findBuffer + (BUFFER_SIZE / 2);
+		// Ensure the window contains at least one candidate position
+		if (!isBuffered(pos, tokenLength) && fillBuffer(pos, tokenLength) < tokenLength)
+			return npos;
 
-		size_t findBufferLen = 0;
-		size_t findBufferOffset = 0;
+		const byte_t* const buffer = &m_buffer[0];
+		const byte_t* const last = buffer + m_bufferLength - tokenLength;  // last candidate
 
-		bool isEOF = false;
-
-		// Fill in initial buffer
-		findBufferLen = read(findBuffer, BUFFER_SIZE);
-
-		while (findBufferLen != 0)
+		// Scan for the first byte of the token (memchr() is usually
+		// vectorized), then compare the remaining bytes
+		for (const byte_t* p = buffer + (pos - m_bufferOffset) ; p <= last ; ++p)
 		{
-			// Find token
-			for (byte_t *begin = findBuffer, *end = findBuffer + findBufferLen - token.length() ;
-			     begin <= end ; ++begin)
-			{
-				if (begin[0] == token[0] &&
-				    (token.length() == 1 ||
-				     memcmp(static_cast <const void *>(&begin[1]),
-				            static_cast <const void *>(token.data() + 1),
-				            token.length() - 1) == 0))
-				{
-					seek(initialPos);
-					return startPosition + findBufferOffset + (begin - findBuffer);
-				}
-			}
+			p = static_cast <const byte_t*>(::memchr(p, tokenBytes[0], last - p + 1));
 
-			// Rotate buffer
-			memcpy(findBuffer1, findBuffer2, (BUFFER_SIZE / 2));
+			if (p == NULL)
+				break;
 
-			// Read more bytes
-			if (findBufferLen < BUFFER_SIZE && (eof() || isEOF))
+			if (p[tokenLength - 1] == tokenBytes[tokenLength - 1] &&
+			    ::memcmp(p + 1, tokenBytes + 1, tokenLength - 1) == 0)
 			{
-				break;
+				return m_bufferOffset + (p - buffer);
 			}
-			else
-			{
-				const size_t bytesRead = read(findBuffer2, BUFFER_SIZE / 2);
+		}
+
+		// Continue with the next candidate position (the window will be
+		// refilled from there, so that a token spanning the end of the
+		// current window is found)
+		pos = m_bufferOffset + (last - buffer) + 1;
+	}
+}
 
-				if (bytesRead == 0)
-					isEOF = true;
 
-				findBufferLen = (BUFFER_SIZE / 2) + bytesRead;
-				findBufferOffset += (BUFFER_SIZE / 2);
-			}
-		}
+size_t parserInputStreamAdapter::findNextDashLine(const size_t startPosition)
+{
+	static const string DASH_LINE("\n--");
 
-		seek(initialPos);
+	// Searching before the indexed range: restart indexing from here
+	if (startPosition < m_dashLinesBegin || m_dashLinesBegin == m_dashLinesEnd)
+	{
+		m_dashLines.clear();
+		m_dashLinesBegin = startPosition;
+		m_dashLinesEnd = startPosition;
 	}
-	catch (...)
+
+	// Look in the lines already found
+	std::vector <size_t>::const_iterator it =
+		std::lower_bound(m_dashLines.begin(), m_dashLines.end(), startPosition);
+
+	if (it != m_dashLines.end())
+		return *it;
+
+	// Extend the indexed range up to the next line
+	while (m_dashLinesEnd != npos)
 	{
-		seek(initialPos);
-		throw;
+		const size_t pos = findNext(DASH_LINE, m_dashLinesEnd);
+
+		if (pos == npos)
+		{
+			m_dashLinesEnd = npos;
+			break;
+		}
+
+		m_dashLines.push_back(pos);
+		m_dashLinesEnd = pos + 1;
+
+		if (pos >= startPosition)
+			return pos;
 	}
 
 	return npos;
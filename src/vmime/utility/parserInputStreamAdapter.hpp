@@ -27,7 +27,9 @@
 
 #include "vmime/utility/seekableInputStream.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 
 namespace vmime {
@@ -35,6 +37,11 @@ namespace utility {
 
 
 /** An adapter class used for parsing from an input stream.
+  *
+  * Bytes are read from the underlying stream into an internal read-ahead
+  * window, so that byte-level operations (peekByte(), getByte(), matchBytes()
+  * and skipIf()) are performed in memory. The underlying stream must not be
+  * modified while the adapter is in use.
   */
 
 class VMIME_EXPORT parserInputStreamAdapter : public seekableInputStream
@@ -50,20 +57,12 @@ public:
 	bool eof() const;
 	void reset();
 	size_t read(byte_t* const data, const size_t count);
-
-	void seek(const size_t pos)
-	{
-		m_stream->seek(pos);
-	}
-
-	size_t skip(const size_t count)
-	{
-		return m_stream->skip(count);
-	}
+	void seek(const size_t pos);
+	size_t skip(const size_t count);
 
 	size_t getPosition() const
 	{
-		return m_stream->getPosition();
+		return m_pos;
 	}
 
 	/** Get the byte at the current position without updating the
@@ -73,22 +72,10 @@ public:
 	  */
 	byte_t peekByte() const
 	{
-		const size_t initialPos = m_stream->getPosition();
-
-		try
-		{
-			byte_t buffer[1];
-			const size_t readBytes = m_stream->read(buffer, 1);
+		if (isBuffered(m_pos, 1) || fillBuffer(m_pos, 1) != 0)
+			return m_buffer[m_pos - m_bufferOffset];
 
-			m_stream->seek(initialPos);
-
-			return (readBytes == 1 ? buffer[0] : static_cast <byte_t>(0));
-		}
-		catch (...)
-		{
-			m_stream->seek(initialPos);
-			throw;
-		}
+		return 0;
 	}
 
 	/** Get the byte at the current position and advance current
@@ -98,10 +85,10 @@ public:
 	  */
 	byte_t getByte()
 	{
-		byte_t buffer[1];
-		const size_t readBytes = m_stream->read(buffer, 1);
+		if (isBuffered(m_pos, 1) || fillBuffer(m_pos, 1) != 0)
+			return m_buffer[m_pos++ - m_bufferOffset];
 
-		return (readBytes == 1 ? buffer[0] : static_cast <byte_t>(0));
+		return 0;
 	}
 
 	/** Check whether the bytes following the current position match
@@ -114,23 +101,10 @@ public:
 	template <typename T>
 	bool matchBytes(const T* bytes, const size_t length) const
 	{
-		const size_t initialPos = m_stream->getPosition();
-
-		try
-		{
-			byte_t buffer[32];
-			const size_t readBytes = m_stream->read(buffer, length);
-
-			m_stream->seek(initialPos);
+		if (!isBuffered(m_pos, length) && fillBuffer(m_pos, length) < length)
+			return false;
 
-			return readBytes == length &&
-			       ::memcmp(bytes, buffer, length) == 0;
-		}
-		catch (...)
-		{
-			m_stream->seek(initialPos);
-			throw;
-		}
+		return ::memcmp(bytes, &m_buffer[m_pos - m_bufferOffset], length) == 0;
 	}
 
 	const string extract(const size_t begin, const size_t end) const;
@@ -147,22 +121,78 @@ public:
 	template <typename PREDICATE>
 	size_t skipIf(PREDICATE pred, const size_t endPosition)
 	{
-		const size_t initialPos = getPosition();
-		size_t pos = initialPos;
+		const size_t initialPos = m_pos;
+
+		while (m_pos < endPosition)
+		{
+			if (!isBuffered(m_pos, 1) && fillBuffer(m_pos, 1) == 0)
+				break;  // end of stream
 
-		while (!m_stream->eof() && pos < endPosition && pred(getByte()))
-			++pos;
+			const size_t bufferEnd = std::min(m_bufferOffset + m_bufferLength, endPosition);
 
-		m_stream->seek(pos);
+			while (m_pos < bufferEnd && pred(m_buffer[m_pos - m_bufferOffset]))
+				++m_pos;
 
-		return pos - initialPos;
+			if (m_pos < bufferEnd)
+				break;  // predicate not matched
+		}
+
+		return m_pos - initialPos;
 	}
 
 	size_t findNext(const string& token, const size_t startPosition = 0);
 
+	/** Find the next line which starts with "--", that is the next
+	  * occurrence of the "\n--" sequence (MIME boundary delimiter lines
+	  * are a subset of these lines).
+	  *
+	  * The positions found are cached, so that the bytes of the stream
+	  * are scanned only once, even when nested multipart bodies search
+	  * the same range for different boundaries.
+	  *
+	  * @param startPosition position from which to start the search
+	  * @return position of the "\n--" sequence, or npos if not found
+	  */
+	size_t findNextDashLine(const size_t startPosition);
+
 private:
 
+	/** Test whether the specified range is entirely contained in
+	  * the read-ahead window.
+	  *
+	  * @param pos position in the stream
+	  * @param length number of bytes
+	  * @return true if the bytes are available in the window
+	  */
+	bool isBuffered(const size_t pos, const size_t length) const
+	{
+		return pos >= m_bufferOffset &&
+		       pos - m_bufferOffset + length <= m_bufferLength;
+	}
+
+	/** Read bytes from the underlying stream into the read-ahead window,
+	  * starting at the specified position.
+	  *
+	  * @param pos position in the stream
+	  * @param minLength minimum size of the window
+	  * @return number of bytes available in the window
+	  */
+	size_t fillBuffer(const size_t pos, const size_t minLength) const;
+
+
 	mutable shared_ptr <seekableInputStream> m_stream;
+
+	mutable std::vector <byte_t> m_buffer;
+	mutable size_t m_bufferOffset;
+	mutable size_t m_bufferLength;
+
+	size_t m_pos;
+
+	// Positions of the "\n--" sequences found in the range
+	// [m_dashLinesBegin, m_dashLinesEnd) of the stream
+	std::vector <size_t> m_dashLines;
+	size_t m_dashLinesBegin;
+	size_t m_dashLinesEnd;
 };
 
 
@@ -85,7 +85,9 @@
 #include "vmime/utility/outputStreamAdapter.hpp"
 #include "vmime/utility/outputStreamByteArrayAdapter.hpp"
 #include "vmime/utility/outputStreamSocketAdapter.hpp"
+#include "vmime/utility/outputStreamBufferedSocketAdapter.hpp"
 #include "vmime/utility/outputStreamStringAdapter.hpp"
+#include "vmime/utility/outputStreamByteCounter.hpp"
 #include "vmime/utility/streamUtils.hpp"
 
 // Message builder/parser
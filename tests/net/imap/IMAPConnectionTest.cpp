@@ -0,0 +1,244 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "tests/net/imap/IMAPTestUtils.hpp"
+
+#include "vmime/net/imap/IMAPConnection.hpp"
+#include "vmime/net/imap/IMAPCommand.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPConnectionTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testQueueCommands)
+		VMIME_TEST(testQueuedCommandError)
+		VMIME_TEST(testSendCommandAfterQueue)
+		VMIME_TEST(testQueueCommandSendError)
+		VMIME_TEST(testGetFoldersStatus)
+		VMIME_TEST(testGetFoldersStatusError)
+	VMIME_TEST_LIST_END
+
+
+	class recordingHandler : public vmime::net::imap::IMAPConnection::commandResponseHandler
+	{
+	public:
+
+		recordingHandler()
+			: m_failOn(-1)
+		{
+		}
+
+		void handleCommandResponse
+			(vmime::shared_ptr <vmime::net::imap::IMAPCommand> cmd,
+			 const vmime::net::imap::IMAPParser::response* resp)
+		{
+			const int index = static_cast <int>(m_commands.size());
+
+			m_commands.push_back(cmd->getText());
+			m_status.push_back(resp->response_done()->response_tagged()->resp_cond_state()->status());
+
+			if (index == m_failOn)
+				throw vmime::exceptions::invalid_argument();
+		}
+
+		std::vector <vmime::string> m_commands;
+		std::vector <vmime::net::imap::IMAPParser::resp_cond_state::Status> m_status;
+
+		int m_failOn;
+	};
+
+
+	static vmime::shared_ptr <vmime::net::imap::IMAPConnection> connectToTestServer
+		(vmime::shared_ptr <IMAPTestServerSocket> socket, vmime::shared_ptr <vmime::net::store>& store)
+	{
+		store = connectIMAPTestStore(socket);
+
+		return vmime::dynamicCast <vmime::net::imap::IMAPStore>(store)->getConnection();
+	}
+
+	static const std::vector <vmime::string> makeStatusAttribs()
+	{
+		std::vector <vmime::string> attribs;
+		attribs.push_back("MESSAGES");
+
+		return attribs;
+	}
+
+
+	void testQueueCommands()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+		socket->addMailbox("A", 1);
+		socket->addMailbox("B", 2);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::imap::IMAPConnection> cnt = connectToTestServer(socket, store);
+
+		recordingHandler handler;
+
+		cnt->queueCommand(vmime::net::imap::IMAPCommand::STATUS("A", makeStatusAttribs()), &handler);
+		cnt->queueCommand(vmime::net::imap::IMAPCommand::STATUS("B", makeStatusAttribs()), &handler);
+		cnt->queueCommand(vmime::net::imap::IMAPCommand::STATUS("C", makeStatusAttribs()), &handler);
+
+		VASSERT_EQ("Queued", 3, cnt->getQueuedCommandCount());
+		VASSERT_EQ("Handler not called", 0, handler.m_commands.size());
+
+		cnt->processQueuedCommands();
+
+		VASSERT_EQ("Queue empty", 0, cnt->getQueuedCommandCount());
+		VASSERT_EQ("Pipelined", 2, socket->getPipelinedCommandCount());
+
+		VASSERT_EQ("Count", 3, handler.m_commands.size());
+		VASSERT_EQ("Command 1", "STATUS A (MESSAGES)", handler.m_commands[0]);
+		VASSERT_EQ("Command 2", "STATUS B (MESSAGES)", handler.m_commands[1]);
+		VASSERT_EQ("Command 3", "STATUS C (MESSAGES)", handler.m_commands[2]);
+
+		VASSERT_EQ("Status 1", vmime::net::imap::IMAPParser::resp_cond_state::OK, handler.m_status[0]);
+		VASSERT_EQ("Status 2", vmime::net::imap::IMAPParser::resp_cond_state::OK, handler.m_status[1]);
+		VASSERT_EQ("Status 3", vmime::net::imap::IMAPParser::resp_cond_state::NO, handler.m_status[2]);
+	}
+
+	void testQueuedCommandError()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+		socket->addMailbox("A", 1);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::imap::IMAPConnection> cnt = connectToTestServer(socket, store);
+
+		recordingHandler handler;
+		handler.m_failOn = 0;
+
+		cnt->queueCommand(vmime::net::imap::IMAPCommand::STATUS("A", makeStatusAttribs()), &handler);
+		cnt->queueCommand(vmime::net::imap::IMAPCommand::NOOP(), &handler);
+
+		VASSERT_THROW("Error", cnt->processQueuedCommands(), vmime::exceptions::command_error);
+
+		// All the responses must have been read anyway
+		VASSERT_EQ("Count", 2, handler.m_commands.size());
+		VASSERT_EQ("Queue empty", 0, cnt->getQueuedCommandCount());
+
+		// Error has been reported once
+		cnt->processQueuedCommands();
+
+		store->noop();
+	}
+
+	void testSendCommandAfterQueue()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+		socket->addMailbox("A", 1);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::imap::IMAPConnection> cnt = connectToTestServer(socket, store);
+
+		recordingHandler handler;
+
+		cnt->queueCommand(vmime::net::imap::IMAPCommand::STATUS("A", makeStatusAttribs()), &handler);
+
+		// Pending responses are read before the response to this command
+		store->noop();
+
+		VASSERT_EQ("Count", 1, handler.m_commands.size());
+		VASSERT_EQ("Queue empty", 0, cnt->getQueuedCommandCount());
+	}
+
+	void testQueueCommandSendError()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+		socket->addMailbox("A", 1);
+		socket->setSendError("NOOP");
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::imap::IMAPConnection> cnt = connectToTestServer(socket, store);
+
+		{
+			recordingHandler handler;
+
+			cnt->queueCommand(vmime::net::imap::IMAPCommand::STATUS("A", makeStatusAttribs()), &handler);
+
+			VASSERT_THROW("Send error",
+				cnt->queueCommand(vmime::net::imap::IMAPCommand::NOOP(), &handler),
+				vmime::exceptions::socket_exception);
+
+			VASSERT_EQ("Handler not called", 0, handler.m_commands.size());
+		}
+
+		// The handler does not exist anymore: the queue must not refer to it
+		VASSERT_EQ("Queue empty", 0, cnt->getQueuedCommandCount());
+
+		cnt->processQueuedCommands();
+	}
+
+	void testGetFoldersStatus()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+		socket->addMailbox("A", 10);
+		socket->addMailbox("B", 20);
+		socket->addMailbox("INBOX", 30);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		store = connectIMAPTestStore(socket);
+
+		std::vector <vmime::shared_ptr <vmime::net::folder> > folders;
+		folders.push_back(store->getFolder(vmime::net::folder::path(vmime::net::folder::path::component("A"))));
+		folders.push_back(store->getFolder(vmime::net::folder::path(vmime::net::folder::path::component("B"))));
+		folders.push_back(store->getFolder(vmime::net::folder::path(vmime::net::folder::path::component("Inbox"))));
+
+		const size_t commandCount = socket->getCommands().size();
+
+		std::vector <vmime::shared_ptr <vmime::net::folderStatus> > status =
+			vmime::dynamicCast <vmime::net::imap::IMAPStore>(store)->getFoldersStatus(folders);
+
+		VASSERT_EQ("Commands", commandCount + 3, socket->getCommands().size());
+		VASSERT_EQ("Pipelined", 2, socket->getPipelinedCommandCount());
+
+		VASSERT_EQ("Count", 3, status.size());
+		VASSERT_EQ("Status A", 10, status[0]->getMessageCount());
+		VASSERT_EQ("Status B", 20, status[1]->getMessageCount());
+		VASSERT_EQ("Status INBOX", 30, status[2]->getMessageCount());
+	}
+
+	void testGetFoldersStatusError()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+		socket->addMailbox("A", 10);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		store = connectIMAPTestStore(socket);
+
+		std::vector <vmime::shared_ptr <vmime::net::folder> > folders;
+		folders.push_back(store->getFolder(vmime::net::folder::path(vmime::net::folder::path::component("A"))));
+		folders.push_back(store->getFolder(vmime::net::folder::path(vmime::net::folder::path::component("Unknown"))));
+
+		VASSERT_THROW("Error",
+			vmime::dynamicCast <vmime::net::imap::IMAPStore>(store)->getFoldersStatus(folders),
+			vmime::exceptions::command_error);
+
+		// Connection is still usable
+		store->noop();
+	}
+
+VMIME_TEST_SUITE_END
@@ -0,0 +1,266 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "tests/net/imap/IMAPTestUtils.hpp"
+
+#include "vmime/net/imap/IMAPFolder.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPFolderTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testAddMessage)
+		VMIME_TEST(testAddMessage_Large)
+		VMIME_TEST(testFetchMessages)
+		VMIME_TEST(testFetchMessagesError)
+		VMIME_TEST(testGetAndFetchMessages)
+	VMIME_TEST_LIST_END
+
+
+	class recordingMessageChangedListener : public vmime::net::events::messageChangedListener
+	{
+	public:
+
+		void messageChanged(vmime::shared_ptr <vmime::net::events::messageChangedEvent> event)
+		{
+			const std::vector <int>& numbers = event->getNumbers();
+			m_numbers.insert(m_numbers.end(), numbers.begin(), numbers.end());
+		}
+
+		std::vector <int> m_numbers;
+	};
+
+
+	class failingProgressListener : public vmime::utility::progressListener
+	{
+	public:
+
+		failingProgressListener(const size_t failOn)
+			: m_failOn(failOn)
+		{
+		}
+
+		void start(const size_t /* predictedTotal */) { }
+		void stop(const size_t /* total */) { }
+
+		void progress(const size_t current, const size_t /* currentTotal */)
+		{
+			if (current == m_failOn)
+				throw vmime::exceptions::invalid_argument();
+		}
+
+	private:
+
+		const size_t m_failOn;
+	};
+
+
+	static vmime::shared_ptr <IMAPTestServerSocket> makeServerWithMessages(const size_t count)
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+
+		for (size_t i = 1 ; i <= count ; ++i)
+		{
+			std::ostringstream oss;
+			oss << "Subject: Message " << i << "\r\n\r\n";
+
+			IMAPTestServerSocket::testMessage msg;
+			msg.header = oss.str();
+
+			socket->addMessage(msg);
+		}
+
+		return socket;
+	}
+
+	static const vmime::string getSubject(vmime::shared_ptr <vmime::net::message> msg)
+	{
+		return msg->getHeader()->Subject()->getValue <vmime::text>()->getWholeBuffer();
+	}
+
+
+	static const vmime::string makeMessageData(const size_t lineCount)
+	{
+		std::ostringstream oss;
+		oss << "Subject: Test\r\n\r\n";
+
+		for (size_t i = 0 ; i < lineCount ; ++i)
+			oss << "Line " << i << " of the message body, with some more text\r\n";
+
+		return oss.str();
+	}
+
+
+	void testAddMessage()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openIMAPTestFolder(socket, store);
+
+		const vmime::string data = makeMessageData(100);
+		vmime::utility::inputStreamStringAdapter is(data);
+
+		const unsigned int sendCount = socket->getSendCount();
+
+		folder->addMessage(is, data.length());
+
+		// APPEND command, then message data and final CRLF at once
+		VASSERT_EQ("Send count", 2, socket->getSendCount() - sendCount);
+
+		VASSERT_EQ("Count", 1, socket->getAppendedMessages().size());
+		VASSERT_EQ("Data", data, socket->getAppendedMessages()[0]);
+	}
+
+	void testFetchMessages()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = makeServerWithMessages(3);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openIMAPTestFolder(socket, store);
+
+		recordingMessageChangedListener listener;
+		folder->addMessageChangedListener(&listener);
+
+		// Another object for message 2, which is not fetched explicitly
+		vmime::shared_ptr <vmime::net::message> other = folder->getMessage(2);
+
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 3));
+
+		// Unsolicited flags update, received after the FETCH data
+		socket->addUntaggedResponse("* 2 FETCH (FLAGS (\\Seen))");
+
+		folder->fetchMessages(msgs, vmime::net::fetchAttributes::FLAGS |
+			vmime::net::fetchAttributes::SIZE | vmime::net::fetchAttributes::FULL_HEADER);
+
+		VASSERT_EQ("Subject 1", "Message 1", getSubject(msgs[0]));
+		VASSERT_EQ("Subject 2", "Message 2", getSubject(msgs[1]));
+		VASSERT_EQ("Subject 3", "Message 3", getSubject(msgs[2]));
+
+		VASSERT_EQ("Size", 1000, msgs[2]->getSize());
+
+		VASSERT_EQ("Flags 1", 0, msgs[0]->getFlags());
+		VASSERT_EQ("Flags 2", vmime::net::message::FLAG_SEEN, msgs[1]->getFlags());
+
+		// Other objects for the same message are updated too
+		VASSERT_EQ("Flags 2 (other)", vmime::net::message::FLAG_SEEN, other->getFlags());
+
+		// One event per FETCH response, in the order they were received
+		VASSERT_EQ("Event count", 4, listener.m_numbers.size());
+		VASSERT_EQ("Event 1", 1, listener.m_numbers[0]);
+		VASSERT_EQ("Event 2", 2, listener.m_numbers[1]);
+		VASSERT_EQ("Event 3", 3, listener.m_numbers[2]);
+		VASSERT_EQ("Event 4", 2, listener.m_numbers[3]);
+
+		folder->removeMessageChangedListener(&listener);
+	}
+
+	void testFetchMessagesError()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = makeServerWithMessages(3);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openIMAPTestFolder(socket, store);
+
+		recordingMessageChangedListener listener;
+		folder->addMessageChangedListener(&listener);
+
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 3));
+
+		// Processing of the second message fails: the error is reported
+		// once the whole response has been read
+		failingProgressListener progress(2);
+
+		VASSERT_THROW("Error", folder->fetchMessages(msgs,
+			vmime::net::fetchAttributes::FULL_HEADER, &progress), vmime::exceptions::command_error);
+
+		VASSERT_EQ("Processed", "Message 1", getSubject(msgs[0]));
+		VASSERT_EQ("No events", 0, listener.m_numbers.size());
+
+		// The connection is still usable
+		folder->fetchMessages(msgs, vmime::net::fetchAttributes::FULL_HEADER);
+
+		VASSERT_EQ("Subject 3", "Message 3", getSubject(msgs[2]));
+		VASSERT_EQ("Event count", 3, listener.m_numbers.size());
+
+		folder->removeMessageChangedListener(&listener);
+	}
+
+	void testGetAndFetchMessages()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = makeServerWithMessages(3);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openIMAPTestFolder(socket, store);
+
+		recordingMessageChangedListener listener;
+		folder->addMessageChangedListener(&listener);
+
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs = folder->getAndFetchMessages
+			(vmime::net::messageSet::byNumber(2, 3), vmime::net::fetchAttributes::FULL_HEADER);
+
+		VASSERT_EQ("Count", 2, msgs.size());
+
+		VASSERT_EQ("Number 1", 2, msgs[0]->getNumber());
+		VASSERT_EQ("UID 1", "102", static_cast <vmime::string>(msgs[0]->getUID()));
+		VASSERT_EQ("Subject 1", "Message 2", getSubject(msgs[0]));
+
+		VASSERT_EQ("Number 2", 3, msgs[1]->getNumber());
+		VASSERT_EQ("UID 2", "103", static_cast <vmime::string>(msgs[1]->getUID()));
+		VASSERT_EQ("Subject 2", "Message 3", getSubject(msgs[1]));
+
+		VASSERT_EQ("Event count", 2, listener.m_numbers.size());
+
+		folder->removeMessageChangedListener(&listener);
+	}
+
+	void testAddMessage_Large()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openIMAPTestFolder(socket, store);
+
+		const vmime::string data = makeMessageData(5000);
+		vmime::utility::inputStreamStringAdapter is(data);
+
+		const unsigned int sendCount = socket->getSendCount();
+
+		folder->addMessage(is, data.length());
+
+		// APPEND command, full blocks, then the rest of the data and final CRLF
+		const size_t blockSize = socket->getBlockSize();
+
+		VASSERT_EQ("Send count", 1 + data.length() / blockSize + 1,
+			socket->getSendCount() - sendCount);
+
+		VASSERT_EQ("Count", 1, socket->getAppendedMessages().size());
+		VASSERT_EQ("Data", data, socket->getAppendedMessages()[0]);
+	}
+
+VMIME_TEST_SUITE_END
+
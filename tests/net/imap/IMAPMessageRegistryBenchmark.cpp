@@ -0,0 +1,194 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+//
+// IMAP message registry benchmark
+//
+// Measures the time needed to process a storm of EXPUNGE and FETCH
+// untagged responses (one FETCH for each EXPUNGE, as sent by servers when
+// a client expunges messages while another one changes flags), with 10000
+// and 100000 live message objects. This is compared to the algorithm
+// which was used before IMAPMessageRegistry, which scanned all the
+// messages on each response and renumbered them on each EXPUNGE.
+// Message numbers found by both algorithms are checked to be identical.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+
+#include "vmime/vmime.hpp"
+#include "vmime/net/imap/IMAPMessageRegistry.hpp"
+
+
+typedef vmime::net::imap::IMAPMessage IMAPMessage;
+typedef vmime::net::imap::IMAPMessageRegistry IMAPMessageRegistry;
+
+
+// The registry never dereferences message pointers, so any
+// distinct address can be used for a message
+static IMAPMessage* fakeMessage(std::vector <char>& storage, const size_t index)
+{
+	return reinterpret_cast <IMAPMessage*>(&storage[index]);
+}
+
+
+// Generate the sequence numbers of the responses: even events are
+// EXPUNGE responses, odd events are FETCH responses
+static std::vector <int> randomEvents(const int messageCount, const int eventCount)
+{
+	std::vector <int> events(eventCount);
+
+	int liveCount = messageCount;
+	unsigned int seed = 42;
+
+	for (int e = 0 ; e < eventCount ; ++e)
+	{
+		seed = seed * 1103515245 + 12345;
+		events[e] = static_cast <int>((seed >> 8) % static_cast <unsigned int>(liveCount)) + 1;
+
+		if (e % 2 == 0)
+			--liveCount;
+	}
+
+	return events;
+}
+
+
+// Previous algorithm: each message holds its number, and all messages
+// are scanned for each response
+static double runLegacy(const int messageCount, const std::vector <int>& events, std::vector <int>& numbers)
+{
+	numbers.resize(messageCount);
+
+	for (int i = 0 ; i < messageCount ; ++i)
+		numbers[i] = i + 1;
+
+	const std::clock_t start = std::clock();
+
+	size_t found = 0;
+
+	for (size_t e = 0 ; e < events.size() ; ++e)
+	{
+		const int number = events[e];
+
+		for (int i = 0 ; i < messageCount ; ++i)
+		{
+			if (numbers[i] == number)
+			{
+				++found;
+
+				if (e % 2 == 0)
+					numbers[i] = 0;
+			}
+			else if (e % 2 == 0 && numbers[i] > number)
+			{
+				--numbers[i];
+			}
+		}
+	}
+
+	const double time = static_cast <double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+	if (found != events.size())
+		std::cerr << "Legacy: " << (events.size() - found) << " messages not found!" << std::endl;
+
+	return time;
+}
+
+
+static double runRegistry(const int messageCount, const std::vector <int>& events, std::vector <int>& numbers)
+{
+	std::vector <char> storage(messageCount);
+	IMAPMessageRegistry reg;
+
+	for (int i = 0 ; i < messageCount ; ++i)
+		reg.registerMessage(fakeMessage(storage, i), i + 1);
+
+	const std::clock_t start = std::clock();
+
+	size_t found = 0;
+	std::vector <IMAPMessage*> msgs;
+
+	for (size_t e = 0 ; e < events.size() ; ++e)
+	{
+		msgs.clear();
+
+		if (e % 2 == 0)
+			reg.expunge(events[e], msgs);
+		else
+			reg.getMessages(events[e], msgs);
+
+		found += msgs.size();
+	}
+
+	const double time = static_cast <double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+	if (found != events.size())
+		std::cerr << "Registry: " << (events.size() - found) << " messages not found!" << std::endl;
+
+	numbers.resize(messageCount);
+
+	for (int i = 0 ; i < messageCount ; ++i)
+		numbers[i] = reg.getMessageNumber(fakeMessage(storage, i));
+
+	return time;
+}
+
+
+int main()
+{
+	static const int messageCounts[] = { 10000, 100000 };
+
+	bool ok = true;
+
+	std::cout << std::setw(30) << "legacy" << std::setw(15) << "registry" << std::endl;
+
+	for (unsigned int i = 0 ; i < sizeof(messageCounts) / sizeof(messageCounts[0]) ; ++i)
+	{
+		const int messageCount = messageCounts[i];
+		const std::vector <int> events = randomEvents(messageCount, messageCount / 2);
+
+		std::vector <int> legacyNumbers, registryNumbers;
+
+		const double legacy = runLegacy(messageCount, events, legacyNumbers);
+		const double registry = runRegistry(messageCount, events, registryNumbers);
+
+		if (legacyNumbers != registryNumbers)
+		{
+			std::cerr << "Message numbers differ!" << std::endl;
+			ok = false;
+		}
+
+		std::cout << std::setw(7) << messageCount << " messages:" << std::fixed
+		          << std::setprecision(1)
+		          << std::setw(10) << legacy * 1000 << " ms"
+		          << std::setw(12) << registry * 1000 << " ms"
+		          << std::setw(8) << (registry > 0 ? legacy / registry : 0) << "x"
+		          << std::endl;
+	}
+
+	return ok ? 0 : 1;
+}
+
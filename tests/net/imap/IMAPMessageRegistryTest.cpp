@@ -0,0 +1,219 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/imap/IMAPMessageRegistry.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPMessageRegistryTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testRegister)
+		VMIME_TEST(testExpunge)
+		VMIME_TEST(testExpungeUnknownNumber)
+		VMIME_TEST(testUnregister)
+		VMIME_TEST(testRandomUpdates)
+	VMIME_TEST_LIST_END
+
+
+	typedef vmime::net::imap::IMAPMessage IMAPMessage;
+	typedef vmime::net::imap::IMAPMessageRegistry IMAPMessageRegistry;
+
+
+	// The registry never dereferences message pointers, so any
+	// distinct address can be used for a message
+	static IMAPMessage* fakeMessage(std::vector <char>& storage, const size_t index)
+	{
+		return reinterpret_cast <IMAPMessage*>(&storage[index]);
+	}
+
+
+	void testRegister()
+	{
+		std::vector <char> storage(10);
+		IMAPMessageRegistry reg;
+
+		reg.registerMessage(fakeMessage(storage, 0), 5);
+		reg.registerMessage(fakeMessage(storage, 1), 2);
+		reg.registerMessage(fakeMessage(storage, 2), 5);
+
+		VASSERT_EQ("1", 5, reg.getMessageNumber(fakeMessage(storage, 0)));
+		VASSERT_EQ("2", 2, reg.getMessageNumber(fakeMessage(storage, 1)));
+		VASSERT_EQ("3", 5, reg.getMessageNumber(fakeMessage(storage, 2)));
+		VASSERT_EQ("4", 0, reg.getMessageNumber(fakeMessage(storage, 3)));
+
+		std::vector <IMAPMessage*> msgs;
+		reg.getMessages(5, msgs);
+
+		VASSERT_EQ("5", 2, msgs.size());
+
+		msgs.clear();
+		reg.getMessages(3, msgs);
+
+		VASSERT_EQ("6", 0, msgs.size());
+	}
+
+	void testExpunge()
+	{
+		std::vector <char> storage(10);
+		IMAPMessageRegistry reg;
+
+		for (int i = 0 ; i < 10 ; ++i)
+			reg.registerMessage(fakeMessage(storage, i), i + 1);
+
+		std::vector <IMAPMessage*> expunged;
+		reg.expunge(4, expunged);
+
+		VASSERT_EQ("Expunged count", 1, expunged.size());
+		VASSERT("Expunged", expunged[0] == fakeMessage(storage, 3));
+
+		VASSERT_EQ("1", 3, reg.getMessageNumber(fakeMessage(storage, 2)));
+		VASSERT_EQ("2", 0, reg.getMessageNumber(fakeMessage(storage, 3)));
+		VASSERT_EQ("3", 4, reg.getMessageNumber(fakeMessage(storage, 4)));
+		VASSERT_EQ("4", 9, reg.getMessageNumber(fakeMessage(storage, 9)));
+
+		// A message registered after the expunge uses the new numbering
+		std::vector <char> storage2(1);
+		reg.registerMessage(fakeMessage(storage2, 0), 4);
+
+		std::vector <IMAPMessage*> msgs;
+		reg.getMessages(4, msgs);
+
+		VASSERT_EQ("5", 2, msgs.size());
+	}
+
+	void testExpungeUnknownNumber()
+	{
+		std::vector <char> storage(2);
+		IMAPMessageRegistry reg;
+
+		reg.registerMessage(fakeMessage(storage, 0), 1);
+		reg.registerMessage(fakeMessage(storage, 1), 3);
+
+		std::vector <IMAPMessage*> expunged;
+		reg.expunge(10, expunged);
+		reg.expunge(2, expunged);
+
+		VASSERT_EQ("Expunged count", 0, expunged.size());
+		VASSERT_EQ("1", 1, reg.getMessageNumber(fakeMessage(storage, 0)));
+		VASSERT_EQ("2", 2, reg.getMessageNumber(fakeMessage(storage, 1)));
+	}
+
+	void testUnregister()
+	{
+		std::vector <char> storage(3);
+		IMAPMessageRegistry reg;
+
+		reg.registerMessage(fakeMessage(storage, 0), 1);
+		reg.registerMessage(fakeMessage(storage, 1), 1);
+		reg.registerMessage(fakeMessage(storage, 2), 2);
+
+		reg.unregisterMessage(fakeMessage(storage, 0));
+
+		std::vector <IMAPMessage*> msgs;
+		reg.getMessages(1, msgs);
+
+		VASSERT_EQ("1", 1, msgs.size());
+		VASSERT("2", msgs[0] == fakeMessage(storage, 1));
+		VASSERT_EQ("3", 0, reg.getMessageNumber(fakeMessage(storage, 0)));
+
+		// Unregistering twice is harmless
+		reg.unregisterMessage(fakeMessage(storage, 0));
+
+		reg.unregisterMessage(fakeMessage(storage, 1));
+		reg.unregisterMessage(fakeMessage(storage, 2));
+
+		msgs.clear();
+		reg.getAllMessages(msgs);
+
+		VASSERT_EQ("4", 0, msgs.size());
+	}
+
+	void testRandomUpdates()
+	{
+		// Random EXPUNGE and FETCH responses, checked against a naive
+		// model which renumbers every message on each EXPUNGE (see
+		// IMAPMessageRegistryBenchmark for a larger number of messages)
+		const int messageCount = 200;
+		const int eventCount = 300;
+
+		std::vector <char> storage(messageCount);
+		std::vector <int> model(messageCount);
+
+		IMAPMessageRegistry reg;
+
+		for (int i = 0 ; i < messageCount ; ++i)
+		{
+			reg.registerMessage(fakeMessage(storage, i), i + 1);
+			model[i] = i + 1;
+		}
+
+		int liveCount = messageCount;
+		unsigned int seed = 42;
+
+		for (int e = 0 ; e < eventCount ; ++e)
+		{
+			seed = seed * 1103515245 + 12345;
+			const int number = static_cast <int>((seed >> 8) % liveCount) + 1;
+
+			std::ostringstream oss;
+			oss << "Event " << e << ", number " << number;
+
+			if (e % 2 == 0)  // EXPUNGE
+			{
+				std::vector <IMAPMessage*> expunged;
+				reg.expunge(number, expunged);
+
+				VASSERT_EQ(oss.str(), 1, expunged.size());
+
+				const int index = static_cast <int>(reinterpret_cast <char*>(expunged[0]) - &storage[0]);
+				VASSERT_EQ(oss.str(), number, model[index]);
+
+				for (int i = 0 ; i < messageCount ; ++i)
+				{
+					if (model[i] == number)
+						model[i] = 0;
+					else if (model[i] > number)
+						--model[i];
+				}
+
+				--liveCount;
+			}
+			else  // FETCH
+			{
+				std::vector <IMAPMessage*> msgs;
+				reg.getMessages(number, msgs);
+
+				VASSERT_EQ(oss.str(), 1, msgs.size());
+
+				const int index = static_cast <int>(reinterpret_cast <char*>(msgs[0]) - &storage[0]);
+				VASSERT_EQ(oss.str(), number, model[index]);
+			}
+		}
+
+		for (int i = 0 ; i < messageCount ; ++i)
+			VASSERT_EQ("Final numbers", model[i], reg.getMessageNumber(fakeMessage(storage, i)));
+	}
+
+VMIME_TEST_SUITE_END
@@ -0,0 +1,220 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "tests/net/imap/IMAPTestUtils.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(IMAPMessageTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testGetParsedMessage)
+		VMIME_TEST(testFetchMessagesPartHeaders)
+		VMIME_TEST(testStatusUpdates)
+	VMIME_TEST_LIST_END
+
+
+	static IMAPTestServerSocket::testMessage makeMultipartMessage(const vmime::string& subject)
+	{
+		IMAPTestServerSocket::testMessage msg;
+
+		msg.bodyStructure =
+			"((\"TEXT\" \"PLAIN\" (\"CHARSET\" \"us-ascii\") NIL NIL \"7BIT\" 10 1 NIL NIL NIL)"
+			"((\"TEXT\" \"PLAIN\" NIL NIL NIL \"7BIT\" 10 1 NIL NIL NIL)"
+			"(\"TEXT\" \"HTML\" NIL NIL NIL \"7BIT\" 20 1 NIL NIL NIL)"
+			" \"ALTERNATIVE\" (\"BOUNDARY\" \"b2\") NIL NIL)"
+			" \"MIXED\" (\"BOUNDARY\" \"b1\") NIL NIL)";
+
+		msg.header =
+			"Subject: " + subject + "\r\n"
+			"Content-Type: multipart/mixed; boundary=b1\r\n\r\n";
+
+		msg.sections["1.MIME"] = "Content-Type: text/plain; charset=us-ascii\r\n\r\n";
+		msg.sections["2.MIME"] = "Content-Type: multipart/alternative; boundary=b2\r\n\r\n";
+		msg.sections["2.1.MIME"] = "Content-Type: text/plain\r\n\r\n";
+		msg.sections["2.2.MIME"] = "Content-Type: text/html\r\n\r\n";
+
+		return msg;
+	}
+
+	static IMAPTestServerSocket::testMessage makeSinglePartMessage(const vmime::string& subject)
+	{
+		IMAPTestServerSocket::testMessage msg;
+
+		msg.bodyStructure = "(\"TEXT\" \"PLAIN\" NIL NIL NIL \"7BIT\" 10 1 NIL NIL NIL)";
+		msg.header = "Subject: " + subject + "\r\n\r\n";
+
+		return msg;
+	}
+
+	static const vmime::string getContentType(vmime::shared_ptr <const vmime::header> hdr)
+	{
+		return hdr->ContentType()->getValue()->generate();
+	}
+
+
+	void testGetParsedMessage()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+		socket->addMessage(makeMultipartMessage("Test"));
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openIMAPTestFolder(socket, store);
+
+		vmime::shared_ptr <vmime::net::message> msg = folder->getMessage(1);
+		folder->fetchMessage(msg, vmime::net::fetchAttributes::STRUCTURE);
+
+		const size_t fetchCount = socket->getCommandCount("FETCH");
+
+		vmime::shared_ptr <vmime::message> parsedMsg = msg->getParsedMessage();
+
+		// Headers of all parts are fetched with a single command
+		VASSERT_EQ("Commands", fetchCount + 1, socket->getCommandCount("FETCH"));
+		VASSERT_EQ("Command", "FETCH 1 (BODY.PEEK[HEADER] BODY.PEEK[1.MIME] "
+			"BODY.PEEK[2.MIME] BODY.PEEK[2.1.MIME] BODY.PEEK[2.2.MIME])", socket->getCommands().back());
+
+		VASSERT_EQ("Subject", "Test", parsedMsg->getHeader()->Subject()->getValue()->generate());
+		VASSERT_EQ("Part count", 2, parsedMsg->getBody()->getPartCount());
+
+		vmime::shared_ptr <vmime::bodyPart> part1 = parsedMsg->getBody()->getPartAt(0);
+		vmime::shared_ptr <vmime::bodyPart> part2 = parsedMsg->getBody()->getPartAt(1);
+
+		VASSERT_EQ("Part 1", "text/plain", getContentType(part1->getHeader()));
+		VASSERT_EQ("Part 2", "multipart/alternative", getContentType(part2->getHeader()));
+		VASSERT_EQ("Part 2 count", 2, part2->getBody()->getPartCount());
+		VASSERT_EQ("Part 2.1", "text/plain", getContentType(part2->getBody()->getPartAt(0)->getHeader()));
+		VASSERT_EQ("Part 2.2", "text/html", getContentType(part2->getBody()->getPartAt(1)->getHeader()));
+
+		store->disconnect();
+	}
+
+	void testFetchMessagesPartHeaders()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+		socket->addMessage(makeMultipartMessage("Message 1"));
+		socket->addMessage(makeSinglePartMessage("Message 2"));
+		socket->addMessage(makeMultipartMessage("Message 3"));
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openIMAPTestFolder(socket, store);
+
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 3));
+
+		const size_t fetchCount = socket->getCommandCount("FETCH");
+
+		folder->fetchMessages(msgs,
+			vmime::net::fetchAttributes::FULL_HEADER | vmime::net::fetchAttributes::STRUCTURE);
+
+		// Parts headers of messages with the same structure are fetched together,
+		// and there is nothing more to fetch for single-part messages
+		VASSERT_EQ("Commands", fetchCount + 2, socket->getCommandCount("FETCH"));
+		VASSERT_EQ("Command", "FETCH 1,3 (BODY.PEEK[1.MIME] BODY.PEEK[2.MIME] "
+			"BODY.PEEK[2.1.MIME] BODY.PEEK[2.2.MIME])", socket->getCommands().back());
+
+		for (int i = 0 ; i < 3 ; ++i)
+		{
+			vmime::shared_ptr <vmime::net::messagePart> root = msgs[i]->getStructure()->getPartAt(0);
+
+			std::ostringstream subject;
+			subject << "Message " << (i + 1);
+
+			VASSERT_EQ("Root header", subject.str(), root->getHeader()->Subject()->getValue()->generate());
+
+			if (i == 1)
+				continue;
+
+			vmime::shared_ptr <vmime::net::messagePart> part2 = root->getStructure()->getPartAt(1);
+
+			VASSERT_EQ("Part 1", "text/plain",
+				getContentType(root->getStructure()->getPartAt(0)->getHeader()));
+			VASSERT_EQ("Part 2", "multipart/alternative", getContentType(part2->getHeader()));
+			VASSERT_EQ("Part 2.2", "text/html", getContentType(part2->getStructure()->getPartAt(1)->getHeader()));
+		}
+
+		// Headers have already been fetched
+		msgs[2]->getParsedMessage();
+
+		VASSERT_EQ("Commands", fetchCount + 2, socket->getCommandCount("FETCH"));
+
+		store->disconnect();
+	}
+
+	void testStatusUpdates()
+	{
+		vmime::shared_ptr <IMAPTestServerSocket> socket = vmime::make_shared <IMAPTestServerSocket>();
+
+		for (int i = 0 ; i < 10 ; ++i)
+			socket->addMessage(makeSinglePartMessage("Message"));
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openIMAPTestFolder(socket, store);
+
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs;
+
+		for (int i = 1 ; i <= 10 ; ++i)
+			msgs.push_back(folder->getMessage(i));
+
+		// Two objects for the same message
+		vmime::shared_ptr <vmime::net::message> msg7 = folder->getMessage(7);
+
+		// Messages 3 and 4 are expunged, then flags of message 7 (now 5) change
+		socket->addUntaggedResponse("* 3 EXPUNGE");
+		socket->addUntaggedResponse("* 3 EXPUNGE");
+		socket->addUntaggedResponse("* 5 FETCH (FLAGS (\\Seen))");
+
+		vmime::dynamicCast <vmime::net::imap::IMAPFolder>(folder)->noop();
+
+		VASSERT_EQ("1", 1, msgs[0]->getNumber());
+		VASSERT_EQ("2", 2, msgs[1]->getNumber());
+		VASSERT_EQ("5", 3, msgs[4]->getNumber());
+		VASSERT_EQ("7", 5, msgs[6]->getNumber());
+		VASSERT_EQ("10", 8, msgs[9]->getNumber());
+
+		VASSERT("3 expunged", msgs[2]->isExpunged());
+		VASSERT("4 expunged", msgs[3]->isExpunged());
+		VASSERT_EQ("3 number", 3, msgs[2]->getNumber());
+		VASSERT_EQ("4 number", 3, msgs[3]->getNumber());
+		VASSERT("5 not expunged", !msgs[4]->isExpunged());
+
+		VASSERT_EQ("7 flags", vmime::net::message::FLAG_SEEN, msgs[6]->getFlags());
+		VASSERT_EQ("7 flags (other object)", vmime::net::message::FLAG_SEEN, msg7->getFlags());
+
+		// Messages obtained after the expunge use the new numbering
+		vmime::shared_ptr <vmime::net::message> msg8 = folder->getMessage(8);
+
+		socket->addUntaggedResponse("* 1 EXPUNGE");
+		vmime::dynamicCast <vmime::net::imap::IMAPFolder>(folder)->noop();
+
+		VASSERT_EQ("8 (new object)", 7, msg8->getNumber());
+		VASSERT_EQ("10 (after second expunge)", 7, msgs[9]->getNumber());
+		VASSERT_EQ("2 (after second expunge)", 1, msgs[1]->getNumber());
+
+		// Numbers are kept when the folder is closed
+		folder->close(false);
+
+		VASSERT_EQ("7 (closed)", 4, msgs[6]->getNumber());
+	}
+
+VMIME_TEST_SUITE_END
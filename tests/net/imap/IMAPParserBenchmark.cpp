@@ -0,0 +1,201 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+//
+// IMAP parser benchmark
+//
+// Measures the time needed to parse a multi-megabyte FETCH response
+// (UID, RFC822.SIZE, FLAGS, ENVELOPE and a header literal for each of
+// 4000 messages, as requested by a client to display a message list).
+// The response is read from "fixtures/fetchResponse.txt" and is received
+// in 64 KB chunks, as from a network socket.
+//
+// Usage: IMAPParserBenchmark [path/to/fetchResponse.txt]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <ctime>
+
+#include "vmime/vmime.hpp"
+#include "vmime/net/imap/IMAPTag.hpp"
+#include "vmime/net/imap/IMAPParser.hpp"
+
+
+// Socket which returns the fixture data in fixed-size chunks
+class fixtureSocket : public vmime::net::socket
+{
+public:
+
+	fixtureSocket(const vmime::string& data, const vmime::size_t chunkSize)
+		: m_data(data), m_chunkSize(chunkSize), m_pos(0)
+	{
+	}
+
+	void connect(const vmime::string& /* address */, const vmime::port_t /* port */) { }
+	void disconnect() { }
+	bool isConnected() const { return true; }
+
+	bool waitForRead(const int /* msecs */) { return true; }
+	bool waitForWrite(const int /* msecs */) { return true; }
+
+	void receive(vmime::string& buffer)
+	{
+		const vmime::size_t n = std::min(m_chunkSize, m_data.length() - m_pos);
+
+		buffer.assign(m_data, m_pos, n);
+		m_pos += n;
+	}
+
+	vmime::size_t receiveRaw(vmime::byte_t* buffer, const vmime::size_t count)
+	{
+		const vmime::size_t n = std::min(std::min(m_chunkSize, count), m_data.length() - m_pos);
+
+		std::copy(m_data.begin() + m_pos, m_data.begin() + m_pos + n, buffer);
+		m_pos += n;
+
+		return n;
+	}
+
+	void send(const vmime::string& /* buffer */) { }
+	void send(const char* /* str */) { }
+	void sendRaw(const vmime::byte_t* /* buffer */, const vmime::size_t /* count */) { }
+
+	vmime::size_t sendRawNonBlocking(const vmime::byte_t* /* buffer */, const vmime::size_t count)
+	{
+		return count;
+	}
+
+	vmime::size_t getBlockSize() const { return m_chunkSize; }
+	unsigned int getStatus() const { return 0; }
+
+	const vmime::string getPeerName() const { return "localhost"; }
+	const vmime::string getPeerAddress() const { return "127.0.0.1"; }
+
+	vmime::shared_ptr <vmime::net::timeoutHandler> getTimeoutHandler()
+	{
+		return vmime::null;
+	}
+
+	void setTracer(vmime::shared_ptr <vmime::net::tracer> /* tracer */) { }
+
+	vmime::shared_ptr <vmime::net::tracer> getTracer()
+	{
+		return vmime::null;
+	}
+
+private:
+
+	const vmime::string& m_data;
+	const vmime::size_t m_chunkSize;
+	vmime::size_t m_pos;
+};
+
+
+// Parse the response, and count the FETCH responses found
+static double run(const vmime::string& data, vmime::size_t& fetchCount, bool& ok)
+{
+	vmime::shared_ptr <fixtureSocket> socket = vmime::make_shared <fixtureSocket>(data, 65536);
+
+	vmime::shared_ptr <vmime::net::imap::IMAPTag> tag =
+		vmime::make_shared <vmime::net::imap::IMAPTag>();
+
+	vmime::shared_ptr <vmime::net::imap::IMAPParser> parser =
+		vmime::make_shared <vmime::net::imap::IMAPParser>();
+
+	parser->setTag(tag);
+	parser->setSocket(socket);
+
+	const std::clock_t start = std::clock();
+
+	std::auto_ptr <vmime::net::imap::IMAPParser::response> resp(parser->readResponse());
+
+	const double time = static_cast <double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+	fetchCount = 0;
+
+	for (vmime::size_t i = 0 ; i < resp->continue_req_or_response_data().size() ; ++i)
+	{
+		const vmime::net::imap::IMAPParser::response_data* respData =
+			resp->continue_req_or_response_data()[i]->response_data();
+
+		if (respData && respData->message_data())
+			++fetchCount;
+	}
+
+	if (resp->isBad())
+	{
+		std::cerr << "Bad response!" << std::endl;
+		ok = false;
+	}
+
+	return time;
+}
+
+
+int main(int argc, char* argv[])
+{
+	const std::string path = (argc > 1 ? argv[1] : VMIME_SOURCE_DIR "/tests/net/imap/fixtures/fetchResponse.txt");
+
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+
+	if (!file)
+	{
+		std::cerr << "Cannot open " << path << std::endl;
+		return 1;
+	}
+
+	std::ostringstream oss;
+	oss << file.rdbuf();
+
+	const vmime::string data = oss.str();
+	const double mb = static_cast <double>(data.length()) / (1024 * 1024);
+
+	static const unsigned int iterations = 10;
+
+	bool ok = true;
+	double total = 0;
+	vmime::size_t fetchCount = 0;
+
+	for (unsigned int i = 0 ; i < iterations ; ++i)
+		total += run(data, fetchCount, ok);
+
+	if (fetchCount != 4000)
+	{
+		std::cerr << "Expected 4000 FETCH responses, got " << fetchCount << "!" << std::endl;
+		ok = false;
+	}
+
+	const double time = total / iterations;
+
+	std::cout << std::fixed << std::setprecision(1)
+	          << mb << " MB, " << fetchCount << " FETCH responses: "
+	          << time * 1000 << " ms per parse, "
+	          << (time > 0 ? mb / time : 0) << " MB/s" << std::endl;
+
+	return ok ? 0 : 1;
+}
+
@@ -34,6 +34,10 @@ VMIME_TEST_SUITE_BEGIN(IMAPParserTest)
 		VMIME_TEST(testContinueReqWithoutSpace)
 		VMIME_TEST(testNILValueInBodyFldEnc)
 		VMIME_TEST(testFETCHResponse_optional_body_fld_lang)
+		VMIME_TEST(testResponseHandler)
+		VMIME_TEST(testResponseSplitAcrossReads)
+		VMIME_TEST(testComponentArena)
+		VMIME_TEST(testResponseOutlivesParser)
 	VMIME_TEST_LIST_END
 
 
@@ -166,4 +170,235 @@ VMIME_TEST_SUITE_BEGIN(IMAPParserTest)
 		VASSERT_NO_THROW("parse", parser->readResponse());
 	}
 
+	class fetchResponseHandler : public vmime::net::imap::IMAPParser::responseHandler
+	{
+	public:
+
+		bool handleResponseData(const vmime::net::imap::IMAPParser::response_data* data)
+		{
+			const vmime::net::imap::IMAPParser::message_data* msgData = data->message_data();
+
+			if (msgData == NULL || msgData->type() != vmime::net::imap::IMAPParser::message_data::FETCH)
+				return false;
+
+			numbers.push_back(static_cast <int>(msgData->number()));
+
+			return true;
+		}
+
+		std::vector <int> numbers;
+	};
+
+	void testResponseHandler()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+		vmime::shared_ptr <vmime::net::timeoutHandler> toh = vmime::make_shared <testTimeoutHandler>();
+
+		vmime::shared_ptr <vmime::net::imap::IMAPTag> tag =
+				vmime::make_shared <vmime::net::imap::IMAPTag>();
+
+		socket->localSend(
+			"* 1 FETCH (UID 10 FLAGS (\\Seen))\r\n"
+			"* 2 FETCH (UID 11 RFC822.HEADER {3}\r\nx\r\n)\r\n"
+			"* 42 EXISTS\r\n"
+			"* 3 FETCH (UID 12 FLAGS ())\r\n"
+			"a001 OK FETCH complete\r\n");
+
+		vmime::shared_ptr <vmime::net::imap::IMAPParser> parser =
+			vmime::make_shared <vmime::net::imap::IMAPParser>();
+
+		parser->setTag(tag);
+		parser->setSocket(socket);
+		parser->setTimeoutHandler(toh);
+
+		fetchResponseHandler handler;
+
+		std::auto_ptr <vmime::net::imap::IMAPParser::response> resp
+			(parser->readResponse(/* literalHandler */ NULL, &handler));
+
+		VASSERT_EQ("Handled", 3, handler.numbers.size());
+		VASSERT_EQ("Handled 1", 1, handler.numbers[0]);
+		VASSERT_EQ("Handled 2", 2, handler.numbers[1]);
+		VASSERT_EQ("Handled 3", 3, handler.numbers[2]);
+
+		// Only responses which have not been handled are kept
+		VASSERT_EQ("Kept", 1, resp->continue_req_or_response_data().size());
+		VASSERT_NOT_NULL("Kept EXISTS", resp->continue_req_or_response_data()[0]->response_data()->mailbox_data());
+		VASSERT_FALSE("Status", resp->isBad());
+	}
+
+	// Socket which returns received data in small chunks
+	class chunkedTestSocket : public testSocket
+	{
+	public:
+
+		chunkedTestSocket(const size_t chunkSize)
+			: m_chunkSize(chunkSize)
+		{
+		}
+
+		void receive(vmime::string& buffer)
+		{
+			testSocket::receive(buffer);
+
+			if (buffer.length() > m_chunkSize)
+			{
+				localSend(buffer.substr(m_chunkSize));
+				buffer.resize(m_chunkSize);
+			}
+		}
+
+	private:
+
+		const size_t m_chunkSize;
+	};
+
+	void testResponseSplitAcrossReads()
+	{
+		const vmime::string header = "Subject: test\r\nFrom: me@vmime.org\r\n\r\n";
+
+		std::ostringstream oss;
+
+		for (int i = 1 ; i <= 20 ; ++i)
+		{
+			oss << "* " << i << " FETCH (UID " << (100 + i) << " RFC822.HEADER {"
+			    << header.length() << "}\r\n" << header << " FLAGS (\\Seen))\r\n";
+		}
+
+		oss << "a001 OK FETCH complete\r\n";
+
+		for (size_t chunkSize = 1 ; chunkSize <= 50 ; chunkSize += 7)
+		{
+			vmime::shared_ptr <chunkedTestSocket> socket = vmime::make_shared <chunkedTestSocket>(chunkSize);
+			vmime::shared_ptr <vmime::net::timeoutHandler> toh = vmime::make_shared <testTimeoutHandler>();
+
+			vmime::shared_ptr <vmime::net::imap::IMAPTag> tag =
+					vmime::make_shared <vmime::net::imap::IMAPTag>();
+
+			socket->localSend(oss.str());
+
+			vmime::shared_ptr <vmime::net::imap::IMAPParser> parser =
+				vmime::make_shared <vmime::net::imap::IMAPParser>();
+
+			parser->setTag(tag);
+			parser->setSocket(socket);
+			parser->setTimeoutHandler(toh);
+
+			std::auto_ptr <vmime::net::imap::IMAPParser::response> resp(parser->readResponse());
+
+			VASSERT_FALSE("Status", resp->isBad());
+			VASSERT_EQ("Count", 20, resp->continue_req_or_response_data().size());
+
+			for (size_t i = 0 ; i < 20 ; ++i)
+			{
+				const vmime::net::imap::IMAPParser::message_data* msgData =
+					resp->continue_req_or_response_data()[i]->response_data()->message_data();
+
+				VASSERT_EQ("Number", i + 1, msgData->number());
+				VASSERT_EQ("Items", 3, msgData->msg_att()->items().size());
+				VASSERT_EQ("Header", header, msgData->msg_att()->items()[1]->nstring()->value());
+			}
+		}
+	}
+
+	void testComponentArena()
+	{
+		typedef vmime::net::imap::IMAPParser::componentArena componentArena;
+
+		componentArena arena;
+
+		// Blocks are aligned and do not overlap
+		std::vector <char*> blocks;
+
+		for (size_t size = 1 ; size < 3000 ; size += 97)
+		{
+			char* block = static_cast <char*>(arena.allocate(size));
+
+			VASSERT_EQ("Alignment", 0, reinterpret_cast <size_t>(block) % 16);
+
+			std::fill(block, block + size, static_cast <char>(size));
+			blocks.push_back(block);
+		}
+
+		for (size_t i = 0, size = 1 ; i < blocks.size() ; ++i, size += 97)
+		{
+			VASSERT_EQ("Contents", static_cast <char>(size), blocks[i][0]);
+			VASSERT_EQ("Contents", static_cast <char>(size), blocks[i][size - 1]);
+		}
+
+		// Space of the last allocated block is given back
+		void* last = arena.allocate(64);
+		componentArena::deallocate(last);
+
+		VASSERT_EQ("Reuse", last, arena.allocate(64));
+
+		// Blocks larger than a chunk
+		char* large = static_cast <char*>(arena.allocate(100000));
+		std::fill(large, large + 100000, 'x');
+
+		componentArena::deallocate(large);
+
+		for (size_t i = 0 ; i < blocks.size() ; ++i)
+			componentArena::deallocate(blocks[i]);
+
+		componentArena::deallocate(last);
+
+		// Heap blocks
+		void* heap = componentArena::allocateOnHeap(32);
+		componentArena::deallocate(heap);
+	}
+
+	void testResponseOutlivesParser()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+		vmime::shared_ptr <vmime::net::timeoutHandler> toh = vmime::make_shared <testTimeoutHandler>();
+
+		vmime::shared_ptr <vmime::net::imap::IMAPTag> tag =
+			vmime::make_shared <vmime::net::imap::IMAPTag>();
+
+		std::ostringstream oss;
+
+		for (int i = 1 ; i <= 100 ; ++i)
+		{
+			oss << "* " << i << " FETCH (UID " << (100 + i) << " BODYSTRUCTURE ("
+			    << "(\"TEXT\" \"PLAIN\" (\"CHARSET\" \"utf-8\") NIL NIL \"7BIT\" 12 1 NIL NIL NIL)"
+			    << "(\"IMAGE\" \"PNG\" (\"NAME\" \"a.png\") NIL NIL \"BASE64\" 3456 NIL"
+			    << " (\"ATTACHMENT\" (\"FILENAME\" \"a.png\")) NIL)"
+			    << " \"MIXED\" (\"BOUNDARY\" \"xxx\") NIL NIL))\r\n";
+		}
+
+		oss << "a001 OK FETCH complete\r\n";
+
+		socket->localSend(oss.str());
+
+		std::auto_ptr <vmime::net::imap::IMAPParser::response> resp;
+
+		{
+			vmime::shared_ptr <vmime::net::imap::IMAPParser> parser =
+				vmime::make_shared <vmime::net::imap::IMAPParser>();
+
+			parser->setTag(tag);
+			parser->setSocket(socket);
+			parser->setTimeoutHandler(toh);
+
+			resp.reset(parser->readResponse());
+		}
+
+		// Components are still valid once the parser has been destroyed
+		VASSERT_FALSE("Status", resp->isBad());
+		VASSERT_EQ("Count", 100, resp->continue_req_or_response_data().size());
+
+		const vmime::net::imap::IMAPParser::message_data* msgData =
+			resp->continue_req_or_response_data()[99]->response_data()->message_data();
+
+		VASSERT_EQ("Number", 100, msgData->number());
+
+		const vmime::net::imap::IMAPParser::body_type_mpart* mpart =
+			msgData->msg_att()->items()[1]->body()->body_type_mpart();
+
+		VASSERT_NOT_NULL("Multipart", mpart);
+		VASSERT_EQ("Parts", 2, mpart->list().size());
+		VASSERT_EQ("Subtype", "MIXED", mpart->media_subtype()->value());
+	}
+
 VMIME_TEST_SUITE_END
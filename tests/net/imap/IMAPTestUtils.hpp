@@ -0,0 +1,386 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "vmime/net/imap/IMAPStore.hpp"
+#include "vmime/net/imap/IMAPFolder.hpp"
+#include "vmime/net/imap/IMAPMessage.hpp"
+
+
+/** Test IMAP server, which serves messages from a single mailbox.
+  * Commands sent by the client are recorded, without tags.
+  */
+class IMAPTestServerSocket : public commandRecordingTestSocket
+{
+public:
+
+	IMAPTestServerSocket()
+		: m_pipelinedCommandCount(0), m_literalRemaining(0)
+	{
+	}
+
+	struct testMessage
+	{
+		vmime::string bodyStructure;
+		vmime::string header;
+		std::map <vmime::string, vmime::string> sections;   // eg. "1.MIME" --> data
+	};
+
+
+	void addMessage(const testMessage& msg)
+	{
+		m_messages.push_back(msg);
+	}
+
+	/** Add a mailbox whose status can be requested with STATUS.
+	  */
+	void addMailbox(const vmime::string& name, const size_t messageCount)
+	{
+		m_mailboxes[name] = messageCount;
+	}
+
+	/** Add an untagged response which will be sent before the
+	  * completion result of the next command (eg. "* 3 EXPUNGE").
+	  */
+	void addUntaggedResponse(const vmime::string& resp)
+	{
+		m_untaggedResponses += resp + "\r\n";
+	}
+
+	/** Make sending the specified command fail, as if the connection
+	  * had been lost (eg. "NOOP").
+	  */
+	void setSendError(const vmime::string& cmd)
+	{
+		m_sendErrorCommand = cmd;
+	}
+
+	/** Return the number of commands which have been received while
+	  * the client had not read the responses to the previous commands.
+	  */
+	size_t getPipelinedCommandCount() const
+	{
+		return m_pipelinedCommandCount;
+	}
+
+	/** Return the messages received with APPEND.
+	  */
+	const std::vector <vmime::string>& getAppendedMessages() const
+	{
+		return m_appendedMessages;
+	}
+
+	void onConnected()
+	{
+		sendResponse("* PREAUTH [CAPABILITY IMAP4rev1] test.vmime.org ready\r\n");
+	}
+
+	void processCommand()
+	{
+		while (haveMoreLines())
+		{
+			const vmime::string line = getNextLine();
+
+			// Literal data for APPEND, followed by the CRLF ending the command
+			if (m_literalRemaining != 0)
+			{
+				m_literal += line + "\r\n";
+				m_literalRemaining -= std::min(m_literalRemaining, line.length() + 2);
+
+				if (m_literalRemaining == 0)
+				{
+					m_appendedMessages.push_back(m_literal.substr(0, m_literal.length() - 2));
+					sendResponse(m_literalTag + " OK APPEND completed\r\n");
+				}
+
+				continue;
+			}
+
+			const vmime::size_t sp = line.find(' ');
+			const vmime::string tag = line.substr(0, sp);
+			const vmime::string cmdLine = (sp == vmime::string::npos) ? "" : line.substr(sp + 1);
+
+			recordCommand(cmdLine);
+
+			if (getReadBytes() < getSentBytes())
+				++m_pipelinedCommandCount;
+
+			std::istringstream iss(cmdLine);
+			vmime::string cmd;
+			iss >> cmd;
+
+			if (cmd == m_sendErrorCommand)
+				throw vmime::exceptions::socket_exception("Connection lost");
+
+			vmime::string result = "OK";
+
+			if (cmd == "CAPABILITY")
+			{
+				sendResponse("* CAPABILITY IMAP4rev1\r\n");
+			}
+			else if (cmd == "LIST")
+			{
+				sendResponse("* LIST () \"/\" \"\"\r\n");
+			}
+			else if (cmd == "SELECT" || cmd == "EXAMINE")
+			{
+				std::ostringstream oss;
+				oss << "* " << m_messages.size() << " EXISTS\r\n"
+				    << "* FLAGS (\\Seen \\Deleted)\r\n";
+
+				sendResponse(oss.str());
+			}
+			else if (cmd == "FETCH" || cmd == "UID")
+			{
+				const bool uid = (cmd == "UID");
+
+				if (uid)
+					iss >> cmd;
+
+				vmime::string set;
+				iss >> set;
+
+				vmime::string items;
+				std::getline(iss, items);
+
+				processFETCH(set, items, uid);
+			}
+			else if (cmd == "STATUS")
+			{
+				vmime::string mailbox;
+				iss >> mailbox;
+
+				// INBOX is case-insensitive
+				if (vmime::utility::stringUtils::isStringEqualNoCase(unquote(mailbox), "INBOX"))
+					mailbox = "INBOX";
+
+				std::map <vmime::string, size_t>::const_iterator it =
+					m_mailboxes.find(unquote(mailbox));
+
+				if (it != m_mailboxes.end())
+				{
+					std::ostringstream oss;
+					oss << "* STATUS " << mailbox << " (MESSAGES " << (*it).second
+					    << " UNSEEN 0 UIDNEXT " << ((*it).second + 1) << " UIDVALIDITY 42)\r\n";
+
+					sendResponse(oss.str());
+				}
+				else
+				{
+					result = "NO";
+				}
+			}
+			else if (cmd == "APPEND")
+			{
+				const vmime::size_t brace = cmdLine.rfind('{');
+
+				m_literal.clear();
+				m_literalTag = tag;
+				m_literalRemaining = atoi(cmdLine.c_str() + brace + 1) + 2;
+
+				sendResponse("+ Ready for literal data\r\n");
+				continue;
+			}
+			else if (cmd == "LOGOUT")
+			{
+				sendResponse("* BYE\r\n");
+			}
+
+			if (!m_untaggedResponses.empty())
+			{
+				sendResponse(m_untaggedResponses);
+				m_untaggedResponses.clear();
+			}
+
+			sendResponse(tag + " " + result + " " + cmd + " completed\r\n");
+		}
+	}
+
+private:
+
+	static const vmime::string unquote(const vmime::string& str)
+	{
+		if (str.length() >= 2 && str[0] == '"' && str[str.length() - 1] == '"')
+			return str.substr(1, str.length() - 2);
+
+		return str;
+	}
+
+	void processFETCH(const vmime::string& set, const vmime::string& itemList, const bool uid)
+	{
+		// Split items, taking care of spaces inside brackets
+		vmime::string items = itemList;
+
+		while (!items.empty() && items[0] == ' ')
+			items.erase(0, 1);
+
+		if (!items.empty() && items[0] == '(')
+			items = items.substr(1, items.length() - 2);
+
+		std::vector <vmime::string> itemVect;
+		vmime::string current;
+		int depth = 0;
+
+		for (size_t i = 0 ; i < items.length() ; ++i)
+		{
+			if (items[i] == '[') ++depth;
+			else if (items[i] == ']') --depth;
+
+			if (items[i] == ' ' && depth == 0)
+			{
+				itemVect.push_back(current);
+				current.clear();
+			}
+			else
+			{
+				current += items[i];
+			}
+		}
+
+		if (!current.empty())
+			itemVect.push_back(current);
+
+		// Message numbers (UIDs are number + 100)
+		std::istringstream setStream(set);
+		vmime::string range;
+
+		while (std::getline(setStream, range, ','))
+		{
+			const vmime::size_t colon = range.find(':');
+
+			const size_t first = atoi(range.c_str()) - (uid ? 100 : 0);
+			const size_t last = (colon == vmime::string::npos)
+				? first : atoi(range.c_str() + colon + 1) - (uid ? 100 : 0);
+
+			for (size_t n = first ; n <= last ; ++n)
+			{
+				if (n >= 1 && n <= m_messages.size())
+					sendFETCHResponse(n, itemVect, uid);
+			}
+		}
+	}
+
+	void sendFETCHResponse(const size_t n, const std::vector <vmime::string>& itemVect, const bool uid)
+	{
+		const testMessage& msg = m_messages[n - 1];
+
+		std::ostringstream oss;
+		oss << "* " << n << " FETCH (";
+
+		for (size_t i = 0 ; i < itemVect.size() ; ++i)
+		{
+			const vmime::string& item = itemVect[i];
+
+			if (i != 0)
+				oss << " ";
+
+			if (item == "BODYSTRUCTURE")
+			{
+				oss << "BODYSTRUCTURE " << msg.bodyStructure;
+			}
+			else if (item == "RFC822.HEADER")
+			{
+				oss << "RFC822.HEADER {" << msg.header.length() << "}\r\n" << msg.header;
+			}
+			else if (item == "FLAGS")
+			{
+				oss << "FLAGS ()";
+			}
+			else if (item == "UID")
+			{
+				oss << "UID " << (n + 100);
+			}
+			else if (item == "RFC822.SIZE")
+			{
+				oss << "RFC822.SIZE 1000";
+			}
+			else if (item.compare(0, 10, "BODY.PEEK[") == 0)
+			{
+				const vmime::string section = item.substr(10, item.length() - 11);
+				vmime::string data;
+
+				if (section == "HEADER")
+					data = msg.header;
+				else if (msg.sections.find(section) != msg.sections.end())
+					data = (*msg.sections.find(section)).second;
+
+				oss << "BODY[" << section << "] {" << data.length() << "}\r\n" << data;
+			}
+		}
+
+		if (uid && std::find(itemVect.begin(), itemVect.end(), "UID") == itemVect.end())
+			oss << " UID " << (n + 100);
+
+		oss << ")\r\n";
+
+		sendResponse(oss.str());
+	}
+
+
+	std::vector <testMessage> m_messages;
+	std::map <vmime::string, size_t> m_mailboxes;
+	vmime::string m_untaggedResponses;
+	vmime::string m_sendErrorCommand;
+
+	size_t m_pipelinedCommandCount;
+
+	std::vector <vmime::string> m_appendedMessages;
+	vmime::string m_literal;
+	vmime::string m_literalTag;
+	size_t m_literalRemaining;
+};
+
+
+/** Connect to the test server.
+  */
+inline vmime::shared_ptr <vmime::net::store> connectIMAPTestStore
+	(vmime::shared_ptr <IMAPTestServerSocket> socket)
+{
+	vmime::shared_ptr <vmime::net::session> session = vmime::make_shared <vmime::net::session>();
+
+	vmime::shared_ptr <vmime::net::store> store =
+		session->getStore(vmime::utility::url("imap://localhost"));
+
+	store->setSocketFactory(vmime::make_shared <sharedTestSocketFactory <IMAPTestServerSocket> >(socket));
+	store->setTimeoutHandlerFactory(vmime::make_shared <testTimeoutHandlerFactory>());
+
+	store->connect();
+
+	return store;
+}
+
+
+/** Connect to the test server and open INBOX. As the folder uses its
+  * own connection, the store connection must not be used afterwards.
+  */
+inline vmime::shared_ptr <vmime::net::folder> openIMAPTestFolder
+	(vmime::shared_ptr <IMAPTestServerSocket> socket, vmime::shared_ptr <vmime::net::store>& store)
+{
+	store = connectIMAPTestStore(socket);
+
+	vmime::shared_ptr <vmime::net::folder> folder = store->getFolder
+		(vmime::net::folder::path(vmime::net::folder::path::component("INBOX")));
+
+	folder->open(vmime::net::folder::MODE_READ_WRITE);
+
+	return folder;
+}
@@ -153,6 +153,9 @@ VMIME_TEST_SUITE_BEGIN(maildirStoreTest)
 		VMIME_TEST(testListMessages_KMail)
 		VMIME_TEST(testListMessages_Courier)
 
+		VMIME_TEST(testRescanFolder_KMail)
+		VMIME_TEST(testRescanFolder_Courier)
+
 		VMIME_TEST(testRenameFolder_KMail)
 		VMIME_TEST(testRenameFolder_Courier)
 
@@ -316,6 +319,85 @@ public:
 	}
 
 
+	void testRescanFolder_KMail()
+	{
+		testRescanFolderImpl(TEST_MAILDIR_KMAIL, TEST_MAILDIRFILES_KMAIL,
+			"/.Folder.directory/.SubFolder.directory/SubSubFolder2");
+	}
+
+	void testRescanFolder_Courier()
+	{
+		testRescanFolderImpl(TEST_MAILDIR_COURIER, TEST_MAILDIRFILES_COURIER,
+			"/.Folder.SubFolder.SubSubFolder2");
+	}
+
+	void testRescanFolderImpl(const vmime::string* const dirs, const vmime::string* const files,
+		const vmime::string& folderDir)
+	{
+		createMaildir(dirs, files);
+
+		vmime::shared_ptr <vmime::net::store> store = createAndConnectStore();
+
+		vmime::shared_ptr <vmime::net::folder> folder = store->getFolder
+			(fpath() / "Folder" / "SubFolder" / "SubSubFolder2");
+
+		folder->open(vmime::net::folder::MODE_READ_WRITE);
+
+		int count, unseen;
+		folder->status(count, unseen);
+
+		VASSERT_EQ("Message count 1", 1, count);
+		VASSERT_EQ("Unseen count 1", 0, unseen);
+
+		// No change
+		folder->status(count, unseen);
+
+		VASSERT_EQ("Message count 2", 1, count);
+
+		// Deliver new messages, from outside of the store
+		const vmime::string newMessages[] =
+		{
+			folderDir + "/new/1043236114.352.EmqD", TEST_MESSAGE_1,
+			folderDir + "/cur/1043236115.353.EmqD:2,", TEST_MESSAGE_1,
+			"*"  // end
+		};
+
+		createMaildirFiles(newMessages);
+
+		folder->status(count, unseen);
+
+		VASSERT_EQ("Message count 3", 3, count);
+		VASSERT_EQ("Unseen count 3", 2, unseen);
+
+		// Change flags and delete a message, from outside of the store
+		vmime::shared_ptr <vmime::utility::fileSystemFactory> fsf =
+			vmime::platform::getHandler()->getFileSystemFactory();
+
+		vmime::shared_ptr <vmime::utility::file> file = fsf->create
+			(m_tempPath / fsf->stringToPath(folderDir + "/cur/1043236115.353.EmqD:2,"));
+
+		file->rename(m_tempPath / fsf->stringToPath(folderDir + "/cur/1043236115.353.EmqD:2,S"));
+
+		file = fsf->create(m_tempPath / fsf->stringToPath(folderDir + "/cur/1043236113.351.EmqD:S"));
+		file->remove();
+
+		folder->status(count, unseen);
+
+		VASSERT_EQ("Message count 4", 3, count);
+		VASSERT_EQ("Unseen count 4", 1, unseen);
+
+		folder->close(true);
+
+		folder->open(vmime::net::folder::MODE_READ_ONLY);
+
+		VASSERT_EQ("Message count 5", 2, folder->getMessageCount());
+
+		folder->close(false);
+
+		destroyMaildir();
+	}
+
+
 	void testRenameFolder_KMail()
 	{
 		try
@@ -522,6 +604,14 @@ private:
 			fdir->createDirectory(false);
 		}
 
+		createMaildirFiles(files);
+	}
+
+	void createMaildirFiles(const vmime::string* const files)
+	{
+		vmime::shared_ptr <vmime::utility::fileSystemFactory> fsf =
+			vmime::platform::getHandler()->getFileSystemFactory();
+
 		for (vmime::string const* file = files ; *file != "*" ; file += 2)
 		{
 			const vmime::string& contents = *(file + 1);
@@ -537,7 +627,6 @@ private:
 
 			fileWriter = vmime::null;
 		}
-
 	}
 
 	void destroyMaildir()
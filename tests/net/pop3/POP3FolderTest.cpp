@@ -0,0 +1,187 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "tests/net/pop3/POP3TestUtils.hpp"
+
+#include "vmime/net/pop3/POP3Folder.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(POP3FolderTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testFetchMessagesPipelined)
+		VMIME_TEST(testFetchMessagesNoPipelining)
+		VMIME_TEST(testFetchMessagesWindow)
+		VMIME_TEST(testDeleteMessagesPipelined)
+		VMIME_TEST(testDeleteMessagesError)
+	VMIME_TEST_LIST_END
+
+
+	static vmime::shared_ptr <POP3TestServerSocket> createTestServer
+		(const size_t messageCount, const bool pipelining = true)
+	{
+		vmime::shared_ptr <POP3TestServerSocket> socket =
+			vmime::make_shared <POP3TestServerSocket>(pipelining);
+
+		for (size_t i = 1 ; i <= messageCount ; ++i)
+		{
+			std::ostringstream oss;
+			oss << "Subject: Message " << i << "\r\n"
+			    << "From: me@vmime.org\r\n"
+			    << "\r\n"
+			    << "Body of message " << i << "\r\n"
+			    << ".\r\n"
+			    << "..\r\n";
+
+			socket->addMessage(oss.str());
+		}
+
+		return socket;
+	}
+
+	static void checkSubjects(const std::vector <vmime::shared_ptr <vmime::net::message> >& msgs)
+	{
+		for (size_t i = 0 ; i < msgs.size() ; ++i)
+		{
+			std::ostringstream oss;
+			oss << "Message " << (i + 1);
+
+			VASSERT_EQ("Subject", oss.str(),
+				msgs[i]->getHeader()->Subject()->getValue()->generate());
+		}
+	}
+
+
+	void testFetchMessagesPipelined()
+	{
+		vmime::shared_ptr <POP3TestServerSocket> socket = createTestServer(5);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openPOP3TestFolder(socket, store);
+
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 5));
+
+		folder->fetchMessages(msgs, vmime::net::fetchAttributes::FULL_HEADER);
+
+		VASSERT_EQ("Commands", 5, socket->getCommandCount("TOP"));
+		VASSERT_EQ("Pipelined", 4, socket->getMaxPendingResponseCount());
+
+		checkSubjects(msgs);
+
+		// Connection is still in sync
+		vmime::string data;
+		vmime::utility::outputStreamStringAdapter os(data);
+
+		msgs[2]->extract(os);
+
+		VASSERT_EQ("Data", "Subject: Message 3\r\nFrom: me@vmime.org\r\n\r\n"
+			"Body of message 3\r\n.\r\n..", data);
+	}
+
+	void testFetchMessagesNoPipelining()
+	{
+		vmime::shared_ptr <POP3TestServerSocket> socket = createTestServer(5, /* pipelining */ false);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openPOP3TestFolder(socket, store);
+
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 5));
+
+		folder->fetchMessages(msgs, vmime::net::fetchAttributes::FULL_HEADER);
+
+		VASSERT_EQ("Commands", 5, socket->getCommandCount("TOP"));
+		VASSERT_EQ("Pipelined", 0, socket->getMaxPendingResponseCount());
+
+		checkSubjects(msgs);
+	}
+
+	void testFetchMessagesWindow()
+	{
+		vmime::shared_ptr <POP3TestServerSocket> socket = createTestServer(5);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openPOP3TestFolder(socket, store);
+
+		store->setProperty("options.pipelining.window", 2);
+
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 5));
+
+		folder->fetchMessages(msgs, vmime::net::fetchAttributes::FULL_HEADER);
+
+		VASSERT_EQ("Commands", 5, socket->getCommandCount("TOP"));
+		VASSERT_EQ("Pipelined", 1, socket->getMaxPendingResponseCount());
+
+		checkSubjects(msgs);
+	}
+
+	void testDeleteMessagesPipelined()
+	{
+		vmime::shared_ptr <POP3TestServerSocket> socket = createTestServer(5);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openPOP3TestFolder(socket, store);
+
+		folder->deleteMessages(vmime::net::messageSet::byNumber(2, 4));
+
+		VASSERT_EQ("Commands", 3, socket->getCommandCount("DELE"));
+		VASSERT_EQ("Pipelined", 2, socket->getMaxPendingResponseCount());
+
+		VASSERT_FALSE("Deleted 1", socket->isDeleted(1));
+		VASSERT_TRUE("Deleted 2", socket->isDeleted(2));
+		VASSERT_TRUE("Deleted 3", socket->isDeleted(3));
+		VASSERT_TRUE("Deleted 4", socket->isDeleted(4));
+		VASSERT_FALSE("Deleted 5", socket->isDeleted(5));
+	}
+
+	void testDeleteMessagesError()
+	{
+		vmime::shared_ptr <POP3TestServerSocket> socket = createTestServer(5);
+
+		vmime::shared_ptr <vmime::net::store> store;
+		vmime::shared_ptr <vmime::net::folder> folder = openPOP3TestFolder(socket, store);
+
+		// Messages 6 and 7 do not exist
+		VASSERT_THROW("Error",
+			folder->deleteMessages(vmime::net::messageSet::byNumber(4, 7)),
+			vmime::exceptions::command_error);
+
+		// Commands already sent have been processed anyway
+		VASSERT_EQ("Commands", 4, socket->getCommandCount("DELE"));
+		VASSERT_TRUE("Deleted 4", socket->isDeleted(4));
+		VASSERT_TRUE("Deleted 5", socket->isDeleted(5));
+
+		// Connection is still in sync
+		std::vector <vmime::shared_ptr <vmime::net::message> > msgs =
+			folder->getMessages(vmime::net::messageSet::byNumber(1, 3));
+
+		folder->fetchMessages(msgs, vmime::net::fetchAttributes::FULL_HEADER);
+
+		checkSubjects(msgs);
+	}
+
+VMIME_TEST_SUITE_END
@@ -42,6 +42,8 @@ VMIME_TEST_SUITE_BEGIN(POP3ResponseTest)
 		VMIME_TEST(testMultiLineResponse)
 		VMIME_TEST(testMultiLineResponseLF)
 		VMIME_TEST(testLargeResponse)
+		VMIME_TEST(testPipelinedResponses)
+		VMIME_TEST(testPipelinedLargeResponses)
 	VMIME_TEST_LIST_END
 
 
@@ -226,5 +228,71 @@ VMIME_TEST_SUITE_BEGIN(POP3ResponseTest)
 		VASSERT_EQ("Data Bytes", data.str(), receivedData);
 	}
 
+	void testPipelinedResponses()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+		vmime::shared_ptr <vmime::net::timeoutHandler> toh = vmime::make_shared <testTimeoutHandler>();
+
+		vmime::shared_ptr <POP3ConnectionTest> conn = vmime::make_shared <POP3ConnectionTest>
+			(vmime::dynamicCast <vmime::net::socket>(socket), toh);
+
+		// All responses are received at once
+		socket->localSend(
+			"+OK Response 1\r\n"
+			"+OK Response 2\r\nLine 1\r\n..Line 2\r\n.\r\n"
+			"-ERR Response 3\r\n"
+			"+OK Response 4\r\n");
+
+		vmime::shared_ptr <POP3Response> resp1 = POP3Response::readResponse(conn);
+		vmime::shared_ptr <POP3Response> resp2 = POP3Response::readMultilineResponse(conn);
+		vmime::shared_ptr <POP3Response> resp3 = POP3Response::readMultilineResponse(conn);
+		vmime::shared_ptr <POP3Response> resp4 = POP3Response::readResponse(conn);
+
+		VASSERT_EQ("Text 1", "Response 1", resp1->getText());
+
+		VASSERT_EQ("Text 2", "Response 2", resp2->getText());
+		VASSERT_EQ("Lines 2", 2, resp2->getLineCount());
+		VASSERT_EQ("Line 2.1", "Line 1", resp2->getLineAt(0));
+		VASSERT_EQ("Line 2.2", ".Line 2", resp2->getLineAt(1));
+
+		VASSERT_EQ("Code 3", POP3Response::CODE_ERR, resp3->getCode());
+		VASSERT_EQ("Text 3", "Response 3", resp3->getText());
+		VASSERT_EQ("Lines 3", 0, resp3->getLineCount());
+
+		VASSERT_EQ("Text 4", "Response 4", resp4->getText());
+	}
+
+	void testPipelinedLargeResponses()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+		vmime::shared_ptr <vmime::net::timeoutHandler> toh = vmime::make_shared <testTimeoutHandler>();
+
+		vmime::shared_ptr <POP3ConnectionTest> conn = vmime::make_shared <POP3ConnectionTest>
+			(vmime::dynamicCast <vmime::net::socket>(socket), toh);
+
+		socket->localSend(
+			"+OK Large 1\r\nData 1\r\n...\r\n.\r\n"
+			"-ERR Large 2\r\n"
+			"+OK Large 3\nData 3\n.\n"
+			"+OK Response 4\r\n");
+
+		vmime::string data1, data2, data3;
+		vmime::utility::outputStreamStringAdapter os1(data1), os2(data2), os3(data3);
+
+		POP3Response::readLargeResponse(conn, os1, NULL, 0);
+
+		VASSERT_THROW("Error", POP3Response::readLargeResponse(conn, os2, NULL, 0),
+			vmime::exceptions::command_error);
+
+		POP3Response::readLargeResponse(conn, os3, NULL, 0);
+
+		vmime::shared_ptr <POP3Response> resp4 = POP3Response::readResponse(conn);
+
+		VASSERT_EQ("Data 1", "Data 1\r\n..", data1);
+		VASSERT_EQ("Data 2", "", data2);
+		VASSERT_EQ("Data 3", "Data 3", data3);
+		VASSERT_EQ("Text 4", "Response 4", resp4->getText());
+	}
+
 VMIME_TEST_SUITE_END
 
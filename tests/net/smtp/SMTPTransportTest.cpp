@@ -36,6 +36,10 @@ VMIME_TEST_SUITE_BEGIN(SMTPTransportTest)
 		VMIME_TEST(testConnectToInvalidServer)
 		VMIME_TEST(testGreetingError)
 		VMIME_TEST(testMAILandRCPT)
+		VMIME_TEST(testDATASendCount)
+		VMIME_TEST(testDATAMessage)
+		VMIME_TEST(testDATAGenerationError)
+		VMIME_TEST(testDATAGenerationErrorDisconnected)
 		VMIME_TEST(testChunking)
 		VMIME_TEST(testSize_Chunking)
 		VMIME_TEST(testSize_NoChunking)
@@ -94,6 +98,139 @@ VMIME_TEST_SUITE_BEGIN(SMTPTransportTest)
 		tr->send(exp, recips, is, 0);
 	}
 
+	void testDATASendCount()
+	{
+		vmime::shared_ptr <vmime::net::session> session =
+			vmime::make_shared <vmime::net::session>();
+
+		vmime::shared_ptr <vmime::net::transport> tr = session->getTransport
+			(vmime::utility::url("smtp://localhost"));
+
+		tr->setSocketFactory(vmime::make_shared <testSocketFactory <MAILandRCPTSMTPTestSocket> >());
+		tr->setTimeoutHandlerFactory(vmime::make_shared <testTimeoutHandlerFactory>());
+
+		tr->connect();
+
+		vmime::shared_ptr <testSocket> socket = vmime::dynamicCast <testSocket>
+			(vmime::dynamicCast <vmime::net::smtp::SMTPTransport>(tr)->getConnection()->getSocket());
+
+		vmime::mailbox exp("expeditor@test.vmime.org");
+
+		vmime::mailboxList recips;
+		recips.appendMailbox(vmime::make_shared <vmime::mailbox>("recipient1@test.vmime.org"));
+		recips.appendMailbox(vmime::make_shared <vmime::mailbox>("recipient2@test.vmime.org"));
+		recips.appendMailbox(vmime::make_shared <vmime::mailbox>("recipient3@test.vmime.org"));
+
+		vmime::string data("Message data");
+		vmime::utility::inputStreamStringAdapter is(data);
+
+		const unsigned int sendCount = socket->getSendCount();
+
+		tr->send(exp, recips, is, 0);
+
+		// MAIL, 3 x RCPT, DATA, then message data and end-of-data
+		// delimiter at once
+		VASSERT_EQ("Send count", 6, socket->getSendCount() - sendCount);
+	}
+
+	void testDATAMessage()
+	{
+		vmime::shared_ptr <vmime::net::session> session =
+			vmime::make_shared <vmime::net::session>();
+
+		vmime::shared_ptr <vmime::net::transport> tr = session->getTransport
+			(vmime::utility::url("smtp://localhost"));
+
+		tr->setSocketFactory(vmime::make_shared <testSocketFactory <MAILandRCPTSMTPTestSocket> >());
+		tr->setTimeoutHandlerFactory(vmime::make_shared <testTimeoutHandlerFactory>());
+
+		tr->connect();
+
+		vmime::shared_ptr <testSocket> socket = vmime::dynamicCast <testSocket>
+			(vmime::dynamicCast <vmime::net::smtp::SMTPTransport>(tr)->getConnection()->getSocket());
+
+		vmime::mailbox exp("expeditor@test.vmime.org");
+
+		vmime::mailboxList recips;
+		recips.appendMailbox(vmime::make_shared <vmime::mailbox>("recipient1@test.vmime.org"));
+		recips.appendMailbox(vmime::make_shared <vmime::mailbox>("recipient2@test.vmime.org"));
+		recips.appendMailbox(vmime::make_shared <vmime::mailbox>("recipient3@test.vmime.org"));
+
+		vmime::shared_ptr <vmime::message> msg = vmime::make_shared <SMTPDataTestMessage>();
+
+		const unsigned int sendCount = socket->getSendCount();
+
+		tr->send(msg, exp, recips);
+
+		// Message is generated directly to the socket: MAIL, 3 x RCPT,
+		// DATA, then message data and end-of-data delimiter at once
+		VASSERT_EQ("Send count", 6, socket->getSendCount() - sendCount);
+	}
+
+	void testDATAGenerationError()
+	{
+		vmime::shared_ptr <vmime::net::session> session =
+			vmime::make_shared <vmime::net::session>();
+
+		vmime::shared_ptr <vmime::net::transport> tr = session->getTransport
+			(vmime::utility::url("smtp://localhost"));
+
+		tr->setSocketFactory(vmime::make_shared <testSocketFactory <DATAErrorSMTPTestSocket> >());
+		tr->setTimeoutHandlerFactory(vmime::make_shared <testTimeoutHandlerFactory>());
+
+		tr->connect();
+
+		vmime::shared_ptr <DATAErrorSMTPTestSocket> socket = vmime::dynamicCast <DATAErrorSMTPTestSocket>
+			(vmime::dynamicCast <vmime::net::smtp::SMTPTransport>(tr)->getConnection()->getSocket());
+
+		vmime::mailbox exp("expeditor@test.vmime.org");
+
+		vmime::mailboxList recips;
+		recips.appendMailbox(vmime::make_shared <vmime::mailbox>("recipient@test.vmime.org"));
+
+		vmime::shared_ptr <vmime::message> msg = vmime::make_shared <SMTPGenerationErrorTestMessage>();
+
+		VASSERT_THROW("Send", tr->send(msg, exp, recips), SMTPGenerationTestError);
+
+		// The DATA transaction cannot be aborted: the connection must be
+		// closed without sending the end-of-data delimiter
+		VASSERT_FALSE("Transport connected", tr->isConnected());
+		VASSERT_FALSE("Socket connected", socket->isConnected());
+		VASSERT_FALSE("End of data", socket->hasReceivedEndOfData());
+	}
+
+	void testDATAGenerationErrorDisconnected()
+	{
+		vmime::shared_ptr <vmime::net::session> session =
+			vmime::make_shared <vmime::net::session>();
+
+		vmime::shared_ptr <vmime::net::transport> tr = session->getTransport
+			(vmime::utility::url("smtp://localhost"));
+
+		tr->setSocketFactory(vmime::make_shared <testSocketFactory <DATAErrorSMTPTestSocket> >());
+		tr->setTimeoutHandlerFactory(vmime::make_shared <testTimeoutHandlerFactory>());
+
+		tr->connect();
+
+		vmime::shared_ptr <DATAErrorSMTPTestSocket> socket = vmime::dynamicCast <DATAErrorSMTPTestSocket>
+			(vmime::dynamicCast <vmime::net::smtp::SMTPTransport>(tr)->getConnection()->getSocket());
+
+		socket->setDisconnectOnData(true);
+
+		vmime::mailbox exp("expeditor@test.vmime.org");
+
+		vmime::mailboxList recips;
+		recips.appendMailbox(vmime::make_shared <vmime::mailbox>("recipient@test.vmime.org"));
+
+		vmime::shared_ptr <vmime::message> msg = vmime::make_shared <SMTPGenerationErrorTestMessage>();
+
+		// The connection is already closed: the generation error must be
+		// reported, not the failure to disconnect
+		VASSERT_THROW("Send", tr->send(msg, exp, recips), SMTPGenerationTestError);
+
+		VASSERT_FALSE("Transport connected", tr->isConnected());
+	}
+
 	void testChunking()
 	{
 		vmime::shared_ptr <vmime::net::session> session =
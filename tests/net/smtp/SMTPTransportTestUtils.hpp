@@ -257,6 +257,12 @@ public:
 
 	void onDataReceived()
 	{
+		processCommand();
+	}
+
+	void processCommand()
+	{
+		// Chunk data may be received along with the BDAT command
 		if (m_state == STATE_DATA)
 		{
 			if (m_bdatChunkReceived != m_bdatChunkSize)
@@ -267,17 +273,12 @@ public:
 				m_bdatChunkReceived += received;
 			}
 
-			if (m_bdatChunkReceived == m_bdatChunkSize)
-			{
-				m_state = STATE_COMMAND;
-			}
-		}
+			if (m_bdatChunkReceived != m_bdatChunkSize)
+				return;
 
-		processCommand();
-	}
+			m_state = STATE_COMMAND;
+		}
 
-	void processCommand()
-	{
 		vmime::string line;
 
 		if (!localReceiveLine(line))
@@ -443,6 +444,146 @@ public:
 
 
 
+/** Message generated in several small writes, which is expected by
+  * MAILandRCPTSMTPTestSocket when sent with the DATA command.
+  */
+class SMTPDataTestMessage : public vmime::message
+{
+public:
+
+	size_t getGeneratedSize(const vmime::generationContext& /* ctx */)
+	{
+		return 12;
+	}
+
+	void generateImpl
+		(const vmime::generationContext& /* ctx */, vmime::utility::outputStream& outputStream,
+		 const size_t /* curLinePos */ = 0, size_t* /* newLinePos */ = NULL) const
+	{
+		outputStream.write("Message", 7);
+		outputStream.write(" ", 1);
+		outputStream.write("data", 4);
+	}
+};
+
+
+
+/** Exception thrown by SMTPGenerationErrorTestMessage (not derived from
+  * vmime::exception, so that it cannot be mistaken for an error of the
+  * transport).
+  */
+class SMTPGenerationTestError : public std::exception
+{
+public:
+
+	const char* what() const throw()
+	{
+		return "Generation error";
+	}
+};
+
+
+/** Message whose generation fails after some data has been written.
+  */
+class SMTPGenerationErrorTestMessage : public vmime::message
+{
+public:
+
+	size_t getGeneratedSize(const vmime::generationContext& /* ctx */)
+	{
+		return 12;
+	}
+
+	void generateImpl
+		(const vmime::generationContext& /* ctx */, vmime::utility::outputStream& outputStream,
+		 const size_t /* curLinePos */ = 0, size_t* /* newLinePos */ = NULL) const
+	{
+		outputStream.write("Message\r\n", 9);
+		outputStream.flush();
+
+		throw SMTPGenerationTestError();
+	}
+};
+
+
+
+/** SMTP test server which accepts any message sent with the DATA
+  * command, and records whether the end of the data was received.
+  */
+class DATAErrorSMTPTestSocket : public lineBasedTestSocket
+{
+public:
+
+	DATAErrorSMTPTestSocket()
+		: m_data(false), m_endOfDataReceived(false), m_disconnectOnData(false)
+	{
+	}
+
+	/** Close the connection as soon as message data is received.
+	  */
+	void setDisconnectOnData(const bool disconnectOnData)
+	{
+		m_disconnectOnData = disconnectOnData;
+	}
+
+	bool hasReceivedEndOfData() const
+	{
+		return m_endOfDataReceived;
+	}
+
+	void onConnected()
+	{
+		localSend("220 test.vmime.org Service ready\r\n");
+	}
+
+	void processCommand()
+	{
+		while (haveMoreLines())
+		{
+			const vmime::string line = getNextLine();
+
+			if (m_data)
+			{
+				if (m_disconnectOnData)
+				{
+					disconnect();
+					return;
+				}
+
+				if (line == ".")
+				{
+					m_data = false;
+					m_endOfDataReceived = true;
+
+					localSend("250 Message accepted for delivery\r\n");
+				}
+			}
+			else if (line == "DATA")
+			{
+				m_data = true;
+
+				localSend("354 Ready to accept data; end with <CRLF>.<CRLF>\r\n");
+			}
+			else if (line == "QUIT")
+			{
+				localSend("221 test.vmime.org Service closing transmission channel\r\n");
+			}
+			else
+			{
+				localSend("250 OK\r\n");
+			}
+		}
+	}
+
+private:
+
+	bool m_data;
+	bool m_endOfDataReceived;
+	bool m_disconnectOnData;
+};
+
+
+
 /** SMTP test server 3.
   *
   * Test SIZE extension.
@@ -0,0 +1,170 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/net/tls/TLSSessionCache.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(TLSSessionCacheTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testMakeKey)
+		VMIME_TEST(testMakeKeyClientIdentity)
+		VMIME_TEST(testStoreFind)
+		VMIME_TEST(testRemove)
+		VMIME_TEST(testMaxSize)
+		VMIME_TEST(testDisabled)
+	VMIME_TEST_LIST_END
+
+
+	class sessionData : public vmime::object
+	{
+	};
+
+
+	vmime::shared_ptr <vmime::net::tls::TLSSessionCache> cache;
+	size_t defaultMaxSize;
+
+
+	void setUp()
+	{
+		cache = vmime::net::tls::TLSSessionCache::getInstance();
+		defaultMaxSize = cache->getMaxSize();
+
+		cache->removeAll();
+	}
+
+	void tearDown()
+	{
+		cache->removeAll();
+		cache->setMaxSize(defaultMaxSize);
+	}
+
+
+	void testMakeKey()
+	{
+		typedef vmime::net::tls::TLSSessionCache TLSSessionCache;
+
+		VASSERT_EQ("1", TLSSessionCache::makeKey("mail.vmime.org", 993, "NORMAL"),
+			TLSSessionCache::makeKey("Mail.VMime.org", 993, "NORMAL"));
+		VASSERT_NEQ("2", TLSSessionCache::makeKey("mail.vmime.org", 993, "NORMAL"),
+			TLSSessionCache::makeKey("mail.vmime.org", 995, "NORMAL"));
+		VASSERT_NEQ("3", TLSSessionCache::makeKey("mail.vmime.org", 993, "NORMAL"),
+			TLSSessionCache::makeKey("mail.vmime.org", 993, "SECURE256"));
+	}
+
+	void testMakeKeyClientIdentity()
+	{
+		typedef vmime::net::tls::TLSSessionCache TLSSessionCache;
+
+		const vmime::string anonymousKey = TLSSessionCache::makeKey("mail.vmime.org", 993, "NORMAL");
+		const vmime::string client1Key = TLSSessionCache::makeKey("mail.vmime.org", 993, "NORMAL", "client1");
+		const vmime::string client2Key = TLSSessionCache::makeKey("mail.vmime.org", 993, "NORMAL", "client2");
+
+		VASSERT_EQ("1", anonymousKey, TLSSessionCache::makeKey("mail.vmime.org", 993, "NORMAL", ""));
+		VASSERT_NEQ("2", anonymousKey, client1Key);
+		VASSERT_NEQ("3", client1Key, client2Key);
+
+		// A session established with some credentials must not be
+		// resumed anonymously or with other credentials, and vice versa
+		cache->store(client1Key, vmime::make_shared <sessionData>());
+
+		VASSERT_NULL("Anonymous", cache->find(anonymousKey));
+		VASSERT_NULL("Other client", cache->find(client2Key));
+		VASSERT_NOT_NULL("Same client", cache->find(client1Key));
+
+		cache->removeAll();
+		cache->store(anonymousKey, vmime::make_shared <sessionData>());
+
+		VASSERT_NULL("Client", cache->find(client1Key));
+	}
+
+	void testStoreFind()
+	{
+		vmime::shared_ptr <sessionData> data1 = vmime::make_shared <sessionData>();
+		vmime::shared_ptr <sessionData> data2 = vmime::make_shared <sessionData>();
+
+		VASSERT_NULL("Empty", cache->find("key1"));
+
+		cache->store("key1", data1);
+		cache->store("key2", data2);
+
+		VASSERT_EQ("Size", 2, cache->getSize());
+		VASSERT_EQ("Find 1", data1, cache->find("key1"));
+		VASSERT_EQ("Find 2", data2, cache->find("key2"));
+
+		// Replace
+		cache->store("key1", data2);
+
+		VASSERT_EQ("Size after replace", 2, cache->getSize());
+		VASSERT_EQ("Find after replace", data2, cache->find("key1"));
+	}
+
+	void testRemove()
+	{
+		cache->store("key1", vmime::make_shared <sessionData>());
+		cache->store("key2", vmime::make_shared <sessionData>());
+
+		cache->remove("key1");
+		cache->remove("key3");  // not in cache
+
+		VASSERT_NULL("Removed", cache->find("key1"));
+		VASSERT_NOT_NULL("Not removed", cache->find("key2"));
+
+		cache->removeAll();
+
+		VASSERT_EQ("Size", 0, cache->getSize());
+	}
+
+	void testMaxSize()
+	{
+		cache->setMaxSize(2);
+
+		cache->store("key1", vmime::make_shared <sessionData>());
+		cache->store("key2", vmime::make_shared <sessionData>());
+		cache->store("key1", vmime::make_shared <sessionData>());  // refresh
+		cache->store("key3", vmime::make_shared <sessionData>());
+
+		VASSERT_EQ("Size", 2, cache->getSize());
+		VASSERT_NOT_NULL("Key 1", cache->find("key1"));
+		VASSERT_NULL("Key 2", cache->find("key2"));
+		VASSERT_NOT_NULL("Key 3", cache->find("key3"));
+
+		cache->setMaxSize(1);
+
+		VASSERT_EQ("Size after shrink", 1, cache->getSize());
+		VASSERT_NOT_NULL("Key 3 after shrink", cache->find("key3"));
+	}
+
+	void testDisabled()
+	{
+		cache->setMaxSize(0);
+		cache->store("key1", vmime::make_shared <sessionData>());
+
+		VASSERT_EQ("Size", 0, cache->getSize());
+		VASSERT_NULL("Find", cache->find("key1"));
+	}
+
+VMIME_TEST_SUITE_END
@@ -39,6 +39,7 @@ VMIME_TEST_SUITE_BEGIN(bodyPartTest)
 		VMIME_TEST(testGenerate7bit)
 		VMIME_TEST(testTextUsageForQPEncoding)
 		VMIME_TEST(testParseVeryBigMessage)
+		VMIME_TEST(testParseNestedMultipart)
 	VMIME_TEST_LIST_END
 
 
@@ -365,5 +366,72 @@ VMIME_TEST_SUITE_BEGIN(bodyPartTest)
 		VASSERT("2.2", vmime::dynamicCast <const vmime::streamContentHandler>(body2Cts) != NULL);
 	}
 
+	void testParseNestedMultipart()
+	{
+		vmime::string str =
+			"Content-Type: multipart/mixed; boundary=\"B1\"\r\n"
+			"\r\n"
+			"--B1\r\n"
+			"Content-Type: multipart/alternative; boundary=\"B2\"\r\n"
+			"\r\n"
+			"--B2\r\n"
+			"Content-Type: text/plain\r\n"
+			"\r\n"
+			"TEXT\r\n"
+			"--B2\r\n"
+			"Content-Type: multipart/related; boundary=\"B3\"\r\n"
+			"\r\n"
+			"--B3\r\n"
+			"Content-Type: text/html\r\n"
+			"\r\n"
+			"HTML\r\n"
+			"--B3\r\n"
+			"Content-Type: image/png\r\n"
+			"\n"
+			"IMAGE\r\n"
+			"--B3--\r\n"
+			"--B2--\r\n"
+			"--B1\r\n"
+			"\r\n"
+			"NO HEADER\r\n"
+			"--B1--\r\n";
+
+		vmime::shared_ptr <vmime::utility::inputStream> is =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::bodyPart p;
+		p.parse(is, str.length());
+
+		VASSERT_EQ("count", 2, p.getBody()->getPartCount());
+
+		vmime::shared_ptr <vmime::bodyPart> alt = p.getBody()->getPartAt(0);
+		vmime::shared_ptr <vmime::bodyPart> noHeader = p.getBody()->getPartAt(1);
+
+		VASSERT_EQ("alt-count", 2, alt->getBody()->getPartCount());
+		VASSERT_EQ("alt-header", "Content-Type: multipart/alternative; boundary=\"B2\"\r\n\r\n",
+			extractComponentString(str, *alt->getHeader()));
+
+		vmime::shared_ptr <vmime::bodyPart> text = alt->getBody()->getPartAt(0);
+		vmime::shared_ptr <vmime::bodyPart> related = alt->getBody()->getPartAt(1);
+
+		VASSERT_EQ("text-header", "Content-Type: text/plain\r\n\r\n", extractComponentString(str, *text->getHeader()));
+		VASSERT_EQ("text-body", "TEXT", extractContents(text->getBody()->getContents()));
+
+		VASSERT_EQ("related-count", 2, related->getBody()->getPartCount());
+
+		vmime::shared_ptr <vmime::bodyPart> html = related->getBody()->getPartAt(0);
+		vmime::shared_ptr <vmime::bodyPart> image = related->getBody()->getPartAt(1);
+
+		VASSERT_EQ("html-header", "Content-Type: text/html\r\n\r\n", extractComponentString(str, *html->getHeader()));
+		VASSERT_EQ("html-body", "HTML", extractContents(html->getBody()->getContents()));
+		VASSERT_EQ("image-header", "Content-Type: image/png\r\n\n", extractComponentString(str, *image->getHeader()));
+		VASSERT_EQ("image-field", "image/png", image->getHeader()->ContentType()->getValue()->generate());
+		VASSERT_EQ("image-body", "IMAGE", extractContents(image->getBody()->getContents()));
+
+		VASSERT_EQ("no-header-header", "\r\n", extractComponentString(str, *noHeader->getHeader()));
+		VASSERT_EQ("no-header-count", 0, noHeader->getHeader()->getFieldCount());
+		VASSERT_EQ("no-header-body", "NO HEADER", extractContents(noHeader->getBody()->getContents()));
+	}
+
 VMIME_TEST_SUITE_END
 
@@ -0,0 +1,156 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+//
+// Charset converter benchmark
+//
+// Measures the throughput of conversions to UTF-8 from the charsets
+// handled by the built-in converter (us-ascii, iso-8859-1, windows-1252
+// and utf-8) on 1, 10 and 100 MB of text, and compares it to the generic
+// converter (iconv, ICU or Windows API, depending on the build). Output
+// of both converters is checked to be identical.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+
+#include "vmime/vmime.hpp"
+
+
+// Gives access to the generic converter, which is used for charsets
+// not supported by the built-in converter
+class genericConverter : public vmime::charsetConverter
+{
+public:
+
+	static vmime::shared_ptr <vmime::charsetConverter> create
+		(const vmime::charset& source, const vmime::charset& dest)
+	{
+		return createGenericConverter(source, dest, vmime::charsetConverterOptions());
+	}
+};
+
+
+// Generate mostly ASCII text, with a non-ASCII word every few words
+// (as in most European languages), encoded in the specified charset
+static vmime::string sampleText(const vmime::string& charset, const vmime::size_t length)
+{
+	static const char* const asciiWords[] =
+	{
+		"The", "message", "was", "sent", "to", "all", "recipients", "of",
+		"the", "list", "and", "will", "be", "archived", "tomorrow"
+	};
+
+	// "déjà", "reçu", "€uro" in ISO-8859-1/Windows-1252 and UTF-8
+	static const char* const latin1Words[] = { "d\xe9j\xe0", "re\xe7u", "caf\xe9" };
+	static const char* const cp1252Words[] = { "d\xe9j\xe0", "re\xe7u", "\x80uro" };
+	static const char* const utf8Words[] = { "d\xc3\xa9j\xc3\xa0", "re\xc3\xa7u", "\xe2\x82\xacuro" };
+
+	const char* const* otherWords =
+		charset == "iso-8859-1" ? latin1Words :
+		charset == "windows-1252" ? cp1252Words :
+		charset == "utf-8" ? utf8Words : NULL;
+
+	vmime::string text;
+	text.reserve(length + 16);
+
+	for (unsigned int i = 0 ; text.length() < length ; ++i)
+	{
+		if (otherWords && i % 7 == 6)
+			text += otherWords[(i / 7) % 3];
+		else
+			text += asciiWords[i % (sizeof(asciiWords) / sizeof(asciiWords[0]))];
+
+		text += (i % 12 == 11 ? "\r\n" : " ");
+	}
+
+	return text;
+}
+
+
+static double run(vmime::charsetConverter& conv, const vmime::string& in, vmime::string& out)
+{
+	out.clear();
+
+	const std::clock_t start = std::clock();
+
+	conv.convert(in, out);
+
+	return static_cast <double>(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+static void printResult(const char* name, const vmime::size_t length, const double generic, const double current)
+{
+	const double mb = static_cast <double>(length) / (1024 * 1024);
+
+	std::cout << "  " << std::setw(12) << std::left << name << std::right << std::fixed
+	          << std::setprecision(1)
+	          << std::setw(10) << (generic > 0 ? mb / generic : 0) << " MB/s"
+	          << std::setw(10) << (current > 0 ? mb / current : 0) << " MB/s"
+	          << std::setw(8) << (current > 0 ? generic / current : 0) << "x"
+	          << std::endl;
+}
+
+
+int main()
+{
+	static const vmime::size_t sizes[] = { 1, 10, 100 };
+	static const char* const charsets[] = { "us-ascii", "iso-8859-1", "windows-1252", "utf-8" };
+
+	bool ok = true;
+
+	for (unsigned int i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; ++i)
+	{
+		std::cout << sizes[i] << " MB:" << std::setw(22) << "generic" << std::setw(15) << "built-in" << std::endl;
+
+		for (unsigned int j = 0 ; j < sizeof(charsets) / sizeof(charsets[0]) ; ++j)
+		{
+			const vmime::charset source(charsets[j]);
+			const vmime::charset dest(vmime::charsets::UTF_8);
+
+			const vmime::string text = sampleText(charsets[j], sizes[i] * 1024 * 1024);
+
+			vmime::shared_ptr <vmime::charsetConverter> generic = genericConverter::create(source, dest);
+			vmime::shared_ptr <vmime::charsetConverter> current = vmime::charsetConverter::create(source, dest);
+
+			vmime::string genericOut, currentOut;
+
+			const double genericTime = run(*generic, text, genericOut);
+			const double currentTime = run(*current, text, currentOut);
+
+			if (genericOut != currentOut)
+			{
+				std::cerr << "Converted text differs for " << charsets[j] << "!" << std::endl;
+				ok = false;
+			}
+
+			printResult(charsets[j], text.length(), genericTime, currentTime);
+		}
+	}
+
+	return ok ? 0 : 1;
+}
+
@@ -44,6 +44,12 @@ VMIME_TEST_SUITE_BEGIN(charsetTest)
 
 		VMIME_TEST(testReplaceInvalidSequence)
 		VMIME_TEST(testStopOnInvalidSequence)
+		VMIME_TEST(testConverterReuse)
+
+		// Built-in converters to UTF-8
+		VMIME_TEST(testBuiltinConvertToUTF8)
+		VMIME_TEST(testBuiltinInvalidSequence)
+		VMIME_TEST(testBuiltinConvertStream)
 
 		VMIME_TEST(testStatus)
 		VMIME_TEST(testStatusWithInvalidSequence)
@@ -192,6 +198,123 @@ VMIME_TEST_SUITE_BEGIN(charsetTest)
 		);
 	}
 
+	void testConverterReuse()
+	{
+		vmime::charsetConverterOptions opts;
+		opts.silentlyReplaceInvalidSequences = false;
+
+		// Stop conversion in the middle of a shift sequence
+		VASSERT_THROW(
+			"Illegal UTF-8 sequence",
+			convertHelper("\x66\xc3\xb8\xc3\xb8\x80\x80", "utf-8", "utf-7", opts),
+			vmime::exceptions::illegal_byte_sequence_for_charset
+		);
+
+		// Converters for the same charsets should start in the initial state
+		for (int i = 0 ; i < 3 ; ++i)
+			VASSERT_EQ("Reuse", "f+APg-o", convertHelper("\x66\xc3\xb8\x6f", "utf-8", "utf-7"));
+	}
+
+	void testBuiltinConvertToUTF8()
+	{
+		VASSERT_EQ("us-ascii", "Plain ASCII text", convertHelper("Plain ASCII text", "us-ascii", "utf-8"));
+
+		VASSERT_EQ("iso-8859-1", toHex("Gwena\xc3\xabl \xc3\xbf\xc2\x80"),
+			toHex(convertHelper("Gwena\xebl \xff\x80", "iso-8859-1", "utf-8")));
+
+		VASSERT_EQ("windows-1252", toHex("\xe2\x82\xac \xe2\x80\x9cq\xe2\x80\x9d \xc5\xb8 \xc3\xa9"),
+			toHex(convertHelper("\x80 \x93q\x94 \x9f \xe9", "windows-1252", "utf-8")));
+
+		VASSERT_EQ("cp1252", toHex("\xe2\x84\xa2"), toHex(convertHelper("\x99", "cp1252", "utf-8")));
+
+		const vmime::string utf8("A\xc3\xa7\xe2\x82\xac\xf0\x9f\x98\x80\xf4\x8f\xbf\xbfZ");
+		VASSERT_EQ("utf-8", toHex(utf8), toHex(convertHelper(utf8, "utf-8", "utf-8")));
+
+		// Long ASCII runs are copied by words: check with non-ASCII bytes at all offsets
+		for (unsigned int i = 0 ; i < 20 ; ++i)
+		{
+			const vmime::string prefix(i, 'x');
+
+			VASSERT_EQ("offset", prefix + "\xc3\xa9" + prefix,
+				convertHelper(prefix + "\xe9" + prefix, "iso-8859-1", "utf-8"));
+		}
+	}
+
+	void testBuiltinInvalidSequence()
+	{
+		vmime::charsetConverterOptions opts;
+		opts.silentlyReplaceInvalidSequences = true;
+		opts.invalidSequence = "?";
+
+		// One replacement per invalid byte
+		VASSERT_EQ("us-ascii", "a?b", convertHelper("a\xe9" "b", "us-ascii", "utf-8", opts));
+		VASSERT_EQ("windows-1252", "a?b?", convertHelper("a\x81" "b\x9d", "windows-1252", "utf-8", opts));
+
+		VASSERT_EQ("overlong", "a??b", convertHelper("a\xc0\xaf" "b", "utf-8", "utf-8", opts));
+		VASSERT_EQ("overlong 3", "a???b", convertHelper("a\xe0\x80\xaf" "b", "utf-8", "utf-8", opts));
+		VASSERT_EQ("surrogate", "a???b", convertHelper("a\xed\xa0\x80" "b", "utf-8", "utf-8", opts));
+		VASSERT_EQ("out of range", "a????b", convertHelper("a\xf4\x90\x80\x80" "b", "utf-8", "utf-8", opts));
+		VASSERT_EQ("truncated", "a?b??", convertHelper("a\xc3" "b\xe2\x82", "utf-8", "utf-8", opts));
+
+		opts.silentlyReplaceInvalidSequences = false;
+
+		VASSERT_THROW("throw us-ascii",
+			convertHelper("a\xe9" "b", "us-ascii", "utf-8", opts),
+			vmime::exceptions::illegal_byte_sequence_for_charset);
+
+		VASSERT_THROW("throw utf-8",
+			convertHelper("Fran\xc3\xa7ois\xf1\x80\x65", "utf-8", "utf-8", opts),
+			vmime::exceptions::illegal_byte_sequence_for_charset);
+
+		vmime::charsetConverter::status st;
+
+		try
+		{
+			//             012   3   4
+			convertHelper("a\xc3\xa7\x9d", "windows-1252", "utf-8", opts, &st);
+		}
+		catch (vmime::exceptions::illegal_byte_sequence_for_charset&)
+		{
+		}
+
+		VASSERT_EQ("inputBytesRead", 3, st.inputBytesRead);
+		VASSERT_EQ("outputBytesWritten", 5, st.outputBytesWritten);
+	}
+
+	void testBuiltinConvertStream()
+	{
+		// Multi-byte sequences span the boundaries of the internal buffer
+		vmime::string in, expectedOut;
+
+		for (unsigned int i = 0 ; i < 50000 ; ++i)
+		{
+			if (i % 7 == 0)
+				in += "\xe2\x82\xac";
+			else if (i % 5 == 0)
+				in += "\xf0\x9f\x98\x80";
+			else
+				in += static_cast <char>('a' + i % 26);
+		}
+
+		vmime::charsetConverterOptions opts;
+		opts.silentlyReplaceInvalidSequences = false;
+
+		vmime::shared_ptr <vmime::charsetConverter> conv =
+			vmime::charsetConverter::create("utf-8", "utf-8", opts);
+
+		vmime::utility::inputStreamStringAdapter is(in);
+
+		vmime::string out;
+		vmime::utility::outputStreamStringAdapter os(out);
+
+		vmime::charsetConverter::status st;
+		conv->convert(is, os, &st);
+
+		VASSERT_EQ("Output", in, out);
+		VASSERT_EQ("inputBytesRead", in.length(), st.inputBytesRead);
+		VASSERT_EQ("outputBytesWritten", in.length(), st.outputBytesWritten);
+	}
+
 	void testStatus()
 	{
 		vmime::charsetConverterOptions opts;
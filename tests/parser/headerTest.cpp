@@ -57,10 +57,16 @@ VMIME_TEST_SUITE_BEGIN(headerTest)
 		VMIME_TEST(testGetFieldList2)
 
 		VMIME_TEST(testFind1)
+		VMIME_TEST(testFind2)
+		VMIME_TEST(testFind3)
 
 		VMIME_TEST(testFindAllFields1)
 		VMIME_TEST(testFindAllFields2)
 		VMIME_TEST(testFindAllFields3)
+
+		VMIME_TEST(testLazyParsing1)
+		VMIME_TEST(testLazyParsing2)
+		VMIME_TEST(testLazyParsingBounds)
 	VMIME_TEST_LIST_END
 
 
@@ -336,6 +342,36 @@ VMIME_TEST_SUITE_BEGIN(headerTest)
 		VASSERT_EQ("Value", "B: b", getFieldValue(*res));
 	}
 
+	void testFind2()
+	{
+		vmime::header hdr;
+		hdr.parse("A: a\r\ncontent-TYPE: text/plain\r\nB: b\r\n");
+
+		VASSERT_TRUE("Has", hdr.hasField("Content-Type"));
+		VASSERT_FALSE("Has not", hdr.hasField("Content-Typ"));
+		VASSERT_EQ("Find", "content-TYPE: text/plain", headerTest::getFieldValue(*hdr.findField("CONTENT-type")));
+		VASSERT_EQ("Get", hdr.findField("Content-Type"), hdr.ContentType());
+		VASSERT_EQ("Find all", static_cast <unsigned int>(1), hdr.findAllFields(vmime::fields::CONTENT_TYPE).size());
+		VASSERT_NULL("Not found", hdr.findField("C"));
+	}
+
+	void testFind3()
+	{
+		vmime::header hdr;
+		hdr.parse("A: a\r\nB: b\r\n");
+
+		// Renamed field
+		hdr.findField("B")->setName("C");
+
+		VASSERT_NULL("B", hdr.findField("B"));
+		VASSERT_EQ("C", "C: b", headerTest::getFieldValue(*hdr.findField("c")));
+		VASSERT_EQ("Count", 2, hdr.getFieldCount());
+
+		hdr.getField("B");
+
+		VASSERT_EQ("Count after get", 3, hdr.getFieldCount());
+	}
+
 	// getAllByName function tests
 	void testFindAllFields1()
 	{
@@ -372,5 +408,101 @@ VMIME_TEST_SUITE_BEGIN(headerTest)
 		VASSERT_EQ("Second value", "C: c2", headerTest::getFieldValue(*res[2]));
 	}
 
+	// Lazy parsing of field values
+	static const vmime::string getLazyTestHeader()
+	{
+		return "From: Me <me@vmime.org>\r\n"
+		       "To: you@vmime.org, \"Other\" <other@vmime.org>\r\n"
+		       "Subject: =?us-ascii?Q?Test?=\r\n"
+		       "Received: from a.example.org by b.example.org;\r\n"
+		       "  Tue, 15 Oct 2013 11:22:33 +0200\r\n"
+		       "Content-Type: text/plain; charset=\"utf-8\"; format=flowed\r\n"
+		       "\r\n";
+	}
+
+	void testLazyParsing1()
+	{
+		vmime::parsingContext ctx;
+		ctx.setLazyHeaderFieldParsing(true);
+
+		vmime::header hdr;
+		hdr.parse(ctx, getLazyTestHeader());
+
+		vmime::header ref;
+		ref.parse(getLazyTestHeader());
+
+		VASSERT_EQ("Count", ref.getFieldCount(), hdr.getFieldCount());
+
+		VASSERT_EQ("From", "me@vmime.org", hdr.From()->getValue <vmime::mailbox>()->getEmail().generate());
+		VASSERT_EQ("To", 2, hdr.To()->getValue <vmime::addressList>()->getAddressCount());
+		VASSERT_EQ("Subject", "Test", hdr.Subject()->getValue <vmime::text>()->getWholeBuffer());
+
+		vmime::shared_ptr <const vmime::parameterizedHeaderField> ctf =
+			vmime::dynamicCast <const vmime::parameterizedHeaderField>(hdr.ContentType());
+
+		VASSERT_EQ("Content-Type charset", "utf-8", ctf->findParameter("charset")->getValue().getBuffer());
+		VASSERT_EQ("Content-Type params", 2, ctf->getParameterCount());
+
+		VASSERT_EQ("Generate", ref.generate(), hdr.generate());
+	}
+
+	void testLazyParsing2()
+	{
+		vmime::parsingContext ctx;
+		ctx.setLazyHeaderFieldParsing(true);
+
+		vmime::header hdr;
+		hdr.parse(ctx, getLazyTestHeader());
+
+		// Field values not accessed before being copied/modified
+		vmime::shared_ptr <vmime::header> hdr2 = vmime::clone(hdr);
+
+		VASSERT_EQ("Clone", "Test", hdr2->Subject()->getValue <vmime::text>()->getWholeBuffer());
+
+		vmime::shared_ptr <vmime::parameterizedHeaderField> ctf =
+			vmime::dynamicCast <vmime::parameterizedHeaderField>(hdr.ContentType());
+
+		ctf->setValue(vmime::mediaType("text/html"));
+
+		VASSERT_EQ("Value", "text/html", ctf->getValue <vmime::mediaType>()->generate());
+		VASSERT_EQ("Params", 2, ctf->getParameterCount());
+
+		hdr.Subject()->setValue(vmime::text("New subject"));
+
+		VASSERT_EQ("Subject", "New subject", hdr.Subject()->getValue <vmime::text>()->getWholeBuffer());
+	}
+
+	void testLazyParsingBounds()
+	{
+		const vmime::string str = "X-Dummy: foo\r\n" + getLazyTestHeader() + "Body\r\n";
+
+		vmime::parsingContext ctx;
+		ctx.setLazyHeaderFieldParsing(true);
+
+		// Parse from a stream, so that parsed bounds have to be offset
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> is =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::message> msg = vmime::make_shared <vmime::message>();
+		msg->parse(ctx, is, 0, str.length());
+
+		vmime::shared_ptr <vmime::message> ref = vmime::make_shared <vmime::message>();
+		ref->parse(str);
+
+		vmime::shared_ptr <const vmime::addressList> to =
+			msg->getHeader()->To()->getValue <vmime::addressList>();
+		vmime::shared_ptr <const vmime::addressList> refTo =
+			ref->getHeader()->To()->getValue <vmime::addressList>();
+
+		VASSERT_EQ("Field offset", ref->getHeader()->To()->getParsedOffset(), msg->getHeader()->To()->getParsedOffset());
+		VASSERT_EQ("Field length", ref->getHeader()->To()->getParsedLength(), msg->getHeader()->To()->getParsedLength());
+
+		VASSERT_EQ("Value offset", refTo->getParsedOffset(), to->getParsedOffset());
+		VASSERT_EQ("Value length", refTo->getParsedLength(), to->getParsedLength());
+
+		VASSERT_EQ("Address offset", refTo->getAddressAt(1)->getParsedOffset(), to->getAddressAt(1)->getParsedOffset());
+		VASSERT_EQ("Address length", refTo->getAddressAt(1)->getParsedLength(), to->getAddressAt(1)->getParsedLength());
+	}
+
 VMIME_TEST_SUITE_END
 
@@ -28,9 +28,61 @@ VMIME_TEST_SUITE_BEGIN(messageTest)
 
 	VMIME_TEST_LIST_BEGIN
 		VMIME_TEST(testGetGeneratedSize)
+		VMIME_TEST(testGetGeneratedSize_Exact)
+		VMIME_TEST(testGetGeneratedSize_ModifiedContents)
 	VMIME_TEST_LIST_END
 
 
+	static const vmime::string generateMessage
+		(const vmime::generationContext& ctx, vmime::shared_ptr <vmime::message> msg)
+	{
+		vmime::string out;
+		vmime::utility::outputStreamStringAdapter os(out);
+
+		msg->generate(ctx, os);
+
+		return out;
+	}
+
+	static vmime::shared_ptr <vmime::message> buildTestMessage()
+	{
+		vmime::messageBuilder mb;
+
+		mb.setExpeditor(vmime::mailbox("expeditor@vmime.org"));
+		mb.getRecipients().appendAddress(vmime::make_shared <vmime::mailbox>("recipient@vmime.org"));
+		mb.setSubject(vmime::text(
+			"A rather long subject line, with non-ASCII characters (\xc3\xa9\xc3\xa0\xc3\xa8) "
+			"and enough words to be folded over several lines when generated",
+			vmime::charset("utf-8")));
+
+		mb.getTextPart()->setText(vmime::make_shared <vmime::stringContentHandler>
+			("Foo bar baz\r\n.\r\nA line that is long enough to be cut by soft line breaks "
+			 "when encoded in quoted-printable \xc3\xa9\xc3\xa9\xc3\xa9\r\n"));
+
+		vmime::string binaryData;
+
+		for (int i = 0 ; i < 1000 ; ++i)
+			binaryData += static_cast <char>(i % 256);
+
+		mb.appendAttachment(vmime::make_shared <vmime::defaultAttachment>
+			(vmime::make_shared <vmime::stringContentHandler>(binaryData),
+			 vmime::encoding(vmime::encodingTypes::BASE64),
+			 vmime::mediaType("application/octet-stream")));
+
+		mb.appendAttachment(vmime::make_shared <vmime::defaultAttachment>
+			(vmime::make_shared <vmime::stringContentHandler>(binaryData),
+			 vmime::encoding(vmime::encodingTypes::QUOTED_PRINTABLE),
+			 vmime::mediaType("text/plain")));
+
+		mb.appendAttachment(vmime::make_shared <vmime::defaultAttachment>
+			(vmime::make_shared <vmime::stringContentHandler>("Already encoded=\r\n data"),
+			 vmime::encoding(vmime::encodingTypes::SEVEN_BIT),
+			 vmime::mediaType("text/plain")));
+
+		return mb.construct();
+	}
+
+
 	void testGetGeneratedSize()
 	{
 		vmime::generationContext ctx;
@@ -53,5 +105,59 @@ VMIME_TEST_SUITE_BEGIN(messageTest)
 		VASSERT(oss.str(), genSize >= actualSize);
 	}
 
+	void testGetGeneratedSize_Exact()
+	{
+		vmime::shared_ptr <vmime::message> msg = buildTestMessage();
+
+		static const vmime::size_t maxLineLengths[] = { 78, 40, 998 };
+
+		for (unsigned int i = 0 ; i < sizeof(maxLineLengths) / sizeof(maxLineLengths[0]) ; ++i)
+		{
+			vmime::generationContext ctx;
+			ctx.setMaxLineLength(maxLineLengths[i]);
+
+			std::ostringstream oss;
+			oss << "maxLineLength=" << maxLineLengths[i];
+
+			VASSERT_EQ(oss.str(), generateMessage(ctx, msg).length(), msg->getGeneratedSize(ctx));
+
+			// Same result when computed again
+			VASSERT_EQ(oss.str() + " (again)", generateMessage(ctx, msg).length(), msg->getGeneratedSize(ctx));
+		}
+	}
+
+	void testGetGeneratedSize_ModifiedContents()
+	{
+		vmime::generationContext ctx;
+
+		vmime::shared_ptr <vmime::message> msg = buildTestMessage();
+		VASSERT_EQ("1", generateMessage(ctx, msg).length(), msg->getGeneratedSize(ctx));
+
+		// Change contents of a quoted-printable part
+		vmime::shared_ptr <vmime::body> bdy = msg->getBody()->getPartAt(2)->getBody();
+		bdy->setContents(vmime::make_shared <vmime::stringContentHandler>("=== new contents ==="));
+
+		VASSERT_EQ("2", generateMessage(ctx, msg).length(), msg->getGeneratedSize(ctx));
+
+		// Replace data in place, with data of the same length which
+		// needs more quoted-printable escapes
+		vmime::shared_ptr <vmime::stringContentHandler> contents =
+			vmime::make_shared <vmime::stringContentHandler>("abcdefghijklmnopqrst");
+
+		bdy->setContents(contents);
+
+		VASSERT_EQ("3", generateMessage(ctx, msg).length(), msg->getGeneratedSize(ctx));
+
+		contents->setData("=== new contents ===");
+
+		VASSERT_EQ("4", generateMessage(ctx, msg).length(), msg->getGeneratedSize(ctx));
+
+		// Change encoding
+		msg->getBody()->getPartAt(2)->getHeader()->ContentTransferEncoding()->setValue
+			(vmime::encoding(vmime::encodingTypes::BASE64));
+
+		VASSERT_EQ("5", generateMessage(ctx, msg).length(), msg->getGeneratedSize(ctx));
+	}
+
 VMIME_TEST_SUITE_END
 
@@ -0,0 +1,165 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+//
+// Nested multipart parsing benchmark
+//
+// Measures the time needed to parse messages made of nested
+// multipart/mixed, multipart/alternative and multipart/related bodies
+// (as generated by most mail clients for HTML messages with inline
+// images and attachments), with the same attachment size and an
+// increasing nesting depth. Boundaries are located using the delimiter
+// lines indexed by the parser, so the parsing time should not depend
+// on the nesting depth.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <ctime>
+
+#include "vmime/vmime.hpp"
+
+
+// Build a message whose innermost part is a Base64 attachment of the
+// specified size, nested in the specified number of multipart bodies
+static vmime::string nestedMessage(const vmime::size_t levels, const vmime::size_t length)
+{
+	static const char* const types[] = { "mixed", "alternative", "related" };
+
+	vmime::string prefix, suffix;
+
+	prefix += "From: sender@vmime.org\r\n";
+	prefix += "To: recipient@vmime.org\r\n";
+	prefix += "Subject: Nested multipart benchmark\r\n";
+	prefix += "MIME-Version: 1.0\r\n";
+
+	for (vmime::size_t level = 0 ; level < levels ; ++level)
+	{
+		std::ostringstream boundary;
+		boundary << "=_vmime_boundary_" << level;
+
+		prefix += "Content-Type: multipart/";
+		prefix += types[level % 3];
+		prefix += "; boundary=\"" + boundary.str() + "\"\r\n";
+		prefix += "\r\n";
+		prefix += "--" + boundary.str() + "\r\n";
+		prefix += "Content-Type: text/plain; charset=us-ascii\r\n";
+		prefix += "\r\n";
+		prefix += "Text part at level " + boundary.str().substr(17) + ".\r\n";
+		prefix += "--" + boundary.str() + "\r\n";
+
+		suffix = "\r\n--" + boundary.str() + "--\r\n" + suffix;
+	}
+
+	prefix += "Content-Type: image/png\r\n";
+	prefix += "Content-Transfer-Encoding: base64\r\n";
+	prefix += "\r\n";
+
+	vmime::string data;
+	data.reserve(prefix.length() + length + suffix.length());
+
+	data += prefix;
+
+	static const char base64Chars[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	for (vmime::size_t i = 0 ; i < length ; ++i)
+	{
+		if (i % 78 == 76)
+			data += '\r';
+		else if (i % 78 == 77)
+			data += '\n';
+		else
+			data += base64Chars[(i * 7 + i / 78) % 64];
+	}
+
+	data += suffix;
+
+	return data;
+}
+
+
+// Parse the message and check that the attachment is found at the
+// expected depth
+static double run(const vmime::string& data, const vmime::size_t levels, const vmime::size_t length, bool& ok)
+{
+	vmime::shared_ptr <vmime::message> msg = vmime::make_shared <vmime::message>();
+
+	const std::clock_t start = std::clock();
+
+	msg->parse(vmime::make_shared <vmime::utility::inputStreamStringAdapter>(data), data.length());
+
+	const double time = static_cast <double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+	vmime::shared_ptr <const vmime::bodyPart> part = msg;
+
+	for (vmime::size_t level = 0 ; level < levels && part ; ++level)
+	{
+		if (part->getBody()->getPartCount() != 2)
+			part = vmime::null;
+		else
+			part = part->getBody()->getPartAt(1);
+	}
+
+	if (!part || part->getBody()->getContents()->getLength() != length)
+	{
+		std::cerr << "Attachment not found at level " << levels << "!" << std::endl;
+		ok = false;
+	}
+
+	return time;
+}
+
+
+int main()
+{
+	static const vmime::size_t sizes[] = { 1, 10, 100 };
+	static const vmime::size_t levels[] = { 3, 12, 48 };
+
+	bool ok = true;
+
+	for (unsigned int i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; ++i)
+	{
+		std::cout << sizes[i] << " MB:" << std::endl;
+
+		for (unsigned int j = 0 ; j < sizeof(levels) / sizeof(levels[0]) ; ++j)
+		{
+			const vmime::size_t length = sizes[i] * 1024 * 1024;
+			const vmime::string data = nestedMessage(levels[j], length);
+
+			const double time = run(data, levels[j], length, ok);
+			const double mb = static_cast <double>(data.length()) / (1024 * 1024);
+
+			std::cout << "  " << std::setw(2) << levels[j] << " levels" << std::fixed
+			          << std::setprecision(1)
+			          << std::setw(10) << time * 1000 << " ms"
+			          << std::setw(10) << (time > 0 ? mb / time : 0) << " MB/s"
+			          << std::endl;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
+
@@ -0,0 +1,196 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/utility/inputStreamStringAdapter.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(posixFileTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testMappedInputStream)
+		VMIME_TEST(testMappedInputStreamSeek)
+		VMIME_TEST(testEmptyFileInputStream)
+		VMIME_TEST(testParseMappedFile)
+	VMIME_TEST_LIST_END
+
+
+	vmime::shared_ptr <vmime::utility::file> testFile;
+
+
+	void setUp()
+	{
+		std::ostringstream testFilePath;
+		testFilePath << "/tmp/vmime_test_" << (rand() % 999999999);
+
+		vmime::shared_ptr <vmime::utility::fileSystemFactory> fsf =
+			vmime::platform::getHandler()->getFileSystemFactory();
+
+		testFile = fsf->create(fsf->stringToPath(testFilePath.str()));
+		testFile->createFile();
+	}
+
+	void tearDown()
+	{
+		testFile->remove();
+		testFile = vmime::null;
+	}
+
+
+	void writeTestFile(const vmime::string& data)
+	{
+		testFile->getFileWriter()->getOutputStream()->write(data.data(), data.length());
+	}
+
+	vmime::shared_ptr <vmime::utility::seekableInputStream> getTestFileInputStream()
+	{
+		return vmime::dynamicCast <vmime::utility::seekableInputStream>
+			(testFile->getFileReader()->getInputStream());
+	}
+
+
+	void testMappedInputStream()
+	{
+		writeTestFile("0123456789ABCDEF");
+
+		vmime::shared_ptr <vmime::utility::seekableInputStream> is = getTestFileInputStream();
+
+		VASSERT_NOT_NULL("seekable", is);
+
+		vmime::byte_t buffer[10];
+
+		VASSERT_EQ("Read 1", 10, is->read(buffer, 10));
+		VASSERT_EQ("Read 1 data", "0123456789", vmime::string(buffer, buffer + 10));
+		VASSERT_EQ("Position 1", 10, is->getPosition());
+		VASSERT_FALSE("EOF 1", is->eof());
+
+		VASSERT_EQ("Read 2", 6, is->read(buffer, 10));
+		VASSERT_EQ("Read 2 data", "ABCDEF", vmime::string(buffer, buffer + 6));
+		VASSERT_TRUE("EOF 2", is->eof());
+
+		VASSERT_EQ("Read 3", 0, is->read(buffer, 10));
+
+		is->reset();
+
+		VASSERT_EQ("Position 2", 0, is->getPosition());
+		VASSERT_FALSE("EOF 3", is->eof());
+	}
+
+	void testMappedInputStreamSeek()
+	{
+		writeTestFile("0123456789ABCDEF");
+
+		vmime::shared_ptr <vmime::utility::seekableInputStream> is = getTestFileInputStream();
+
+		vmime::byte_t buffer[4];
+
+		is->seek(12);
+
+		VASSERT_EQ("Read 1", 4, is->read(buffer, 4));
+		VASSERT_EQ("Read 1 data", "CDEF", vmime::string(buffer, buffer + 4));
+
+		is->seek(2);
+
+		VASSERT_EQ("Skip 1", 3, is->skip(3));
+		VASSERT_EQ("Position 1", 5, is->getPosition());
+		VASSERT_EQ("Skip 2", 11, is->skip(100));
+		VASSERT_TRUE("EOF", is->eof());
+
+		is->seek(100);
+
+		VASSERT_EQ("Position 2", 16, is->getPosition());
+	}
+
+	void testEmptyFileInputStream()
+	{
+		// Empty files cannot be mapped: should fall back to read()
+		vmime::shared_ptr <vmime::utility::seekableInputStream> is = getTestFileInputStream();
+
+		VASSERT_NOT_NULL("seekable", is);
+
+		vmime::byte_t buffer[4];
+
+		VASSERT_EQ("Read", 0, is->read(buffer, 4));
+		VASSERT_TRUE("EOF", is->eof());
+	}
+
+	void testParseMappedFile()
+	{
+		std::ostringstream oss;
+
+		oss << "From: me@vmime.org\r\n"
+		    << "To: you@vmime.org\r\n"
+		    << "Subject: Test\r\n"
+		    << "Content-Type: multipart/mixed; boundary=\"XXX\"\r\n"
+		    << "\r\n"
+		    << "Preamble\r\n"
+		    << "--XXX\r\n"
+		    << "Content-Type: text/plain\r\n"
+		    << "\r\n";
+
+		for (int i = 0 ; i < 1000 ; ++i)
+			oss << "Line " << i << " of the first part\r\n";
+
+		oss << "--XXX\r\n"
+		    << "Content-Type: application/octet-stream\r\n"
+		    << "Content-Transfer-Encoding: base64\r\n"
+		    << "\r\n";
+
+		for (int i = 0 ; i < 1000 ; ++i)
+			oss << "QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVogYWJjZGVmZ2hpamtsbW5vcHFyc3R1dnd4eXow\r\n";
+
+		oss << "--XXX--\r\n"
+		    << "Epilogue\r\n";
+
+		const vmime::string data = oss.str();
+
+		writeTestFile(data);
+
+		// Parse from file, and from memory (reference)
+		vmime::shared_ptr <vmime::utility::seekableInputStream> fileStream = getTestFileInputStream();
+		vmime::shared_ptr <vmime::utility::seekableInputStream> memStream =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(data);
+
+		vmime::shared_ptr <vmime::message> msg1 = vmime::make_shared <vmime::message>();
+		msg1->parse(fileStream, data.length());
+
+		vmime::shared_ptr <vmime::message> msg2 = vmime::make_shared <vmime::message>();
+		msg2->parse(memStream, data.length());
+
+		VASSERT_EQ("Part count", 2, msg1->getBody()->getPartCount());
+		VASSERT_EQ("Part count", msg2->getBody()->getPartCount(), msg1->getBody()->getPartCount());
+
+		for (size_t i = 0 ; i < msg1->getBody()->getPartCount() ; ++i)
+		{
+			vmime::shared_ptr <vmime::bodyPart> part1 = msg1->getBody()->getPartAt(i);
+			vmime::shared_ptr <vmime::bodyPart> part2 = msg2->getBody()->getPartAt(i);
+
+			VASSERT_EQ("Parsed offset", part2->getParsedOffset(), part1->getParsedOffset());
+			VASSERT_EQ("Parsed length", part2->getParsedLength(), part1->getParsedLength());
+		}
+
+		VASSERT_EQ("Generate", msg2->generate(), msg1->generate());
+	}
+
+VMIME_TEST_SUITE_END
@@ -0,0 +1,156 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/platforms/posix/posixSocket.hpp"
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+VMIME_TEST_SUITE_BEGIN(posixSocketTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testReceiveRaw)
+#if VMIME_HAVE_EPOLL
+		VMIME_TEST(testReactor)
+		VMIME_TEST(testReactorInvalidSocket)
+#endif // VMIME_HAVE_EPOLL
+	VMIME_TEST_LIST_END
+
+
+	int listenDesc;
+	vmime::port_t listenPort;
+
+
+	void setUp()
+	{
+		listenDesc = ::socket(AF_INET, SOCK_STREAM, 0);
+
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;  // any free port
+
+		socklen_t addrLen = sizeof(addr);
+
+		VASSERT_TRUE("bind", ::bind(listenDesc, reinterpret_cast <sockaddr*>(&addr), sizeof(addr)) == 0);
+		VASSERT_TRUE("listen", ::listen(listenDesc, 5) == 0);
+		VASSERT_TRUE("getsockname", ::getsockname(listenDesc, reinterpret_cast <sockaddr*>(&addr), &addrLen) == 0);
+
+		listenPort = ntohs(addr.sin_port);
+	}
+
+	void tearDown()
+	{
+		::close(listenDesc);
+	}
+
+
+	// Connects a new socket, and returns the server side descriptor
+	int connectSocket(vmime::shared_ptr <vmime::net::socket>& sok)
+	{
+		sok = vmime::platform::getHandler()->getSocketFactory()->create();
+		sok->connect("127.0.0.1", listenPort);
+
+		return ::accept(listenDesc, NULL, NULL);
+	}
+
+
+	void testReceiveRaw()
+	{
+		vmime::shared_ptr <vmime::net::socket> sok;
+		const int peer = connectSocket(sok);
+
+		vmime::byte_t buffer[16];
+
+		// No data available
+		VASSERT_EQ("Receive 1", 0, sok->receiveRaw(buffer, sizeof(buffer)));
+		VASSERT_TRUE("Would block", (sok->getStatus() & vmime::net::socket::STATUS_WOULDBLOCK) != 0);
+
+		VASSERT_EQ("Write", 5, ::write(peer, "Hello", 5));
+
+		VASSERT_TRUE("Wait", sok->waitForRead(5000));
+		VASSERT_EQ("Receive 2", 5, sok->receiveRaw(buffer, sizeof(buffer)));
+		VASSERT_EQ("Data", "Hello", vmime::string(buffer, buffer + 5));
+		VASSERT_EQ("Status", 0, sok->getStatus() & vmime::net::socket::STATUS_WOULDBLOCK);
+
+		::close(peer);
+	}
+
+#if VMIME_HAVE_EPOLL
+
+	void testReactor()
+	{
+		vmime::shared_ptr <vmime::net::socket> sok1, sok2;
+		const int peer1 = connectSocket(sok1);
+		const int peer2 = connectSocket(sok2);
+
+		vmime::platforms::posix::posixSocketReactor reactor;
+		reactor.addSocket(sok1);
+		reactor.addSocket(sok2);
+
+		VASSERT_EQ("No data", 0, reactor.waitForRead(0).size());
+
+		VASSERT_EQ("Write", 3, ::write(peer2, "abc", 3));
+
+		std::vector <vmime::shared_ptr <vmime::net::socket> > ready = reactor.waitForRead(5000);
+
+		VASSERT_EQ("Ready count", 1, ready.size());
+		VASSERT_TRUE("Ready socket", ready[0] == sok2);
+
+		vmime::byte_t buffer[16];
+		VASSERT_EQ("Receive", 3, ready[0]->receiveRaw(buffer, sizeof(buffer)));
+
+		reactor.removeSocket(sok2);
+
+		VASSERT_EQ("Write", 3, ::write(peer2, "def", 3));
+		VASSERT_EQ("Removed", 0, reactor.waitForRead(100).size());
+
+		::close(peer1);
+		::close(peer2);
+	}
+
+	void testReactorInvalidSocket()
+	{
+		vmime::platforms::posix::posixSocketReactor reactor;
+
+		// Not a POSIX socket
+		VASSERT_THROW("Other socket",
+			reactor.addSocket(vmime::make_shared <testSocket>()),
+			vmime::exceptions::invalid_argument);
+
+		// Not connected
+		VASSERT_THROW("Not connected",
+			reactor.addSocket(vmime::platform::getHandler()->getSocketFactory()->create()),
+			vmime::exceptions::invalid_argument);
+	}
+
+#endif // VMIME_HAVE_EPOLL
+
+VMIME_TEST_SUITE_END
@@ -0,0 +1,136 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/security/cert/defaultCertificateVerifier.hpp"
+#include "vmime/security/cert/X509Certificate.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(defaultCertificateVerifierTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testTrustedCert)
+		VMIME_TEST(testCachedVerification)
+		VMIME_TEST(testCacheInvalidation)
+		VMIME_TEST(testCacheDisabled)
+	VMIME_TEST_LIST_END
+
+
+	// Self-signed certificate for "mail.vmime.org"
+	static vmime::shared_ptr <vmime::security::cert::X509Certificate> getTestCertificate()
+	{
+		static const char pem[] =
+			"-----BEGIN CERTIFICATE-----\n"
+			"MIICEDCCAXmgAwIBAgIUT+I9+LH7C2He+k4qjgs2UULC35YwDQYJKoZIhvcNAQEL\n"
+			"BQAwGTEXMBUGA1UEAwwObWFpbC52bWltZS5vcmcwIBcNMjYxMDE4MDMzMjIxWhgP\n"
+			"MjEyNjA5MjQwMzMyMjFaMBkxFzAVBgNVBAMMDm1haWwudm1pbWUub3JnMIGfMA0G\n"
+			"CSqGSIb3DQEBAQUAA4GNADCBiQKBgQClDrJWZCGO30pxVp4UjvMocCOK1rmaKCBS\n"
+			"DOE0qTv0a8JUVp/It+I9+4Vo9GG59/DnGa4tpdkNL3XI//F7DsQJmZ8rK7xTm3qH\n"
+			"/hoZgECEmNaqAzw1wspcCXka3hYBbSgGoNHx2SRkEfyDx1GCyDv8O8PLioL2G0sW\n"
+			"NeWFPT9ZeQIDAQABo1MwUTAdBgNVHQ4EFgQUyWfoYvZiAistSKkSSc2fW1julHUw\n"
+			"HwYDVR0jBBgwFoAUyWfoYvZiAistSKkSSc2fW1julHUwDwYDVR0TAQH/BAUwAwEB\n"
+			"/zANBgkqhkiG9w0BAQsFAAOBgQAMPHLbHz190Ep3Mcm29mw1YEIuZ2VSC/EP6u2E\n"
+			"sz65b1MKaV+6Ba11oCiqJAPcXrB86xVewj2zgz5YG/zHlpQHG5s0ra2xLTGgw/9C\n"
+			"+xHVU0m507FucPoHYy9LEfOBBOANVOqhcfM1c9lnvyqvofo//sjBd7cuHQLLXl+f\n"
+			"Hwu+Qg==\n"
+			"-----END CERTIFICATE-----\n";
+
+		return vmime::security::cert::X509Certificate::import
+			(reinterpret_cast <const vmime::byte_t*>(pem), sizeof(pem) - 1);
+	}
+
+	static vmime::shared_ptr <vmime::security::cert::certificateChain> getTestChain()
+	{
+		std::vector <vmime::shared_ptr <vmime::security::cert::certificate> > certs;
+		certs.push_back(getTestCertificate());
+
+		return vmime::make_shared <vmime::security::cert::certificateChain>(certs);
+	}
+
+	static vmime::shared_ptr <vmime::security::cert::defaultCertificateVerifier> createVerifier()
+	{
+		std::vector <vmime::shared_ptr <vmime::security::cert::X509Certificate> > trusted;
+		trusted.push_back(getTestCertificate());
+
+		vmime::shared_ptr <vmime::security::cert::defaultCertificateVerifier> verifier =
+			vmime::make_shared <vmime::security::cert::defaultCertificateVerifier>();
+
+		verifier->setX509TrustedCerts(trusted);
+
+		return verifier;
+	}
+
+
+	void testTrustedCert()
+	{
+		vmime::shared_ptr <vmime::security::cert::defaultCertificateVerifier> verifier = createVerifier();
+
+		VASSERT_NO_THROW("Trusted", verifier->verify(getTestChain(), "mail.vmime.org"));
+		VASSERT_THROW("Host name", verifier->verify(getTestChain(), "www.vmime.org"),
+			vmime::security::cert::serverIdentityException);
+
+		verifier->setX509TrustedCerts(std::vector <vmime::shared_ptr <vmime::security::cert::X509Certificate> >());
+
+		VASSERT_THROW("Not trusted", verifier->verify(getTestChain(), "mail.vmime.org"),
+			vmime::security::cert::certificateNotTrustedException);
+	}
+
+	void testCachedVerification()
+	{
+		vmime::shared_ptr <vmime::security::cert::defaultCertificateVerifier> verifier = createVerifier();
+
+		VASSERT_NO_THROW("1", verifier->verify(getTestChain(), "mail.vmime.org"));
+		VASSERT_NO_THROW("2", verifier->verify(getTestChain(), "MAIL.vmime.org"));
+
+		// Cached result only applies to the same host name
+		VASSERT_THROW("Other host", verifier->verify(getTestChain(), "www.vmime.org"),
+			vmime::security::cert::serverIdentityException);
+	}
+
+	void testCacheInvalidation()
+	{
+		vmime::shared_ptr <vmime::security::cert::defaultCertificateVerifier> verifier = createVerifier();
+
+		VASSERT_NO_THROW("Trusted", verifier->verify(getTestChain(), "mail.vmime.org"));
+
+		// Certificate is not trusted anymore
+		verifier->setX509TrustedCerts(std::vector <vmime::shared_ptr <vmime::security::cert::X509Certificate> >());
+
+		VASSERT_THROW("Not trusted", verifier->verify(getTestChain(), "mail.vmime.org"),
+			vmime::security::cert::certificateNotTrustedException);
+	}
+
+	void testCacheDisabled()
+	{
+		vmime::shared_ptr <vmime::security::cert::defaultCertificateVerifier> verifier = createVerifier();
+
+		verifier->setVerificationCacheTimeout(0);
+
+		VASSERT_EQ("Timeout", 0, verifier->getVerificationCacheTimeout());
+		VASSERT_NO_THROW("1", verifier->verify(getTestChain(), "mail.vmime.org"));
+		VASSERT_NO_THROW("2", verifier->verify(getTestChain(), "mail.vmime.org"));
+	}
+
+VMIME_TEST_SUITE_END
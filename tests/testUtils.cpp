@@ -31,6 +31,12 @@
 
 // testSocket
 
+testSocket::testSocket()
+	: m_port(0), m_connected(false), m_sendCount(0)
+{
+}
+
+
 void testSocket::connect(const vmime::string& address, const vmime::port_t port)
 {
 	m_address = address;
@@ -118,6 +124,7 @@ void testSocket::receive(vmime::string& buffer)
 void testSocket::send(const vmime::string& buffer)
 {
 	m_outBuffer += buffer;
+	++m_sendCount;
 
 	onDataReceived();
 }
@@ -153,6 +160,12 @@ vmime::size_t testSocket::sendRawNonBlocking(const vmime::byte_t* buffer, const
 }
 
 
+unsigned int testSocket::getSendCount() const
+{
+	return m_sendCount;
+}
+
+
 void testSocket::localSend(const vmime::string& buffer)
 {
 	m_inBuffer += buffer;
@@ -254,6 +267,75 @@ bool lineBasedTestSocket::haveMoreLines() const
 }
 
 
+// commandRecordingTestSocket
+
+commandRecordingTestSocket::commandRecordingTestSocket()
+	: m_sentBytes(0), m_readBytes(0)
+{
+}
+
+
+const std::vector <vmime::string>& commandRecordingTestSocket::getCommands() const
+{
+	return m_commands;
+}
+
+
+size_t commandRecordingTestSocket::getCommandCount(const vmime::string& name) const
+{
+	size_t count = 0;
+
+	for (size_t i = 0 ; i < m_commands.size() ; ++i)
+	{
+		if (m_commands[i] == name || m_commands[i].compare(0, name.length() + 1, name + " ") == 0)
+			++count;
+	}
+
+	return count;
+}
+
+
+void commandRecordingTestSocket::receive(vmime::string& buffer)
+{
+	lineBasedTestSocket::receive(buffer);
+	m_readBytes += buffer.length();
+}
+
+
+size_t commandRecordingTestSocket::receiveRaw(vmime::byte_t* buffer, const size_t count)
+{
+	const size_t n = lineBasedTestSocket::receiveRaw(buffer, count);
+	m_readBytes += n;
+
+	return n;
+}
+
+
+void commandRecordingTestSocket::recordCommand(const vmime::string& command)
+{
+	m_commands.push_back(command);
+}
+
+
+void commandRecordingTestSocket::sendResponse(const vmime::string& data)
+{
+	m_sentBytes += data.length();
+	localSend(data);
+}
+
+
+size_t commandRecordingTestSocket::getSentBytes() const
+{
+	return m_sentBytes;
+}
+
+
+size_t commandRecordingTestSocket::getReadBytes() const
+{
+	return m_readBytes;
+}
+
+
 // testTimeoutHandler
 
 testTimeoutHandler::testTimeoutHandler(const unsigned long delay)
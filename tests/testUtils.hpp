@@ -250,6 +250,8 @@ class testSocket : public vmime::net::socket
 {
 public:
 
+	testSocket();
+
 	void connect(const vmime::string& address, const vmime::port_t port);
 	void disconnect();
 
@@ -305,6 +307,13 @@ public:
 	  */
 	vmime::size_t localReceiveRaw(vmime::byte_t* buffer, const size_t count);
 
+	/** Return the number of send operations performed by the client
+	  * (ie. the number of calls to send() and sendRaw()).
+	  *
+	  * @return number of send operations
+	  */
+	unsigned int getSendCount() const;
+
 protected:
 
 	/** Called when the client has sent some data.
@@ -323,6 +332,8 @@ private:
 
 	vmime::string m_inBuffer;
 	vmime::string m_outBuffer;
+
+	unsigned int m_sendCount;
 };
 
 
@@ -343,6 +354,35 @@ public:
 };
 
 
+/** Socket factory which always returns the same socket (eg. a test
+  * server whose state is checked after the client is done).
+  */
+template <typename T>
+class sharedTestSocketFactory : public vmime::net::socketFactory
+{
+public:
+
+	sharedTestSocketFactory(vmime::shared_ptr <T> socket)
+		: m_socket(socket)
+	{
+	}
+
+	vmime::shared_ptr <vmime::net::socket> create()
+	{
+		return m_socket;
+	}
+
+	vmime::shared_ptr <vmime::net::socket> create(vmime::shared_ptr <vmime::net::timeoutHandler> /* th */)
+	{
+		return m_socket;
+	}
+
+private:
+
+	vmime::shared_ptr <T> m_socket;
+};
+
+
 class lineBasedTestSocket : public testSocket
 {
 public:
@@ -361,6 +401,52 @@ private:
 };
 
 
+/** Base class for test servers which record the commands sent by the
+  * client, and count the bytes exchanged so that they can tell whether
+  * the client pipelined its commands.
+  */
+class commandRecordingTestSocket : public lineBasedTestSocket
+{
+public:
+
+	commandRecordingTestSocket();
+
+	/** Return the commands received from the client.
+	  */
+	const std::vector <vmime::string>& getCommands() const;
+
+	/** Return the number of commands received with the specified name.
+	  */
+	size_t getCommandCount(const vmime::string& name) const;
+
+	void receive(vmime::string& buffer);
+	size_t receiveRaw(vmime::byte_t* buffer, const size_t count);
+
+protected:
+
+	void recordCommand(const vmime::string& command);
+
+	/** Send a response to the client.
+	  *
+	  * @param data response data
+	  */
+	void sendResponse(const vmime::string& data);
+
+	/** Return the number of bytes sent to the client. */
+	size_t getSentBytes() const;
+
+	/** Return the number of bytes read by the client. */
+	size_t getReadBytes() const;
+
+private:
+
+	std::vector <vmime::string> m_commands;
+
+	size_t m_sentBytes;
+	size_t m_readBytes;
+};
+
+
 class testTimeoutHandler : public vmime::net::timeoutHandler
 {
 public:
@@ -0,0 +1,267 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+//
+// Base64 encoder benchmark
+//
+// Measures the throughput of the Base64 encoder and decoder on 1, 10 and
+// 100 MB of random data, and compares it to the byte-per-byte algorithm
+// which was used before the block-based implementation. Output of both
+// implementations is checked to be identical.
+//
+
+#include "vmime/vmime.hpp"
+#include "vmime/utility/encoder/b64Encoder.hpp"
+#include "vmime/parserHelpers.hpp"
+
+#include "encoderBenchmarkUtils.hpp"
+
+
+// Previous implementation, processing data one group at a time
+class legacyB64Encoder : public vmime::utility::encoder::b64Encoder
+{
+public:
+
+	vmime::size_t encode(vmime::utility::inputStream& in,
+		vmime::utility::outputStream& out, vmime::utility::progressListener* /* progress */ = NULL)
+	{
+		in.reset();  // may not work...
+
+		const vmime::size_t propMaxLineLength =
+			getProperties().getProperty <vmime::size_t>("maxlinelength", static_cast <vmime::size_t>(-1));
+
+		const bool cutLines = (propMaxLineLength != static_cast <vmime::size_t>(-1));
+		const vmime::size_t maxLineLength = std::min(propMaxLineLength, static_cast <vmime::size_t>(76));
+
+		vmime::byte_t buffer[65536];
+		vmime::size_t bufferLength = 0;
+		vmime::size_t bufferPos = 0;
+
+		vmime::byte_t bytes[3];
+		vmime::byte_t output[4];
+
+		vmime::size_t total = 0;
+		vmime::size_t curCol = 0;
+
+		while (bufferPos < bufferLength || !in.eof())
+		{
+			if (bufferPos >= bufferLength)
+			{
+				bufferLength = in.read(buffer, sizeof(buffer));
+				bufferPos = 0;
+
+				if (bufferLength == 0)
+					break;
+			}
+
+			int count = 0;
+
+			while (count < 3 && bufferPos < bufferLength)
+				bytes[count++] = buffer[bufferPos++];
+
+			while (count < 3)
+			{
+				if (bufferPos >= bufferLength)
+				{
+					bufferLength = in.read(buffer, sizeof(buffer));
+					bufferPos = 0;
+
+					if (bufferLength == 0)
+						break;
+				}
+
+				while (count < 3 && bufferPos < bufferLength)
+					bytes[count++] = buffer[bufferPos++];
+			}
+
+			switch (count)
+			{
+			case 1:
+
+				output[0] = sm_alphabet[(bytes[0] & 0xFC) >> 2];
+				output[1] = sm_alphabet[(bytes[0] & 0x03) << 4];
+				output[2] = sm_alphabet[64];
+				output[3] = sm_alphabet[64];
+
+				break;
+
+			case 2:
+
+				output[0] = sm_alphabet[(bytes[0] & 0xFC) >> 2];
+				output[1] = sm_alphabet[((bytes[0] & 0x03) << 4) | ((bytes[1] & 0xF0) >> 4)];
+				output[2] = sm_alphabet[(bytes[1] & 0x0F) << 2];
+				output[3] = sm_alphabet[64];
+
+				break;
+
+			default:
+			case 3:
+
+				output[0] = sm_alphabet[(bytes[0] & 0xFC) >> 2];
+				output[1] = sm_alphabet[((bytes[0] & 0x03) << 4) | ((bytes[1] & 0xF0) >> 4)];
+				output[2] = sm_alphabet[((bytes[1] & 0x0F) << 2) | ((bytes[2] & 0xC0) >> 6)];
+				output[3] = sm_alphabet[(bytes[2] & 0x3F)];
+
+				break;
+			}
+
+			out.write(output, 4);
+
+			total += 4;
+			curCol += 4;
+
+			if (cutLines && curCol + 2 /* \r\n */ + 4 /* next bytes */ >= maxLineLength)
+			{
+				out.write("\r\n", 2);
+				curCol = 0;
+			}
+		}
+
+		return (total);
+	}
+
+	vmime::size_t decode(vmime::utility::inputStream& in,
+		vmime::utility::outputStream& out, vmime::utility::progressListener* /* progress */ = NULL)
+	{
+		in.reset();  // may not work...
+
+		vmime::byte_t buffer[16384];
+		vmime::size_t bufferLength = 0;
+		vmime::size_t bufferPos = 0;
+
+		vmime::size_t total = 0;
+
+		vmime::byte_t bytes[4];
+		vmime::byte_t output[3];
+
+		while (bufferPos < bufferLength || !in.eof())
+		{
+			bytes[0] = '=';
+			bytes[1] = '=';
+			bytes[2] = '=';
+			bytes[3] = '=';
+
+			if (bufferPos >= bufferLength)
+			{
+				bufferLength = in.read(buffer, sizeof(buffer));
+				bufferPos = 0;
+
+				if (bufferLength == 0)
+					break;
+			}
+
+			int count = 0;
+
+			while (count < 4 && bufferPos < bufferLength)
+			{
+				const vmime::byte_t c = buffer[bufferPos++];
+
+				if (!vmime::parserHelpers::isSpace(c))
+					bytes[count++] = c;
+			}
+
+			if (count != 4)
+			{
+				while (count < 4 && !in.eof())
+				{
+					bufferLength = in.read(buffer, sizeof(buffer));
+					bufferPos = 0;
+
+					while (count < 4 && bufferPos < bufferLength)
+					{
+						const vmime::byte_t c = buffer[bufferPos++];
+
+						if (!vmime::parserHelpers::isSpace(c))
+							bytes[count++] = c;
+					}
+				}
+			}
+
+			if (count != 4)
+				break;
+
+			vmime::byte_t c1 = bytes[0];
+			vmime::byte_t c2 = bytes[1];
+
+			if (c1 == '=' || c2 == '=')
+				break;
+
+			output[0] = static_cast <vmime::byte_t>((sm_decodeMap[c1] << 2) | ((sm_decodeMap[c2] & 0x30) >> 4));
+
+			c1 = bytes[2];
+
+			if (c1 == '=')
+			{
+				out.write(output, 1);
+				total += 1;
+				break;
+			}
+
+			output[1] = static_cast <vmime::byte_t>(((sm_decodeMap[c2] & 0xf) << 4) | ((sm_decodeMap[c1] & 0x3c) >> 2));
+
+			c2 = bytes[3];
+
+			if (c2 == '=')
+			{
+				out.write(output, 2);
+				total += 2;
+				break;
+			}
+
+			output[2] = static_cast <vmime::byte_t>(((sm_decodeMap[c1] & 0x03) << 6) | sm_decodeMap[c2]);
+
+			out.write(output, 3);
+			total += 3;
+		}
+
+		return (total);
+	}
+};
+
+
+static const vmime::string randomData(const vmime::size_t length)
+{
+	vmime::string data(length, '\0');
+	unsigned int seed = 42;
+
+	for (vmime::size_t i = 0 ; i < length ; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		data[i] = static_cast <char>((seed >> 16) & 0xff);
+	}
+
+	return data;
+}
+
+
+int main()
+{
+	legacyB64Encoder legacy;
+	legacy.getProperties()["maxlinelength"] = 76;
+
+	vmime::utility::encoder::b64Encoder current;
+	current.getProperties()["maxlinelength"] = 76;
+
+	return runEncoderBenchmark(legacy, current, randomData);
+}
+
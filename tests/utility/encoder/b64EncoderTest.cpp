@@ -30,9 +30,67 @@ VMIME_TEST_SUITE_BEGIN(b64EncoderTest)
 
 	VMIME_TEST_LIST_BEGIN
 		VMIME_TEST(testBase64)
+		VMIME_TEST(testEncodedSize)
+		VMIME_TEST(testLargeData)
+		VMIME_TEST(testLineLength)
+		VMIME_TEST(testDecodeWhitespace)
+		VMIME_TEST(testDecodeInvalid)
 	VMIME_TEST_LIST_END
 
 
+	// Simple, byte-per-byte, reference encoder
+	static const vmime::string referenceEncode(const vmime::string& in)
+	{
+		static const char alphabet[] =
+			"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+		vmime::string out;
+
+		for (vmime::size_t i = 0 ; i < in.length() ; i += 3)
+		{
+			unsigned int group = static_cast <unsigned char>(in[i]) << 16;
+
+			if (i + 1 < in.length())
+				group |= static_cast <unsigned char>(in[i + 1]) << 8;
+			if (i + 2 < in.length())
+				group |= static_cast <unsigned char>(in[i + 2]);
+
+			out += alphabet[(group >> 18) & 0x3f];
+			out += alphabet[(group >> 12) & 0x3f];
+			out += (i + 1 < in.length() ? alphabet[(group >> 6) & 0x3f] : '=');
+			out += (i + 2 < in.length() ? alphabet[group & 0x3f] : '=');
+		}
+
+		return out;
+	}
+
+	static const vmime::string randomData(const vmime::size_t length, unsigned int seed)
+	{
+		vmime::string data(length, '\0');
+
+		for (vmime::size_t i = 0 ; i < length ; ++i)
+		{
+			seed = seed * 1103515245 + 12345;
+			data[i] = static_cast <char>((seed >> 16) & 0xff);
+		}
+
+		return data;
+	}
+
+	static const vmime::string removeLineBreaks(const vmime::string& str)
+	{
+		vmime::string res;
+
+		for (vmime::size_t i = 0 ; i < str.length() ; ++i)
+		{
+			if (str[i] != '\r' && str[i] != '\n')
+				res += str[i];
+		}
+
+		return res;
+	}
+
+
 	void testBase64()
 	{
 		static const vmime::string testSuites[] =
@@ -149,5 +207,132 @@ VMIME_TEST_SUITE_BEGIN(b64EncoderTest)
 		}
 	}
 
+	void testEncodedSize()
+	{
+		static const int maxLineLengths[] = { 0, 10, 11, 20, 76, 1000 };
+
+		for (unsigned int i = 0 ; i < sizeof(maxLineLengths) / sizeof(maxLineLengths[0]) ; ++i)
+		{
+			for (vmime::size_t n = 0 ; n < 300 ; ++n)
+			{
+				std::ostringstream oss;
+				oss << "[maxLineLength=" << maxLineLengths[i] << ", n=" << n << "] ";
+
+				const vmime::string decoded(n, 'x');
+
+				// Encoded size must be exact
+				VASSERT_EQ(oss.str(),
+					encode("base64", decoded, maxLineLengths[i]).length(),
+					getEncoder("base64", maxLineLengths[i])->getEncodedSize(n));
+			}
+		}
+	}
+
+	void testLargeData()
+	{
+		// Sizes around the block sizes used by the encoder
+		static const vmime::size_t sizes[] =
+		{
+			1, 2, 3, 4, 5, 11, 12, 13, 23, 24, 25, 31, 32, 33, 47, 48, 49, 95, 96, 97,
+			12287, 12288, 12289, 16383, 16384, 16385, 36864, 100000, 1048577
+		};
+
+		for (unsigned int i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; ++i)
+		{
+			std::ostringstream oss;
+			oss << "[size=" << sizes[i] << "] ";
+
+			const vmime::string decoded = randomData(sizes[i], i);
+			const vmime::string encoded = encode("base64", decoded);
+
+			VASSERT_EQ(oss.str() + "encoding", referenceEncode(decoded), encoded);
+			VASSERT_EQ(oss.str() + "decoding", decoded, decode("base64", encoded));
+		}
+	}
+
+	void testLineLength()
+	{
+		static const int maxLineLengths[] = { 10, 11, 20, 50, 76 };
+
+		const vmime::string decoded = randomData(40000, 42);
+		const vmime::string reference = referenceEncode(decoded);
+
+		for (unsigned int i = 0 ; i < sizeof(maxLineLengths) / sizeof(maxLineLengths[0]) ; ++i)
+		{
+			std::ostringstream oss;
+			oss << "[maxLineLength=" << maxLineLengths[i] << "] ";
+
+			const vmime::string encoded = encode("base64", decoded, maxLineLengths[i]);
+
+			VASSERT_EQ(oss.str() + "data", reference, removeLineBreaks(encoded));
+
+			for (vmime::size_t pos = 0, next ; pos < encoded.length() ; pos = next + 2)
+			{
+				next = encoded.find("\r\n", pos);
+
+				if (next == vmime::string::npos)
+					next = encoded.length();
+
+				VASSERT(oss.str() + "line length", next - pos <= static_cast <vmime::size_t>(maxLineLengths[i]));
+			}
+
+			VASSERT_EQ(oss.str() + "decoding", decoded, decode("base64", encoded));
+		}
+	}
+
+	void testDecodeWhitespace()
+	{
+		VASSERT_EQ("1", "ABCDEF", decode("base64", " Q U\tJ\r\nD R E\nV G "));
+		VASSERT_EQ("2", "ABCDEF", decode("base64", "QUJD\r\nREVG\r\n"));
+
+		// Whitespace at various positions in long data
+		const vmime::string decoded = randomData(5000, 7);
+		const vmime::string encoded = referenceEncode(decoded);
+
+		for (vmime::size_t step = 1 ; step < 80 ; step += 7)
+		{
+			vmime::string spaced;
+
+			for (vmime::size_t i = 0 ; i < encoded.length() ; ++i)
+			{
+				if (i % step == 0)
+					spaced += (i % 2 ? "\r\n" : " ");
+
+				spaced += encoded[i];
+			}
+
+			std::ostringstream oss;
+			oss << "[step=" << step << "]";
+
+			VASSERT_EQ(oss.str(), decoded, decode("base64", spaced));
+		}
+	}
+
+	void testDecodeInvalid()
+	{
+		// Padding ends decoding
+		VASSERT_EQ("1", "A", decode("base64", "QQ==QUJD"));
+		VASSERT_EQ("2", "", decode("base64", "=QUJDREVG"));
+		VASSERT_EQ("3", "ABC", decode("base64", "QUJDR=VG"));
+
+		// Incomplete group at the end is ignored
+		VASSERT_EQ("4", "ABC", decode("base64", "QUJDRE"));
+
+		// Invalid characters do not stop decoding
+		VASSERT_EQ("5", vmime::string("ABC\xfc" "EFGHI"), decode("base64", "QUJD*EVGR0hJ"));
+		VASSERT_EQ("6", vmime::string("AO\xc3" "DEF"), decode("base64", "QU\x80" "DREVG"));
+
+		// Same, in long data
+		const vmime::string decoded = randomData(3000, 3);
+		vmime::string encoded = referenceEncode(decoded);
+		encoded[1000] = '*';
+
+		const vmime::string res = decode("base64", encoded);
+
+		VASSERT_EQ("7", decoded.length(), res.length());
+		VASSERT_EQ("8", decoded.substr(0, 750), res.substr(0, 750));
+		VASSERT_EQ("9", decoded.substr(753), res.substr(753));
+	}
+
 VMIME_TEST_SUITE_END
 
@@ -0,0 +1,115 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+
+#include <iostream>
+#include <iomanip>
+#include <ctime>
+
+
+// Runs the encoder (or decoder) on the specified data, and returns
+// the time it took, in seconds
+static double runEncoder(vmime::utility::encoder::encoder& enc, const bool encode,
+	const vmime::string& in, vmime::string& out)
+{
+	out.clear();
+	out.reserve(encode ? enc.getEncodedSize(in.length()) : in.length());
+
+	vmime::utility::inputStreamStringAdapter vin(in);
+	vmime::utility::outputStreamStringAdapter vout(out);
+
+	const std::clock_t start = std::clock();
+
+	if (encode)
+		enc.encode(vin, vout);
+	else
+		enc.decode(vin, vout);
+
+	return static_cast <double>(std::clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+// Prints the throughput of both implementations, for the specified input length
+static void printEncoderResult(const char* name, const vmime::size_t length,
+	const double legacy, const double current)
+{
+	const double mb = static_cast <double>(length) / (1024 * 1024);
+
+	std::cout << "  " << std::setw(7) << std::left << name << std::right << std::fixed
+	          << std::setprecision(1)
+	          << std::setw(10) << (legacy > 0 ? mb / legacy : 0) << " MB/s"
+	          << std::setw(10) << (current > 0 ? mb / current : 0) << " MB/s"
+	          << std::setw(8) << (current > 0 ? legacy / current : 0) << "x"
+	          << std::endl;
+}
+
+
+// Encodes then decodes 1, 10 and 100 MB of data produced by the specified
+// generator with both implementations, and checks their output is identical.
+// Returns the exit code of the benchmark.
+static int runEncoderBenchmark(vmime::utility::encoder::encoder& legacy,
+	vmime::utility::encoder::encoder& current,
+	const vmime::string (*generateData)(const vmime::size_t length))
+{
+	static const vmime::size_t sizes[] = { 1, 10, 100 };
+
+	bool ok = true;
+
+	for (unsigned int i = 0 ; i < sizeof(sizes) / sizeof(sizes[0]) ; ++i)
+	{
+		const vmime::string data = generateData(sizes[i] * 1024 * 1024);
+
+		std::cout << sizes[i] << " MB:" << std::setw(21) << "legacy" << std::setw(15) << "current" << std::endl;
+
+		vmime::string legacyOut, currentOut;
+
+		// Encoding
+		const double legacyEncode = runEncoder(legacy, true, data, legacyOut);
+		const double currentEncode = runEncoder(current, true, data, currentOut);
+
+		if (legacyOut != currentOut)
+		{
+			std::cerr << "Encoded data differs!" << std::endl;
+			ok = false;
+		}
+
+		printEncoderResult("encode", data.length(), legacyEncode, currentEncode);
+
+		// Decoding
+		const vmime::string encoded = currentOut;
+
+		const double legacyDecode = runEncoder(legacy, false, encoded, legacyOut);
+		const double currentDecode = runEncoder(current, false, encoded, currentOut);
+
+		if (legacyOut != currentOut || currentOut != data)
+		{
+			std::cerr << "Decoded data differs!" << std::endl;
+			ok = false;
+		}
+
+		printEncoderResult("decode", encoded.length(), legacyDecode, currentDecode);
+	}
+
+	return ok ? 0 : 1;
+}
+
@@ -56,9 +56,10 @@ static const vmime::string encode(const vmime::string& name, const vmime::string
 
 
 // Decoding helper function
-static const vmime::string decode(const vmime::string& name, const vmime::string& in, int maxLineLength = 0)
+static const vmime::string decode(const vmime::string& name, const vmime::string& in,
+	int maxLineLength = 0, const vmime::propertySet props = vmime::propertySet())
 {
-	vmime::shared_ptr <vmime::utility::encoder::encoder> enc = getEncoder(name, maxLineLength);
+	vmime::shared_ptr <vmime::utility::encoder::encoder> enc = getEncoder(name, maxLineLength, props);
 
 	vmime::utility::inputStreamStringAdapter vin(in);
 
@@ -0,0 +1,472 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+//
+// Quoted-printable encoder benchmark
+//
+// Measures the throughput of the quoted-printable encoder and decoder on
+// a typical HTML newsletter, and compares it to the byte-per-byte algorithm
+// which was used before literal characters were processed by runs. Output
+// of both implementations is checked to be identical.
+//
+
+#include "vmime/vmime.hpp"
+#include "vmime/utility/encoder/qpEncoder.hpp"
+
+#include "encoderBenchmarkUtils.hpp"
+
+
+#define QP_ENCODE_HEX(x) \
+	outBuffer[outBufferPos] = '=';                           \
+	outBuffer[outBufferPos + 1] = sm_hexDigits[x >> 4];  \
+	outBuffer[outBufferPos + 2] = sm_hexDigits[x & 0xF]; \
+	outBufferPos += 3;                                       \
+	curCol += 3
+
+#define QP_WRITE(s, x, l) s.write(reinterpret_cast <vmime::byte_t*>(x), l)
+
+
+// Previous implementation, processing data one byte at a time
+class legacyQPEncoder : public vmime::utility::encoder::qpEncoder
+{
+public:
+
+	vmime::size_t encode(vmime::utility::inputStream& in,
+		vmime::utility::outputStream& out, vmime::utility::progressListener* progress = NULL)
+	{
+		in.reset();  // may not work...
+
+		const vmime::size_t propMaxLineLength =
+			getProperties().getProperty <vmime::size_t>("maxlinelength", static_cast <vmime::size_t>(-1));
+
+		const bool rfc2047 = getProperties().getProperty <bool>("rfc2047", false);
+		const bool text = getProperties().getProperty <bool>("text", false);  // binary mode by default
+
+		const bool cutLines = (propMaxLineLength != static_cast <vmime::size_t>(-1));
+		const vmime::size_t maxLineLength = std::min(propMaxLineLength, static_cast <vmime::size_t>(74));
+
+		// Process the data
+		vmime::byte_t buffer[16384];
+		vmime::size_t bufferLength = 0;
+		vmime::size_t bufferPos = 0;
+
+		vmime::size_t curCol = 0;
+
+		vmime::byte_t outBuffer[16384];
+		vmime::size_t outBufferPos = 0;
+
+		vmime::size_t total = 0;
+		vmime::size_t inTotal = 0;
+
+		if (progress)
+			progress->start(0);
+
+		while (bufferPos < bufferLength || !in.eof())
+		{
+			// Flush current output buffer
+			if (outBufferPos + 6 >= static_cast <int>(sizeof(outBuffer)))
+			{
+				QP_WRITE(out, outBuffer, outBufferPos);
+
+				total += outBufferPos;
+				outBufferPos = 0;
+			}
+
+			// Need to get more data?
+			if (bufferPos >= bufferLength)
+			{
+				bufferLength = in.read(buffer, sizeof(buffer));
+				bufferPos = 0;
+
+				// No more data
+				if (bufferLength == 0)
+					break;
+			}
+
+			// Get the next char and encode it
+			const vmime::byte_t c = buffer[bufferPos++];
+
+			if (rfc2047)
+			{
+				if (c >= 128 || sm_RFC2047EncodeTable[c] != 0)
+				{
+					if (c == 32)  // space
+					{
+						// RFC-2047, Page 5, 4.2. The "Q" encoding:
+						// << The 8-bit hexadecimal value 20 (e.g., ISO-8859-1 SPACE) may be
+						// represented as "_" (underscore, ASCII 95.). >>
+						outBuffer[outBufferPos++] = '_';
+						++curCol;
+					}
+					else
+					{
+						// Other characters: '=' + hexadecimal encoding
+						QP_ENCODE_HEX(c);
+					}
+				}
+				else
+				{
+					// No encoding
+					outBuffer[outBufferPos++] = c;
+					++curCol;
+				}
+			}
+			else
+			{
+				switch (c)
+				{
+				case 46:  // .
+				{
+					if (curCol == 0)
+					{
+						// If a '.' appears at the beginning of a line, we encode it to
+						// to avoid problems with SMTP servers... ("\r\n.\r\n" means the
+						// end of data transmission).
+						QP_ENCODE_HEX('.');
+						continue;
+					}
+
+					outBuffer[outBufferPos++] = '.';
+					++curCol;
+					break;
+				}
+				case 32:  // space
+				{
+					// Need to get more data?
+					if (bufferPos >= bufferLength)
+					{
+						bufferLength = in.read(buffer, sizeof(buffer));
+						bufferPos = 0;
+					}
+
+					// Spaces cannot appear at the end of a line. So, encode the space.
+					if (bufferPos >= bufferLength ||
+					    (buffer[bufferPos] == '\r' || buffer[bufferPos] == '\n'))
+					{
+						QP_ENCODE_HEX(' ');
+					}
+					else
+					{
+						outBuffer[outBufferPos++] = ' ';
+						++curCol;
+					}
+
+					break;
+				}
+				case 9:   // TAB
+				{
+					QP_ENCODE_HEX(c);
+					break;
+				}
+				case 13:  // CR
+				case 10:  // LF
+				{
+					// RFC-2045/6.7(4)
+
+					// Text data
+					if (text && !rfc2047)
+					{
+						outBuffer[outBufferPos++] = c;
+						++curCol;
+
+						if (c == 10)
+							curCol = 0;  // reset current line length
+					}
+					// Binary data
+					else
+					{
+						QP_ENCODE_HEX(c);
+					}
+
+					break;
+				}
+				case 61:  // =
+				{
+					QP_ENCODE_HEX('=');
+					break;
+				}
+				/*
+					Rule #2: (Literal representation) Octets with decimal values of 33
+					through 60 inclusive, and 62 through 126, inclusive, MAY be
+					represented as the ASCII characters which correspond to those
+					octets (EXCLAMATION POINT through LESS THAN, and GREATER THAN
+					through TILDE, respectively).
+				*/
+				default:
+
+					//if ((c >= 33 && c <= 60) || (c >= 62 && c <= 126))
+					if (c >= 33 && c <= 126 && c != 61 && c != 63)
+					{
+						outBuffer[outBufferPos++] = c;
+						++curCol;
+					}
+					// Other characters: '=' + hexadecimal encoding
+					else
+					{
+						QP_ENCODE_HEX(c);
+					}
+
+					break;
+
+				} // switch (c)
+
+				// Soft line break : "=\r\n"
+				if (cutLines && curCol >= maxLineLength - 1)
+				{
+					outBuffer[outBufferPos] = '=';
+					outBuffer[outBufferPos + 1] = '\r';
+					outBuffer[outBufferPos + 2] = '\n';
+
+					outBufferPos += 3;
+					curCol = 0;
+				}
+
+			} // !rfc2047
+
+			++inTotal;
+
+			if (progress)
+				progress->progress(inTotal, inTotal);
+		}
+
+		// Flush remaining output buffer
+		if (outBufferPos != 0)
+		{
+			QP_WRITE(out, outBuffer, outBufferPos);
+			total += outBufferPos;
+		}
+
+		if (progress)
+			progress->stop(inTotal);
+
+		return (total);
+	}
+	vmime::size_t decode(vmime::utility::inputStream& in,
+		vmime::utility::outputStream& out, vmime::utility::progressListener* progress = NULL)
+	{
+		in.reset();  // may not work...
+
+		// Process the data
+		const bool rfc2047 = getProperties().getProperty <bool>("rfc2047", false);
+
+		vmime::byte_t buffer[16384];
+		vmime::size_t bufferLength = 0;
+		vmime::size_t bufferPos = 0;
+
+		vmime::byte_t outBuffer[16384];
+		vmime::size_t outBufferPos = 0;
+
+		vmime::size_t total = 0;
+		vmime::size_t inTotal = 0;
+
+		while (bufferPos < bufferLength || !in.eof())
+		{
+			// Flush current output buffer
+			if (outBufferPos >= sizeof(outBuffer))
+			{
+				QP_WRITE(out, outBuffer, outBufferPos);
+
+				total += outBufferPos;
+				outBufferPos = 0;
+			}
+
+			// Need to get more data?
+			if (bufferPos >= bufferLength)
+			{
+				bufferLength = in.read(buffer, sizeof(buffer));
+				bufferPos = 0;
+
+				// No more data
+				if (bufferLength == 0)
+					break;
+			}
+
+			// Decode the next sequence (hex-encoded byte or printable character)
+			vmime::byte_t c = buffer[bufferPos++];
+
+			++inTotal;
+
+			switch (c)
+			{
+			case '=':
+			{
+				if (bufferPos >= bufferLength)
+				{
+					bufferLength = in.read(buffer, sizeof(buffer));
+					bufferPos = 0;
+				}
+
+				if (bufferPos < bufferLength)
+				{
+					c = buffer[bufferPos++];
+
+					++inTotal;
+
+					switch (c)
+					{
+					// Ignore soft line break ("=\r\n" or "=\n")
+					case '\r':
+
+						// Read one byte more
+						if (bufferPos >= bufferLength)
+						{
+							bufferLength = in.read(buffer, sizeof(buffer));
+							bufferPos = 0;
+						}
+
+						if (bufferPos < bufferLength)
+						{
+							++bufferPos;
+							++inTotal;
+						}
+
+						break;
+
+					case '\n':
+
+						break;
+
+					// Hex-encoded char
+					default:
+					{
+						// We need another byte...
+						if (bufferPos >= bufferLength)
+						{
+							bufferLength = in.read(buffer, sizeof(buffer));
+							bufferPos = 0;
+						}
+
+						if (bufferPos < bufferLength)
+						{
+							const vmime::byte_t next = buffer[bufferPos++];
+
+							++inTotal;
+
+							const vmime::byte_t value = static_cast <vmime::byte_t>
+								(sm_hexDecodeTable[c] * 16 + sm_hexDecodeTable[next]);
+
+							outBuffer[outBufferPos++] = value;
+						}
+						else
+						{
+							// Premature end-of-data
+						}
+
+						break;
+					}
+
+					}
+				}
+				else
+				{
+					// Premature end-of-data
+				}
+
+				break;
+			}
+			case '_':
+
+				if (rfc2047)
+				{
+					// RFC-2047, Page 5, 4.2. The "Q" encoding:
+					// << Note that the "_" always represents hexadecimal 20, even if the SPACE
+					// character occupies a different code position in the character set in use. >>
+					outBuffer[outBufferPos++] = 0x20;
+					break;
+				}
+
+				// fall through
+
+			default:
+			{
+				outBuffer[outBufferPos++] = c;
+			}
+
+			}
+
+			if (progress)
+				progress->progress(inTotal, inTotal);
+		}
+
+		// Flush remaining output buffer
+		if (outBufferPos != 0)
+		{
+			QP_WRITE(out, outBuffer, outBufferPos);
+			total += outBufferPos;
+		}
+
+		if (progress)
+			progress->stop(inTotal);
+
+		return (total);
+	}
+};
+
+
+// Builds an HTML newsletter, as generated by common mailing tools
+static const vmime::string newsletter(const vmime::size_t length)
+{
+	static const char* const lines[] =
+	{
+		"<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Transitional//EN\">",
+		"<html><head><meta http-equiv=\"Content-Type\" content=\"text/html; charset=utf-8\">",
+		"<table width=\"100%\" cellpadding=\"0\" cellspacing=\"0\" border=\"0\" class=\"wrapper\">",
+		"  <tr>",
+		"    <td align=\"center\" style=\"padding: 20px 0 30px 0; font-family: Arial, sans-serif;\">",
+		"      <h1 style=\"color: #153643; font-size: 24px;\">This month's news</h1>",
+		"      <p>Lorem ipsum dolor sit amet, consectetur adipiscing elit. Curabitur vel leo quis",
+		"      neque posuere pharetra. Donec faucibus, libero a facilisis mollis, nulla lorem",
+		"      tincidunt erat, vitae accumsan est lorem eget metus. Caf\xc3\xa9 cr\xc3\xa8me.</p>",
+		"      <a href=\"https://www.example.com/newsletter?id=12345&amp;utm_source=mail\">Read more</a>",
+		"    </td>",
+		"  </tr>",
+		"</table>",
+	};
+
+	vmime::string data;
+
+	for (vmime::size_t i = 0 ; data.length() < length ; ++i)
+	{
+		data += lines[i % (sizeof(lines) / sizeof(lines[0]))];
+		data += "\r\n";
+	}
+
+	data.resize(length);
+
+	return data;
+}
+
+
+int main()
+{
+	legacyQPEncoder legacy;
+	legacy.getProperties()["maxlinelength"] = 76;
+	legacy.getProperties()["text"] = true;
+
+	vmime::utility::encoder::qpEncoder current;
+	current.getProperties()["maxlinelength"] = 76;
+	current.getProperties()["text"] = true;
+
+	return runEncoderBenchmark(legacy, current, newsletter);
+}
+
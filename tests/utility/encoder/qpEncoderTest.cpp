@@ -35,6 +35,10 @@ VMIME_TEST_SUITE_BEGIN(qpEncoderTest)
 		VMIME_TEST(testQuotedPrintable_HardLineBreakDecode)
 		VMIME_TEST(testQuotedPrintable_CRLF)
 		VMIME_TEST(testQuotedPrintable_RFC2047)
+		VMIME_TEST(testQuotedPrintable_EncodedSize)
+		VMIME_TEST(testQuotedPrintable_LiteralRuns)
+		VMIME_TEST(testQuotedPrintable_LargeText)
+		VMIME_TEST(testQuotedPrintable_RFC2047Decode)
 	VMIME_TEST_LIST_END
 
 
@@ -243,6 +247,99 @@ VMIME_TEST_SUITE_BEGIN(qpEncoderTest)
 		VASSERT_EQ("especials.12", "=22", encode("quoted-printable", "\"", 10, encProps));
 	}
 
+	void testQuotedPrintable_EncodedSize()
+	{
+		static const int maxLineLengths[] = { 0, 10, 20, 76 };
+
+		// Worst case: all bytes must be encoded
+		const vmime::string decoded(1000, '\xff');
+
+		for (unsigned int i = 0 ; i < sizeof(maxLineLengths) / sizeof(maxLineLengths[0]) ; ++i)
+		{
+			std::ostringstream oss;
+			oss << "[maxLineLength=" << maxLineLengths[i] << "] ";
+
+			VASSERT(oss.str(),
+				getEncoder("quoted-printable", maxLineLengths[i])->getEncodedSize(decoded.length())
+				>= encode("quoted-printable", decoded, maxLineLengths[i]).length());
+		}
+	}
+
+	void testQuotedPrintable_LiteralRuns()
+	{
+		vmime::propertySet encProps;
+		encProps["text"] = true;
+
+		// Spaces are encoded at the end of lines only
+		VASSERT_EQ("1", "a b =20\r\nc=20", encode("quoted-printable", "a b  \r\nc ", 80, encProps));
+
+		// Special characters in the middle of a run
+		VASSERT_EQ("2", "a=3Db=3Fc", encode("quoted-printable", "a=b?c", 80, encProps));
+
+		// Dot at the beginning of a line, including after a soft line break
+		VASSERT_EQ("3", "x\r\n=2Ey.z", encode("quoted-printable", "x\r\n.y.z", 80, encProps));
+		VASSERT_EQ("4", "abcdefghi=\r\n=2Ek", encode("quoted-printable", "abcdefghi.k", 10, encProps));
+
+		// Soft line breaks
+		VASSERT_EQ("5", "abcdefghi=\r\njklmnop", encode("quoted-printable", "abcdefghijklmnop", 10, encProps));
+
+		VASSERT_EQ("6", "a b  cd=3De", decode("quoted-printable", "a b  c=\r\nd=3D3De"));
+	}
+
+	void testQuotedPrintable_LargeText()
+	{
+		// HTML-like text, with runs of literal characters crossing
+		// the boundaries of the internal buffers
+		vmime::string text;
+
+		for (int i = 0 ; text.length() < 100000 ; ++i)
+		{
+			text += "<td style=\"color: #333333;\">Line ";
+			text += static_cast <char>('0' + i % 10);
+			text += " of the text, with some non-ASCII chars: \xc3\xa9\xc3\xa8.";
+
+			if (i % 3 == 0)
+				text += vmime::string(i % 200, 'x');
+			if (i % 5 == 0)
+				text += "   ";
+
+			text += "\r\n";
+
+			if (i % 7 == 0)
+				text += ".";
+		}
+
+		vmime::propertySet encProps;
+		encProps["text"] = true;
+
+		const vmime::string encoded = encode("quoted-printable", text, 76, encProps);
+
+		for (vmime::size_t pos = 0, next ; pos < encoded.length() ; pos = next + 2)
+		{
+			next = encoded.find("\r\n", pos);
+
+			if (next == vmime::string::npos)
+				next = encoded.length();
+
+			VASSERT("line length", next - pos <= 76);
+			VASSERT("dot", encoded[pos] != '.');
+			VASSERT("space", next == pos || encoded[next - 1] != ' ');
+		}
+
+		VASSERT_EQ("decoding", text, decode("quoted-printable", encoded));
+	}
+
+	void testQuotedPrintable_RFC2047Decode()
+	{
+		vmime::propertySet encProps;
+		encProps["rfc2047"] = true;
+
+		VASSERT_EQ("1", "a b_c", decode("quoted-printable", "a_b=5Fc", 0, encProps));
+		VASSERT_EQ("2", "a_b_c", decode("quoted-printable", "a_b=5Fc"));
+
+		VASSERT_EQ("3", "a_b=5Fc", encode("quoted-printable", "a b_c", 0, encProps));
+	}
+
 	// TODO: UUEncode
 
 VMIME_TEST_SUITE_END
@@ -32,6 +32,8 @@ VMIME_TEST_SUITE_BEGIN(filteredStreamTest)
 	VMIME_TEST_LIST_BEGIN
 		VMIME_TEST(testDotFilteredInputStream)
 		VMIME_TEST(testDotFilteredOutputStream)
+		VMIME_TEST(testDotUnstuffingFilteredOutputStream)
+		VMIME_TEST(testDotUnstuffingFilteredOutputStream_Split)
 		VMIME_TEST(testCRLFToLFFilteredOutputStream)
 		VMIME_TEST(testStopSequenceFilteredInputStream1)
 		VMIME_TEST(testStopSequenceFilteredInputStreamN_2)
@@ -128,6 +130,7 @@ VMIME_TEST_SUITE_BEGIN(filteredStreamTest)
 		testDotFilteredInputStreamHelper("4", "foo\n.bar", "foo\n..", "bar");
 		testDotFilteredInputStreamHelper("5", "foo\n.bar", "foo\n", ".", ".bar");
 		testDotFilteredInputStreamHelper("6", "foo\n.bar", "foo\n", ".", ".", "bar");
+		testDotFilteredInputStreamHelper("7", "foo\r\n.\r\n..\r\nbar", "foo\r\n..\r\n...\r\nbar");
 	}
 
 	// dotFilteredOutputStream
@@ -169,6 +172,49 @@ VMIME_TEST_SUITE_BEGIN(filteredStreamTest)
 		testFilteredOutputStreamHelper<FILTER>("10", ".foobar", ".", "foobar");
 	}
 
+	void testDotUnstuffingFilteredOutputStream()
+	{
+		typedef vmime::utility::dotUnstuffingFilteredOutputStream FILTER;
+
+		testFilteredOutputStreamHelper<FILTER>("1", "foo\r\n.bar", "foo\r\n..bar\r\n.\r\n");
+		testFilteredOutputStreamHelper<FILTER>("2", "foo\n.bar", "foo\n..bar\n.\n");
+		testFilteredOutputStreamHelper<FILTER>("3", "foo\r\n.bar", "foo\r", "\n.", ".bar\r\n.", "\r\n");
+		testFilteredOutputStreamHelper<FILTER>("4", ".foo\r\n..", "..foo\r\n...\r\n.\r\n");
+		testFilteredOutputStreamHelper<FILTER>("5", "", ".\r\n");
+		testFilteredOutputStreamHelper<FILTER>("6", "\r\n", "\r\n\r\n.\r\n");
+		testFilteredOutputStreamHelper<FILTER>("7", "foo\r\n.\rbar", "foo\r\n.\rbar\r\n.\r\n");
+
+		// Data following the terminating line is ignored
+		testFilteredOutputStreamHelper<FILTER>("8", "foo", "foo\r\n.\r\nbar\r\n", ".\r\n");
+	}
+
+	void testDotUnstuffingFilteredOutputStream_Split()
+	{
+		const std::string data = "Line 1\r\n..Line 2\r\n.\r\r\n...\r\n\r\n.\r\nIgnored";
+		const std::string expected = "Line 1\r\n.Line 2\r\n.\r\r\n..\r\n";
+
+		for (size_t i = 0 ; i <= data.length() ; ++i)
+		{
+			for (size_t j = i ; j <= data.length() ; ++j)
+			{
+				std::ostringstream oss;
+				vmime::utility::outputStreamAdapter os(oss);
+
+				vmime::utility::dotUnstuffingFilteredOutputStream fos(os);
+
+				fos.write(data.data(), i);
+				fos.write(data.data() + i, j - i);
+				fos.write(data.data() + j, data.length() - j);
+
+				std::ostringstream number;
+				number << i << "/" << j;
+
+				VASSERT_EQ(number.str(), expected, oss.str());
+				VASSERT_TRUE(number.str(), fos.isTerminated());
+			}
+		}
+	}
+
 	void testCRLFToLFFilteredOutputStream()
 	{
 		typedef vmime::utility::CRLFToLFFilteredOutputStream FILTER;
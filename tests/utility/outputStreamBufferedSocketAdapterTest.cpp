@@ -0,0 +1,125 @@
+//
+// VMime library (http://www.vmime.org)
+// Copyright (C) 2002-2013 Vincent Richard <vincent@vmime.org>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License as
+// published by the Free Software Foundation; either version 3 of
+// the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// Linking this library statically or dynamically with other modules is making
+// a combined work based on this library.  Thus, the terms and conditions of
+// the GNU General Public License cover the whole combination.
+//
+
+#include "tests/testUtils.hpp"
+
+#include "vmime/utility/outputStreamBufferedSocketAdapter.hpp"
+
+
+VMIME_TEST_SUITE_BEGIN(outputStreamBufferedSocketAdapterTest)
+
+	VMIME_TEST_LIST_BEGIN
+		VMIME_TEST(testWrite)
+		VMIME_TEST(testWriteFullBuffer)
+		VMIME_TEST(testWriteLargeBlock)
+		VMIME_TEST(testFlushEmpty)
+		VMIME_TEST(testBlockSize)
+	VMIME_TEST_LIST_END
+
+
+	void testWrite()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+
+		vmime::utility::outputStreamBufferedSocketAdapter stream(*socket);
+		stream << "some";
+		stream << " ";
+		stream << "data";
+
+		VASSERT_EQ("Buffered", 0, socket->getSendCount());
+
+		stream.flush();
+
+		vmime::string buffer;
+		socket->localReceive(buffer);
+
+		VASSERT_EQ("Send count", 1, socket->getSendCount());
+		VASSERT_EQ("Write", "some data", buffer);
+	}
+
+	void testWriteFullBuffer()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+
+		vmime::utility::outputStreamBufferedSocketAdapter stream(*socket, 8);
+		stream << "0123";
+		stream << "4567";
+
+		VASSERT_EQ("Send count 1", 1, socket->getSendCount());
+
+		stream << "89";
+
+		VASSERT_EQ("Send count 2", 1, socket->getSendCount());
+
+		stream.flush();
+
+		vmime::string buffer;
+		socket->localReceive(buffer);
+
+		VASSERT_EQ("Send count 3", 2, socket->getSendCount());
+		VASSERT_EQ("Write", "0123456789", buffer);
+	}
+
+	void testWriteLargeBlock()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+
+		vmime::utility::outputStreamBufferedSocketAdapter stream(*socket, 8);
+		stream << "abc";
+		stream << "defghijklmnopqrstuvwxyz";
+
+		// Buffer is completed and sent, then the rest is sent directly
+		VASSERT_EQ("Send count", 2, socket->getSendCount());
+
+		stream.flush();
+
+		vmime::string buffer;
+		socket->localReceive(buffer);
+
+		VASSERT_EQ("Nothing buffered", 2, socket->getSendCount());
+		VASSERT_EQ("Write", "abcdefghijklmnopqrstuvwxyz", buffer);
+	}
+
+	void testFlushEmpty()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+
+		vmime::utility::outputStreamBufferedSocketAdapter stream(*socket);
+		stream.flush();
+
+		VASSERT_EQ("Send count", 0, socket->getSendCount());
+	}
+
+	void testBlockSize()
+	{
+		vmime::shared_ptr <testSocket> socket = vmime::make_shared <testSocket>();
+
+		vmime::utility::outputStreamBufferedSocketAdapter stream1(*socket);
+		VASSERT_EQ("Default", socket->getBlockSize(), stream1.getBlockSize());
+
+		vmime::utility::outputStreamBufferedSocketAdapter stream2(*socket, 42);
+		VASSERT_EQ("Specified", 42, stream2.getBlockSize());
+	}
+
+VMIME_TEST_SUITE_END
+
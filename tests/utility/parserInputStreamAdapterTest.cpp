@@ -24,15 +24,39 @@
 #include "tests/testUtils.hpp"
 
 #include "vmime/utility/parserInputStreamAdapter.hpp"
+#include "vmime/parserHelpers.hpp"
 
 
 VMIME_TEST_SUITE_BEGIN(parserInputStreamAdapterTest)
 
 	VMIME_TEST_LIST_BEGIN
 		VMIME_TEST(testEndlessLoopBufferSize)
+		VMIME_TEST(testBufferedAccess)
+		VMIME_TEST(testSkipIf)
+		VMIME_TEST(testReadAndExtract)
+		VMIME_TEST(testEOF)
+		VMIME_TEST(testFindNext)
+		VMIME_TEST(testFindNextAcrossBuffer)
+		VMIME_TEST(testFindNextLongToken)
+		VMIME_TEST(testFindNextDashLine)
+		VMIME_TEST(testFindNextDashLineAcrossBuffer)
+		VMIME_TEST(testFindNextDashLinePastCache)
+		VMIME_TEST(testFindNextDashLineNoMatch)
 	VMIME_TEST_LIST_END
 
 
+	static const vmime::string makeTestData(const size_t length)
+	{
+		vmime::string str;
+		str.reserve(length);
+
+		for (size_t i = 0 ; i < length ; ++i)
+			str += static_cast <char>('A' + (i * 7 + i / 26) % 26);
+
+		return str;
+	}
+
+
 	void testEndlessLoopBufferSize()
 	{
 		static const unsigned int BUFFER_SIZE = 4096;  // same as in parserInputStreamAdapter::findNext()
@@ -48,4 +72,302 @@ VMIME_TEST_SUITE_BEGIN(parserInputStreamAdapterTest)
 		VASSERT_EQ("Not found", vmime::string::npos, parser->findNext("token"));
 	}
 
+	void testBufferedAccess()
+	{
+		const vmime::string str = makeTestData(200000);
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		// Sequential access
+		for (size_t i = 0 ; i < str.length() ; ++i)
+		{
+			VASSERT_EQ("Peek", str[i], static_cast <char>(parser->peekByte()));
+			VASSERT_EQ("Get", str[i], static_cast <char>(parser->getByte()));
+		}
+
+		VASSERT_EQ("Position", str.length(), parser->getPosition());
+		VASSERT_EQ("Peek at end", 0, parser->peekByte());
+		VASSERT_EQ("Get at end", 0, parser->getByte());
+		VASSERT_EQ("Position at end", str.length(), parser->getPosition());
+
+		// Random access, across window boundaries
+		const size_t positions[] = { 0, 511, 512, 65535, 65536, 100000, 3, 199990 };
+
+		for (size_t i = 0 ; i < sizeof(positions) / sizeof(positions[0]) ; ++i)
+		{
+			const size_t pos = positions[i];
+
+			parser->seek(pos);
+
+			VASSERT_EQ("Seek", pos, parser->getPosition());
+			VASSERT_EQ("Peek", str[pos], static_cast <char>(parser->peekByte()));
+			VASSERT_TRUE("Match", parser->matchBytes(str.data() + pos, 10));
+			VASSERT_FALSE("No match", parser->matchBytes("0123456789", 10));
+			VASSERT_EQ("Position", pos, parser->getPosition());
+		}
+
+		// Match beyond end
+		parser->seek(str.length() - 5);
+
+		VASSERT_TRUE("Match end", parser->matchBytes(str.data() + str.length() - 5, 5));
+		VASSERT_FALSE("Match beyond end", parser->matchBytes(str.data() + str.length() - 5, 6));
+	}
+
+	void testSkipIf()
+	{
+		const vmime::string str = vmime::string(100000, ' ') + "X" + vmime::string(10, ' ');
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		VASSERT_EQ("Skip 1", 100000, parser->skipIf(vmime::parserHelpers::isSpace, str.length()));
+		VASSERT_EQ("Position 1", 100000, parser->getPosition());
+		VASSERT_EQ("Byte 1", 'X', parser->getByte());
+
+		VASSERT_EQ("Skip 2", 5, parser->skipIf(vmime::parserHelpers::isSpace, 100006));
+		VASSERT_EQ("Position 2", 100006, parser->getPosition());
+
+		VASSERT_EQ("Skip 3", 5, parser->skipIf(vmime::parserHelpers::isSpace, vmime::npos));
+		VASSERT_EQ("Position 3", str.length(), parser->getPosition());
+	}
+
+	void testReadAndExtract()
+	{
+		const vmime::string str = makeTestData(200000);
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		vmime::byte_t buffer[10000];
+
+		parser->seek(10);
+		parser->peekByte();  // fill window
+
+		VASSERT_EQ("Read 1", 100, parser->read(buffer, 100));
+		VASSERT_EQ("Read 1 data", str.substr(10, 100), vmime::string(buffer, buffer + 100));
+		VASSERT_EQ("Read 1 position", 110, parser->getPosition());
+
+		VASSERT_EQ("Read 2", 10000, parser->read(buffer, 10000));
+		VASSERT_EQ("Read 2 data", str.substr(110, 10000), vmime::string(buffer, buffer + 10000));
+		VASSERT_EQ("Read 2 position", 10110, parser->getPosition());
+
+		parser->seek(str.length() - 20);
+
+		VASSERT_EQ("Read 3", 20, parser->read(buffer, 100));
+		VASSERT_EQ("Read 3 data", str.substr(str.length() - 20), vmime::string(buffer, buffer + 20));
+
+		VASSERT_EQ("Extract 1", str.substr(5, 50), parser->extract(5, 55));
+		VASSERT_EQ("Extract 2", str.substr(1000, 150000), parser->extract(1000, 151000));
+		VASSERT_EQ("Extract 3", str.substr(199990), parser->extract(199990, 200010));
+		VASSERT_EQ("Position", str.length(), parser->getPosition());
+	}
+
+	void testEOF()
+	{
+		vmime::string str("abc");
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		VASSERT_FALSE("EOF 1", parser->eof());
+
+		parser->getByte();
+		parser->getByte();
+
+		VASSERT_FALSE("EOF 2", parser->eof());
+
+		parser->getByte();
+
+		VASSERT_TRUE("EOF 3", parser->eof());
+
+		parser->reset();
+
+		VASSERT_FALSE("EOF 4", parser->eof());
+		VASSERT_EQ("Byte", 'a', parser->getByte());
+	}
+
+	void testFindNext()
+	{
+		vmime::string str("abcabdabe xyz abe");
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		parser->seek(2);
+
+		VASSERT_EQ("1", 0, parser->findNext("abc"));
+		VASSERT_EQ("2", 6, parser->findNext("abe"));
+		VASSERT_EQ("3", 14, parser->findNext("abe", 7));
+		VASSERT_EQ("4", 16, parser->findNext("e", 9));
+		VASSERT_EQ("5", vmime::string::npos, parser->findNext("abf"));
+		VASSERT_EQ("6", vmime::string::npos, parser->findNext("abe", 15));
+		VASSERT_EQ("7", vmime::string::npos, parser->findNext("abe xyz abe abe"));
+		VASSERT_EQ("8", vmime::string::npos, parser->findNext(""));
+
+		// Position should not be changed
+		VASSERT_EQ("Position", 2, parser->getPosition());
+	}
+
+	void testFindNextAcrossBuffer()
+	{
+		const vmime::string token("--boundary--");
+
+		// Place token at every offset around the end of the read-ahead
+		// window (whose size is not known here)
+		for (size_t offset = 0 ; offset < 140000 ;
+		     offset += (offset < 2000 || (offset > 65400 && offset < 65700) ? 1 : 97))
+		{
+			vmime::string str(offset, 'x');
+			str += token;
+			str += "yyy";
+
+			vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+				vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+			vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+				vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+			parser->peekByte();  // fill window
+
+			VASSERT_EQ("Found", offset, parser->findNext(token));
+
+			if (offset > 0)
+				VASSERT_EQ("Found (start)", offset, parser->findNext(token, offset - 1));
+		}
+	}
+
+	void testFindNextLongToken()
+	{
+		const vmime::string token = makeTestData(10000);
+		const vmime::string str = vmime::string(5000, '-') + token + vmime::string(10, '-');
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		VASSERT_EQ("Found", 5000, parser->findNext(token));
+		VASSERT_EQ("Not found", vmime::string::npos, parser->findNext(token, 5001));
+	}
+
+	void testFindNextDashLine()
+	{
+		vmime::string str("a\n--b\nc\n--d\n-e");
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		VASSERT_EQ("1", 1, parser->findNextDashLine(0));
+		VASSERT_EQ("2", 1, parser->findNextDashLine(1));
+		VASSERT_EQ("3", 7, parser->findNextDashLine(2));
+		VASSERT_EQ("4", vmime::string::npos, parser->findNextDashLine(8));
+
+		// Search before the lines found
+		VASSERT_EQ("5", 1, parser->findNextDashLine(0));
+
+		// Position should not be changed
+		VASSERT_EQ("Position", 0, parser->getPosition());
+	}
+
+	void testFindNextDashLineAcrossBuffer()
+	{
+		// Place "\n--" at every offset around the end of the read-ahead
+		// window, so that it is split between two refills
+		for (size_t offset = 0 ; offset < 140000 ;
+		     offset += (offset < 2000 || (offset > 65400 && offset < 65700) ? 1 : 97))
+		{
+			vmime::string str(offset, 'x');
+			str += "\n--boundary\r\nyyy\n--boundary--";
+
+			vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+				vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+			vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+				vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+			parser->peekByte();  // fill window
+
+			VASSERT_EQ("First", offset, parser->findNextDashLine(0));
+			VASSERT_EQ("Second", offset + 16, parser->findNextDashLine(offset + 1));
+			VASSERT_EQ("End", vmime::string::npos, parser->findNextDashLine(offset + 17));
+		}
+	}
+
+	void testFindNextDashLinePastCache()
+	{
+		std::ostringstream oss;
+
+		for (int i = 0 ; i < 100 ; ++i)
+			oss << "line " << i << "\n--" << i << "\n";
+
+		const vmime::string str = oss.str();
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		// Only the first lines are found
+		VASSERT_EQ("1", str.find("\n--0"), parser->findNextDashLine(0));
+		VASSERT_EQ("2", str.find("\n--1\n"), parser->findNextDashLine(str.find("\n--0") + 1));
+
+		// Search past the lines already found
+		const size_t start = str.find("line 50");
+
+		VASSERT_EQ("3", str.find("\n--50"), parser->findNextDashLine(start));
+
+		// Lines in between have been found too
+		VASSERT_EQ("4", str.find("\n--20"), parser->findNextDashLine(str.find("line 20")));
+		VASSERT_EQ("5", str.find("\n--51"), parser->findNextDashLine(str.find("\n--50") + 1));
+		VASSERT_EQ("6", str.find("\n--99"), parser->findNextDashLine(str.find("line 99")));
+		VASSERT_EQ("7", vmime::string::npos, parser->findNextDashLine(str.find("\n--99") + 1));
+
+		// Search from the beginning again
+		VASSERT_EQ("8", str.find("\n--0"), parser->findNextDashLine(0));
+	}
+
+	void testFindNextDashLineNoMatch()
+	{
+		// Dashes not at the beginning of a line, or not two of them
+		vmime::string str("--a\nb--c\n-d\n\n- -e\n-");
+
+		vmime::shared_ptr <vmime::utility::inputStreamStringAdapter> iss =
+			vmime::make_shared <vmime::utility::inputStreamStringAdapter>(str);
+
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> parser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>(iss);
+
+		VASSERT_EQ("1", vmime::string::npos, parser->findNextDashLine(0));
+		VASSERT_EQ("2", vmime::string::npos, parser->findNextDashLine(0));
+		VASSERT_EQ("3", vmime::string::npos, parser->findNextDashLine(str.length() - 1));
+
+		// Empty stream
+		vmime::shared_ptr <vmime::utility::parserInputStreamAdapter> emptyParser =
+			vmime::make_shared <vmime::utility::parserInputStreamAdapter>
+				(vmime::make_shared <vmime::utility::inputStreamStringAdapter>(""));
+
+		VASSERT_EQ("Empty", vmime::string::npos, emptyParser->findNextDashLine(0));
+	}
+
 VMIME_TEST_SUITE_END